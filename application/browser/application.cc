@@ -356,7 +356,7 @@ bool Application::RegisterPermissions(const std::string& extension_name,
           && (*api_iter)->GetAsString(&api)))
         return false;
       // register the permission and api
-      name_perm_map_[api] = permission_name;
+      name_perm_map_[extension_name][api] = permission_name;
       DLOG(INFO) << "Permission Registered [PERM] " << permission_name
                  << " [API] " << api;
     }
@@ -368,13 +368,27 @@ bool Application::RegisterPermissions(const std::string& extension_name,
 std::string Application::GetRegisteredPermissionName(
     const std::string& extension_name,
     const std::string& api_name) const {
-  std::map<std::string, std::string>::const_iterator iter =
-      name_perm_map_.find(api_name);
-  if (iter == name_perm_map_.end())
+  std::map<std::string, APIPermissionMap>::const_iterator extension =
+      name_perm_map_.find(extension_name);
+  if (extension == name_perm_map_.end())
+    return std::string();
+  APIPermissionMap::const_iterator iter = extension->second.find(api_name);
+  if (iter == extension->second.end())
     return std::string();
   return iter->second;
 }
 
+void Application::GetRegisteredAPIs(const std::string& extension_name,
+                                    std::vector<std::string>* apis) const {
+  std::map<std::string, APIPermissionMap>::const_iterator extension =
+      name_perm_map_.find(extension_name);
+  if (extension == name_perm_map_.end())
+    return;
+  for (APIPermissionMap::const_iterator iter = extension->second.begin();
+       iter != extension->second.end(); ++iter)
+    apis->push_back(iter->first);
+}
+
 StoredPermission Application::GetPermission(PermissionType type,
     const std::string& permission_name) const {
   if (type == SESSION_PERMISSION) {
@@ -396,10 +410,17 @@ bool Application::SetPermission(PermissionType type,
                                 StoredPermission perm) {
   if (type == SESSION_PERMISSION) {
     permission_map_[permission_name] = perm;
+    if (observer_)
+      observer_->OnPermissionsChanged(this);
+    return true;
+  }
+  if (type == PERSISTENT_PERMISSION) {
+    if (!data_->SetPermission(permission_name, perm))
+      return false;
+    if (observer_)
+      observer_->OnPermissionsChanged(this);
     return true;
   }
-  if (type == PERSISTENT_PERMISSION)
-    return data_->SetPermission(permission_name, perm);
 
   NOTREACHED();
   return false;
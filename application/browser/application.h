@@ -54,6 +54,9 @@ class Application : public Runtime::Observer,
     // are closed.
     virtual void OnApplicationTerminated(Application* app) {}
 
+    // Invoked when a stored permission of the application changed.
+    virtual void OnPermissionsChanged(Application* app) {}
+
    protected:
     virtual ~Observer() {}
   };
@@ -96,6 +99,8 @@ class Application : public Runtime::Observer,
                            const std::string& perm_table);
   std::string GetRegisteredPermissionName(const std::string& extension_name,
                                           const std::string& api_name) const;
+  void GetRegisteredAPIs(const std::string& extension_name,
+                         std::vector<std::string>* apis) const;
 
   StoredPermission GetPermission(PermissionType type,
                                  const std::string& permission_name) const;
@@ -162,7 +167,9 @@ class Application : public Runtime::Observer,
 
   Observer* observer_;
 
-  std::map<std::string, std::string> name_perm_map_;
+  // Permission name of each registered API, per extension.
+  typedef std::map<std::string, std::string> APIPermissionMap;
+  std::map<std::string, APIPermissionMap> name_perm_map_;
   // Application's session permissions.
   StoredPermissionMap permission_map_;
   // Security policy.
@@ -0,0 +1,85 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_data_cache.h"
+
+#include "base/strings/string_util.h"
+#include "xwalk/application/browser/application.h"
+#include "xwalk/application/common/application_data.h"
+#include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/manifest_handlers/csp_handler.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const char kSpace[] = " ";
+const char kSemicolon[] = ";";
+
+std::string BuildContentSecurityPolicy(const ApplicationData& data) {
+  std::string content_security_policy;
+  const char* csp_key = GetCSPKey(data.manifest_type());
+  const CSPInfo* csp_info =
+      static_cast<CSPInfo*>(data.GetManifestData(csp_key));
+  if (csp_info) {
+    for (auto& directive : csp_info->GetDirectives()) {
+      content_security_policy.append(directive.first)
+          .append(kSpace)
+          .append(base::JoinString(directive.second, kSpace))
+          .append(kSemicolon);
+    }
+  }
+  return content_security_policy;
+}
+
+}  // namespace
+
+ApplicationDataCache::Entry::Entry() : is_widget(false) {
+}
+
+ApplicationDataCache::Entry::Entry(const Entry& other) = default;
+
+ApplicationDataCache::Entry::~Entry() {
+}
+
+ApplicationDataCache::ApplicationDataCache(
+    const CopyOnWriteMap<std::string, Entry>::TaskRunners&
+        reader_task_runners)
+    : entries_(reader_task_runners) {
+}
+
+ApplicationDataCache::~ApplicationDataCache() {
+}
+
+bool ApplicationDataCache::GetEntry(const std::string& application_id,
+                                    Entry* entry) const {
+  return entries_.Get(application_id, entry);
+}
+
+void ApplicationDataCache::AddApplication(const ApplicationData& data) {
+  Entry entry;
+  entry.path = data.path();
+  entry.content_security_policy = BuildContentSecurityPolicy(data);
+  entry.is_widget = data.manifest_type() == Manifest::TYPE_WIDGET;
+  if (entry.is_widget)
+    entry.default_locale = data.GetManifest()->default_locale();
+  entries_.Set(data.ID(), entry);
+}
+
+void ApplicationDataCache::RemoveApplication(
+    const std::string& application_id) {
+  entries_.Erase(application_id);
+}
+
+void ApplicationDataCache::DidLaunchApplication(Application* app) {
+  AddApplication(*app->data());
+}
+
+void ApplicationDataCache::WillDestroyApplication(Application* app) {
+  RemoveApplication(app->id());
+}
+
+}  // namespace application
+}  // namespace xwalk
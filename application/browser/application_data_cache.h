@@ -0,0 +1,66 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_BROWSER_APPLICATION_DATA_CACHE_H_
+#define XWALK_APPLICATION_BROWSER_APPLICATION_DATA_CACHE_H_
+
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "xwalk/application/browser/application_service.h"
+#include "xwalk/runtime/browser/copy_on_write_map.h"
+
+namespace xwalk {
+namespace application {
+
+class ApplicationData;
+
+// A cache of what the app:// protocol handler needs from the running
+// applications. The handler lives on the IO thread and hence cannot access
+// ApplicationService directly.
+//
+// Lookups take no lock: they read an immutable snapshot of the cache, which
+// is replaced whenever an application is launched or destroyed.
+class ApplicationDataCache : public ApplicationService::Observer {
+ public:
+  // The fields of an application, resolved when it is launched rather than
+  // for every request.
+  struct Entry {
+    Entry();
+    Entry(const Entry& other);
+    ~Entry();
+
+    base::FilePath path;
+    // The value of the Content-Security-Policy header.
+    std::string content_security_policy;
+    bool is_widget;
+    std::string default_locale;
+  };
+
+  // Lookups must happen on one of |reader_task_runners|.
+  explicit ApplicationDataCache(
+      const CopyOnWriteMap<std::string, Entry>::TaskRunners&
+          reader_task_runners);
+  ~ApplicationDataCache() override;
+
+  bool GetEntry(const std::string& application_id, Entry* entry) const;
+
+  void AddApplication(const ApplicationData& data);
+  void RemoveApplication(const std::string& application_id);
+
+  // ApplicationService::Observer implementation.
+  void DidLaunchApplication(Application* app) override;
+  void WillDestroyApplication(Application* app) override;
+
+ private:
+  CopyOnWriteMap<std::string, Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(ApplicationDataCache);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_BROWSER_APPLICATION_DATA_CACHE_H_
@@ -0,0 +1,156 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/browser/application_data_cache.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/memory/ptr_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/cancellation_flag.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/common/application_data.h"
+#include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/id_util.h"
+#include "xwalk/application/common/manifest_handlers/unittest_util.h"
+
+namespace xwalk {
+
+namespace keys = application_manifest_keys;
+
+namespace application {
+
+namespace {
+
+const int kReaders = 4;
+const int kChurnedApplications = 20;
+const int kChurnRounds = 200;
+const int kLookupsPerTask = 100;
+
+base::FilePath PathFor(const std::string& application_id) {
+  return base::FilePath(FILE_PATH_LITERAL("/applications"))
+      .AppendASCII(application_id);
+}
+
+scoped_refptr<ApplicationData> CreateApplicationData(const std::string& name) {
+  std::unique_ptr<base::DictionaryValue> manifest =
+      CreateDefaultManifestConfig();
+  manifest->SetString(keys::kCSPKey, "default-src 'self'");
+  std::string id = GenerateId(name);
+  std::string error;
+  scoped_refptr<ApplicationData> data = ApplicationData::Create(
+      PathFor(id), id, ApplicationData::LOCAL_DIRECTORY,
+      base::WrapUnique(new Manifest(std::move(manifest))), &error);
+  EXPECT_TRUE(data.get()) << error;
+  return data;
+}
+
+// Looks up applications, as app:// requests do, until |done| is set.
+void LookUpApplications(const ApplicationDataCache* cache,
+                        const std::vector<std::string>* ids,
+                        const base::CancellationFlag* done) {
+  ApplicationDataCache::Entry entry;
+  for (int i = 0; i < kLookupsPerTask; ++i) {
+    size_t index = i % ids->size();
+    bool found = cache->GetEntry((*ids)[index], &entry);
+    // The first application is never uninstalled.
+    if (index == 0)
+      EXPECT_TRUE(found);
+    if (found) {
+      EXPECT_EQ(PathFor((*ids)[index]), entry.path);
+      EXPECT_EQ("default-src 'self';", entry.content_security_policy);
+    }
+  }
+  if (done->IsSet())
+    return;
+  base::ThreadTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE, base::Bind(&LookUpApplications, cache, ids, done));
+}
+
+}  // namespace
+
+class ApplicationDataCacheTest : public testing::Test {
+ protected:
+  base::MessageLoop message_loop_;
+};
+
+TEST_F(ApplicationDataCacheTest, ResolvesEntries) {
+  ApplicationDataCache cache({base::ThreadTaskRunnerHandle::Get()});
+  scoped_refptr<ApplicationData> data = CreateApplicationData("app");
+  ASSERT_TRUE(data.get());
+
+  ApplicationDataCache::Entry entry;
+  EXPECT_FALSE(cache.GetEntry(data->ID(), &entry));
+
+  cache.AddApplication(*data);
+  ASSERT_TRUE(cache.GetEntry(data->ID(), &entry));
+  EXPECT_EQ(data->path(), entry.path);
+  EXPECT_EQ("default-src 'self';", entry.content_security_policy);
+  EXPECT_FALSE(entry.is_widget);
+
+  cache.RemoveApplication(data->ID());
+  EXPECT_FALSE(cache.GetEntry(data->ID(), &entry));
+}
+
+TEST_F(ApplicationDataCacheTest, InstallAndUninstallDuringLookups) {
+  std::vector<scoped_refptr<ApplicationData>> applications;
+  std::vector<std::string> ids;
+  for (int i = 0; i <= kChurnedApplications; ++i) {
+    applications.push_back(CreateApplicationData("app" + base::IntToString(i)));
+    ASSERT_TRUE(applications.back().get());
+    ids.push_back(applications.back()->ID());
+  }
+
+  std::vector<std::unique_ptr<base::Thread>> readers;
+  CopyOnWriteMap<std::string, ApplicationDataCache::Entry>::TaskRunners
+      task_runners;
+  for (int i = 0; i < kReaders; ++i) {
+    readers.push_back(base::WrapUnique(
+        new base::Thread("Reader" + base::IntToString(i))));
+    ASSERT_TRUE(readers.back()->Start());
+    task_runners.push_back(readers.back()->task_runner());
+  }
+  ApplicationDataCache cache(task_runners);
+  cache.AddApplication(*applications[0]);
+
+  base::CancellationFlag done;
+  for (const auto& task_runner : task_runners) {
+    task_runner->PostTask(
+        FROM_HERE, base::Bind(&LookUpApplications, &cache, &ids, &done));
+  }
+
+  for (int round = 0; round < kChurnRounds; ++round) {
+    for (int i = 1; i <= kChurnedApplications; ++i) {
+      if (round % 2 == 0)
+        cache.AddApplication(*applications[i]);
+      else
+        cache.RemoveApplication(ids[i]);
+    }
+  }
+  done.Set();
+
+  // Runs the last lookups and drops the replaced snapshots.
+  for (const auto& task_runner : task_runners) {
+    base::WaitableEvent flushed(
+        base::WaitableEvent::ResetPolicy::AUTOMATIC,
+        base::WaitableEvent::InitialState::NOT_SIGNALED);
+    task_runner->PostTask(
+        FROM_HERE,
+        base::Bind(&base::WaitableEvent::Signal, base::Unretained(&flushed)));
+    flushed.Wait();
+  }
+  for (const std::unique_ptr<base::Thread>& reader : readers)
+    reader->Stop();
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -29,13 +29,13 @@
 #include "net/url_request/url_request_error_job.h"
 #include "net/url_request/url_request_file_job.h"
 #include "net/url_request/url_request_simple_job.h"
+#include "xwalk/application/browser/application_data_cache.h"
 #include "xwalk/application/browser/application_service.h"
 #include "xwalk/application/common/application_data.h"
 #include "xwalk/application/common/application_file_util.h"
 #include "xwalk/application/common/application_manifest_constants.h"
 #include "xwalk/application/common/application_resource.h"
 #include "xwalk/application/common/constants.h"
-#include "xwalk/application/common/manifest_handlers/csp_handler.h"
 #include "xwalk/runtime/common/xwalk_system_locale.h"
 
 using content::BrowserThread;
@@ -156,66 +156,25 @@ class URLRequestApplicationJob : public net::URLRequestFileJob {
   base::WeakPtrFactory<URLRequestApplicationJob> weak_factory_;
 };
 
-// This class is a thread-safe cache of active application's data.
-// This class is used by ApplicationProtocolHandler which lives on
-// IO thread and hence cannot access ApplicationService directly.
-class ApplicationDataCache : public ApplicationService::Observer {
- public:
-  scoped_refptr<ApplicationData> GetApplicationData(
-      const std::string& application_id) const {
-    base::AutoLock lock(lock_);
-    ApplicationData::ApplicationDataMap::const_iterator it =
-        cache_.find(application_id);
-    if (it != cache_.end()) {
-      return it->second;
-    }
-    return NULL;
-  }
-
-  static void CreateIfNeeded(ApplicationService* service) {
-    DCHECK(service);
-    DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
-    if (s_instance_)
-      return;
-    // The cache lives longer than ApplicationService,
-    // so we do not need to remove cache_ from ApplicationService
-    // observers list.
-    s_instance_ = new ApplicationDataCache();
-    service->AddObserver(s_instance_);
-  }
-
-  static ApplicationDataCache* Get() { return s_instance_;}
-
- private:
-  void DidLaunchApplication(Application* app) override {
-    base::AutoLock lock(lock_);
-    cache_.insert(std::pair<std::string, scoped_refptr<ApplicationData> >(
-        app->id(), app->data()));
-  }
-
-  void WillDestroyApplication(Application* app) override {
-    base::AutoLock lock(lock_);
-    cache_.erase(app->id());
-  }
-
-  ApplicationDataCache() = default;
-  // The life time of the cache instance is equal to the process life time,
-  // it is not supposed to be explicitly destroyed.
-  ~ApplicationDataCache() override = default;
+// The cache lives longer than ApplicationService, so it is never removed
+// from the ApplicationService observers list.
+ApplicationDataCache* g_application_data_cache = nullptr;
 
-  ApplicationData::ApplicationDataMap cache_;
-  mutable base::Lock lock_;
-
-  static ApplicationDataCache* s_instance_;
-};
-
-ApplicationDataCache* ApplicationDataCache::s_instance_;
+void CreateApplicationDataCacheIfNeeded(ApplicationService* service) {
+  DCHECK(service);
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if (g_application_data_cache)
+    return;
+  g_application_data_cache = new ApplicationDataCache(
+      {BrowserThread::GetTaskRunnerForThread(BrowserThread::IO)});
+  service->AddObserver(g_application_data_cache);
+}
 
 class ApplicationProtocolHandler
     : public net::URLRequestJobFactory::ProtocolHandler {
  public:
   explicit ApplicationProtocolHandler(ApplicationService* service) {
-    ApplicationDataCache::CreateIfNeeded(service);
+    CreateApplicationDataCacheIfNeeded(service);
   }
 
   ~ApplicationProtocolHandler() override {}
@@ -244,42 +203,22 @@ void GetUserAgentLocales(const std::string& sys_locale,
   } while (position != std::string::npos);
 }
 
-namespace {
-const char kSpace[] = " ";
-const char kSemicolon[] = ";";
-}  // namespace
-
 net::URLRequestJob*
 ApplicationProtocolHandler::MaybeCreateJob(
     net::URLRequest* request, net::NetworkDelegate* network_delegate) const {
   const std::string& application_id = request->url().host();
-  scoped_refptr<ApplicationData> application =
-      ApplicationDataCache::Get()->GetApplicationData(application_id);
-
-  if (!application.get())
+  ApplicationDataCache::Entry application;
+  if (!g_application_data_cache->GetEntry(application_id, &application))
     return new net::URLRequestErrorJob(
         request, network_delegate, net::ERR_FILE_NOT_FOUND);
 
   base::FilePath relative_path =
       ApplicationURLToRelativeFilePath(request->url());
-  base::FilePath directory_path = application->path();
-  std::string content_security_policy;
-  const char* csp_key = GetCSPKey(application->manifest_type());
-  const CSPInfo* csp_info =
-      static_cast<CSPInfo*>(application->GetManifestData(csp_key));
-  if (csp_info) {
-    for (auto& directive : csp_info->GetDirectives()) {
-      content_security_policy.append(directive.first)
-          .append(kSpace)
-          .append(base::JoinString(directive.second, kSpace))
-          .append(kSemicolon);
-    }
-  }
 
   std::list<std::string> locales;
-  if (application->manifest_type() == Manifest::TYPE_WIDGET) {
+  if (application.is_widget) {
     GetUserAgentLocales(GetSystemLocale(), locales);
-    GetUserAgentLocales(application->GetManifest()->default_locale(), locales);
+    GetUserAgentLocales(application.default_locale, locales);
   }
 
   return new URLRequestApplicationJob(
@@ -289,9 +228,9 @@ ApplicationProtocolHandler::MaybeCreateJob(
       GetTaskRunnerWithShutdownBehavior(
           base::SequencedWorkerPool::SKIP_ON_SHUTDOWN),
       application_id,
-      directory_path,
+      application.path,
       relative_path,
-      content_security_policy,
+      application.content_security_policy,
       locales);
 }
 
@@ -4,20 +4,30 @@
 
 #include "xwalk/application/browser/application_service.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/command_line.h"
 #include "base/files/file_util.h"
 #include "base/memory/ptr_util.h"
+#include "base/path_service.h"
 #include "base/strings/utf_string_conversions.h"
+#include "content/public/browser/browser_context.h"
 #include "content/public/browser/browser_thread.h"
+#include "content/public/browser/storage_partition.h"
 #include "content/public/browser/web_contents.h"
 #include "content/public/browser/web_contents_observer.h"
 #include "xwalk/application/browser/application.h"
 #include "xwalk/application/common/application_manifest_constants.h"
 #include "xwalk/application/common/application_file_util.h"
+#include "xwalk/application/common/constants.h"
 #include "xwalk/application/common/id_util.h"
 #include "xwalk/runtime/browser/runtime.h"
 #include "xwalk/runtime/browser/xwalk_browser_context.h"
 #include "xwalk/runtime/browser/xwalk_runner.h"
 #include "xwalk/runtime/common/xwalk_paths.h"
+#include "xwalk/runtime/common/xwalk_switches.h"
 
 #if defined(OS_WIN)
 #include <shobjidl.h>
@@ -27,8 +37,22 @@ namespace xwalk {
 
 namespace application {
 
+namespace {
+
+// Number of extracted packages kept in the package store.
+const size_t kMaxStoredPackages = 8;
+
+}  // namespace
+
 ApplicationService::ApplicationService(XWalkBrowserContext* browser_context)
   : browser_context_(browser_context) {
+  base::FilePath data_path;
+  if (PathService::Get(DIR_DATA_PATH, &data_path)) {
+    package_store_.reset(new PackageStore(
+        data_path.Append(kPackageStoreDirname), kMaxStoredPackages,
+        base::CommandLine::ForCurrentProcess()->HasSwitch(
+            switches::kVerifyInstalledPackages)));
+  }
 }
 
 std::unique_ptr<ApplicationService> ApplicationService::Create(
@@ -74,8 +98,17 @@ Application* ApplicationService::Launch(
 
 Application* ApplicationService::LaunchFromManifestPath(
     const base::FilePath& path, Manifest::Type manifest_type) {
+  // Relaunching an unpacked application reuses the manifest parsed last time.
+  base::FilePath snapshot_path;
+  if (PathService::Get(DIR_DATA_PATH, &snapshot_path)) {
+    snapshot_path = snapshot_path.Append(kManifestSnapshotsDirname)
+        .AppendASCII(GenerateIdForPath(path));
+  }
+
   std::string error;
-  std::unique_ptr<Manifest> manifest = LoadManifest(path, manifest_type, &error);
+  std::unique_ptr<Manifest> manifest = snapshot_path.empty() ?
+      LoadManifest(path, manifest_type, &error) :
+      LoadManifest(path, manifest_type, snapshot_path, &error);
   if (!manifest) {
     LOG(ERROR) << "Failed to load manifest.";
     return NULL;
@@ -105,45 +138,69 @@ Application* ApplicationService::LaunchFromManifestPath(
 
 Application* ApplicationService::LaunchFromPackagePath(
     const base::FilePath& path) {
-  std::unique_ptr<Package> package = Package::Create(path);
-  if (!package || !package->IsValid()) {
-    LOG(ERROR) << "Failed to obtain valid package from "
-               << path.AsUTF8Unsafe();
-    return NULL;
-  }
+  PackageStore::Entry entry;
+  ApplicationData::SourceType source_type;
+  if (package_store_) {
+    std::vector<PackageStore::Entry> evicted_entries;
+    bool installed = package_store_->Install(path, &entry, &evicted_entries);
+    for (const PackageStore::Entry& evicted_entry : evicted_entries)
+      DeleteApplicationData(evicted_entry.id);
+    if (!installed) {
+      LOG(ERROR) << "Failed to install the package " << path.AsUTF8Unsafe();
+      return NULL;
+    }
+    source_type = ApplicationData::LOCAL_DIRECTORY;
+  } else {
+    std::unique_ptr<Package> package = Package::Create(path);
+    if (!package || !package->IsValid()) {
+      LOG(ERROR) << "Failed to obtain valid package from "
+                 << path.AsUTF8Unsafe();
+      return NULL;
+    }
 
-  base::FilePath tmp_dir, target_dir;
-  if (!GetTempDir(&tmp_dir)) {
-    LOG(ERROR) << "Failed to obtain system temp directory.";
-    return NULL;
-  }
+    base::FilePath tmp_dir, target_dir;
+    if (!GetTempDir(&tmp_dir)) {
+      LOG(ERROR) << "Failed to obtain system temp directory.";
+      return NULL;
+    }
 
 #if defined (OS_WIN)
-  base::CreateTemporaryDirInDir(tmp_dir,
-      base::UTF8ToWide(package->name()), &target_dir);
+    base::CreateTemporaryDirInDir(tmp_dir,
+        base::UTF8ToWide(package->name()), &target_dir);
 #else
-  base::CreateTemporaryDirInDir(tmp_dir, package->name(), &target_dir);
+    base::CreateTemporaryDirInDir(tmp_dir, package->name(), &target_dir);
 #endif
-  if (!package->ExtractTo(target_dir)) {
-    LOG(ERROR) << "Failed to unpack to a temporary directory: "
-               << target_dir.MaybeAsASCII();
-    return NULL;
+    if (!package->ExtractTo(target_dir)) {
+      LOG(ERROR) << "Failed to unpack to a temporary directory: "
+                 << target_dir.MaybeAsASCII();
+      return NULL;
+    }
+
+    entry.path = target_dir;
+    entry.id = package->Id();
+    entry.manifest_type = package->manifest_type();
+    source_type = ApplicationData::TEMP_DIRECTORY;
   }
 
+  // Stored packages keep their path across updates, but the ID of the
+  // package is the one which identifies the application and its data.
   std::string app_id;
-  if (package->manifest_type() == Manifest::TYPE_MANIFEST)
-    app_id = package->Id();
+  if (entry.manifest_type == Manifest::TYPE_MANIFEST || package_store_)
+    app_id = entry.id;
   std::string error;
   scoped_refptr<ApplicationData> application_data = LoadApplication(
-      target_dir, app_id, ApplicationData::TEMP_DIRECTORY,
-      package->manifest_type(), &error);
+      entry.path, app_id, source_type, entry.manifest_type, &error);
   if (!application_data.get()) {
     LOG(ERROR) << "Error occurred while trying to load application: "
                << error;
     return NULL;
   }
 
-  return Launch(application_data);
+  Application* application = Launch(application_data);
+  // The stored tree must outlive the application.
+  if (application && package_store_)
+    package_store_->Pin(application->id());
+  return application;
 }
 
 // Launch an application created from arbitrary url.
@@ -234,6 +291,8 @@ void ApplicationService::OnApplicationTerminated(
                     WillDestroyApplication(application));
   scoped_refptr<ApplicationData> app_data = application->data();
   applications_.erase(found);
+  if (package_store_)
+    package_store_->Unpin(app_data->ID());
 
   if (app_data->source_type() == ApplicationData::TEMP_DIRECTORY) {
       LOG(INFO) << "Deleting the app temporary directory "
@@ -255,6 +314,23 @@ void ApplicationService::OnApplicationTerminated(
   }
 }
 
+void ApplicationService::DeleteApplicationData(const std::string& app_id) {
+  LOG(INFO) << "Deleting the data of the application " << app_id;
+  content::StoragePartition* partition =
+      content::BrowserContext::GetStoragePartitionForSite(
+          browser_context_,
+          ApplicationData::GetBaseURLFromApplicationId(app_id));
+  partition->ClearData(
+      content::StoragePartition::REMOVE_DATA_MASK_ALL,
+      content::StoragePartition::QUOTA_MANAGED_STORAGE_MASK_ALL,
+      GURL(), content::StoragePartition::OriginMatcherFunction(),
+      base::Time(), base::Time::Max(), base::Bind(&base::DoNothing));
+  content::BrowserThread::PostTask(content::BrowserThread::FILE, FROM_HERE,
+      base::Bind(base::IgnoreResult(&base::DeleteFile),
+                 partition->GetPath().Append(kWidgetStorageDirname),
+                 true /*recursive*/));
+}
+
 void ApplicationService::CheckAPIAccessControl(const std::string& app_id,
     const std::string& extension_name,
     const std::string& api_name, const PermissionCallback& callback) {
@@ -272,14 +348,46 @@ void ApplicationService::CheckAPIAccessControl(const std::string& app_id,
     callback.Run(UNDEFINED_RUNTIME_PERM);
     return;
   }
+  // TODO(Bai): For "PROMPT" we needed to pop-up a dialog asking user to chose
+  // one from either allow/deny for session/one shot/forever. Then, we need to
+  // update the session and persistent policy accordingly.
+  callback.Run(GetRuntimePermission(app, extension_name, api_name));
+}
+
+void ApplicationService::GetPermissionSnapshot(const std::string& app_id,
+    const std::string& extension_name,
+    PermissionSnapshot* snapshot) {
+  Application* app = GetApplicationByID(app_id);
+  if (!app || !app->UseExtension(extension_name))
+    return;
+
+  std::vector<std::string> apis;
+  app->GetRegisteredAPIs(extension_name, &apis);
+  for (size_t i = 0; i < apis.size(); ++i) {
+    RuntimePermission perm =
+        GetRuntimePermission(app, extension_name, apis[i]);
+    // One shot and undefined decisions must be asked every time.
+    if (perm == ALLOW_SESSION || perm == ALLOW_ALWAYS ||
+        perm == DENY_SESSION || perm == DENY_ALWAYS)
+      snapshot->push_back(std::make_pair(apis[i], perm));
+  }
+}
+
+void ApplicationService::OnPermissionsChanged(Application* app) {
+  FOR_EACH_OBSERVER(Observer, observers_,
+                    DidChangeApplicationPermissions(app));
+}
+
+RuntimePermission ApplicationService::GetRuntimePermission(Application* app,
+    const std::string& extension_name,
+    const std::string& api_name) const {
   // Permission name should have been registered at extension initialization.
   std::string permission_name =
       app->GetRegisteredPermissionName(extension_name, api_name);
   if (permission_name.empty()) {
     LOG(ERROR) << "API: " << api_name << " of extension: "
       << extension_name << " not registered!";
-    callback.Run(UNDEFINED_RUNTIME_PERM);
-    return;
+    return UNDEFINED_RUNTIME_PERM;
   }
   // Okay, since we have the permission name, let's get down to the policies.
   // First, find out whether the permission is stored for the current session.
@@ -288,14 +396,10 @@ void ApplicationService::CheckAPIAccessControl(const std::string& app_id,
   if (perm != UNDEFINED_STORED_PERM) {
     // "PROMPT" should not be in the session storage.
     DCHECK(perm != PROMPT);
-    if (perm == ALLOW) {
-      callback.Run(ALLOW_SESSION);
-      return;
-    }
-    if (perm == DENY) {
-      callback.Run(DENY_SESSION);
-      return;
-    }
+    if (perm == ALLOW)
+      return ALLOW_SESSION;
+    if (perm == DENY)
+      return DENY_SESSION;
     NOTREACHED();
   }
   // Then, query the persistent policy storage.
@@ -304,26 +408,17 @@ void ApplicationService::CheckAPIAccessControl(const std::string& app_id,
   // not happen because all the permission needed by the application should be
   // contained in its manifest, so it also means that the application is asking
   // for something wasn't allowed.
-  if (perm == UNDEFINED_STORED_PERM) {
-    callback.Run(UNDEFINED_RUNTIME_PERM);
-    return;
-  }
-  if (perm == PROMPT) {
-    // TODO(Bai): We needed to pop-up a dialog asking user to chose one from
-    // either allow/deny for session/one shot/forever. Then, we need to update
-    // the session and persistent policy accordingly.
-    callback.Run(UNDEFINED_RUNTIME_PERM);
-    return;
-  }
-  if (perm == ALLOW) {
-    callback.Run(ALLOW_ALWAYS);
-    return;
-  }
-  if (perm == DENY) {
-    callback.Run(DENY_ALWAYS);
-    return;
-  }
+  if (perm == UNDEFINED_STORED_PERM)
+    return UNDEFINED_RUNTIME_PERM;
+  // "PROMPT" is not supported yet, see CheckAPIAccessControl().
+  if (perm == PROMPT)
+    return UNDEFINED_RUNTIME_PERM;
+  if (perm == ALLOW)
+    return ALLOW_ALWAYS;
+  if (perm == DENY)
+    return DENY_ALWAYS;
   NOTREACHED();
+  return UNDEFINED_RUNTIME_PERM;
 }
 
 bool ApplicationService::RegisterPermissions(const std::string& app_id,
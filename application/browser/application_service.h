@@ -14,6 +14,7 @@
 #include "xwalk/application/browser/application.h"
 #include "xwalk/application/common/permission_policy_manager.h"
 #include "xwalk/application/common/application_data.h"
+#include "xwalk/application/common/package/package_store.h"
 
 namespace xwalk {
 
@@ -30,6 +31,7 @@ class ApplicationService : public Application::Observer {
    public:
     virtual void DidLaunchApplication(Application* app) {}
     virtual void WillDestroyApplication(Application* app) {}
+    virtual void DidChangeApplicationPermissions(Application* app) {}
    protected:
     virtual ~Observer() {}
   };
@@ -45,8 +47,11 @@ class ApplicationService : public Application::Observer {
                                       Manifest::Type manifest_type);
 
   // Launch an application using path to its package file.
-  // Note: the given package is unpacked to a temporary folder,
-  // which is deleted after the application terminates.
+  // Note: the given package is unpacked to the package store and launched
+  // from there, so launching it again doesn't unpack it again. The data of
+  // the applications evicted from the store is deleted. Without a data path
+  // it is unpacked to a temporary folder, which is deleted after the
+  // application terminates.
   Application* LaunchFromPackagePath(const base::FilePath& path);
 
   // Launch an application from an arbitrary URL.
@@ -74,6 +79,12 @@ class ApplicationService : public Application::Observer {
   bool RegisterPermissions(const std::string& app_id,
       const std::string& extension_name,
       const std::string& perm_table);
+  // Returns the decisions for the APIs registered by extension which hold for
+  // the rest of the session, so they can be cached by the extension process
+  // until DidChangeApplicationPermissions() is called.
+  void GetPermissionSnapshot(const std::string& app_id,
+      const std::string& extension_name,
+      PermissionSnapshot* snapshot);
 
  protected:
   explicit ApplicationService(XWalkBrowserContext* browser_context);
@@ -83,10 +94,21 @@ class ApplicationService : public Application::Observer {
  private:
   // Implementation of Application::Observer.
   void OnApplicationTerminated(Application* app) override;
+  void OnPermissionsChanged(Application* app) override;
+
+  // Deletes the storage of an application whose package was evicted from
+  // the package store.
+  void DeleteApplicationData(const std::string& app_id);
+
+  // Decides from the stored permissions, without prompting the user.
+  RuntimePermission GetRuntimePermission(Application* app,
+      const std::string& extension_name,
+      const std::string& api_name) const;
 
   XWalkBrowserContext* browser_context_;
   ScopedVector<Application> applications_;
   base::ObserverList<Observer> observers_;
+  std::unique_ptr<PackageStore> package_store_;
 
   DISALLOW_COPY_AND_ASSIGN(ApplicationService);
 };
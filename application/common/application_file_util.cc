@@ -32,6 +32,7 @@
 #include "xwalk/application/common/constants.h"
 #include "xwalk/application/common/manifest.h"
 #include "xwalk/application/common/manifest_handler.h"
+#include "xwalk/application/common/manifest_snapshot.h"
 
 namespace errors = xwalk::application_manifest_errors;
 namespace keys = xwalk::application_manifest_keys;
@@ -418,6 +419,23 @@ std::unique_ptr<Manifest> LoadManifest(const base::FilePath& manifest_path,
   return std::unique_ptr<Manifest>();
 }
 
+std::unique_ptr<Manifest> LoadManifest(const base::FilePath& manifest_path,
+    Manifest::Type type, const base::FilePath& snapshot_path,
+    std::string* error) {
+  std::unique_ptr<Manifest> manifest =
+      LoadManifestSnapshot(snapshot_path, manifest_path, type);
+  UMA_HISTOGRAM_BOOLEAN("XWalk.Application.ManifestSnapshotHit", !!manifest);
+  if (manifest)
+    return manifest;
+
+  manifest = LoadManifest(manifest_path, type, error);
+  if (manifest && !SaveManifestSnapshot(snapshot_path, manifest_path,
+                                        *manifest))
+    LOG(WARNING) << "Failed to save manifest snapshot to "
+                 << snapshot_path.AsUTF8Unsafe();
+  return manifest;
+}
+
 base::FilePath GetManifestPath(
     const base::FilePath& app_directory, Manifest::Type type) {
   base::FilePath manifest_path;
@@ -40,6 +40,13 @@ class FileDeleter {
 std::unique_ptr<Manifest> LoadManifest(
     const base::FilePath& file_path, Manifest::Type type, std::string* error);
 
+// Same as above, but uses the snapshot at |snapshot_path| when it is still
+// valid for the manifest, and otherwise parses the manifest and refreshes the
+// snapshot for the next launch. See manifest_snapshot.h.
+std::unique_ptr<Manifest> LoadManifest(
+    const base::FilePath& file_path, Manifest::Type type,
+    const base::FilePath& snapshot_path, std::string* error);
+
 base::FilePath GetManifestPath(
     const base::FilePath& app_directory, Manifest::Type type);
 
@@ -20,6 +20,12 @@ const char kGeneratedMainDocumentFilename[] =
     "_generated_main_document.html";
 const base::FilePath::CharType kCookieDatabaseFilename[] =
     FILE_PATH_LITERAL("ApplicationCookies");
+const base::FilePath::CharType kManifestSnapshotsDirname[] =
+    FILE_PATH_LITERAL("ManifestSnapshots");
+const base::FilePath::CharType kPackageStoreDirname[] =
+    FILE_PATH_LITERAL("Packages");
+const base::FilePath::CharType kWidgetStorageDirname[] =
+    FILE_PATH_LITERAL("WidgetStorage");
 
 }  // namespace application
 }  // namespace xwalk
@@ -29,6 +29,16 @@ extern const char kGeneratedMainDocumentFilename[];
 // The name of cookies database file.
 extern const base::FilePath::CharType kCookieDatabaseFilename[];
 
+// The name of the directory holding the manifest snapshots.
+extern const base::FilePath::CharType kManifestSnapshotsDirname[];
+
+// The name of the directory holding the extracted packages.
+extern const base::FilePath::CharType kPackageStoreDirname[];
+
+// The name of the directory holding the widget storage of an application,
+// inside its storage partition.
+extern const base::FilePath::CharType kWidgetStorageDirname[];
+
 }  // namespace application
 }  // namespace xwalk
 
@@ -0,0 +1,255 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/manifest_snapshot.h"
+
+#include <limits>
+#include <string>
+#include <utility>
+
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/pickle.h"
+#include "base/sha1.h"
+#include "base/values.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const uint32_t kSnapshotMagic = 0x534d5758;  // "XWMS"
+// Bump when the layout changes, older snapshots are then ignored.
+const int kSnapshotVersion = 1;
+
+// Same nesting limit as the JSON parser.
+const int kMaxDepth = 100;
+
+// Identifies the contents of the manifest file a snapshot was made from.
+struct ManifestKey {
+  int64_t size;
+  int64_t last_modified;
+  std::string hash;
+};
+
+bool GetManifestKey(const base::FilePath& manifest_path, ManifestKey* key) {
+  base::File::Info info;
+  if (!base::GetFileInfo(manifest_path, &info) || info.is_directory)
+    return false;
+
+  std::string contents;
+  if (!base::ReadFileToString(manifest_path, &contents))
+    return false;
+
+  key->size = info.size;
+  key->last_modified = info.last_modified.ToInternalValue();
+  key->hash = base::SHA1HashString(contents);
+  return true;
+}
+
+bool WriteValue(const base::Value& value, int depth, base::Pickle* pickle) {
+  if (depth > kMaxDepth)
+    return false;
+
+  pickle->WriteInt(value.GetType());
+  switch (value.GetType()) {
+    case base::Value::TYPE_NULL:
+      return true;
+    case base::Value::TYPE_BOOLEAN: {
+      bool result;
+      value.GetAsBoolean(&result);
+      pickle->WriteBool(result);
+      return true;
+    }
+    case base::Value::TYPE_INTEGER: {
+      int result;
+      value.GetAsInteger(&result);
+      pickle->WriteInt(result);
+      return true;
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double result;
+      value.GetAsDouble(&result);
+      pickle->WriteDouble(result);
+      return true;
+    }
+    case base::Value::TYPE_STRING: {
+      std::string result;
+      value.GetAsString(&result);
+      pickle->WriteString(result);
+      return true;
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      const base::DictionaryValue* dict;
+      value.GetAsDictionary(&dict);
+      pickle->WriteSizeT(dict->size());
+      for (base::DictionaryValue::Iterator it(*dict); !it.IsAtEnd();
+           it.Advance()) {
+        pickle->WriteString(it.key());
+        if (!WriteValue(it.value(), depth + 1, pickle))
+          return false;
+      }
+      return true;
+    }
+    case base::Value::TYPE_LIST: {
+      const base::ListValue* list;
+      value.GetAsList(&list);
+      pickle->WriteSizeT(list->GetSize());
+      for (size_t i = 0; i < list->GetSize(); ++i) {
+        const base::Value* item;
+        list->Get(i, &item);
+        if (!WriteValue(*item, depth + 1, pickle))
+          return false;
+      }
+      return true;
+    }
+    default:
+      // Manifests are parsed from text, they never hold binary values.
+      return false;
+  }
+}
+
+std::unique_ptr<base::Value> ReadValue(base::PickleIterator* iter,
+                                       int depth) {
+  int type;
+  if (depth > kMaxDepth || !iter->ReadInt(&type))
+    return nullptr;
+
+  switch (type) {
+    case base::Value::TYPE_NULL:
+      return base::Value::CreateNullValue();
+    case base::Value::TYPE_BOOLEAN: {
+      bool result;
+      if (!iter->ReadBool(&result))
+        return nullptr;
+      return std::unique_ptr<base::Value>(new base::FundamentalValue(result));
+    }
+    case base::Value::TYPE_INTEGER: {
+      int result;
+      if (!iter->ReadInt(&result))
+        return nullptr;
+      return std::unique_ptr<base::Value>(new base::FundamentalValue(result));
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double result;
+      if (!iter->ReadDouble(&result))
+        return nullptr;
+      return std::unique_ptr<base::Value>(new base::FundamentalValue(result));
+    }
+    case base::Value::TYPE_STRING: {
+      std::string result;
+      if (!iter->ReadString(&result))
+        return nullptr;
+      return std::unique_ptr<base::Value>(new base::StringValue(result));
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      size_t size;
+      if (!iter->ReadSizeT(&size))
+        return nullptr;
+      std::unique_ptr<base::DictionaryValue> dict(new base::DictionaryValue);
+      for (size_t i = 0; i < size; ++i) {
+        std::string key;
+        if (!iter->ReadString(&key))
+          return nullptr;
+        std::unique_ptr<base::Value> item = ReadValue(iter, depth + 1);
+        if (!item)
+          return nullptr;
+        dict->SetWithoutPathExpansion(key, std::move(item));
+      }
+      return std::move(dict);
+    }
+    case base::Value::TYPE_LIST: {
+      size_t size;
+      if (!iter->ReadSizeT(&size))
+        return nullptr;
+      std::unique_ptr<base::ListValue> list(new base::ListValue);
+      for (size_t i = 0; i < size; ++i) {
+        std::unique_ptr<base::Value> item = ReadValue(iter, depth + 1);
+        if (!item)
+          return nullptr;
+        list->Append(std::move(item));
+      }
+      return std::move(list);
+    }
+    default:
+      return nullptr;
+  }
+}
+
+}  // namespace
+
+std::unique_ptr<Manifest> LoadManifestSnapshot(
+    const base::FilePath& snapshot_path,
+    const base::FilePath& manifest_path,
+    Manifest::Type type) {
+  base::MemoryMappedFile file;
+  if (!file.Initialize(snapshot_path) ||
+      file.length() > static_cast<size_t>(std::numeric_limits<int>::max()))
+    return nullptr;
+
+  // The pickle reads straight from the mapping, nothing is copied until the
+  // values are rebuilt.
+  base::Pickle pickle(reinterpret_cast<const char*>(file.data()),
+                      static_cast<int>(file.length()));
+  base::PickleIterator iter(pickle);
+
+  uint32_t magic;
+  int version;
+  int snapshot_type;
+  ManifestKey snapshot_key;
+  if (!iter.ReadUInt32(&magic) || magic != kSnapshotMagic ||
+      !iter.ReadInt(&version) || version != kSnapshotVersion ||
+      !iter.ReadInt(&snapshot_type) || snapshot_type != type ||
+      !iter.ReadInt64(&snapshot_key.size) ||
+      !iter.ReadInt64(&snapshot_key.last_modified) ||
+      !iter.ReadString(&snapshot_key.hash))
+    return nullptr;
+
+  ManifestKey key;
+  if (!GetManifestKey(manifest_path, &key) ||
+      key.size != snapshot_key.size ||
+      key.last_modified != snapshot_key.last_modified ||
+      key.hash != snapshot_key.hash)
+    return nullptr;
+
+  std::unique_ptr<base::Value> root = ReadValue(&iter, 0);
+  if (!root || !root->IsType(base::Value::TYPE_DICTIONARY))
+    return nullptr;
+
+  std::unique_ptr<base::DictionaryValue> dv(
+      static_cast<base::DictionaryValue*>(root.release()));
+  return std::unique_ptr<Manifest>(new Manifest(std::move(dv), type));
+}
+
+bool SaveManifestSnapshot(const base::FilePath& snapshot_path,
+                          const base::FilePath& manifest_path,
+                          const Manifest& manifest) {
+  ManifestKey key;
+  if (!GetManifestKey(manifest_path, &key))
+    return false;
+
+  base::Pickle pickle;
+  pickle.WriteUInt32(kSnapshotMagic);
+  pickle.WriteInt(kSnapshotVersion);
+  pickle.WriteInt(manifest.type());
+  pickle.WriteInt64(key.size);
+  pickle.WriteInt64(key.last_modified);
+  pickle.WriteString(key.hash);
+  if (!WriteValue(*manifest.value(), 0, &pickle))
+    return false;
+
+  if (!base::CreateDirectory(snapshot_path.DirName()))
+    return false;
+
+  return base::ImportantFileWriter::WriteFileAtomically(
+      snapshot_path,
+      base::StringPiece(static_cast<const char*>(pickle.data()),
+                        pickle.size()));
+}
+
+}  // namespace application
+}  // namespace xwalk
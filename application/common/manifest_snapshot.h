@@ -0,0 +1,41 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_MANIFEST_SNAPSHOT_H_
+#define XWALK_APPLICATION_COMMON_MANIFEST_SNAPSHOT_H_
+
+#include <memory>
+
+#include "xwalk/application/common/manifest.h"
+
+namespace base {
+class FilePath;
+}
+
+namespace xwalk {
+namespace application {
+
+// A manifest snapshot is a binary copy of the value tree parsed from a
+// manifest file, so launching the same application again does not need to
+// go through the JSON or XML parser. The snapshot records the size,
+// modification time and a hash of the manifest file it was made from, and is
+// ignored as soon as any of them changes.
+
+// Returns NULL if there is no usable snapshot at |snapshot_path| for the
+// manifest at |manifest_path|. The snapshot is memory-mapped while read.
+std::unique_ptr<Manifest> LoadManifestSnapshot(
+    const base::FilePath& snapshot_path,
+    const base::FilePath& manifest_path,
+    Manifest::Type type);
+
+// Writes a snapshot of |manifest|, which must have been parsed from the file
+// at |manifest_path|. The file is replaced atomically.
+bool SaveManifestSnapshot(const base::FilePath& snapshot_path,
+                          const base::FilePath& manifest_path,
+                          const Manifest& manifest);
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_MANIFEST_SNAPSHOT_H_
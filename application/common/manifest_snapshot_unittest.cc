@@ -0,0 +1,155 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/manifest_snapshot.h"
+
+#include <memory>
+#include <string>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/application/common/application_file_util.h"
+#include "xwalk/application/common/constants.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const char kManifest[] =
+    "{\n"
+    "  \"name\": \"snapshot\",\n"
+    "  \"xwalk_version\": \"1.0\",\n"
+    "  \"start_url\": \"index.html\",\n"
+    "  \"xwalk_permissions\": [\"Contacts\", \"Messaging\"],\n"
+    "  \"display\": {\"fullscreen\": true, \"ratio\": 1.5, \"none\": null}\n"
+    "}\n";
+
+const char kWidget[] =
+    "<widget xmlns=\"http://www.w3.org/ns/widgets\" version=\"1.0\">\n"
+    "  <name>unlocalized</name>\n"
+    "  <name xml:lang=\"fr\">localized</name>\n"
+    "  <content src=\"index.html\"/>\n"
+    "</widget>\n";
+
+}  // namespace
+
+class ManifestSnapshotTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    snapshot_path_ = temp_dir_.path().Append(kManifestSnapshotsDirname)
+        .AppendASCII("snapshot");
+  }
+
+  base::FilePath WriteManifest(const base::FilePath::CharType* name,
+                               const std::string& contents) {
+    base::FilePath path = temp_dir_.path().Append(name);
+    EXPECT_EQ(static_cast<int>(contents.size()),
+              base::WriteFile(path, contents.data(), contents.size()));
+    return path;
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath snapshot_path_;
+};
+
+TEST_F(ManifestSnapshotTest, RoundTrip) {
+  base::FilePath manifest_path = WriteManifest(kManifestXpkFilename, kManifest);
+  std::string error;
+  std::unique_ptr<Manifest> manifest =
+      LoadManifest(manifest_path, Manifest::TYPE_MANIFEST, &error);
+  ASSERT_TRUE(manifest);
+
+  EXPECT_FALSE(LoadManifestSnapshot(snapshot_path_, manifest_path,
+                                    Manifest::TYPE_MANIFEST));
+  ASSERT_TRUE(SaveManifestSnapshot(snapshot_path_, manifest_path, *manifest));
+
+  std::unique_ptr<Manifest> snapshot = LoadManifestSnapshot(
+      snapshot_path_, manifest_path, Manifest::TYPE_MANIFEST);
+  ASSERT_TRUE(snapshot);
+  EXPECT_EQ(Manifest::TYPE_MANIFEST, snapshot->type());
+  EXPECT_TRUE(snapshot->Equals(manifest.get()));
+
+  // The snapshot is only valid for the type it was made for.
+  EXPECT_FALSE(LoadManifestSnapshot(snapshot_path_, manifest_path,
+                                    Manifest::TYPE_WIDGET));
+}
+
+TEST_F(ManifestSnapshotTest, WidgetLocalizationIsKept) {
+  base::FilePath manifest_path = WriteManifest(kManifestWgtFilename, kWidget);
+  std::string error;
+  std::unique_ptr<Manifest> manifest =
+      LoadManifest(manifest_path, Manifest::TYPE_WIDGET, &error);
+  ASSERT_TRUE(manifest);
+  ASSERT_TRUE(SaveManifestSnapshot(snapshot_path_, manifest_path, *manifest));
+
+  std::unique_ptr<Manifest> snapshot = LoadManifestSnapshot(
+      snapshot_path_, manifest_path, Manifest::TYPE_WIDGET);
+  ASSERT_TRUE(snapshot);
+  EXPECT_TRUE(snapshot->Equals(manifest.get()));
+
+  manifest->SetSystemLocale("fr");
+  snapshot->SetSystemLocale("fr");
+  std::string name;
+  std::string snapshot_name;
+  EXPECT_TRUE(manifest->GetString("widget.name", &name));
+  EXPECT_TRUE(snapshot->GetString("widget.name", &snapshot_name));
+  EXPECT_EQ(name, snapshot_name);
+}
+
+TEST_F(ManifestSnapshotTest, ChangedManifestInvalidatesSnapshot) {
+  base::FilePath manifest_path = WriteManifest(kManifestXpkFilename, kManifest);
+  std::string error;
+  std::unique_ptr<Manifest> manifest =
+      LoadManifest(manifest_path, Manifest::TYPE_MANIFEST, &error);
+  ASSERT_TRUE(manifest);
+  ASSERT_TRUE(SaveManifestSnapshot(snapshot_path_, manifest_path, *manifest));
+
+  // Same size, different contents.
+  std::string changed(kManifest);
+  changed.replace(changed.find("snapshot"), 8, "SNAPSHOT");
+  WriteManifest(kManifestXpkFilename, changed);
+  EXPECT_FALSE(LoadManifestSnapshot(snapshot_path_, manifest_path,
+                                    Manifest::TYPE_MANIFEST));
+
+  // The next load parses the manifest again and refreshes the snapshot.
+  manifest = LoadManifest(manifest_path, Manifest::TYPE_MANIFEST,
+                          snapshot_path_, &error);
+  ASSERT_TRUE(manifest);
+  std::string name;
+  EXPECT_TRUE(manifest->GetString("name", &name));
+  EXPECT_EQ("SNAPSHOT", name);
+
+  std::unique_ptr<Manifest> snapshot = LoadManifestSnapshot(
+      snapshot_path_, manifest_path, Manifest::TYPE_MANIFEST);
+  ASSERT_TRUE(snapshot);
+  EXPECT_TRUE(snapshot->Equals(manifest.get()));
+}
+
+TEST_F(ManifestSnapshotTest, CorruptSnapshotIsIgnored) {
+  base::FilePath manifest_path = WriteManifest(kManifestXpkFilename, kManifest);
+  std::string error;
+  std::unique_ptr<Manifest> manifest =
+      LoadManifest(manifest_path, Manifest::TYPE_MANIFEST, &error);
+  ASSERT_TRUE(manifest);
+  ASSERT_TRUE(SaveManifestSnapshot(snapshot_path_, manifest_path, *manifest));
+
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(snapshot_path_, &contents));
+  contents.resize(contents.size() / 2);
+  ASSERT_EQ(static_cast<int>(contents.size()),
+            base::WriteFile(snapshot_path_, contents.data(), contents.size()));
+  EXPECT_FALSE(LoadManifestSnapshot(snapshot_path_, manifest_path,
+                                    Manifest::TYPE_MANIFEST));
+
+  // Falls back to parsing the manifest.
+  manifest = LoadManifest(manifest_path, Manifest::TYPE_MANIFEST,
+                          snapshot_path_, &error);
+  EXPECT_TRUE(manifest);
+}
+
+}  // namespace application
+}  // namespace xwalk
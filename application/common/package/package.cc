@@ -4,11 +4,12 @@
 
 #include "xwalk/application/common/package/package.h"
 
+#include "base/bind.h"
+#include "base/files/file_enumerator.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/logging.h"
 #include "base/path_service.h"
-#include "third_party/zlib/google/zip.h"
 #include "xwalk/application/common/id_util.h"
 #include "xwalk/application/common/package/wgt_package.h"
 #include "xwalk/application/common/package/xpk_package.h"
@@ -55,8 +56,9 @@ bool Package::ExtractToTemporaryDir(base::FilePath* target_path) {
     return false;
   }
 
-  if (!zip::Unzip(source_path_, temp_dir_.path())) {
+  if (!Extract(temp_dir_.path())) {
     LOG(ERROR) << "An error occurred during package extraction";
+    temp_dir_.Delete();
     return false;
   }
 
@@ -77,8 +79,14 @@ bool Package::ExtractTo(const base::FilePath& target_path) {
                << "is not empty.";
     return false;
   }
-  if (!zip::Unzip(source_path_, target_path)) {
+  if (!Extract(target_path)) {
     LOG(ERROR) << "An error occurred during package extraction";
+    // Leave the directory empty as it was given.
+    base::FileEnumerator enumerator(target_path, false,
+        base::FileEnumerator::FILES | base::FileEnumerator::DIRECTORIES);
+    for (base::FilePath path = enumerator.Next(); !path.empty();
+         path = enumerator.Next())
+      base::DeleteFile(path, true);
     return false;
   }
 
@@ -98,5 +106,17 @@ bool Package::CreateTempDirectory() {
   return true;
 }
 
+bool Package::Verify() {
+  return true;
+}
+
+bool Package::Extract(const base::FilePath& target_path) {
+  PackageExtractor extractor(source_path_, target_path);
+  extractor.set_verify_callback(
+      base::Bind(&Package::Verify, base::Unretained(this)));
+  extractor.set_progress_callback(progress_callback_);
+  return extractor.Extract();
+}
+
 }  // namespace application
 }  // namespace xwalk
@@ -12,6 +12,7 @@
 #include "base/files/scoped_file.h"
 #include "base/files/scoped_temp_dir.h"
 #include "xwalk/application/common/manifest.h"
+#include "xwalk/application/common/package/package_extractor.h"
 
 namespace xwalk {
 namespace application {
@@ -35,11 +36,21 @@ class Package {
   virtual bool ExtractToTemporaryDir(base::FilePath* result_path);
   // The function will unzip the XPK/WGT file to the given folder.
   virtual bool ExtractTo(const base::FilePath& target_path);
+  // Receives the progress of the following extractions, see
+  // PackageExtractor::ProgressCallback.
+  void set_progress_callback(
+      const PackageExtractor::ProgressCallback& callback) {
+    progress_callback_ = callback;
+  }
 
  protected:
   Package(const base::FilePath& source_path, Manifest::Type manifest_type);
   // Unzipping of the zipped file happens in a temporary directory
   bool CreateTempDirectory();
+  // Checks the content of the package. It is called on the extracting thread
+  // while the archive is being decompressed by other threads, and the
+  // extraction fails if it returns false.
+  virtual bool Verify();
   std::unique_ptr<base::ScopedFILE> file_;
 
   bool is_valid_;
@@ -51,6 +62,11 @@ class Package {
   // Represent if the package has been extracted.
   bool is_extracted_;
   Manifest::Type manifest_type_;
+
+ private:
+  bool Extract(const base::FilePath& target_path);
+
+  PackageExtractor::ProgressCallback progress_callback_;
 };
 
 }  // namespace application
@@ -0,0 +1,234 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_extractor.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/sys_info.h"
+#include "base/threading/simple_thread.h"
+#include "base/time/time.h"
+#include "third_party/zlib/google/zip_reader.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+// minizip inflates 8K at a time, the data is written in much larger chunks.
+const size_t kWriteBufferSize = 1 << 20;
+
+class BufferedFileWriter : public zip::WriterDelegate {
+ public:
+  // |on_written| is called with the number of bytes written to the file
+  // after each write, and returns false to abort the extraction.
+  BufferedFileWriter(const base::FilePath& path,
+                     const base::Callback<bool(int64_t)>& on_written)
+      : path_(path),
+        on_written_(on_written) {}
+
+  bool PrepareOutput() override {
+    if (!base::CreateDirectory(path_.DirName()))
+      return false;
+    file_.Initialize(path_,
+                     base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE);
+    buffer_.reserve(kWriteBufferSize);
+    return file_.IsValid();
+  }
+
+  bool WriteBytes(const char* data, int num_bytes) override {
+    buffer_.insert(buffer_.end(), data, data + num_bytes);
+    if (buffer_.size() < kWriteBufferSize)
+      return true;
+    return Flush();
+  }
+
+  // Writes what is left in the buffer and closes the file.
+  bool Close() {
+    bool result = Flush();
+    file_.Close();
+    return result;
+  }
+
+ private:
+  bool Flush() {
+    if (buffer_.empty())
+      return true;
+    int size = static_cast<int>(buffer_.size());
+    if (file_.WriteAtCurrentPos(&buffer_.front(), size) != size)
+      return false;
+    buffer_.clear();
+    return on_written_.Run(size);
+  }
+
+  base::FilePath path_;
+  base::Callback<bool(int64_t)> on_written_;
+  base::File file_;
+  std::vector<char> buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(BufferedFileWriter);
+};
+
+}  // namespace
+
+class PackageExtractor::Worker : public base::DelegateSimpleThread::Delegate {
+ public:
+  Worker(PackageExtractor* extractor, int index)
+      : extractor_(extractor),
+        index_(index) {}
+
+  void Run() override {
+    if (!ExtractEntries())
+      extractor_->Fail();
+  }
+
+ private:
+  bool ExtractEntries() {
+    // minizip handles can't be shared between threads.
+    zip::ZipReader reader;
+    if (!reader.Open(extractor_->zip_path_))
+      return false;
+
+    const std::vector<int>& owners = extractor_->entry_owners_;
+    for (size_t i = 0; i < owners.size() && reader.HasMore(); ++i) {
+      if (extractor_->failed_.IsSet())
+        return false;
+
+      if (owners[i] == index_) {
+        if (!reader.OpenCurrentEntryInZip())
+          return false;
+        const zip::ZipReader::EntryInfo* info = reader.current_entry_info();
+        base::FilePath path =
+            extractor_->target_path_.Append(info->file_path());
+        BufferedFileWriter writer(
+            path, base::Bind(&PackageExtractor::OnBytesWritten,
+                             base::Unretained(extractor_)));
+        if (!reader.ExtractCurrentEntry(&writer) || !writer.Close())
+          return false;
+        base::TouchFile(path, base::Time::Now(), info->last_modified());
+      }
+
+      if (!reader.AdvanceToNextEntry())
+        return false;
+    }
+    return true;
+  }
+
+  PackageExtractor* extractor_;
+  int index_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+PackageExtractor::PackageExtractor(const base::FilePath& zip_path,
+                                   const base::FilePath& target_path)
+    : zip_path_(zip_path),
+      target_path_(target_path),
+      max_threads_(base::SysInfo::NumberOfProcessors()),
+      total_bytes_(0),
+      written_bytes_(0) {
+}
+
+PackageExtractor::~PackageExtractor() {
+}
+
+bool PackageExtractor::Extract() {
+  if (!base::CreateDirectory(target_path_))
+    return false;
+
+  if (!ReadEntries())
+    return false;
+  int num_workers = std::max(
+      1, std::min(max_threads_, static_cast<int>(files_.size())));
+  AssignFiles(num_workers);
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  base::DelegateSimpleThreadPool pool("PackageExtractor", num_workers);
+  for (int i = 0; i < num_workers; ++i) {
+    workers.push_back(std::unique_ptr<Worker>(new Worker(this, i)));
+    pool.AddWork(workers.back().get());
+  }
+  pool.Start();
+
+  // The verification reads the archive while the workers decompress it.
+  if (!verify_callback_.is_null() && !verify_callback_.Run()) {
+    LOG(ERROR) << "Package verification failed: " << zip_path_.value();
+    Fail();
+  }
+
+  pool.JoinAll();
+  return !failed_.IsSet();
+}
+
+bool PackageExtractor::ReadEntries() {
+  zip::ZipReader reader;
+  if (!reader.Open(zip_path_))
+    return false;
+
+  while (reader.HasMore()) {
+    if (!reader.OpenCurrentEntryInZip())
+      return false;
+    const zip::ZipReader::EntryInfo* info = reader.current_entry_info();
+    if (info->is_unsafe())
+      return false;
+
+    if (info->is_directory()) {
+      if (!base::CreateDirectory(target_path_.Append(info->file_path())))
+        return false;
+      entry_owners_.push_back(-1);
+    } else {
+      files_.push_back(std::make_pair(info->original_size(),
+                                      entry_owners_.size()));
+      entry_owners_.push_back(0);
+      total_bytes_ += info->original_size();
+    }
+
+    if (!reader.AdvanceToNextEntry())
+      return false;
+  }
+  return true;
+}
+
+void PackageExtractor::AssignFiles(int num_workers) {
+  // Give the largest remaining file to the least loaded worker, which keeps
+  // the workers busy for about the same time.
+  std::sort(files_.begin(), files_.end(),
+            std::greater<std::pair<int64_t, size_t>>());
+  typedef std::pair<int64_t, int> Load;
+  std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+  for (int i = 0; i < num_workers; ++i)
+    loads.push(Load(0, i));
+  for (size_t i = 0; i < files_.size(); ++i) {
+    Load load = loads.top();
+    loads.pop();
+    entry_owners_[files_[i].second] = load.second;
+    load.first += files_[i].first;
+    loads.push(load);
+  }
+}
+
+void PackageExtractor::Fail() {
+  failed_.Set();
+}
+
+bool PackageExtractor::OnBytesWritten(int64_t bytes) {
+  if (!progress_callback_.is_null()) {
+    base::AutoLock lock(progress_lock_);
+    written_bytes_ += bytes;
+    progress_callback_.Run(written_bytes_, total_bytes_);
+  }
+  return !failed_.IsSet();
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,89 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_EXTRACTOR_H_
+#define XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_EXTRACTOR_H_
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/synchronization/cancellation_flag.h"
+#include "base/synchronization/lock.h"
+
+namespace xwalk {
+namespace application {
+
+// Extracts the zip archive of a package using several threads.
+//
+// The entries are shared between the threads by their uncompressed size, and
+// each thread reads the archive through its own handle, so they decompress
+// in parallel. Meanwhile the calling thread runs the verify callback, which
+// can read the whole archive (e.g. to check its signature) without waiting
+// for the extraction to be done. The extraction is stopped as soon as the
+// verification fails.
+class PackageExtractor {
+ public:
+  typedef base::Callback<bool()> VerifyCallback;
+  // Called with the number of bytes written so far and the total number of
+  // bytes to write. Can be called from any of the extraction threads, but
+  // never concurrently.
+  typedef base::Callback<void(int64_t, int64_t)> ProgressCallback;
+
+  PackageExtractor(const base::FilePath& zip_path,
+                   const base::FilePath& target_path);
+  ~PackageExtractor();
+
+  void set_verify_callback(const VerifyCallback& callback) {
+    verify_callback_ = callback;
+  }
+  void set_progress_callback(const ProgressCallback& callback) {
+    progress_callback_ = callback;
+  }
+  // Defaults to one thread per core.
+  void set_max_threads(int max_threads) { max_threads_ = max_threads; }
+
+  // Blocks until the archive is extracted and verified. The target directory
+  // is created if needed. On failure, some files may have been written.
+  bool Extract();
+
+ private:
+  class Worker;
+
+  // Reads the list of entries and creates the directories.
+  bool ReadEntries();
+  // Shares the files between |num_workers| workers.
+  void AssignFiles(int num_workers);
+  void Fail();
+  // Returns false once the extraction has failed.
+  bool OnBytesWritten(int64_t bytes);
+
+  base::FilePath zip_path_;
+  base::FilePath target_path_;
+  VerifyCallback verify_callback_;
+  ProgressCallback progress_callback_;
+  int max_threads_;
+
+  // Index of the worker extracting each entry, or -1 for directories.
+  std::vector<int> entry_owners_;
+  // Uncompressed size and entry index of each file.
+  std::vector<std::pair<int64_t, size_t>> files_;
+  int64_t total_bytes_;
+
+  base::CancellationFlag failed_;
+
+  base::Lock progress_lock_;
+  int64_t written_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackageExtractor);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_EXTRACTOR_H_
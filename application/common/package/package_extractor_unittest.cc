@@ -0,0 +1,121 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_extractor.h"
+
+#include <string>
+
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/string_number_conversions.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/google/zip.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const int kNumFiles = 20;
+
+std::string GetContents(int index) {
+  // Files of quite different sizes, so that the workers get a different
+  // number of them.
+  return std::string(index * index * 1000, 'a' + index);
+}
+
+bool VerifyResult(bool result) {
+  return result;
+}
+
+void RecordProgress(int64_t* last_written, int64_t* last_total,
+                    int64_t written, int64_t total) {
+  EXPECT_GT(written, *last_written);
+  EXPECT_LE(written, total);
+  *last_written = written;
+  *last_total = total;
+}
+
+}  // namespace
+
+class PackageExtractorTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    base::FilePath source = temp_dir_.path().AppendASCII("source");
+    for (int i = 0; i < kNumFiles; ++i) {
+      std::string contents = GetContents(i);
+      base::FilePath path = source.AppendASCII(i % 2 ? "odd" : "even")
+          .AppendASCII(base::IntToString(i));
+      ASSERT_TRUE(base::CreateDirectory(path.DirName()));
+      ASSERT_EQ(static_cast<int>(contents.size()),
+                base::WriteFile(path, contents.data(), contents.size()));
+    }
+    ASSERT_TRUE(base::CreateDirectory(source.AppendASCII("empty")));
+
+    zip_path_ = temp_dir_.path().AppendASCII("package.zip");
+    ASSERT_TRUE(zip::Zip(source, zip_path_, false));
+    target_path_ = temp_dir_.path().AppendASCII("target");
+  }
+
+  void ExpectExtracted() {
+    for (int i = 0; i < kNumFiles; ++i) {
+      std::string contents;
+      EXPECT_TRUE(base::ReadFileToString(
+          target_path_.AppendASCII(i % 2 ? "odd" : "even")
+              .AppendASCII(base::IntToString(i)),
+          &contents));
+      EXPECT_EQ(GetContents(i), contents);
+    }
+    EXPECT_TRUE(base::DirectoryExists(target_path_.AppendASCII("empty")));
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath zip_path_;
+  base::FilePath target_path_;
+};
+
+TEST_F(PackageExtractorTest, SingleThread) {
+  PackageExtractor extractor(zip_path_, target_path_);
+  extractor.set_max_threads(1);
+  EXPECT_TRUE(extractor.Extract());
+  ExpectExtracted();
+}
+
+TEST_F(PackageExtractorTest, SeveralThreads) {
+  int64_t written = 0;
+  int64_t total = 0;
+  PackageExtractor extractor(zip_path_, target_path_);
+  extractor.set_max_threads(4);
+  extractor.set_verify_callback(base::Bind(&VerifyResult, true));
+  extractor.set_progress_callback(
+      base::Bind(&RecordProgress, &written, &total));
+  EXPECT_TRUE(extractor.Extract());
+  ExpectExtracted();
+
+  int64_t expected_total = 0;
+  for (int i = 0; i < kNumFiles; ++i)
+    expected_total += GetContents(i).size();
+  EXPECT_EQ(expected_total, total);
+  EXPECT_EQ(expected_total, written);
+}
+
+TEST_F(PackageExtractorTest, FailedVerification) {
+  PackageExtractor extractor(zip_path_, target_path_);
+  extractor.set_max_threads(4);
+  extractor.set_verify_callback(base::Bind(&VerifyResult, false));
+  EXPECT_FALSE(extractor.Extract());
+}
+
+TEST_F(PackageExtractorTest, BadArchive) {
+  std::string garbage(1000, 'x');
+  ASSERT_EQ(static_cast<int>(garbage.size()),
+            base::WriteFile(zip_path_, garbage.data(), garbage.size()));
+  PackageExtractor extractor(zip_path_, target_path_);
+  EXPECT_FALSE(extractor.Extract());
+}
+
+}  // namespace application
+}  // namespace xwalk
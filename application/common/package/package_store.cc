@@ -0,0 +1,284 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_store.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/files/file.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/json/json_file_value_serializer.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "crypto/secure_hash.h"
+#include "crypto/sha2.h"
+#include "xwalk/application/common/application_file_util.h"
+#include "xwalk/application/common/package/package.h"
+
+namespace xwalk {
+namespace application {
+
+namespace {
+
+const base::FilePath::CharType kContentDirname[] =
+    FILE_PATH_LITERAL("content");
+const base::FilePath::CharType kInfoFilename[] =
+    FILE_PATH_LITERAL("info.json");
+const base::FilePath::CharType kTempDirPrefix[] = FILE_PATH_LITERAL(".tmp");
+
+const char kIdKey[] = "id";
+const char kManifestTypeKey[] = "manifest_type";
+const char kFilesKey[] = "files";
+const char kPackageHashKey[] = "package_hash";
+
+// Entries without description older than this were left by a crash.
+const int kStaleEntryHours = 24;
+
+bool HashFile(const base::FilePath& path, std::string* hash) {
+  base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_READ);
+  if (!file.IsValid())
+    return false;
+
+  std::unique_ptr<crypto::SecureHash> hasher(
+      crypto::SecureHash::Create(crypto::SecureHash::SHA256));
+  std::vector<char> buffer(1 << 16);
+  int len;
+  while ((len = file.ReadAtCurrentPos(&buffer.front(),
+                                      static_cast<int>(buffer.size()))) > 0)
+    hasher->Update(&buffer.front(), len);
+  if (len < 0)
+    return false;
+
+  uint8_t digest[crypto::kSHA256Length];
+  hasher->Finish(digest, sizeof(digest));
+  *hash = base::HexEncode(digest, sizeof(digest));
+  return true;
+}
+
+// Fills |hashes| with the hash of each file under |root|, keyed by their
+// path relative to |root|.
+bool HashTree(const base::FilePath& root, base::DictionaryValue* hashes) {
+  base::FileEnumerator enumerator(root, true, base::FileEnumerator::FILES);
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    base::FilePath relative_path;
+    std::string hash;
+    if (!root.AppendRelativePath(path, &relative_path) ||
+        !HashFile(path, &hash))
+      return false;
+    hashes->SetStringWithoutPathExpansion(relative_path.AsUTF8Unsafe(), hash);
+  }
+  return true;
+}
+
+}  // namespace
+
+PackageStore::PackageStore(const base::FilePath& root, size_t max_entries,
+                           bool check_integrity)
+    : root_(root),
+      max_entries_(max_entries),
+      check_integrity_(check_integrity) {
+  DCHECK_GT(max_entries_, 0u);
+}
+
+PackageStore::~PackageStore() {
+}
+
+bool PackageStore::Install(const base::FilePath& package_path, Entry* entry,
+                           std::vector<Entry>* evicted_entries) {
+  std::string package_hash;
+  if (!HashFile(package_path, &package_hash)) {
+    LOG(ERROR) << "Can't read the package " << package_path.AsUTF8Unsafe();
+    return false;
+  }
+
+  base::FilePath entry_path = FindEntry(package_hash);
+  if (!entry_path.empty() &&
+      ReadEntry(entry_path, check_integrity_, entry)) {
+    // The modification time of the description orders the entries for
+    // eviction.
+    base::Time now = base::Time::Now();
+    base::TouchFile(entry_path.Append(kInfoFilename), now, now);
+    return true;
+  }
+
+  // The package is new or updated, or its entry is damaged.
+  if (!AddEntry(package_path, package_hash, &entry_path))
+    return false;
+
+  EvictEntries(entry_path, evicted_entries);
+  return ReadEntry(entry_path, false, entry);
+}
+
+void PackageStore::Pin(const std::string& id) {
+  pinned_ids_.insert(id);
+}
+
+void PackageStore::Unpin(const std::string& id) {
+  pinned_ids_.erase(id);
+}
+
+base::FilePath PackageStore::FindEntry(const std::string& package_hash) const {
+  base::FileEnumerator enumerator(root_, false,
+                                  base::FileEnumerator::DIRECTORIES);
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    JSONFileValueDeserializer deserializer(path.Append(kInfoFilename));
+    std::unique_ptr<base::Value> value = deserializer.Deserialize(NULL, NULL);
+    base::DictionaryValue* info;
+    std::string id;
+    std::string hash;
+    // Entries being stored are not named after their package ID yet.
+    if (value && value->GetAsDictionary(&info) &&
+        info->GetString(kIdKey, &id) &&
+        info->GetString(kPackageHashKey, &hash) &&
+        hash == package_hash && path.BaseName().AsUTF8Unsafe() == id)
+      return path;
+  }
+  return base::FilePath();
+}
+
+bool PackageStore::ReadEntry(const base::FilePath& entry_path,
+                             bool check_integrity,
+                             Entry* entry) const {
+  JSONFileValueDeserializer deserializer(entry_path.Append(kInfoFilename));
+  std::unique_ptr<base::Value> value = deserializer.Deserialize(NULL, NULL);
+  base::DictionaryValue* info;
+  const base::DictionaryValue* files;
+  int manifest_type;
+  if (!value || !value->GetAsDictionary(&info) ||
+      !info->GetString(kIdKey, &entry->id) ||
+      !info->GetInteger(kManifestTypeKey, &manifest_type) ||
+      !info->GetDictionary(kFilesKey, &files))
+    return false;
+  if (manifest_type != Manifest::TYPE_MANIFEST &&
+      manifest_type != Manifest::TYPE_WIDGET)
+    return false;
+
+  base::FilePath content_path = entry_path.Append(kContentDirname);
+  if (!base::DirectoryExists(content_path))
+    return false;
+
+  if (check_integrity) {
+    base::DictionaryValue hashes;
+    if (!HashTree(content_path, &hashes) || !hashes.Equals(files)) {
+      LOG(WARNING) << "The stored package " << entry_path.AsUTF8Unsafe()
+                   << " was modified.";
+      return false;
+    }
+  }
+
+  entry->path = content_path;
+  entry->manifest_type = static_cast<Manifest::Type>(manifest_type);
+  return true;
+}
+
+bool PackageStore::AddEntry(const base::FilePath& package_path,
+                            const std::string& package_hash,
+                            base::FilePath* entry_path) {
+  // The package is extracted aside and moved in place once complete, so an
+  // interrupted extraction never looks like a valid entry.
+  base::FilePath temp_path;
+  if (!base::CreateDirectory(root_) ||
+      !base::CreateTemporaryDirInDir(root_, kTempDirPrefix, &temp_path))
+    return false;
+  FileDeleter deleter(temp_path, true);
+
+  std::unique_ptr<Package> package = Package::Create(package_path);
+  if (!package || !package->IsValid()) {
+    LOG(ERROR) << "Failed to obtain valid package from "
+               << package_path.AsUTF8Unsafe();
+    return false;
+  }
+  if (pinned_ids_.count(package->Id())) {
+    LOG(ERROR) << "Can't replace the stored package " << package->Id()
+               << " while its application is running.";
+    return false;
+  }
+
+  base::FilePath content_path = temp_path.Append(kContentDirname);
+  if (!base::CreateDirectory(content_path) ||
+      !package->ExtractTo(content_path)) {
+    LOG(ERROR) << "Failed to unpack " << package_path.AsUTF8Unsafe();
+    return false;
+  }
+
+  std::unique_ptr<base::DictionaryValue> files(new base::DictionaryValue);
+  if (!HashTree(content_path, files.get()))
+    return false;
+
+  base::DictionaryValue info;
+  info.SetString(kIdKey, package->Id());
+  info.SetInteger(kManifestTypeKey, package->manifest_type());
+  info.SetString(kPackageHashKey, package_hash);
+  info.Set(kFilesKey, std::move(files));
+  JSONFileValueSerializer serializer(temp_path.Append(kInfoFilename));
+  if (!serializer.Serialize(info))
+    return false;
+
+  // An updated package replaces the tree of the previous version.
+  *entry_path = root_.AppendASCII(package->Id());
+  base::DeleteFile(*entry_path, true);
+  // Another launch of the same package may have stored it in the meantime.
+  if (!base::Move(temp_path, *entry_path))
+    return base::PathExists(entry_path->Append(kInfoFilename));
+
+  deleter.Dismiss();
+  return true;
+}
+
+void PackageStore::EvictEntries(const base::FilePath& keep_path,
+                                std::vector<Entry>* evicted_entries) {
+  base::Time stale_time =
+      base::Time::Now() - base::TimeDelta::FromHours(kStaleEntryHours);
+  std::vector<std::pair<base::Time, base::FilePath>> entries;
+  // Counts |keep_path| and the pinned entries too.
+  size_t entry_count = 1;
+
+  base::FileEnumerator enumerator(root_, false,
+                                  base::FileEnumerator::DIRECTORIES);
+  for (base::FilePath path = enumerator.Next(); !path.empty();
+       path = enumerator.Next()) {
+    if (path == keep_path)
+      continue;
+
+    base::File::Info info;
+    if (!base::GetFileInfo(path.Append(kInfoFilename), &info)) {
+      // Either being stored right now, or left by a crash.
+      if (enumerator.GetInfo().GetLastModifiedTime() < stale_time)
+        base::DeleteFile(path, true);
+      continue;
+    }
+    ++entry_count;
+    if (!pinned_ids_.count(path.BaseName().AsUTF8Unsafe()))
+      entries.push_back(std::make_pair(info.last_modified, path));
+  }
+
+  if (entry_count <= max_entries_)
+    return;
+
+  std::sort(entries.begin(), entries.end());
+  size_t excess = std::min(entry_count - max_entries_, entries.size());
+  for (size_t i = 0; i < excess; ++i) {
+    const base::FilePath& path = entries[i].second;
+    VLOG(1) << "Evicting the stored package " << path.AsUTF8Unsafe();
+    // Only an entry named after its package ID holds the tree its
+    // application was launched from.
+    Entry entry;
+    bool owns_data = ReadEntry(path, false, &entry) &&
+                     path.BaseName().AsUTF8Unsafe() == entry.id;
+    base::DeleteFile(path, true);
+    if (owns_data && evicted_entries)
+      evicted_entries->push_back(entry);
+  }
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -0,0 +1,84 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_STORE_H_
+#define XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_STORE_H_
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "xwalk/application/common/manifest.h"
+
+namespace xwalk {
+namespace application {
+
+// Keeps the extracted content of the packages that have been launched, so
+// launching an unchanged package again does not extract it again.
+//
+// The entries are keyed by the package ID, so an updated package replaces the
+// tree of the previous version at the same path, and the application keeps
+// its ID and data. Each entry is a directory under the store root holding the
+// extracted tree and a description of it, written once the package has been
+// extracted and verified. The description records the SHA-256 of the package
+// file, which tells whether a package is unchanged. The least recently
+// launched entries which are not pinned are removed when there are more than
+// |max_entries| of them.
+//
+// When |check_integrity| is set, the extracted files are compared with the
+// hashes recorded when the package was stored before the entry is used, and
+// the package is extracted again if anything changed.
+class PackageStore {
+ public:
+  struct Entry {
+    // Root of the extracted package.
+    base::FilePath path;
+    std::string id;
+    Manifest::Type manifest_type;
+  };
+
+  PackageStore(const base::FilePath& root, size_t max_entries,
+               bool check_integrity);
+  ~PackageStore();
+
+  // Returns the stored entry for the package at |package_path|, extracting
+  // it into the store first if needed. Returns false if the package is not
+  // valid or could not be stored, or if it changed while its entry is
+  // pinned. The entries evicted to make room are appended to
+  // |evicted_entries|, so the caller can remove the data of their
+  // applications; their paths no longer exist.
+  bool Install(const base::FilePath& package_path, Entry* entry,
+               std::vector<Entry>* evicted_entries);
+
+  // A pinned entry is neither evicted nor replaced, e.g. while its
+  // application is running.
+  void Pin(const std::string& id);
+  void Unpin(const std::string& id);
+
+ private:
+  // Returns the path of the entry stored from the package with the hash
+  // |package_hash|, or an empty path.
+  base::FilePath FindEntry(const std::string& package_hash) const;
+  bool ReadEntry(const base::FilePath& entry_path, bool check_integrity,
+                 Entry* entry) const;
+  bool AddEntry(const base::FilePath& package_path,
+                const std::string& package_hash,
+                base::FilePath* entry_path);
+  void EvictEntries(const base::FilePath& keep_path,
+                    std::vector<Entry>* evicted_entries);
+
+  base::FilePath root_;
+  size_t max_entries_;
+  bool check_integrity_;
+  std::set<std::string> pinned_ids_;
+
+  DISALLOW_COPY_AND_ASSIGN(PackageStore);
+};
+
+}  // namespace application
+}  // namespace xwalk
+
+#endif  // XWALK_APPLICATION_COMMON_PACKAGE_PACKAGE_STORE_H_
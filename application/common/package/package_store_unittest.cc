@@ -0,0 +1,210 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/common/package/package_store.h"
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/path_service.h"
+#include "base/strings/stringprintf.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/zlib/google/zip.h"
+
+namespace xwalk {
+namespace application {
+
+class PackageStoreTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    store_path_ = temp_dir_.path().AppendASCII("store");
+  }
+
+  base::FilePath GetTestPackage(const std::string& name) {
+    base::FilePath path;
+    PathService::Get(base::DIR_SOURCE_ROOT, &path);
+    return path.AppendASCII("xwalk")
+        .AppendASCII("application")
+        .AppendASCII("test")
+        .AppendASCII("unpacker")
+        .AppendASCII(name);
+  }
+
+  // Creates a widget package with the given id and version.
+  base::FilePath CreateWidget(const std::string& id,
+                              const std::string& version) {
+    std::string name = id + "-" + version;
+    base::FilePath source = temp_dir_.path().AppendASCII(name);
+    EXPECT_TRUE(base::CreateDirectory(source));
+    std::string config = base::StringPrintf(
+        "<widget xmlns=\"http://www.w3.org/ns/widgets\" id=\"%s\""
+        " version=\"%s\">\n"
+        "  <content src=\"index.html\"/>\n"
+        "</widget>\n", id.c_str(), version.c_str());
+    EXPECT_EQ(static_cast<int>(config.size()),
+              base::WriteFile(source.AppendASCII("config.xml"),
+                              config.data(), config.size()));
+    base::FilePath package = temp_dir_.path().AppendASCII(name + ".wgt");
+    EXPECT_TRUE(zip::Zip(source, package, false));
+    return package;
+  }
+
+  int CountEntries() {
+    base::FileEnumerator enumerator(store_path_, false,
+                                    base::FileEnumerator::DIRECTORIES);
+    int count = 0;
+    while (!enumerator.Next().empty())
+      ++count;
+    return count;
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath store_path_;
+};
+
+TEST_F(PackageStoreTest, ReusesExtractedPackage) {
+  PackageStore store(store_path_, 4, false);
+  PackageStore::Entry entry;
+  ASSERT_TRUE(store.Install(GetTestPackage("good.xpk"), &entry, NULL));
+  EXPECT_TRUE(base::PathExists(entry.path.AppendASCII("manifest.json")));
+  EXPECT_EQ(Manifest::TYPE_MANIFEST, entry.manifest_type);
+  EXPECT_FALSE(entry.id.empty());
+
+  // Files left in the tree show it was not extracted again.
+  base::FilePath marker = entry.path.AppendASCII("marker");
+  ASSERT_EQ(0, base::WriteFile(marker, "", 0));
+
+  PackageStore::Entry second_entry;
+  ASSERT_TRUE(store.Install(GetTestPackage("good.xpk"), &second_entry, NULL));
+  EXPECT_EQ(entry.path, second_entry.path);
+  EXPECT_EQ(entry.id, second_entry.id);
+  EXPECT_TRUE(base::PathExists(marker));
+  EXPECT_EQ(1, CountEntries());
+}
+
+TEST_F(PackageStoreTest, IntegrityCheckRestoresModifiedPackage) {
+  PackageStore::Entry entry;
+  {
+    PackageStore store(store_path_, 4, false);
+    ASSERT_TRUE(store.Install(GetTestPackage("good.xpk"), &entry, NULL));
+  }
+  base::FilePath manifest = entry.path.AppendASCII("manifest.json");
+  std::string original;
+  ASSERT_TRUE(base::ReadFileToString(manifest, &original));
+  ASSERT_EQ(3, base::WriteFile(manifest, "{ }", 3));
+
+  PackageStore store(store_path_, 4, true);
+  ASSERT_TRUE(store.Install(GetTestPackage("good.xpk"), &entry, NULL));
+  std::string restored;
+  ASSERT_TRUE(base::ReadFileToString(manifest, &restored));
+  EXPECT_EQ(original, restored);
+}
+
+TEST_F(PackageStoreTest, EvictsLeastRecentlyUsed) {
+  base::FilePath first = CreateWidget("first", "1.0");
+  base::FilePath second = CreateWidget("second", "1.0");
+  base::FilePath third = CreateWidget("third", "1.0");
+
+  PackageStore store(store_path_, 2, false);
+  PackageStore::Entry first_entry;
+  PackageStore::Entry second_entry;
+  PackageStore::Entry third_entry;
+  ASSERT_TRUE(store.Install(first, &first_entry, NULL));
+  EXPECT_EQ(Manifest::TYPE_WIDGET, first_entry.manifest_type);
+  ASSERT_TRUE(store.Install(second, &second_entry, NULL));
+
+  // Make |first| the most recently used entry.
+  base::Time past = base::Time::Now() - base::TimeDelta::FromHours(1);
+  ASSERT_TRUE(base::TouchFile(second_entry.path.DirName().AppendASCII(
+      "info.json"), past, past));
+  std::vector<PackageStore::Entry> evicted_entries;
+  ASSERT_TRUE(store.Install(first, &first_entry, &evicted_entries));
+  EXPECT_TRUE(evicted_entries.empty());
+
+  ASSERT_TRUE(store.Install(third, &third_entry, &evicted_entries));
+  EXPECT_EQ(2, CountEntries());
+  EXPECT_TRUE(base::DirectoryExists(first_entry.path));
+  EXPECT_FALSE(base::DirectoryExists(second_entry.path));
+  EXPECT_TRUE(base::DirectoryExists(third_entry.path));
+  ASSERT_EQ(1u, evicted_entries.size());
+  EXPECT_EQ(second_entry.id, evicted_entries[0].id);
+}
+
+TEST_F(PackageStoreTest, PinnedEntriesAreNotEvicted) {
+  PackageStore store(store_path_, 1, false);
+  PackageStore::Entry first_entry;
+  PackageStore::Entry second_entry;
+  std::vector<PackageStore::Entry> evicted_entries;
+  ASSERT_TRUE(store.Install(CreateWidget("first", "1.0"), &first_entry,
+                            NULL));
+  store.Pin(first_entry.id);
+  ASSERT_TRUE(store.Install(CreateWidget("second", "1.0"), &second_entry,
+                            &evicted_entries));
+  EXPECT_TRUE(evicted_entries.empty());
+  EXPECT_TRUE(base::DirectoryExists(first_entry.path));
+  EXPECT_TRUE(base::DirectoryExists(second_entry.path));
+
+  store.Unpin(first_entry.id);
+  ASSERT_TRUE(store.Install(CreateWidget("third", "1.0"), &second_entry,
+                            &evicted_entries));
+  EXPECT_FALSE(base::DirectoryExists(first_entry.path));
+  EXPECT_EQ(1, CountEntries());
+  ASSERT_EQ(2u, evicted_entries.size());
+}
+
+TEST_F(PackageStoreTest, UpdateReplacesEntry) {
+  PackageStore store(store_path_, 4, false);
+  PackageStore::Entry entry;
+  ASSERT_TRUE(store.Install(CreateWidget("app", "1.0"), &entry, NULL));
+
+  // The updated package keeps the ID and path of the previous version.
+  PackageStore::Entry updated_entry;
+  std::vector<PackageStore::Entry> evicted_entries;
+  ASSERT_TRUE(store.Install(CreateWidget("app", "2.0"), &updated_entry,
+                            &evicted_entries));
+  EXPECT_EQ(entry.id, updated_entry.id);
+  EXPECT_EQ(entry.path, updated_entry.path);
+  EXPECT_TRUE(evicted_entries.empty());
+  EXPECT_EQ(1, CountEntries());
+  std::string config;
+  ASSERT_TRUE(base::ReadFileToString(
+      updated_entry.path.AppendASCII("config.xml"), &config));
+  EXPECT_NE(std::string::npos, config.find("2.0"));
+}
+
+TEST_F(PackageStoreTest, PinnedEntriesAreNotReplaced) {
+  PackageStore store(store_path_, 4, false);
+  base::FilePath package = CreateWidget("app", "1.0");
+  PackageStore::Entry entry;
+  ASSERT_TRUE(store.Install(package, &entry, NULL));
+  store.Pin(entry.id);
+
+  PackageStore::Entry updated_entry;
+  EXPECT_FALSE(store.Install(CreateWidget("app", "2.0"), &updated_entry,
+                             NULL));
+  std::string config;
+  ASSERT_TRUE(base::ReadFileToString(entry.path.AppendASCII("config.xml"),
+                                     &config));
+  EXPECT_NE(std::string::npos, config.find("1.0"));
+
+  // The unchanged package can still be launched again.
+  EXPECT_TRUE(store.Install(package, &updated_entry, NULL));
+  EXPECT_EQ(entry.path, updated_entry.path);
+}
+
+TEST_F(PackageStoreTest, InvalidPackage) {
+  PackageStore store(store_path_, 4, false);
+  PackageStore::Entry entry;
+  EXPECT_FALSE(store.Install(GetTestPackage("bad_signature.xpk"), &entry,
+                             NULL));
+  EXPECT_FALSE(store.Install(GetTestPackage("bad_zip.xpk"), &entry, NULL));
+  EXPECT_EQ(0, CountEntries());
+}
+
+}  // namespace application
+}  // namespace xwalk
@@ -54,6 +54,14 @@ TEST_F(PackageTest, BadSignature) {
   EXPECT_FALSE(package_->ExtractToTemporaryDir(&path));
 }
 
+TEST_F(PackageTest, BadSignatureLeavesTargetEmpty) {
+  SetupPackage("bad_signature.xpk");
+  ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  EXPECT_FALSE(package_->ExtractTo(temp_dir_.path()));
+  EXPECT_TRUE(base::IsDirectoryEmpty(temp_dir_.path()));
+  EXPECT_FALSE(package_->IsValid());
+}
+
 TEST_F(PackageTest, NoMagicHeader) {
   SetupPackage("no_magic_header.xpk");
   base::FilePath path;
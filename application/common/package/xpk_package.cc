@@ -57,15 +57,18 @@ XPKPackage::XPKPackage(const base::FilePath& path)
     if (len < header_.signature_size)
       is_valid_ = false;
 
-    if (!VerifySignature())
-      is_valid_ = false;
-
     std::string public_key =
         std::string(reinterpret_cast<char*>(&key_.front()), key_.size());
     id_ = GenerateId(public_key);
   }
 }
 
+bool XPKPackage::Verify() {
+  if (!is_valid_ || !VerifySignature())
+    is_valid_ = false;
+  return is_valid_;
+}
+
 bool XPKPackage::VerifySignature() {
 // Set the file read position to the beginning of compressed resource file,
 // which is behind the magic header, public key and signature key.
@@ -78,10 +81,11 @@ bool XPKPackage::VerifySignature() {
                            &key_.front(),
                            base::checked_cast<int>(key_.size())))
     return false;
-  unsigned char buf[1 << 12];
+  // Read in large chunks, the archive is decompressed at the same time.
+  std::vector<uint8_t> buf(1 << 16);
   size_t len = 0;
-  while ((len = fread(buf, 1, sizeof(buf), file_->get())) > 0)
-    verifier.VerifyUpdate(buf, base::checked_cast<int>(len));
+  while ((len = fread(&buf.front(), 1, buf.size(), file_->get())) > 0)
+    verifier.VerifyUpdate(&buf.front(), base::checked_cast<int>(len));
   if (!verifier.VerifyFinal())
     return false;
 
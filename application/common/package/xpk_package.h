@@ -29,6 +29,11 @@ class XPKPackage : public Package {
   explicit XPKPackage(const base::FilePath& path);
   bool ExtractToTemporaryDir(base::FilePath* target_path) override;
 
+ protected:
+  // The signature is checked while the package is extracted, so IsValid()
+  // only reflects the header until then.
+  bool Verify() override;
+
  private:
   // verify the signature in the xpk package
   virtual bool VerifySignature();
@@ -8,6 +8,8 @@
 #include <map>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/callback.h"
 
@@ -34,6 +36,9 @@ enum RuntimePermission {
 
 typedef base::Callback<void(RuntimePermission)> PermissionCallback;
 
+typedef std::vector<std::pair<std::string, RuntimePermission>>
+    PermissionSnapshot;
+
 enum StoredPermission {
   ALLOW = 0,
   DENY,
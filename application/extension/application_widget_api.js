@@ -39,62 +39,105 @@ function defineReadOnlyProperty(object, key, value) {
   });
 }
 
+// The preferences are fetched once and kept in |_items|. Reads never leave
+// the renderer; writes are applied locally and sent asynchronously to the
+// browser, which persists them and notifies the other frames.
 var WidgetStorage = function() {
-  var _SetItem = function(itemKey, itemValue) {
-    var result = extension.internal.sendSyncMessage({
-        cmd: 'SetPreferencesItem',
-        preferencesItemKey: String(itemKey),
-        preferencesItemValue: String(itemValue) });
+  var _self = this;
+  var _items = {};
+  var _readOnly = {};
 
-    if (result) {
-      return itemValue;
-    } else {
-      throw new common.CustomDOMException(
+  var _ThrowNoModificationAllowed = function() {
+    throw new common.CustomDOMException(
         common.CustomDOMException.NO_MODIFICATION_ALLOWED_ERR,
         'The object can not be modified.');
-    }
   }
 
-  var _GetSetter = function(itemKey) {
-    var _itemKey = itemKey;
-    return function(itemValue) {
-      return _SetItem(_itemKey, itemValue);
+  var _DefineAccessors = function(itemKey) {
+    if (_self.__lookupGetter__(itemKey))
+      return;
+    _self.__defineSetter__(itemKey, function(itemValue) {
+      return _SetItem(itemKey, itemValue);
+    });
+    _self.__defineGetter__(itemKey, function() {
+      return _self.getItem(itemKey);
+    });
+  }
+
+  var _SetItem = function(itemKey, itemValue) {
+    itemKey = String(itemKey);
+    itemValue = String(itemValue);
+    if (_readOnly.hasOwnProperty(itemKey))
+      _ThrowNoModificationAllowed();
+
+    if (_items[itemKey] !== itemValue) {
+      _items[itemKey] = itemValue;
+      _DefineAccessors(itemKey);
+      extension.postMessage({
+          cmd: 'SetPreferencesItem',
+          preferencesItemKey: itemKey,
+          preferencesItemValue: itemValue });
     }
+    return itemValue;
   }
 
-  var _GetGetter = function(itemKey) {
-    var _itemKey = itemKey;
-    return function() {
-      var result = extension.internal.sendSyncMessage(
-          { cmd: 'GetItemValueByKey',
-            preferencesItemKey: String(itemKey) });
-      return result == empty ? null : result;
+  var _DispatchStorageEvent = function(msg) {
+    if (!window.eventListenerList)
+      return;
+
+    var event = {
+      key: msg.key,
+      oldValue: msg.oldValue == empty ? null : msg.oldValue,
+      newValue: msg.newValue == empty ? null : msg.newValue,
+      url: window.location.href,
+      storageArea: _self
+    };
+    for (var key in event) {
+      Object.defineProperty(event, key, {
+        value: event[key],
+        writable: false
+      });
     }
+    for (var i = 0; i < window.eventListenerList.length; i++)
+      window.eventListenerList[i](event);
   }
 
-  this.init = function() {
-    var result = extension.internal.sendSyncMessage({cmd: 'GetAllItems'});
-    for (var itemKey in result) {
-      this.__defineSetter__(String(itemKey), _GetSetter(itemKey));
-      this.__defineGetter__(String(itemKey), _GetGetter(itemKey));
+  // Changes made from other frames.
+  extension.setMessageListener(function(msg) {
+    if (msg.cmd != 'PreferencesChanged')
+      return;
+
+    if (msg.newValue == empty) {
+      delete _items[msg.key];
+    } else {
+      _items[msg.key] = msg.newValue;
+      _DefineAccessors(msg.key);
     }
+    _DispatchStorageEvent(msg);
+  });
+
+  this.init = function() {
+    var snapshot = extension.internal.sendSyncMessage(
+        {cmd: 'GetPreferencesSnapshot'});
+    _items = snapshot.items || {};
+    var readOnly = snapshot.readOnly || [];
+    for (var i = 0; i < readOnly.length; i++)
+      _readOnly[readOnly[i]] = true;
+    for (var itemKey in _items)
+      _DefineAccessors(itemKey);
   }
 
   this.__defineGetter__('length', function() {
-    var result = extension.internal.sendSyncMessage({cmd: 'GetAllItems'});
-    return Object.keys(result).length;
+    return Object.keys(_items).length;
   });
 
   this.key = function(index) {
-    var result = extension.internal.sendSyncMessage({ cmd: 'GetAllItems'});
-    return Object.keys(result)[index];
+    return Object.keys(_items)[index];
   }
 
   this.getItem = function(itemKey) {
-    var result = extension.internal.sendSyncMessage({
-        cmd: 'GetItemValueByKey',
-        preferencesItemKey: String(itemKey)});
-    return result == empty ? null : result;
+    itemKey = String(itemKey);
+    return _items.hasOwnProperty(itemKey) ? _items[itemKey] : null;
   }
 
   this.setItem = function(itemKey, itemValue) {
@@ -102,19 +145,25 @@ var WidgetStorage = function() {
   }
 
   this.removeItem = function(itemKey) {
-    var result = extension.internal.sendSyncMessage({
-        cmd: 'RemovePreferencesItem',
-        preferencesItemKey: String(itemKey)});
+    itemKey = String(itemKey);
+    if (_readOnly.hasOwnProperty(itemKey))
+      _ThrowNoModificationAllowed();
 
-    if (!result) {
-      throw new common.CustomDOMException(
-          common.CustomDOMException.NO_MODIFICATION_ALLOWED_ERR,
-          'The object can not be modified.');
-    }
+    if (!_items.hasOwnProperty(itemKey))
+      return;
+
+    delete _items[itemKey];
+    extension.postMessage({
+        cmd: 'RemovePreferencesItem',
+        preferencesItemKey: itemKey});
   }
 
   this.clear = function() {
-    extension.internal.sendSyncMessage({cmd: 'ClearAllItems'});
+    for (var itemKey in _items) {
+      if (!_readOnly.hasOwnProperty(itemKey))
+        delete _items[itemKey];
+    }
+    extension.postMessage({cmd: 'ClearAllItems'});
   }
 
   this.init();
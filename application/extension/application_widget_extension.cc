@@ -8,20 +8,18 @@
 
 #include "base/bind.h"
 #include "base/path_service.h"
-#include "base/strings/stringprintf.h"
 #include "base/strings/string_util.h"
-#include "base/strings/utf_string_conversions.h"
+#include "base/threading/thread_restrictions.h"
 #include "content/public/browser/browser_thread.h"
-#include "content/public/browser/render_frame_host.h"
 #include "content/public/browser/render_process_host.h"
 #include "content/public/browser/storage_partition.h"
-#include "content/public/browser/web_contents.h"
 #include "ipc/ipc_message.h"
 #include "grit/xwalk_application_resources.h"
 #include "ui/base/resource/resource_bundle.h"
 #include "xwalk/application/browser/application.h"
 #include "xwalk/application/common/application_data.h"
 #include "xwalk/application/common/application_manifest_constants.h"
+#include "xwalk/application/common/constants.h"
 #include "xwalk/application/common/manifest_handlers/widget_handler.h"
 #include "xwalk/application/extension/application_widget_storage.h"
 #include "xwalk/runtime/browser/runtime.h"
@@ -38,42 +36,9 @@ const char kWidgetAttributeKey[] = "widgetKey";
 const char kPreferencesItemKey[] = "preferencesItemKey";
 const char kPreferencesItemValue[] = "preferencesItemValue";
 
-void DispatchStorageEvent(
-    base::DictionaryValue* msg,
-    content::WebContents* web_contents,
-    content::RenderFrameHost* frame) {
-  if (frame == web_contents->GetFocusedFrame())
-    return;
-
-  std::string key, oldValue, newValue;
-  msg->GetString("key", &key);
-  msg->GetString("oldValue", &oldValue);
-  msg->GetString("newValue", &newValue);
-
-  std::string code = base::StringPrintf(
-      "(function() {"
-      "  var old_value = '%s' == '' ? null : '%s';"
-      "  var new_value = '%s' == '' ? null : '%s';"
-      "  var event = {"
-      "    key: '%s',"
-      "    oldValue: old_value,"
-      "    newValue: new_value,"
-      "    url: window.location.href,"
-      "    storageArea: widget.preferences"
-      "  };"
-      "  for (var key in event) {"
-      "    Object.defineProperty(event, key, {"
-      "      value: event[key],"
-      "      writable: false"
-      "    });"
-      "  }"
-      "  for (var i = 0; i < window.eventListenerList.length; i++)"
-      "    window.eventListenerList[i](event);"
-      "})();", oldValue.c_str(), oldValue.c_str(),
-      newValue.c_str(), newValue.c_str(), key.c_str());
-
-  frame->ExecuteJavaScript(base::UTF8ToUTF16(code));
-}
+const char kPreferencesChangedCommand[] = "PreferencesChanged";
+const char kSnapshotItemsKey[] = "items";
+const char kSnapshotReadOnlyKey[] = "readOnly";
 
 }  // namespace
 
@@ -95,37 +60,117 @@ ApplicationWidgetExtension::ApplicationWidgetExtension(
       IDR_XWALK_APPLICATION_WIDGET_API).as_string());
 }
 
+ApplicationWidgetExtension::~ApplicationWidgetExtension() {
+  DCHECK(instances_.empty());
+}
+
 XWalkExtensionInstance* ApplicationWidgetExtension::CreateInstance() {
-  return new AppWidgetExtensionInstance(application_);
+  return new AppWidgetExtensionInstance(this, application_);
 }
 
-AppWidgetExtensionInstance::AppWidgetExtensionInstance(
-    Application* application)
-  : application_(application) {
-  DCHECK(application_);
+AppWidgetStorage* ApplicationWidgetExtension::GetStorage() {
+  if (widget_storage_)
+    return widget_storage_.get();
+
   base::ThreadRestrictions::SetIOAllowed(true);
 
   content::RenderProcessHost* rph =
-      content::RenderProcessHost::FromID(application->GetRenderProcessHostID());
+      content::RenderProcessHost::FromID(application_->GetRenderProcessHostID());
   CHECK(rph);
   content::StoragePartition* partition = rph->GetStoragePartition();
   CHECK(partition);
-  base::FilePath path = partition->GetPath().Append(
-      FILE_PATH_LITERAL("WidgetStorage"));
+  base::FilePath path = partition->GetPath().Append(kWidgetStorageDirname);
   widget_storage_.reset(new AppWidgetStorage(application_, path));
+  return widget_storage_.get();
 }
 
-AppWidgetExtensionInstance::~AppWidgetExtensionInstance() {}
+void ApplicationWidgetExtension::AddInstance(
+    AppWidgetExtensionInstance* instance) {
+  instances_.insert(instance);
+}
 
-void AppWidgetExtensionInstance::HandleMessage(std::unique_ptr<base::Value> msg) {
+void ApplicationWidgetExtension::RemoveInstance(
+    AppWidgetExtensionInstance* instance) {
+  instances_.erase(instance);
 }
 
-void AppWidgetExtensionInstance::HandleSyncMessage(
+void ApplicationWidgetExtension::BroadcastChange(
+    AppWidgetExtensionInstance* source,
+    const std::string& key,
+    const std::string& old_value,
+    const std::string& new_value) {
+  std::set<AppWidgetExtensionInstance*>::iterator it;
+  for (it = instances_.begin(); it != instances_.end(); ++it) {
+    if (*it == source)
+      continue;
+
+    std::unique_ptr<base::DictionaryValue> event(new base::DictionaryValue());
+    event->SetString(kCommandKey, kPreferencesChangedCommand);
+    event->SetString("key", key);
+    event->SetString("oldValue", old_value);
+    event->SetString("newValue", new_value);
+    (*it)->PostMessageToJS(std::move(event));
+  }
+}
+
+AppWidgetExtensionInstance::AppWidgetExtensionInstance(
+    ApplicationWidgetExtension* extension,
+    Application* application)
+  : extension_(extension),
+    application_(application) {
+  DCHECK(extension_);
+  DCHECK(application_);
+  // Open the storage eagerly so that the renderer's first snapshot request
+  // does not have to wait for the database.
+  extension_->GetStorage();
+  extension_->AddInstance(this);
+}
+
+AppWidgetExtensionInstance::~AppWidgetExtensionInstance() {
+  extension_->RemoveInstance(this);
+}
+
+void AppWidgetExtensionInstance::HandleMessage(
     std::unique_ptr<base::Value> msg) {
+  static const struct {
+    const char* command;
+    Handler handler;
+  } kHandlers[] = {
+    { "SetPreferencesItem", &AppWidgetExtensionInstance::SetPreferencesItem },
+    { "RemovePreferencesItem",
+      &AppWidgetExtensionInstance::RemovePreferencesItem },
+    { "ClearAllItems", &AppWidgetExtensionInstance::ClearAllItems },
+  };
+
   base::DictionaryValue* dict;
   std::string command;
-  msg->GetAsDictionary(&dict);
+  if (!msg->GetAsDictionary(&dict) || !dict->GetString(kCommandKey, &command)) {
+    LOG(ERROR) << "Fail to handle command message.";
+    return;
+  }
+
+  for (size_t i = 0; i < arraysize(kHandlers); ++i) {
+    if (command == kHandlers[i].command) {
+      (this->*kHandlers[i].handler)(*dict);
+      return;
+    }
+  }
+  LOG(ERROR) << command << " ASSERT NOT REACHED.";
+}
+
+void AppWidgetExtensionInstance::HandleSyncMessage(
+    std::unique_ptr<base::Value> msg) {
+  static const struct {
+    const char* command;
+    SyncHandler handler;
+  } kSyncHandlers[] = {
+    { "GetWidgetInfo", &AppWidgetExtensionInstance::GetWidgetInfo },
+    { "GetPreferencesSnapshot",
+      &AppWidgetExtensionInstance::GetPreferencesSnapshot },
+  };
 
+  base::DictionaryValue* dict;
+  std::string command;
   if (!msg->GetAsDictionary(&dict) || !dict->GetString(kCommandKey, &command)) {
     LOG(ERROR) << "Fail to handle command sync message.";
     SendSyncReplyToJS(std::unique_ptr<base::Value>(new base::StringValue("")));
@@ -133,38 +178,27 @@ void AppWidgetExtensionInstance::HandleSyncMessage(
   }
 
   std::unique_ptr<base::Value> result(new base::StringValue(""));
-  if (command == "GetWidgetInfo") {
-    result = GetWidgetInfo(std::move(msg));
-  } else if (command == "SetPreferencesItem") {
-    result = SetPreferencesItem(std::move(msg));
-  } else if (command == "RemovePreferencesItem") {
-    result = RemovePreferencesItem(std::move(msg));
-  } else if (command == "ClearAllItems") {
-    result = ClearAllItems(std::move(msg));
-  } else if (command == "GetAllItems") {
-    result = GetAllItems(std::move(msg));
-  } else if (command == "GetItemValueByKey") {
-    result = GetItemValueByKey(std::move(msg));
-  } else if (command == "KeyExists") {
-    result = KeyExists(std::move(msg));
-  } else {
-    LOG(ERROR) << command << " ASSERT NOT REACHED.";
+  size_t i = 0;
+  for (; i < arraysize(kSyncHandlers); ++i) {
+    if (command == kSyncHandlers[i].command) {
+      result = (this->*kSyncHandlers[i].handler)(*dict);
+      break;
+    }
   }
+  if (i == arraysize(kSyncHandlers))
+    LOG(ERROR) << command << " ASSERT NOT REACHED.";
 
   SendSyncReplyToJS(std::move(result));
 }
 
-std::unique_ptr<base::StringValue> AppWidgetExtensionInstance::GetWidgetInfo(
-    std::unique_ptr<base::Value> msg) {
-  std::unique_ptr<base::StringValue> result(new base::StringValue(""));
+std::unique_ptr<base::Value> AppWidgetExtensionInstance::GetWidgetInfo(
+    const base::DictionaryValue& msg) {
   std::string key;
   std::string value;
-  base::DictionaryValue* dict;
 
-  if (!msg->GetAsDictionary(&dict) ||
-      !dict->GetString(kWidgetAttributeKey, &key)) {
+  if (!msg.GetString(kWidgetAttributeKey, &key)) {
     LOG(ERROR) << "Fail to get widget attribute key.";
-    return result;
+    return std::unique_ptr<base::Value>(new base::StringValue(""));
   }
 
   WidgetInfo* info =
@@ -172,162 +206,84 @@ std::unique_ptr<base::StringValue> AppWidgetExtensionInstance::GetWidgetInfo(
       application_->data()->GetManifestData(widget_keys::kWidgetKey));
   base::DictionaryValue* widget_info = info->GetWidgetInfo();
   widget_info->GetString(key, &value);
-  result.reset(new base::StringValue(value));
-  return result;
+  return std::unique_ptr<base::Value>(new base::StringValue(value));
+}
+
+std::unique_ptr<base::Value>
+AppWidgetExtensionInstance::GetPreferencesSnapshot(
+    const base::DictionaryValue& msg) {
+  AppWidgetStorage* storage = extension_->GetStorage();
+
+  std::unique_ptr<base::DictionaryValue> items(new base::DictionaryValue());
+  storage->GetAllEntries(items.get());
+  std::unique_ptr<base::ListValue> read_only(new base::ListValue());
+  storage->GetReadOnlyKeys(read_only.get());
+
+  std::unique_ptr<base::DictionaryValue> result(new base::DictionaryValue());
+  result->Set(kSnapshotItemsKey, std::move(items));
+  result->Set(kSnapshotReadOnlyKey, std::move(read_only));
+  return std::move(result);
 }
 
-std::unique_ptr<base::FundamentalValue>
-AppWidgetExtensionInstance::SetPreferencesItem(std::unique_ptr<base::Value> msg) {
-  std::unique_ptr<base::FundamentalValue> result(
-      new base::FundamentalValue(false));
+void AppWidgetExtensionInstance::SetPreferencesItem(
+    const base::DictionaryValue& msg) {
   std::string key;
   std::string value;
-  base::DictionaryValue* dict;
 
-  if (!msg->GetAsDictionary(&dict) ||
-      !dict->GetString(kPreferencesItemKey, &key) ||
-      !dict->GetString(kPreferencesItemValue, &value)) {
+  if (!msg.GetString(kPreferencesItemKey, &key) ||
+      !msg.GetString(kPreferencesItemValue, &value)) {
     LOG(ERROR) << "Fail to set preferences item.";
-    return result;
+    return;
   }
 
+  AppWidgetStorage* storage = extension_->GetStorage();
   std::string old_value;
-  if (!widget_storage_->GetValueByKey(key, &old_value)) {
+  if (!storage->GetValueByKey(key, &old_value))
     old_value = "";
-  }
-  if (old_value == value) {
-    LOG(WARNING) << "You are trying to set the same value."
-                 << " Nothing will be done.";
-    result.reset(new base::FundamentalValue(true));
-    return result;
-  }
-  if (widget_storage_->AddEntry(key, value, false)) {
-    result.reset(new base::FundamentalValue(true));
-
-    std::unique_ptr<base::DictionaryValue> event(new base::DictionaryValue());
-    event->SetString("key", key);
-    event->SetString("oldValue", old_value);
-    event->SetString("newValue", value);
-    PostMessageToOtherFrames(std::move(event));
-  }
+  if (old_value == value)
+    return;
 
-  return result;
+  if (storage->AddEntry(key, value, false))
+    extension_->BroadcastChange(this, key, old_value, value);
 }
 
-std::unique_ptr<base::FundamentalValue>
-AppWidgetExtensionInstance::RemovePreferencesItem(std::unique_ptr<base::Value> msg) {
-  std::unique_ptr<base::FundamentalValue> result(
-      new base::FundamentalValue(false));
+void AppWidgetExtensionInstance::RemovePreferencesItem(
+    const base::DictionaryValue& msg) {
   std::string key;
-  base::DictionaryValue* dict;
 
-  if (!msg->GetAsDictionary(&dict) ||
-      !dict->GetString(kPreferencesItemKey, &key)) {
+  if (!msg.GetString(kPreferencesItemKey, &key)) {
     LOG(ERROR) << "Fail to remove preferences item.";
-    return result;
+    return;
   }
 
+  AppWidgetStorage* storage = extension_->GetStorage();
   std::string old_value;
-  if (!widget_storage_->GetValueByKey(key, &old_value)) {
-    LOG(WARNING) << "You are trying to remove an entry which doesn't exist."
-                 << " Nothing will be done.";
-    result.reset(new base::FundamentalValue(true));
-    return result;
-  }
-
-  if (widget_storage_->RemoveEntry(key)) {
-    result.reset(new base::FundamentalValue(true));
-
-    std::unique_ptr<base::DictionaryValue> event(new base::DictionaryValue());
-    event->SetString("key", key);
-    event->SetString("oldValue", old_value);
-    event->SetString("newValue", "");
-    PostMessageToOtherFrames(std::move(event));
-  }
+  if (!storage->GetValueByKey(key, &old_value))
+    return;
 
-  return result;
+  if (storage->RemoveEntry(key))
+    extension_->BroadcastChange(this, key, old_value, "");
 }
 
-std::unique_ptr<base::FundamentalValue> AppWidgetExtensionInstance::ClearAllItems(
-    std::unique_ptr<base::Value> msg) {
-  std::unique_ptr<base::FundamentalValue> result(
-      new base::FundamentalValue(false));
+void AppWidgetExtensionInstance::ClearAllItems(
+    const base::DictionaryValue& msg) {
+  AppWidgetStorage* storage = extension_->GetStorage();
 
-  std::unique_ptr<base::DictionaryValue> entries(new base::DictionaryValue());
-  widget_storage_->GetAllEntries(entries.get());
+  base::DictionaryValue entries;
+  storage->GetAllEntries(&entries);
 
-  if (!widget_storage_->Clear())
-    return result;
+  if (!storage->Clear())
+    return;
 
-  for (base::DictionaryValue::Iterator it(*(entries.get()));
+  for (base::DictionaryValue::Iterator it(entries);
       !it.IsAtEnd(); it.Advance()) {
-    std::string key = it.key();
-    if (!widget_storage_->EntryExists(key)) {
+    const std::string& key = it.key();
+    if (!storage->EntryExists(key)) {
       std::string old_value;
       it.value().GetAsString(&old_value);
-      std::unique_ptr<base::DictionaryValue> event(new base::DictionaryValue());
-      event->SetString("key", key);
-      event->SetString("oldValue", old_value);
-      event->SetString("newValue", "");
-      PostMessageToOtherFrames(std::move(event));
+      extension_->BroadcastChange(this, key, old_value, "");
     }
   }
-
-  result.reset(new base::FundamentalValue(true));
-  return result;
-}
-
-std::unique_ptr<base::DictionaryValue> AppWidgetExtensionInstance::GetAllItems(
-    std::unique_ptr<base::Value> msg) {
-  std::unique_ptr<base::DictionaryValue> result(new base::DictionaryValue());
-  widget_storage_->GetAllEntries(result.get());
-
-  return result;
-}
-
-std::unique_ptr<base::StringValue> AppWidgetExtensionInstance::GetItemValueByKey(
-    std::unique_ptr<base::Value> msg) {
-  base::DictionaryValue* dict;
-  msg->GetAsDictionary(&dict);
-
-  std::string key;
-  std::string value;
-  if (!dict->GetString(kPreferencesItemKey, &key) ||
-      !widget_storage_->GetValueByKey(key, &value))
-    value = "";
-  std::unique_ptr<base::StringValue> result(new base::StringValue(value));
-  return result;
-}
-
-std::unique_ptr<base::FundamentalValue> AppWidgetExtensionInstance::KeyExists(
-    std::unique_ptr<base::Value> msg) const {
-  std::unique_ptr<base::FundamentalValue> result(
-      new base::FundamentalValue(false));
-  std::string key;
-  base::DictionaryValue* dict;
-
-  if (!msg->GetAsDictionary(&dict) ||
-      !dict->GetString(kPreferencesItemKey, &key)) {
-    LOG(ERROR) << "Fail to remove preferences item.";
-    return result;
-  }
-
-  if (widget_storage_->EntryExists(key))
-    result.reset(new base::FundamentalValue(true));
-
-  return result;
-}
-
-void AppWidgetExtensionInstance::PostMessageToOtherFrames(
-    std::unique_ptr<base::DictionaryValue> msg) {
-  const std::vector<Runtime*>& runtime_set = application_->runtimes();
-  std::vector<Runtime*>::const_iterator it;
-  for (it = runtime_set.begin(); it != runtime_set.end(); ++it) {
-    content::WebContents* web_contents = (*it)->web_contents();
-    web_contents->ForEachFrame(base::Bind(&DispatchStorageEvent,
-                                          msg.get(),
-                                          web_contents));
-  }
 }
 
 }  // namespace application
@@ -5,6 +5,7 @@
 #ifndef XWALK_APPLICATION_EXTENSION_APPLICATION_WIDGET_EXTENSION_H_
 #define XWALK_APPLICATION_EXTENSION_APPLICATION_WIDGET_EXTENSION_H_
 
+#include <set>
 #include <string>
 
 #include "xwalk/extensions/common/xwalk_extension.h"
@@ -12,44 +13,71 @@
 namespace xwalk {
 namespace application {
 class Application;
+class AppWidgetExtensionInstance;
+class AppWidgetStorage;
 
 using extensions::XWalkExtension;
 using extensions::XWalkExtensionInstance;
 
+// The widget extension keeps a single AppWidgetStorage shared by all of its
+// instances (one per frame). The renderer side receives a snapshot of the
+// preferences once, serves reads from it and sends the changes
+// asynchronously; the changes are then broadcast to the other frames so they
+// can update their snapshot and fire the storage event.
 class ApplicationWidgetExtension : public XWalkExtension {
  public:
   explicit ApplicationWidgetExtension(Application* application);
+  ~ApplicationWidgetExtension() override;
 
   // XWalkExtension implementation.
   XWalkExtensionInstance* CreateInstance() override;
 
+  AppWidgetStorage* GetStorage();
+
+  void AddInstance(AppWidgetExtensionInstance* instance);
+  void RemoveInstance(AppWidgetExtensionInstance* instance);
+
+  // Posts the change described by |key|, |old_value| and |new_value| to
+  // every instance but |source|.
+  void BroadcastChange(AppWidgetExtensionInstance* source,
+                       const std::string& key,
+                       const std::string& old_value,
+                       const std::string& new_value);
+
  private:
   Application* application_;
+  std::unique_ptr<AppWidgetStorage> widget_storage_;
+  std::set<AppWidgetExtensionInstance*> instances_;
 };
 
 class AppWidgetExtensionInstance : public XWalkExtensionInstance {
  public:
-  explicit AppWidgetExtensionInstance(Application* application);
+  AppWidgetExtensionInstance(ApplicationWidgetExtension* extension,
+                             Application* application);
   ~AppWidgetExtensionInstance() override;
 
   void HandleMessage(std::unique_ptr<base::Value> msg) override;
   void HandleSyncMessage(std::unique_ptr<base::Value> msg) override;
 
  private:
-  std::unique_ptr<base::StringValue> GetWidgetInfo(std::unique_ptr<base::Value> msg);
-  std::unique_ptr<base::FundamentalValue> SetPreferencesItem(
-      std::unique_ptr<base::Value> mgs);
-  std::unique_ptr<base::FundamentalValue> RemovePreferencesItem(
-      std::unique_ptr<base::Value> mgs);
-  std::unique_ptr<base::FundamentalValue> ClearAllItems(std::unique_ptr<base::Value> mgs);
-  std::unique_ptr<base::DictionaryValue> GetAllItems(std::unique_ptr<base::Value> mgs);
-  std::unique_ptr<base::StringValue> GetItemValueByKey(std::unique_ptr<base::Value> mgs);
-  std::unique_ptr<base::FundamentalValue> KeyExists(
-      std::unique_ptr<base::Value> mgs) const;
-  void PostMessageToOtherFrames(std::unique_ptr<base::DictionaryValue> msg);
+  typedef std::unique_ptr<base::Value> (AppWidgetExtensionInstance::*
+      SyncHandler)(const base::DictionaryValue& msg);
+  typedef void (AppWidgetExtensionInstance::*Handler)(
+      const base::DictionaryValue& msg);
+
+  // Synchronous queries.
+  std::unique_ptr<base::Value> GetWidgetInfo(const base::DictionaryValue& msg);
+  std::unique_ptr<base::Value> GetPreferencesSnapshot(
+      const base::DictionaryValue& msg);
+
+  // Asynchronous, write-behind updates. The renderer has already applied
+  // them to its own snapshot.
+  void SetPreferencesItem(const base::DictionaryValue& msg);
+  void RemovePreferencesItem(const base::DictionaryValue& msg);
+  void ClearAllItems(const base::DictionaryValue& msg);
 
+  ApplicationWidgetExtension* extension_;
   Application* application_;
-  std::unique_ptr<class AppWidgetStorage> widget_storage_;
 };
 
 }  // namespace application
@@ -6,8 +6,11 @@
 
 #include <string>
 
+#include "base/bind.h"
 #include "base/files/file_util.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
 #include "sql/statement.h"
 #include "sql/transaction.h"
 #include "xwalk/application/common/application_manifest_constants.h"
@@ -33,31 +36,20 @@ const char kCreateStorageTableOp[] =
 const char kClearStorageTableWithBindOp[] =
     "DELETE FROM widget_storage WHERE read_only = ? ";
 
-const char kInsertItemWithBindOp[] =
-    "INSERT INTO widget_storage (value, read_only, key) "
+const char kInsertOrReplaceItemWithBindOp[] =
+    "INSERT OR REPLACE INTO widget_storage (value, read_only, key) "
     "VALUES(?,?,?)";
 
-const char kUpdateItemWithBindOp[] =
-    "UPDATE widget_storage SET value = ? , read_only = ? "
-    "WHERE key = ?";
-
 const char kRemoveItemWithBindOp[] =
     "DELETE FROM widget_storage WHERE key = ?";
 
-const char kSelectCountWithBindOp[] =
-    "SELECT count(*) FROM widget_storage "
-    "WHERE key = ?";
-
 const char kSelectAllItem[] =
-    "SELECT key, value FROM widget_storage ";
+    "SELECT key, value, read_only FROM widget_storage ";
 
-const char kSelectValueWithBindOp[] =
-    "SELECT value FROM widget_storage "
-    "WHERE key = ?";
+// Changes are coalesced for this long before being committed, so that a
+// burst of writes from the page ends up in a single transaction.
+const int kFlushDelayMs = 300;
 
-const char kSelectReadOnlyWithBindOp[] =
-    "SELECT read_only FROM widget_storage "
-    "WHERE key = ?";
 }  // namespace
 
 namespace xwalk {
@@ -66,8 +58,10 @@ namespace application {
 AppWidgetStorage::AppWidgetStorage(Application* application,
                                    const base::FilePath& data_dir)
     : application_(application),
-      data_path_(data_dir) ,
-      db_initialized_(false) {
+      data_path_(data_dir),
+      db_initialized_(false),
+      flush_scheduled_(false),
+      weak_factory_(this) {
   sqlite_db_.reset(new sql::Connection);
 
   if (!Init()) {
@@ -77,6 +71,7 @@ AppWidgetStorage::AppWidgetStorage(Application* application,
 }
 
 AppWidgetStorage::~AppWidgetStorage() {
+  Flush();
 }
 
 bool AppWidgetStorage::Init() {
@@ -84,7 +79,6 @@ bool AppWidgetStorage::Init() {
     LOG(ERROR) << "Unable to open widget storage DB.";
     return false;
   }
-  sqlite_db_->Preload();
 
   if (!InitStorageTable()) {
      LOG(ERROR) << "Unable to init widget storage table.";
@@ -145,7 +139,7 @@ bool AppWidgetStorage::SaveConfigInfoInDB() {
 bool AppWidgetStorage::InitStorageTable() {
   if (sqlite_db_->DoesTableExist(kStorageTableName)) {
     db_initialized_ = (sqlite_db_ && sqlite_db_->is_open());
-    return true;
+    return LoadEntries();
   }
 
   sql::Transaction transaction(sqlite_db_.get());
@@ -159,165 +153,197 @@ bool AppWidgetStorage::InitStorageTable() {
   db_initialized_ = (sqlite_db_ && sqlite_db_->is_open());
   SaveConfigInfoInDB();
 
-  return true;
+  // Make sure the preferences from config.xml land on disk together with the
+  // newly created table.
+  return Flush();
 }
 
-bool AppWidgetStorage::EntryExists(const std::string& key) const {
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
+bool AppWidgetStorage::LoadEntries() {
+  entries_.clear();
 
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(
-      kSelectCountWithBindOp));
-  stmt.BindString(0, key);
-  if (!stmt.Step()) {
-    LOG(ERROR) << "There is no item in current DB.";
-    return false;
+  sql::Statement stmt(sqlite_db_->GetUniqueStatement(kSelectAllItem));
+  while (stmt.Step()) {
+    Entry& entry = entries_[stmt.ColumnString(0)];
+    entry.value = stmt.ColumnString(1);
+    entry.read_only = stmt.ColumnBool(2);
   }
 
-  if (!transaction.Commit())
-    return false;
-
-  int exist = stmt.ColumnInt(0);
-  return exist > 0;
+  return stmt.Succeeded();
 }
 
-bool AppWidgetStorage::IsReadOnly(const std::string& key) {
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(
-      kSelectReadOnlyWithBindOp));
-  stmt.BindString(0, key);
-  if (!stmt.Step()) {
-    LOG(WARNING) << "The key doesn't exist or there is an error in current DB.";
-    return false;
-  }
-
-  if (!transaction.Commit())
-    return false;
+bool AppWidgetStorage::EntryExists(const std::string& key) const {
+  return entries_.find(key) != entries_.end();
+}
 
-  return stmt.ColumnBool(0);
+bool AppWidgetStorage::IsReadOnly(const std::string& key) const {
+  EntryMap::const_iterator it = entries_.find(key);
+  return it != entries_.end() && it->second.read_only;
 }
 
 bool AppWidgetStorage::AddEntry(const std::string& key,
                                const std::string& value,
                                bool read_only) {
-  if (!db_initialized_ && !Init())
+  if (!db_initialized_)
     return false;
 
-  std::string operation;
-  if (!EntryExists(key)) {
-    operation = kInsertItemWithBindOp;
-  } else if (!IsReadOnly(key)) {
-    operation = kUpdateItemWithBindOp;
-  } else {
+  if (IsReadOnly(key)) {
     LOG(ERROR) << "Could not set read only item " << key;
     return false;
   }
 
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(
-    operation.c_str()));
-  stmt.BindString(0, value);
-  stmt.BindBool(1, read_only);
-  stmt.BindString(2, key);
-  if (!stmt.Run()) {
-    LOG(ERROR) << "An error occured when set item into DB.";
-    return false;
-  }
-
-  return transaction.Commit();
+  Entry& entry = entries_[key];
+  entry.value = value;
+  entry.read_only = read_only;
+  QueueOperation(PendingOperation::SET, key, value, read_only);
+  return true;
 }
 
 bool AppWidgetStorage::GetValueByKey(const std::string& key,
-                                     std::string* value) {
-  if (!db_initialized_ && !Init())
-    return false;
-
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(
-      kSelectValueWithBindOp));
-  stmt.BindString(0, key);
-  if (!stmt.Step()) {
-    LOG(WARNING) << "The key doesn't exit or there is an error in current DB.";
-    return false;
-  }
-
-  if (!transaction.Commit())
+                                     std::string* value) const {
+  EntryMap::const_iterator it = entries_.find(key);
+  if (it == entries_.end())
     return false;
 
-  *value = stmt.ColumnString(0);
+  *value = it->second.value;
   return true;
 }
 
 bool AppWidgetStorage::RemoveEntry(const std::string& key) {
-  if (!db_initialized_ && !Init())
+  if (!db_initialized_)
     return false;
 
-  if (IsReadOnly(key)) {
+  EntryMap::iterator it = entries_.find(key);
+  if (it == entries_.end() || it->second.read_only) {
     LOG(ERROR) << "The key is readonly or it doesn't exist." << key;
     return false;
   }
 
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
-    return false;
-
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(
-      kRemoveItemWithBindOp));
-  stmt.BindString(0, key);
+  entries_.erase(it);
+  QueueOperation(PendingOperation::REMOVE, key, std::string(), false);
+  return true;
+}
 
-  if (!stmt.Run()) {
-    LOG(ERROR) << "An error occured when removing item into DB.";
+bool AppWidgetStorage::Clear() {
+  if (!db_initialized_)
     return false;
+
+  for (EntryMap::iterator it = entries_.begin(); it != entries_.end();) {
+    if (it->second.read_only)
+      ++it;
+    else
+      entries_.erase(it++);
   }
 
-  return transaction.Commit();
+  // Whatever was queued before is overridden by the clear.
+  pending_operations_.clear();
+  QueueOperation(PendingOperation::CLEAR, std::string(), std::string(), false);
+  return true;
 }
 
-bool AppWidgetStorage::Clear() {
-  if (!db_initialized_ && !Init())
-    return false;
+bool AppWidgetStorage::GetAllEntries(base::DictionaryValue* result) const {
+  DCHECK(result);
 
-  sql::Transaction transaction(sqlite_db_.get());
-  if (!transaction.Begin())
+  if (!db_initialized_)
     return false;
 
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(
-      kClearStorageTableWithBindOp));
-  stmt.BindBool(0, false);
+  for (EntryMap::const_iterator it = entries_.begin();
+       it != entries_.end(); ++it)
+    result->SetStringWithoutPathExpansion(it->first, it->second.value);
 
-  if (!stmt.Run()) {
-    LOG(ERROR) << "An error occured when removing item into DB.";
-    return false;
+  return true;
+}
+
+void AppWidgetStorage::GetReadOnlyKeys(base::ListValue* result) const {
+  DCHECK(result);
+
+  for (EntryMap::const_iterator it = entries_.begin();
+       it != entries_.end(); ++it) {
+    if (it->second.read_only)
+      result->AppendString(it->first);
   }
+}
+
+void AppWidgetStorage::QueueOperation(PendingOperation::Type type,
+                                      const std::string& key,
+                                      const std::string& value,
+                                      bool read_only) {
+  PendingOperation operation;
+  operation.type = type;
+  operation.key = key;
+  operation.value = value;
+  operation.read_only = read_only;
+  pending_operations_.push_back(operation);
+
+  if (flush_scheduled_ || !base::ThreadTaskRunnerHandle::IsSet())
+    return;
 
-  return transaction.Commit();
+  flush_scheduled_ = true;
+  base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+      FROM_HERE,
+      base::Bind(&AppWidgetStorage::OnFlushTimer, weak_factory_.GetWeakPtr()),
+      base::TimeDelta::FromMilliseconds(kFlushDelayMs));
 }
 
-bool AppWidgetStorage::GetAllEntries(base::DictionaryValue* result) {
-  std::string key;
-  std::string value;
-  DCHECK(result);
+void AppWidgetStorage::OnFlushTimer() {
+  flush_scheduled_ = false;
+  if (!Flush())
+    LOG(ERROR) << "Unable to write widget preferences to DB.";
+}
 
-  if (!db_initialized_ && !Init())
+bool AppWidgetStorage::Flush() {
+  if (pending_operations_.empty())
+    return true;
+
+  if (!db_initialized_)
     return false;
 
-  sql::Statement stmt(sqlite_db_->GetUniqueStatement(kSelectAllItem));
-  while (stmt.Step()) {
-    key = stmt.ColumnString(0);
-    value = stmt.ColumnString(1);
-    result->SetString(key, value);
+  // The operations are kept until they are committed, so that a failed
+  // transaction is retried by the next flush rather than lost.
+  sql::Transaction transaction(sqlite_db_.get());
+  if (!transaction.Begin())
+    return false;
+
+  for (size_t i = 0; i < pending_operations_.size(); ++i) {
+    const PendingOperation& operation = pending_operations_[i];
+    switch (operation.type) {
+      case PendingOperation::SET: {
+        sql::Statement stmt(sqlite_db_->GetCachedStatement(
+            SQL_FROM_HERE, kInsertOrReplaceItemWithBindOp));
+        stmt.BindString(0, operation.value);
+        stmt.BindBool(1, operation.read_only);
+        stmt.BindString(2, operation.key);
+        if (!stmt.Run()) {
+          LOG(ERROR) << "An error occured when set item into DB.";
+          return false;
+        }
+        break;
+      }
+      case PendingOperation::REMOVE: {
+        sql::Statement stmt(sqlite_db_->GetCachedStatement(
+            SQL_FROM_HERE, kRemoveItemWithBindOp));
+        stmt.BindString(0, operation.key);
+        if (!stmt.Run()) {
+          LOG(ERROR) << "An error occured when removing item into DB.";
+          return false;
+        }
+        break;
+      }
+      case PendingOperation::CLEAR: {
+        sql::Statement stmt(sqlite_db_->GetCachedStatement(
+            SQL_FROM_HERE, kClearStorageTableWithBindOp));
+        stmt.BindBool(0, false);
+        if (!stmt.Run()) {
+          LOG(ERROR) << "An error occured when clearing the DB.";
+          return false;
+        }
+        break;
+      }
+    }
   }
 
+  if (!transaction.Commit())
+    return false;
+  pending_operations_.clear();
   return true;
 }
 
@@ -7,15 +7,24 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include "base/values.h"
 #include "base/files/file_path.h"
+#include "base/memory/weak_ptr.h"
 #include "sql/connection.h"
 #include "xwalk/application/browser/application.h"
 
 namespace xwalk {
 namespace application {
 
+// Backing store of widget.preferences. All the entries are loaded into memory
+// when the storage is opened and every query is answered from there. Changes
+// are applied to the in-memory copy right away and written behind to the
+// database: they are queued and committed in a single transaction shortly
+// after the first pending change, or when the storage is destroyed.
+//
+// The storage must be used on a single thread with a message loop.
 class AppWidgetStorage {
  public:
   AppWidgetStorage(Application* application,
@@ -28,22 +37,63 @@ class AppWidgetStorage {
                const std::string& value,
                bool read_only);
   bool RemoveEntry(const std::string& key);
+  // Removes all the entries which are not readonly.
   bool Clear();
-  bool GetAllEntries(base::DictionaryValue* result);
+  bool GetAllEntries(base::DictionaryValue* result) const;
+  // Fills |result| with the keys of the readonly entries.
+  void GetReadOnlyKeys(base::ListValue* result) const;
   bool EntryExists(const std::string& key) const;
-  bool GetValueByKey(const std::string& key, std::string* value);
+  bool GetValueByKey(const std::string& key, std::string* value) const;
+  bool IsReadOnly(const std::string& key) const;
+
+  // Commits the pending changes to the database immediately. On failure
+  // they are kept, to be committed by the next flush.
+  bool Flush();
 
  private:
+  struct Entry {
+    std::string value;
+    bool read_only;
+  };
+
+  struct PendingOperation {
+    enum Type {
+      SET,
+      REMOVE,
+      CLEAR,
+    };
+    Type type;
+    std::string key;
+    std::string value;
+    bool read_only;
+  };
+
   bool Init();
-  bool IsReadOnly(const std::string& key);
   bool InitStorageTable();
+  bool LoadEntries();
   bool SaveConfigInfoInDB();
   bool SaveConfigInfoItem(base::DictionaryValue* dict);
 
+  void QueueOperation(PendingOperation::Type type,
+                      const std::string& key,
+                      const std::string& value,
+                      bool read_only);
+  void OnFlushTimer();
+
   Application* application_;
   std::unique_ptr<sql::Connection> sqlite_db_;
   base::FilePath data_path_;
   bool db_initialized_;
+
+  typedef std::map<std::string, Entry> EntryMap;
+  EntryMap entries_;
+
+  std::vector<PendingOperation> pending_operations_;
+  bool flush_scheduled_;
+
+  base::WeakPtrFactory<AppWidgetStorage> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(AppWidgetStorage);
 };
 
 }  // namespace application
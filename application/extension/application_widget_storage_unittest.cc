@@ -0,0 +1,94 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/application/extension/application_widget_storage.h"
+
+#include <string>
+
+#include "base/files/scoped_temp_dir.h"
+#include "sql/connection.h"
+#include "sql/statement.h"
+#include "sql/test/scoped_error_ignorer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/sqlite/sqlite3.h"
+
+namespace xwalk {
+namespace application {
+
+class AppWidgetStorageTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    path_ = temp_dir_.path().AppendASCII("WidgetStorage");
+
+    // With the table already there, the storage doesn't read the
+    // preferences of an application.
+    sql::Connection db;
+    ASSERT_TRUE(db.Open(path_));
+    ASSERT_TRUE(db.Execute(
+        "CREATE TABLE widget_storage ("
+        "key TEXT NOT NULL UNIQUE PRIMARY KEY,"
+        "value TEXT NOT NULL,"
+        "read_only INTEGER )"));
+  }
+
+  // Returns the value stored in the database for |key|, or "" if none.
+  std::string ReadValue(const std::string& key) {
+    sql::Connection db;
+    EXPECT_TRUE(db.Open(path_));
+    sql::Statement stmt(db.GetUniqueStatement(
+        "SELECT value FROM widget_storage WHERE key = ?"));
+    stmt.BindString(0, key);
+    return stmt.Step() ? stmt.ColumnString(0) : std::string();
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath path_;
+};
+
+TEST_F(AppWidgetStorageTest, ChangesAreWrittenOnDestruction) {
+  {
+    AppWidgetStorage storage(nullptr, path_);
+    ASSERT_TRUE(storage.AddEntry("kept", "1", false));
+    ASSERT_TRUE(storage.AddEntry("removed", "2", false));
+    ASSERT_TRUE(storage.RemoveEntry("removed"));
+    // Nothing is written before the flush.
+    EXPECT_EQ("", ReadValue("kept"));
+  }
+  EXPECT_EQ("1", ReadValue("kept"));
+  EXPECT_EQ("", ReadValue("removed"));
+
+  AppWidgetStorage storage(nullptr, path_);
+  std::string value;
+  EXPECT_TRUE(storage.GetValueByKey("kept", &value));
+  EXPECT_EQ("1", value);
+}
+
+TEST_F(AppWidgetStorageTest, FailedFlushKeepsChanges) {
+  AppWidgetStorage storage(nullptr, path_);
+  ASSERT_TRUE(storage.AddEntry("key", "value", false));
+
+  {
+    // Another connection holding the database makes the writes fail.
+    sql::test::ScopedErrorIgnorer ignore_errors;
+    ignore_errors.IgnoreError(SQLITE_BUSY);
+    sql::Connection other;
+    ASSERT_TRUE(other.Open(path_));
+    ASSERT_TRUE(other.Execute("BEGIN EXCLUSIVE"));
+    EXPECT_FALSE(storage.Flush());
+    ASSERT_TRUE(other.Execute("COMMIT"));
+    EXPECT_TRUE(ignore_errors.CheckIgnoredErrors());
+  }
+  EXPECT_EQ("", ReadValue("key"));
+  std::string value;
+  EXPECT_TRUE(storage.GetValueByKey("key", &value));
+  EXPECT_EQ("value", value);
+
+  // The next flush writes the change which failed.
+  EXPECT_TRUE(storage.Flush());
+  EXPECT_EQ("value", ReadValue("key"));
+}
+
+}  // namespace application
+}  // namespace xwalk
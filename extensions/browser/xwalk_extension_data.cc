@@ -4,13 +4,10 @@
 
 #include "xwalk/extensions/browser/xwalk_extension_data.h"
 
-#include "content/public/browser/browser_thread.h"
 #include "xwalk/extensions/browser/xwalk_extension_process_host.h"
 #include "xwalk/extensions/browser/xwalk_extension_service.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
-using content::BrowserThread;
-
 namespace xwalk {
 namespace extensions {
 
@@ -32,10 +29,8 @@ XWalkExtensionData::~XWalkExtensionData() {
   extension_thread_->message_loop()->DeleteSoon(
       FROM_HERE, in_process_extension_thread_server_.release());
 
-  if (extension_process_host_) {
-    BrowserThread::DeleteSoon(
-        BrowserThread::IO, FROM_HERE, extension_process_host_.release());
-  }
+  if (extension_process_host_)
+    XWalkExtensionProcessHost::DeleteSoon(std::move(extension_process_host_));
 }
 
 }  // namespace extensions
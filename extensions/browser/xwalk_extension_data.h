@@ -39,6 +39,11 @@ class XWalkExtensionData {
     return std::move(extension_process_host_);
   }
 
+  // Unlike extension_process_host(), keeps the ownership.
+  XWalkExtensionProcessHost* GetExtensionProcessHost() const {
+    return extension_process_host_.get();
+  }
+
   content::RenderProcessHost* render_process_host() const {
     return render_process_host_;
   }
@@ -5,16 +5,21 @@
 #include "xwalk/extensions/browser/xwalk_extension_process_host.h"
 
 #include <string>
+#include <utility>
 
 #include "base/command_line.h"
 #include "base/logging.h"
 #include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/metrics/histogram_macros.h"
+#include "base/process/process.h"
 #include "content/public/browser/browser_child_process_host.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/render_process_host.h"
 #include "content/public/common/child_process_host.h"
 #include "content/public/common/process_type.h"
 #include "content/public/common/content_switches.h"
+#include "content/public/common/result_codes.h"
 #include "content/public/common/sandboxed_process_launcher_delegate.h"
 #include "ipc/ipc_message.h"
 #include "ipc/ipc_switches.h"
@@ -118,13 +123,23 @@ XWalkExtensionProcessHost::XWalkExtensionProcessHost(
     std::unique_ptr<base::DictionaryValue::Storage> runtime_variables)
     : ep_rp_channel_handle_(""),
       render_process_host_(render_process_host),
+      render_process_id_(content::ChildProcessHost::kInvalidUniqueID),
+      attached_render_process_id_(content::ChildProcessHost::kInvalidUniqueID),
+      was_spare_(!render_process_host),
       render_process_message_filter_(new RenderProcessMessageFilter(this)),
       external_extensions_path_(external_extensions_path),
       is_extension_process_channel_ready_(false),
       delegate_(delegate),
-      runtime_variables_(std::move(runtime_variables)) {
-  render_process_host_->GetChannel()->AddFilter(
-      render_process_message_filter_.get());
+      runtime_variables_(std::move(runtime_variables)),
+      weak_factory_(this) {
+  weak_this_ = weak_factory_.GetWeakPtr();
+  if (render_process_host_) {
+    render_process_id_ = render_process_host_->GetID();
+    attached_render_process_id_ = render_process_id_;
+    attach_time_ = base::TimeTicks::Now();
+    render_process_host_->GetChannel()->AddFilter(
+        render_process_message_filter_.get());
+  }
   BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
       base::Bind(&XWalkExtensionProcessHost::StartProcess,
       base::Unretained(this)));
@@ -138,6 +153,77 @@ XWalkExtensionProcessHost::~XWalkExtensionProcessHost() {
 
 namespace {
 
+void DeleteProcessHost(base::WeakPtr<XWalkExtensionProcessHost> host) {
+  delete host.get();
+}
+
+}  // namespace
+
+// static
+void XWalkExtensionProcessHost::DeleteSoon(
+    std::unique_ptr<XWalkExtensionProcessHost> host) {
+  // If the process dies first, content deletes the host and the pointer
+  // is invalidated.
+  base::WeakPtr<XWalkExtensionProcessHost> weak_host = host->GetWeakPtr();
+  ignore_result(host.release());
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+                          base::Bind(&DeleteProcessHost, weak_host));
+}
+
+void XWalkExtensionProcessHost::AttachRenderProcess(
+    content::RenderProcessHost* render_process_host) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  CHECK(render_process_host);
+  CHECK(was_spare_);
+
+  {
+    base::AutoLock lock(attach_lock_);
+    CHECK_EQ(content::ChildProcessHost::kInvalidUniqueID,
+             attached_render_process_id_);
+    attached_render_process_id_ = render_process_host->GetID();
+  }
+
+  // The host is used on the IO thread from now on. The task is posted before
+  // the filter is added, so it runs before the filter sees any message. It is
+  // dropped if the process dies meanwhile.
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE,
+      base::Bind(&XWalkExtensionProcessHost::OnRenderProcessAttached,
+                 weak_this_, render_process_host, base::TimeTicks::Now()));
+  render_process_host->GetChannel()->AddFilter(
+      render_process_message_filter_.get());
+}
+
+void XWalkExtensionProcessHost::OnRenderProcessAttached(
+    content::RenderProcessHost* render_process_host,
+    base::TimeTicks attach_time) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  DCHECK(!render_process_host_);
+  render_process_host_ = render_process_host;
+  render_process_id_ = render_process_host->GetID();
+  attach_time_ = attach_time;
+
+  std::vector<std::pair<std::string, std::string>> tables;
+  tables.swap(pending_permission_tables_);
+  for (size_t i = 0; i < tables.size(); ++i) {
+    if (!RegisterPermissionsWithDelegate(tables[i].first, tables[i].second)) {
+      // The extension was told otherwise, so its checks are left to the
+      // delegate, which doesn't know the permissions.
+      LOG(WARNING) << "Permissions of extension '" << tables[i].first
+                   << "' were rejected after it was initialized";
+    }
+  }
+
+  if (is_extension_process_channel_ready_ && delegate_)
+    delegate_->OnRenderChannelCreated(render_process_id_);
+}
+
+int XWalkExtensionProcessHost::GetAttachedRenderProcessID() const {
+  base::AutoLock lock(attach_lock_);
+  return attached_render_process_id_;
+}
+
+namespace {
+
 void ToListValue(base::DictionaryValue::Storage* vm, base::ListValue* lv) {
   lv->Clear();
 
@@ -186,6 +272,9 @@ void XWalkExtensionProcessHost::StartProcess() {
   cmd_line->AppendSwitchASCII(switches::kProcessChannelID, channel_id);
   if (!extension_cmd_prefix.empty())
     cmd_line->PrependWrapper(extension_cmd_prefix);
+  if (base::CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kXWalkDumpExtensionStats))
+    cmd_line->AppendSwitch(switches::kXWalkDumpExtensionStats);
 
   process_->Launch(
       new ExtensionSandboxedProcessLauncherDelegate(process_->GetHost()),
@@ -207,6 +296,7 @@ void XWalkExtensionProcessHost::StopProcess() {
 
 void XWalkExtensionProcessHost::OnGetExtensionProcessChannel(
     std::unique_ptr<IPC::Message> reply) {
+  channel_request_time_ = base::TimeTicks::Now();
   pending_reply_for_render_process_ = std::move(reply);
   ReplyChannelHandleToRenderProcess();
 }
@@ -220,9 +310,12 @@ bool XWalkExtensionProcessHost::OnMessageReceived(const IPC::Message& message) {
     IPC_MESSAGE_HANDLER_DELAY_REPLY(
         XWalkExtensionProcessHostMsg_CheckAPIAccessControl,
         OnCheckAPIAccessControl)
-    IPC_MESSAGE_HANDLER(
+    IPC_MESSAGE_HANDLER_DELAY_REPLY(
         XWalkExtensionProcessHostMsg_RegisterPermissions,
         OnRegisterPermissions)
+    IPC_MESSAGE_HANDLER(
+        XWalkExtensionProcessHostMsg_RequestAPIAccessControl,
+        OnRequestAPIAccessControl)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
   return handled;
@@ -239,7 +332,7 @@ void XWalkExtensionProcessHost::OnChannelError() {
 
   VLOG(1) << "\n\nExtensionProcess crashed";
   if (delegate_)
-    delegate_->OnExtensionProcessDied(this, render_process_host_->GetID());
+    delegate_->OnExtensionProcessDied(this, GetAttachedRenderProcessID());
 }
 
 void XWalkExtensionProcessHost::OnProcessLaunched() {
@@ -251,8 +344,8 @@ void XWalkExtensionProcessHost::OnRenderChannelCreated(
   is_extension_process_channel_ready_ = true;
   ep_rp_channel_handle_ = handle;
   ReplyChannelHandleToRenderProcess();
-  if (delegate_)
-    delegate_->OnRenderChannelCreated(render_process_host_->GetID());
+  if (is_attached() && delegate_)
+    delegate_->OnRenderChannelCreated(render_process_id_);
 }
 
 void XWalkExtensionProcessHost::ReplyChannelHandleToRenderProcess() {
@@ -270,6 +363,17 @@ void XWalkExtensionProcessHost::ReplyChannelHandleToRenderProcess() {
       pending_reply_for_render_process_.get(), ep_rp_channel_handle_);
 
   render_process_host_->Send(pending_reply_for_render_process_.release());
+
+  base::TimeTicks now = base::TimeTicks::Now();
+  UMA_HISTOGRAM_BOOLEAN("XWalk.ExtensionProcess.UsedSpare", was_spare_);
+  UMA_HISTOGRAM_TIMES("XWalk.ExtensionProcess.RendererToChannelReady",
+                      now - attach_time_);
+  UMA_HISTOGRAM_TIMES("XWalk.ExtensionProcess.RendererBlockedTime",
+                      now - channel_request_time_);
+  VLOG(1) << "Extension process channel ready "
+          << (now - attach_time_).InMilliseconds()
+          << "ms after the render process got it"
+          << (was_spare_ ? " (spare)" : "");
 }
 
 void XWalkExtensionProcessHost::ReplyAccessControlToExtension(
@@ -284,19 +388,79 @@ void XWalkExtensionProcessHost::OnCheckAPIAccessControl(
     const std::string& extension_name,
     const std::string& api_name, IPC::Message* reply_msg) {
   CHECK(delegate_);
-  delegate_->OnCheckAPIAccessControl(render_process_host_->GetID(),
+  delegate_->OnCheckAPIAccessControl(render_process_id_,
                                      extension_name, api_name,
       base::Bind(&XWalkExtensionProcessHost::ReplyAccessControlToExtension,
                  base::Unretained(this),
                  reply_msg));
 }
 
+void XWalkExtensionProcessHost::OnRequestAPIAccessControl(
+    int request_id,
+    const std::string& extension_name,
+    const std::string& api_name) {
+  CHECK(delegate_);
+  delegate_->OnCheckAPIAccessControl(render_process_id_,
+                                     extension_name, api_name,
+      base::Bind(&XWalkExtensionProcessHost::SendAPIAccessControlResult,
+                 base::Unretained(this),
+                 request_id));
+}
+
+void XWalkExtensionProcessHost::SendAPIAccessControlResult(
+    int request_id, RuntimePermission perm) {
+  Send(new XWalkExtensionProcessMsg_APIAccessControlResult(request_id, perm));
+}
+
+void XWalkExtensionProcessHost::InvalidatePermissions() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  Send(new XWalkExtensionProcessMsg_InvalidatePermissions());
+}
+
+void XWalkExtensionProcessHost::TerminateProcessForTesting() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::IO));
+  if (process_) {
+    base::Process::DeprecatedGetProcessFromHandle(process_->GetData().handle)
+        .Terminate(content::RESULT_CODE_KILLED, false);
+  }
+}
+
 void XWalkExtensionProcessHost::OnRegisterPermissions(
     const std::string& extension_name,
-    const std::string& perm_table, bool* result) {
+    const std::string& perm_table, IPC::Message* reply_msg) {
+  bool result = true;
+  if (is_attached()) {
+    result = RegisterPermissionsWithDelegate(extension_name, perm_table);
+  } else {
+    // Permissions belong to the application of the render process, which a
+    // spare doesn't know yet. The extension is blocked until the reply, so
+    // the table is accepted now and registered once attached.
+    pending_permission_tables_.push_back(
+        std::make_pair(extension_name, perm_table));
+  }
+  XWalkExtensionProcessHostMsg_RegisterPermissions::WriteReplyParams(
+      reply_msg, result);
+  Send(reply_msg);
+}
+
+bool XWalkExtensionProcessHost::RegisterPermissionsWithDelegate(
+    const std::string& extension_name,
+    const std::string& perm_table) {
   CHECK(delegate_);
-  *result = delegate_->OnRegisterPermissions(
-      render_process_host_->GetID(), extension_name, perm_table);
+  if (!delegate_->OnRegisterPermissions(render_process_id_, extension_name,
+                                        perm_table))
+    return false;
+
+  // Push what is already known, so the checks of the extension don't need
+  // a round trip to the browser.
+  PermissionSnapshot snapshot;
+  delegate_->OnGetPermissionSnapshot(render_process_id_, extension_name,
+                                     &snapshot);
+  if (!snapshot.empty()) {
+    Send(new XWalkExtensionProcessMsg_SetPermissionSnapshot(extension_name,
+                                                             snapshot));
+  }
+  return true;
 }
 
 bool XWalkExtensionProcessHost::Send(IPC::Message* msg) {
@@ -7,9 +7,14 @@
 
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/files/file_path.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "content/public/browser/browser_child_process_host_delegate.h"
 #include "ipc/ipc_channel_handle.h"
@@ -28,6 +33,17 @@ namespace extensions {
 // This class represents the browser side of the browser <-> extension process
 // communication channel. It has to run some operations in IO thread for
 // creating the extra process.
+//
+// A host created without a render process is a spare: the extension process
+// is launched and loads the external extensions right away, and the host is
+// handed to a render process later on with AttachRenderProcess(), so the
+// render process doesn't wait for the launch. Permission registrations coming
+// from a spare are accepted right away, so the extensions don't block in
+// XW_Initialize(), and handed to the delegate once it is attached.
+//
+// The host is deleted by content on the IO thread when its process dies,
+// right after Delegate::OnExtensionProcessDied() returns. Its owner must
+// drop it there, and use DeleteSoon() to delete it otherwise.
 class XWalkExtensionProcessHost
     : public content::BrowserChildProcessHostDelegate,
       public IPC::Sender {
@@ -45,6 +61,9 @@ class XWalkExtensionProcessHost
     virtual bool OnRegisterPermissions(int render_process_id,
                                        const std::string& extension_name,
                                        const std::string& perm_table);
+    virtual void OnGetPermissionSnapshot(int render_process_id,
+                                         const std::string& extension_name,
+                                         PermissionSnapshot* snapshot) {}
     virtual void OnRenderChannelCreated(int render_process_id) {}
 
    protected:
@@ -57,6 +76,32 @@ class XWalkExtensionProcessHost
                             std::unique_ptr<base::DictionaryValue::Storage> runtime_variables);
   ~XWalkExtensionProcessHost() override;
 
+  // Deletes |host| on the IO thread, unless its process dies before.
+  static void DeleteSoon(std::unique_ptr<XWalkExtensionProcessHost> host);
+
+  // Hands a spare host to |render_process_host|. Must be called on the UI
+  // thread, at most once, and only if no render process was given to the
+  // constructor. The caller must keep it from racing with
+  // Delegate::OnExtensionProcessDied().
+  void AttachRenderProcess(content::RenderProcessHost* render_process_host);
+
+  // The id of the render process given to the constructor or to
+  // AttachRenderProcess(), which the IO thread may not know about yet. Can
+  // be called on any thread.
+  int GetAttachedRenderProcessID() const;
+
+  // Can be copied on any thread, and used on the IO thread.
+  base::WeakPtr<XWalkExtensionProcessHost> GetWeakPtr() const {
+    return weak_this_;
+  }
+
+  // Makes the extension process forget the permission decisions it got so
+  // far. Must be called on the IO thread.
+  void InvalidatePermissions();
+
+  // Must be called on the IO thread.
+  void TerminateProcessForTesting();
+
   // IPC::Sender implementation
   bool Send(IPC::Message* msg) override;
 
@@ -66,6 +111,10 @@ class XWalkExtensionProcessHost
   void StartProcess();
   void StopProcess();
 
+  void OnRenderProcessAttached(content::RenderProcessHost* render_process_host,
+                               base::TimeTicks attach_time);
+  bool is_attached() const { return render_process_host_ != NULL; }
+
   // Handler for message from Render Process host, it is a synchronous message,
   // that will be replied only when the extension process channel is created.
   void OnGetExtensionProcessChannel(std::unique_ptr<IPC::Message> reply);
@@ -84,14 +133,35 @@ class XWalkExtensionProcessHost
       const std::string& api_name, IPC::Message* reply_msg);
   void ReplyAccessControlToExtension(IPC::Message* reply_msg,
       RuntimePermission perm);
+  void OnRequestAPIAccessControl(int request_id,
+      const std::string& extension_name, const std::string& api_name);
+  void SendAPIAccessControlResult(int request_id, RuntimePermission perm);
   void OnRegisterPermissions(const std::string& extension_name,
-      const std::string& perm_table, bool* result);
+      const std::string& perm_table, IPC::Message* reply_msg);
+  bool RegisterPermissionsWithDelegate(const std::string& extension_name,
+      const std::string& perm_table);
 
   std::unique_ptr<content::BrowserChildProcessHost> process_;
   IPC::ChannelHandle ep_rp_channel_handle_;
   content::RenderProcessHost* render_process_host_;
+  int render_process_id_;
   std::unique_ptr<IPC::Message> pending_reply_for_render_process_;
 
+  // The extension names and permission tables registered while the host was
+  // a spare.
+  std::vector<std::pair<std::string, std::string>> pending_permission_tables_;
+
+  // Guards |attached_render_process_id_|, which is set on the UI thread.
+  mutable base::Lock attach_lock_;
+  int attached_render_process_id_;
+
+  // Used for the startup metrics. |attach_time_| is when the render process
+  // got this host, |channel_request_time_| when it blocked waiting for the
+  // extension process channel.
+  bool was_spare_;
+  base::TimeTicks attach_time_;
+  base::TimeTicks channel_request_time_;
+
   // We use this filter to know when RP asked for the extension process channel.
   // We keep the reference to invalidate the filter once we don't need it
   // anymore.
@@ -110,6 +180,9 @@ class XWalkExtensionProcessHost
 
   // IPC channel for launcher to communicate with BP in service mode.
   std::unique_ptr<IPC::Channel> channel_;
+
+  base::WeakPtr<XWalkExtensionProcessHost> weak_this_;
+  base::WeakPtrFactory<XWalkExtensionProcessHost> weak_factory_;
 };
 
 }  // namespace extensions
@@ -8,19 +8,23 @@
 #include <vector>
 #include "base/callback.h"
 #include "base/command_line.h"
+#include "base/macros.h"
 #include "base/memory/ptr_util.h"
 #include "base/pickle.h"
 #include "base/scoped_native_library.h"
 #include "base/synchronization/lock.h"
+#include "base/trace_event/trace_event.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/notification_types.h"
 #include "content/public/browser/notification_service.h"
 #include "content/public/browser/render_process_host.h"
+#include "content/public/common/child_process_host.h"
 #include "ipc/ipc_message_macros.h"
 #include "xwalk/extensions/browser/xwalk_extension_data.h"
 #include "xwalk/extensions/browser/xwalk_extension_process_host.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
+#include "xwalk/extensions/common/xwalk_extension_stats.h"
 #include "xwalk/extensions/common/xwalk_extension_switches.h"
 
 using content::BrowserThread;
@@ -38,6 +42,38 @@ XWalkExtensionService::CreateExtensionsCallback
 
 base::FilePath g_external_extensions_path_for_testing_;
 
+std::unique_ptr<base::DictionaryValue::Storage> CopyRuntimeVariables(
+    const base::DictionaryValue::Storage& variables) {
+  std::unique_ptr<base::DictionaryValue::Storage> copy(
+      new base::DictionaryValue::Storage);
+  for (base::DictionaryValue::Storage::const_iterator it = variables.begin();
+       it != variables.end(); ++it)
+    (*copy)[it->first] = it->second->CreateDeepCopy();
+  return copy;
+}
+
+bool RuntimeVariablesEqual(const base::DictionaryValue::Storage& a,
+                           const base::DictionaryValue::Storage& b) {
+  if (a.size() != b.size())
+    return false;
+  for (base::DictionaryValue::Storage::const_iterator it = a.begin();
+       it != a.end(); ++it) {
+    base::DictionaryValue::Storage::const_iterator other = b.find(it->first);
+    if (other == b.end() || !it->second->Equals(other->second.get()))
+      return false;
+  }
+  return true;
+}
+
+void DispatchToServer(ExtensionStats* stats,
+                      base::WeakPtr<XWalkExtensionServer> server,
+                      const IPC::Message& message) {
+  if (stats)
+    stats->RecordMessageDequeued();
+  if (server)
+    server->OnMessageReceived(message);
+}
+
 }  // namespace
 
 
@@ -88,7 +124,7 @@ bool ExtensionServerMessageFilter::Send(IPC::Message* msg_ptr) {
 }
 
 int64_t ExtensionServerMessageFilter::GetInstanceIDFromMessage(
-    const IPC::Message& message) {
+    const IPC::Message& message, uint64_t* flow_id) {
   base::PickleIterator iter;
 
   if (message.is_sync())
@@ -100,13 +136,24 @@ int64_t ExtensionServerMessageFilter::GetInstanceIDFromMessage(
   if (!iter.ReadInt64(&instance_id))
     return -1;
 
+  *flow_id = 0;
+  if (message.type() == XWalkExtensionServerMsg_PostMessageToNative::ID ||
+      message.type() == XWalkExtensionServerMsg_SendSyncMessageToNative::ID)
+    iter.ReadUInt64(flow_id);
+
   return instance_id;
  }
 
 void ExtensionServerMessageFilter::RouteMessageToServer(
     const IPC::Message& message) {
-  int64_t id = GetInstanceIDFromMessage(message);
+  uint64_t flow_id;
+  int64_t id = GetInstanceIDFromMessage(message, &flow_id);
   DCHECK_NE(id, -1);
+  TRACE_EVENT_WITH_FLOW1(kExtensionTraceCategory,
+                         "ExtensionServerMessageFilter::RouteMessageToServer",
+                         flow_id,
+                         TRACE_EVENT_FLAG_FLOW_IN | TRACE_EVENT_FLAG_FLOW_OUT,
+                         "instance_id", id);
 
   XWalkExtensionServer* server;
   base::TaskRunner* task_runner;
@@ -122,9 +169,17 @@ void ExtensionServerMessageFilter::RouteMessageToServer(
     task_runner = task_runner_ref.get();
   }
 
-  base::Closure closure = base::Bind(
-      base::IgnoreResult(&XWalkExtensionServer::OnMessageReceived),
-      server->AsWeakPtr(), message);
+  ExtensionStats* stats = nullptr;
+  std::map<int64_t, ExtensionStats*>::iterator it = instances_stats_.find(id);
+  if (it != instances_stats_.end()) {
+    stats = it->second;
+    stats->RecordMessageQueued();
+    if (message.type() == XWalkExtensionServerMsg_DestroyInstance::ID)
+      instances_stats_.erase(it);
+  }
+
+  base::Closure closure = base::Bind(&DispatchToServer, stats,
+                                     server->AsWeakPtr(), message);
 
   task_runner->PostTask(FROM_HERE, closure);
 }
@@ -135,6 +190,12 @@ void ExtensionServerMessageFilter::OnCreateInstance(
   base::TaskRunner* task_runner;
   scoped_refptr<base::TaskRunner> task_runner_ref;
 
+  if (extension_thread_server_->ContainsExtension(name) ||
+      ui_thread_server_->ContainsExtension(name)) {
+    instances_stats_[instance_id] =
+        XWalkExtensionStats::GetInstance()->ForExtension(name);
+  }
+
   if (extension_thread_server_->ContainsExtension(name)) {
     extension_thread_instances_ids_.insert(instance_id);
     server = extension_thread_server_;
@@ -192,7 +253,8 @@ bool XWalkExtensionService::Delegate::RegisterPermissions(
 
 XWalkExtensionService::XWalkExtensionService(Delegate* delegate)
     : extension_thread_("XWalkExtensionThread"),
-      delegate_(delegate) {
+      delegate_(delegate),
+      weak_factory_(this) {
   if (!g_external_extensions_path_for_testing_.empty())
     external_extensions_path_ = g_external_extensions_path_for_testing_;
   registrar_.Add(this, content::NOTIFICATION_RENDERER_PROCESS_TERMINATED,
@@ -208,6 +270,9 @@ XWalkExtensionService::~XWalkExtensionService() {
   // extension thread.
   if (!extension_data_map_.empty())
     VLOG(1) << "The ExtensionData map is not empty!";
+  base::AutoLock lock(process_hosts_lock_);
+  DiscardSpareExtensionProcessHost();
+  XWalkExtensionStats::GetInstance()->DumpIfRequested();
 }
 
 void XWalkExtensionService::RegisterExternalExtensionsForPath(
@@ -226,6 +291,12 @@ void XWalkExtensionService::OnRenderProcessHostCreatedInternal(
   CreateInProcessExtensionServers(host, data, ui_thread_extensions,
                                   extension_thread_extensions);
 
+  // Added first, so that the death of the extension process finds it.
+  {
+    base::AutoLock lock(process_hosts_lock_);
+    extension_data_map_[host->GetID()] = data;
+  }
+
   base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
   if (!cmd_line->HasSwitch(switches::kXWalkDisableExtensionProcess)) {
     CreateExtensionProcessHost(host, data, std::move(runtime_variables));
@@ -235,8 +306,6 @@ void XWalkExtensionService::OnRenderProcessHostCreatedInternal(
         data->in_process_ui_thread_server(),
         external_extensions_path_, base::Passed(std::move(runtime_variables))));
   }
-
-  extension_data_map_[host->GetID()] = data;
 }
 
 void XWalkExtensionService::OnRenderProcessWillLaunch(
@@ -296,6 +365,7 @@ void XWalkExtensionService::Observe(int type,
 
 void XWalkExtensionService::OnRenderProcessHostClosed(
     content::RenderProcessHost* host) {
+  base::AutoLock lock(process_hosts_lock_);
   RenderProcessToExtensionDataMap::iterator it =
       extension_data_map_.find(host->GetID());
 
@@ -373,9 +443,93 @@ void XWalkExtensionService::CreateInProcessExtensionServers(
 void XWalkExtensionService::CreateExtensionProcessHost(
     content::RenderProcessHost* host, XWalkExtensionData* data,
     std::unique_ptr<base::DictionaryValue::Storage> runtime_variables) {
-  data->set_extension_process_host(base::WrapUnique(
-      new XWalkExtensionProcessHost(host, external_extensions_path_, this,
-                                    std::move(runtime_variables))));
+  {
+    // The spare is taken, attached and stored at once, so that its death on
+    // the IO thread either finds it as the spare or in |data|.
+    base::AutoLock lock(process_hosts_lock_);
+    std::unique_ptr<XWalkExtensionProcessHost> eph =
+        TakeSpareExtensionProcessHost(*runtime_variables);
+    if (eph) {
+      eph->AttachRenderProcess(host);
+    } else {
+      eph.reset(new XWalkExtensionProcessHost(
+          host, external_extensions_path_, this,
+          CopyRuntimeVariables(*runtime_variables)));
+    }
+    data->set_extension_process_host(std::move(eph));
+  }
+
+  ScheduleSpareExtensionProcessHost(std::move(runtime_variables));
+}
+
+std::unique_ptr<XWalkExtensionProcessHost>
+XWalkExtensionService::TakeSpareExtensionProcessHost(
+    const base::DictionaryValue::Storage& runtime_variables) {
+  process_hosts_lock_.AssertAcquired();
+  if (!spare_extension_process_host_)
+    return nullptr;
+
+  if (!RuntimeVariablesEqual(*spare_runtime_variables_, runtime_variables)) {
+    DiscardSpareExtensionProcessHost();
+    return nullptr;
+  }
+
+  spare_runtime_variables_.reset();
+  return std::move(spare_extension_process_host_);
+}
+
+void XWalkExtensionService::ScheduleSpareExtensionProcessHost(
+    std::unique_ptr<base::DictionaryValue::Storage> runtime_variables) {
+  base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
+  if (cmd_line->HasSwitch(switches::kXWalkDisableSpareExtensionProcess))
+    return;
+
+  {
+    base::AutoLock lock(process_hosts_lock_);
+    if (spare_extension_process_host_ || extension_data_map_.size() < 2)
+      return;
+  }
+
+  // Launched once the current render process is done starting, so both
+  // processes don't compete for the disk and CPU.
+  spare_runtime_variables_ = std::move(runtime_variables);
+  BrowserThread::PostAfterStartupTask(
+      FROM_HERE, BrowserThread::GetMessageLoopProxyForThread(BrowserThread::UI),
+      base::Bind(&XWalkExtensionService::LaunchSpareExtensionProcessHost,
+                 weak_factory_.GetWeakPtr()));
+}
+
+void XWalkExtensionService::LaunchSpareExtensionProcessHost() {
+  base::AutoLock lock(process_hosts_lock_);
+  if (spare_extension_process_host_ || !spare_runtime_variables_)
+    return;
+
+  spare_extension_process_host_.reset(new XWalkExtensionProcessHost(
+      nullptr, external_extensions_path_, this,
+      CopyRuntimeVariables(*spare_runtime_variables_)));
+}
+
+void XWalkExtensionService::DiscardSpareExtensionProcessHost() {
+  process_hosts_lock_.AssertAcquired();
+  spare_runtime_variables_.reset();
+  if (spare_extension_process_host_) {
+    XWalkExtensionProcessHost::DeleteSoon(
+        std::move(spare_extension_process_host_));
+  }
+}
+
+bool XWalkExtensionService::HasSpareExtensionProcessForTesting() {
+  base::AutoLock lock(process_hosts_lock_);
+  return !!spare_extension_process_host_;
+}
+
+void XWalkExtensionService::TerminateSpareExtensionProcessForTesting() {
+  base::AutoLock lock(process_hosts_lock_);
+  if (!spare_extension_process_host_)
+    return;
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE, base::Bind(
+      &XWalkExtensionProcessHost::TerminateProcessForTesting,
+      spare_extension_process_host_->GetWeakPtr()));
 }
 
 void XWalkExtensionService::OnExtensionProcessDied(
@@ -384,6 +538,16 @@ void XWalkExtensionService::OnExtensionProcessDied(
   // to be deleted. We should invalidate our reference to it so we avoid a
   // segfault when trying to delete it within
   // XWalkExtensionService::OnRenderProcessHostClosed();
+  base::AutoLock lock(process_hosts_lock_);
+  if (spare_extension_process_host_.get() == eph) {
+    ignore_result(spare_extension_process_host_.release());
+    return;
+  }
+
+  // A spare may have been attached since the host looked.
+  render_process_id = eph->GetAttachedRenderProcessID();
+  if (render_process_id == content::ChildProcessHost::kInvalidUniqueID)
+    return;
 
   RenderProcessToExtensionDataMap::iterator it =
       extension_data_map_.find(render_process_id);
@@ -410,6 +574,7 @@ void XWalkExtensionService::OnExtensionProcessDied(
 
 void XWalkExtensionService::OnRenderProcessDied(
     content::RenderProcessHost* host) {
+  base::AutoLock lock(process_hosts_lock_);
   RenderProcessToExtensionDataMap::iterator it =
       extension_data_map_.find(host->GetID());
 
@@ -422,6 +587,21 @@ void XWalkExtensionService::OnRenderProcessDied(
   delete data;
 }
 
+void XWalkExtensionService::InvalidatePermissions(int render_process_id) {
+  base::AutoLock lock(process_hosts_lock_);
+  RenderProcessToExtensionDataMap::iterator it =
+      extension_data_map_.find(render_process_id);
+  if (it == extension_data_map_.end())
+    return;
+
+  XWalkExtensionProcessHost* eph = it->second->GetExtensionProcessHost();
+  if (!eph)
+    return;
+
+  BrowserThread::PostTask(BrowserThread::IO, FROM_HERE, base::Bind(
+      &XWalkExtensionProcessHost::InvalidatePermissions, eph->GetWeakPtr()));
+}
+
 void XWalkExtensionService::OnExtensionProcessCreated(
       int render_process_id,
       const IPC::ChannelHandle channel_handle) {
@@ -448,5 +628,14 @@ bool XWalkExtensionService::OnRegisterPermissions(
                                         extension_name, perm_table);
 }
 
+void XWalkExtensionService::OnGetPermissionSnapshot(
+    int render_process_id,
+    const std::string& extension_name,
+    PermissionSnapshot* snapshot) {
+  CHECK(delegate_);
+  delegate_->GetPermissionSnapshot(render_process_id, extension_name,
+                                   snapshot);
+}
+
 }  // namespace extensions
 }  // namespace xwalk
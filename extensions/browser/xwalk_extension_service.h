@@ -14,6 +14,8 @@
 #include "base/callback_forward.h"
 #include "base/containers/scoped_ptr_hash_map.h"
 #include "base/files/file_path.h"
+#include "base/memory/weak_ptr.h"
+#include "base/synchronization/lock.h"
 #include "base/threading/thread.h"
 #include "base/values.h"
 #include "content/public/browser/notification_observer.h"
@@ -31,6 +33,7 @@ class WebContents;
 namespace xwalk {
 namespace extensions {
 
+class ExtensionStats;
 class XWalkExtension;
 class XWalkExtensionData;
 class XWalkExtensionServer;
@@ -55,6 +58,12 @@ class XWalkExtensionService : public content::NotificationObserver,
     virtual void ExtensionProcessCreated(
         int render_process_id,
         const IPC::ChannelHandle& channel_handle) {}
+    // Fills |snapshot| with the decisions for the APIs registered by
+    // |extension_name| that hold for the rest of the session.
+    virtual void GetPermissionSnapshot(
+        int render_process_id,
+        const std::string& extension_name,
+        PermissionSnapshot* snapshot) {}
 
    protected:
     virtual ~Delegate() {}
@@ -83,6 +92,11 @@ class XWalkExtensionService : public content::NotificationObserver,
   // XWalkContentBrowserClient::RenderProcessHostGone().
   void OnRenderProcessDied(content::RenderProcessHost* host);
 
+  // To be called when the permissions of the application running in a
+  // render process change, so its extension process stops using the old
+  // decisions.
+  void InvalidatePermissions(int render_process_id);
+
   typedef base::Callback<void(XWalkExtensionVector* extensions)>
       CreateExtensionsCallback;
 
@@ -93,6 +107,9 @@ class XWalkExtensionService : public content::NotificationObserver,
 
   static void SetExternalExtensionsPathForTesting(const base::FilePath& path);
 
+  bool HasSpareExtensionProcessForTesting();
+  void TerminateSpareExtensionProcessForTesting();
+
  private:
   void OnRenderProcessHostCreatedInternal(
       content::RenderProcessHost* host,
@@ -116,6 +133,9 @@ class XWalkExtensionService : public content::NotificationObserver,
   bool OnRegisterPermissions(int render_process_id,
                              const std::string& extension_name,
                              const std::string& perm_table) override;
+  void OnGetPermissionSnapshot(int render_process_id,
+                               const std::string& extension_name,
+                               PermissionSnapshot* snapshot) override;
 
   // NotificationObserver implementation.
   void Observe(int type, const content::NotificationSource& source,
@@ -132,6 +152,19 @@ class XWalkExtensionService : public content::NotificationObserver,
   void CreateExtensionProcessHost(content::RenderProcessHost* host,
       XWalkExtensionData* data, std::unique_ptr<base::DictionaryValue::Storage> runtime_variables);
 
+  // The spare extension process is launched with the runtime variables of
+  // the last render process, and only handed to a render process having the
+  // same ones. A spare runs XW_Initialize() of every extension without being
+  // sure to be used, so it is only launched once the application has more
+  // than one render process. The first two must be called with
+  // |process_hosts_lock_| held.
+  std::unique_ptr<XWalkExtensionProcessHost> TakeSpareExtensionProcessHost(
+      const base::DictionaryValue::Storage& runtime_variables);
+  void DiscardSpareExtensionProcessHost();
+  void ScheduleSpareExtensionProcessHost(
+      std::unique_ptr<base::DictionaryValue::Storage> runtime_variables);
+  void LaunchSpareExtensionProcessHost();
+
   // The server that handles in process extensions will live in the
   // extension_thread_.
   base::Thread extension_thread_;
@@ -142,9 +175,21 @@ class XWalkExtensionService : public content::NotificationObserver,
 
   base::FilePath external_extensions_path_;
 
+  // Guards |extension_data_map_| and |spare_extension_process_host_|, which
+  // the IO thread updates when an extension process dies.
+  base::Lock process_hosts_lock_;
+
   typedef std::map<int, XWalkExtensionData*> RenderProcessToExtensionDataMap;
   RenderProcessToExtensionDataMap extension_data_map_;
 
+  // Lives on the IO thread like the other process hosts, but is owned here
+  // until a render process takes it.
+  std::unique_ptr<XWalkExtensionProcessHost> spare_extension_process_host_;
+  // Only used on the UI thread.
+  std::unique_ptr<base::DictionaryValue::Storage> spare_runtime_variables_;
+
+  base::WeakPtrFactory<XWalkExtensionService> weak_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionService);
 };
 
@@ -169,7 +214,10 @@ public:
 
 private:
   ~ExtensionServerMessageFilter() override;
-  int64_t GetInstanceIDFromMessage(const IPC::Message& message);
+  // Also reads the flow id of the messages which have one, or sets
+  // |flow_id| to 0.
+  int64_t GetInstanceIDFromMessage(const IPC::Message& message,
+                                   uint64_t* flow_id);
   void RouteMessageToServer(const IPC::Message& message);
   void OnCreateInstance(int64_t instance_id, std::string name);
   void OnGetExtensions(
@@ -188,6 +236,8 @@ private:
   XWalkExtensionServer* extension_thread_server_;
   XWalkExtensionServer* ui_thread_server_;
   std::set<int64_t> extension_thread_instances_ids_;
+  // Accounts for the messages waiting for the thread of their instance.
+  std::map<int64_t, ExtensionStats*> instances_stats_;
 };
 
 }  // namespace extensions
@@ -19,6 +19,12 @@ bool XWalkExtension::PermissionsDelegate::RegisterPermissions(
   return false;
 }
 
+void XWalkExtension::PermissionsDelegate::CheckAPIAccessControlAsync(
+    const std::string& extension_name, const std::string& api_name,
+    const base::Callback<void(bool)>& callback) {
+  callback.Run(CheckAPIAccessControl(extension_name, api_name));
+}
+
 XWalkExtension::XWalkExtension() : permissions_delegate_(NULL) {}
 
 XWalkExtension::~XWalkExtension() {}
@@ -34,6 +40,17 @@ bool XWalkExtension::CheckAPIAccessControl(const char* api_name) const {
   return permissions_delegate_->CheckAPIAccessControl(name(), api_name);
 }
 
+void XWalkExtension::CheckAPIAccessControlAsync(
+    const char* api_name, const base::Callback<void(bool)>& callback) const {
+  if (!permissions_delegate_) {
+    callback.Run(false);
+    return;
+  }
+
+  permissions_delegate_->CheckAPIAccessControlAsync(name(), api_name,
+                                                    callback);
+}
+
 bool XWalkExtension::RegisterPermissions(const char* perm_table) const {
   if (!permissions_delegate_)
     return false;
@@ -40,6 +40,11 @@ class XWalkExtension {
         const std::string& api_name);
     virtual bool RegisterPermissions(const std::string& extension_name,
         const std::string& perm_table);
+    // Doesn't block while the decision is unknown. The default implementation
+    // runs |callback| with the result of CheckAPIAccessControl().
+    virtual void CheckAPIAccessControlAsync(const std::string& extension_name,
+        const std::string& api_name,
+        const base::Callback<void(bool)>& callback);
 
     ~PermissionsDelegate() {}
   };
@@ -61,6 +66,8 @@ class XWalkExtension {
   }
 
   bool CheckAPIAccessControl(const char* api_name) const;
+  void CheckAPIAccessControlAsync(
+      const char* api_name, const base::Callback<void(bool)>& callback) const;
   bool RegisterPermissions(const char* perm_table) const;
 
  protected:
@@ -53,6 +53,27 @@ IPC_SYNC_MESSAGE_CONTROL2_1(XWalkExtensionProcessHostMsg_RegisterPermissions, //
                             std::string,
                             bool)
 
+// Asynchronous version of CheckAPIAccessControl, answered with
+// XWalkExtensionProcessMsg_APIAccessControlResult.
+IPC_MESSAGE_CONTROL3(XWalkExtensionProcessHostMsg_RequestAPIAccessControl, // NOLINT(*)
+                     int /* request id */,
+                     std::string /* extension name */,
+                     std::string /* api name */)
+
+// Messages from Browser Process to Extension Process about permissions.
+IPC_MESSAGE_CONTROL2(XWalkExtensionProcessMsg_APIAccessControlResult, // NOLINT(*)
+                     int /* request id */,
+                     xwalk::extensions::RuntimePermission)
+
+// Sent after an extension registered its permissions, with the decisions the
+// browser already knows for them.
+IPC_MESSAGE_CONTROL2(XWalkExtensionProcessMsg_SetPermissionSnapshot, // NOLINT(*)
+                     std::string /* extension name */,
+                     xwalk::extensions::PermissionSnapshot)
+
+// The decisions sent so far are outdated.
+IPC_MESSAGE_CONTROL0(XWalkExtensionProcessMsg_InvalidatePermissions) // NOLINT(*)
+
 // We use a separated message class for Client<->Server communication
 // to ease filtering.
 #undef IPC_MESSAGE_START
@@ -68,20 +89,26 @@ IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_CreateInstance,  // NOLINT(*)
                      int64_t /* instance id */,
                      std::string /* extension name */)
 
-IPC_MESSAGE_CONTROL2(XWalkExtensionServerMsg_PostMessageToNative,  // NOLINT(*)
+// The flow id links the trace events of a message across processes, see
+// NextExtensionMessageFlowId(). It follows the instance id, so the message
+// filter reads both without parsing the contents.
+IPC_MESSAGE_CONTROL3(XWalkExtensionServerMsg_PostMessageToNative,  // NOLINT(*)
                      int64_t /* instance id */,
+                     uint64_t /* flow id */,
                      base::ListValue /* contents */)
 
-IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostMessageToJS,  // NOLINT(*)
+IPC_MESSAGE_CONTROL3(XWalkExtensionClientMsg_PostMessageToJS,  // NOLINT(*)
                      int64_t /* instance id */,
+                     uint64_t /* flow id */,
                      base::ListValue /* contents */)
 
 IPC_MESSAGE_CONTROL2(XWalkExtensionClientMsg_PostOutOfLineMessageToJS,  // NOLINT(*)
                      base::SharedMemoryHandle /* message buffer */,
                      uint64_t /* buffer size */)
 
-IPC_SYNC_MESSAGE_CONTROL2_1(XWalkExtensionServerMsg_SendSyncMessageToNative,  // NOLINT(*)
+IPC_SYNC_MESSAGE_CONTROL3_1(XWalkExtensionServerMsg_SendSyncMessageToNative,  // NOLINT(*)
                             int64_t /* instance id */,
+                            uint64_t /* flow id */,
                             base::ListValue /* input contents */,
                             base::ListValue /* output contents */)
 
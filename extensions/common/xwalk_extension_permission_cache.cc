@@ -0,0 +1,96 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_permission_cache.h"
+
+namespace xwalk {
+namespace extensions {
+
+XWalkExtensionPermissionCache::ExtensionEntry::ExtensionEntry() {}
+
+XWalkExtensionPermissionCache::ExtensionEntry::ExtensionEntry(
+    const ExtensionEntry& other) = default;
+
+XWalkExtensionPermissionCache::ExtensionEntry::~ExtensionEntry() {}
+
+XWalkExtensionPermissionCache::XWalkExtensionPermissionCache() {}
+
+XWalkExtensionPermissionCache::~XWalkExtensionPermissionCache() {}
+
+// static
+bool XWalkExtensionPermissionCache::IsCacheable(RuntimePermission perm) {
+  return perm == ALLOW_SESSION || perm == ALLOW_ALWAYS ||
+         perm == DENY_SESSION || perm == DENY_ALWAYS;
+}
+
+// static
+bool XWalkExtensionPermissionCache::IsAllowed(RuntimePermission perm) {
+  return perm == ALLOW_ONCE || perm == ALLOW_SESSION || perm == ALLOW_ALWAYS;
+}
+
+RuntimePermission XWalkExtensionPermissionCache::Lookup(
+    const std::string& extension_name,
+    const std::string& api_name) const {
+  base::hash_map<std::string, size_t>::const_iterator extension =
+      extension_ids_.find(extension_name);
+  if (extension == extension_ids_.end())
+    return UNDEFINED_RUNTIME_PERM;
+
+  const ExtensionEntry& entry = extensions_[extension->second];
+  base::hash_map<std::string, size_t>::const_iterator api =
+      entry.api_ids.find(api_name);
+  if (api == entry.api_ids.end())
+    return UNDEFINED_RUNTIME_PERM;
+
+  return entry.permissions[api->second];
+}
+
+void XWalkExtensionPermissionCache::Store(const std::string& extension_name,
+                                          const std::string& api_name,
+                                          RuntimePermission perm) {
+  if (!IsCacheable(perm))
+    return;
+
+  ExtensionEntry* entry = GetOrCreateEntry(extension_name);
+  std::pair<base::hash_map<std::string, size_t>::iterator, bool> result =
+      entry->api_ids.insert(
+          std::make_pair(api_name, entry->permissions.size()));
+  if (result.second)
+    entry->permissions.push_back(perm);
+  else
+    entry->permissions[result.first->second] = perm;
+}
+
+void XWalkExtensionPermissionCache::SetSnapshot(
+    const std::string& extension_name,
+    const PermissionSnapshot& snapshot) {
+  ExtensionEntry* entry = GetOrCreateEntry(extension_name);
+  for (size_t i = 0; i < entry->permissions.size(); ++i)
+    entry->permissions[i] = UNDEFINED_RUNTIME_PERM;
+
+  for (size_t i = 0; i < snapshot.size(); ++i)
+    Store(extension_name, snapshot[i].first, snapshot[i].second);
+}
+
+void XWalkExtensionPermissionCache::Clear() {
+  for (size_t i = 0; i < extensions_.size(); ++i) {
+    std::vector<RuntimePermission>& permissions = extensions_[i].permissions;
+    for (size_t j = 0; j < permissions.size(); ++j)
+      permissions[j] = UNDEFINED_RUNTIME_PERM;
+  }
+}
+
+XWalkExtensionPermissionCache::ExtensionEntry*
+XWalkExtensionPermissionCache::GetOrCreateEntry(
+    const std::string& extension_name) {
+  std::pair<base::hash_map<std::string, size_t>::iterator, bool> result =
+      extension_ids_.insert(
+          std::make_pair(extension_name, extensions_.size()));
+  if (result.second)
+    extensions_.push_back(ExtensionEntry());
+  return &extensions_[result.first->second];
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,73 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_PERMISSION_CACHE_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_PERMISSION_CACHE_H_
+
+#include <string>
+#include <vector>
+
+#include "base/containers/hash_tables.h"
+#include "base/macros.h"
+#include "xwalk/extensions/common/xwalk_extension_permission_types.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Keeps the permission decisions that stay valid for the whole session.
+//
+// Extension and API names are given a small integer the first time they are
+// seen, and the decisions are kept in a table indexed by those integers, so
+// a lookup needs neither string concatenation nor allocation. Names are kept
+// when the decisions are cleared, since the same APIs are checked again.
+//
+// The cache is not thread-safe.
+class XWalkExtensionPermissionCache {
+ public:
+  XWalkExtensionPermissionCache();
+  ~XWalkExtensionPermissionCache();
+
+  // Only decisions valid for the session or longer can be cached.
+  static bool IsCacheable(RuntimePermission perm);
+  static bool IsAllowed(RuntimePermission perm);
+
+  // Returns UNDEFINED_RUNTIME_PERM if there is no decision for the API.
+  RuntimePermission Lookup(const std::string& extension_name,
+                           const std::string& api_name) const;
+
+  // Non-cacheable decisions are ignored.
+  void Store(const std::string& extension_name,
+             const std::string& api_name,
+             RuntimePermission perm);
+
+  // Replaces all the decisions for |extension_name|.
+  void SetSnapshot(const std::string& extension_name,
+                   const PermissionSnapshot& snapshot);
+
+  void Clear();
+
+ private:
+  struct ExtensionEntry {
+    ExtensionEntry();
+    ExtensionEntry(const ExtensionEntry& other);
+    ~ExtensionEntry();
+
+    base::hash_map<std::string, size_t> api_ids;
+    // Indexed by API id.
+    std::vector<RuntimePermission> permissions;
+  };
+
+  ExtensionEntry* GetOrCreateEntry(const std::string& extension_name);
+
+  base::hash_map<std::string, size_t> extension_ids_;
+  // Indexed by extension id.
+  std::vector<ExtensionEntry> extensions_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionPermissionCache);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_PERMISSION_CACHE_H_
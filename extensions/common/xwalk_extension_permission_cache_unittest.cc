@@ -0,0 +1,75 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_permission_cache.h"
+
+#include <string>
+#include <utility>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+namespace extensions {
+
+TEST(XWalkExtensionPermissionCacheTest, StoresOnlySessionDecisions) {
+  XWalkExtensionPermissionCache cache;
+  EXPECT_EQ(UNDEFINED_RUNTIME_PERM, cache.Lookup("echo", "add"));
+
+  cache.Store("echo", "add", ALLOW_ONCE);
+  cache.Store("echo", "remove", DENY_ONCE);
+  EXPECT_EQ(UNDEFINED_RUNTIME_PERM, cache.Lookup("echo", "add"));
+  EXPECT_EQ(UNDEFINED_RUNTIME_PERM, cache.Lookup("echo", "remove"));
+
+  cache.Store("echo", "add", ALLOW_SESSION);
+  cache.Store("echo", "remove", DENY_ALWAYS);
+  EXPECT_EQ(ALLOW_SESSION, cache.Lookup("echo", "add"));
+  EXPECT_EQ(DENY_ALWAYS, cache.Lookup("echo", "remove"));
+
+  cache.Store("echo", "add", DENY_SESSION);
+  EXPECT_EQ(DENY_SESSION, cache.Lookup("echo", "add"));
+}
+
+TEST(XWalkExtensionPermissionCacheTest, ExtensionsDoNotShareAPIs) {
+  XWalkExtensionPermissionCache cache;
+  cache.Store("echo", "add", ALLOW_ALWAYS);
+  cache.Store("echoadd", "", DENY_ALWAYS);
+
+  EXPECT_EQ(ALLOW_ALWAYS, cache.Lookup("echo", "add"));
+  EXPECT_EQ(DENY_ALWAYS, cache.Lookup("echoadd", ""));
+  EXPECT_EQ(UNDEFINED_RUNTIME_PERM, cache.Lookup("other", "add"));
+}
+
+TEST(XWalkExtensionPermissionCacheTest, SnapshotReplacesDecisions) {
+  XWalkExtensionPermissionCache cache;
+  cache.Store("echo", "add", ALLOW_ALWAYS);
+  cache.Store("echo", "remove", ALLOW_ALWAYS);
+  cache.Store("other", "get", ALLOW_SESSION);
+
+  PermissionSnapshot snapshot;
+  snapshot.push_back(std::make_pair(std::string("remove"), DENY_SESSION));
+  snapshot.push_back(std::make_pair(std::string("get"), ALLOW_ONCE));
+  cache.SetSnapshot("echo", snapshot);
+
+  EXPECT_EQ(UNDEFINED_RUNTIME_PERM, cache.Lookup("echo", "add"));
+  EXPECT_EQ(DENY_SESSION, cache.Lookup("echo", "remove"));
+  EXPECT_EQ(UNDEFINED_RUNTIME_PERM, cache.Lookup("echo", "get"));
+  EXPECT_EQ(ALLOW_SESSION, cache.Lookup("other", "get"));
+
+  cache.Clear();
+  EXPECT_EQ(UNDEFINED_RUNTIME_PERM, cache.Lookup("echo", "remove"));
+  EXPECT_EQ(UNDEFINED_RUNTIME_PERM, cache.Lookup("other", "get"));
+}
+
+TEST(XWalkExtensionPermissionCacheTest, IsAllowed) {
+  EXPECT_TRUE(XWalkExtensionPermissionCache::IsAllowed(ALLOW_ONCE));
+  EXPECT_TRUE(XWalkExtensionPermissionCache::IsAllowed(ALLOW_SESSION));
+  EXPECT_TRUE(XWalkExtensionPermissionCache::IsAllowed(ALLOW_ALWAYS));
+  EXPECT_FALSE(XWalkExtensionPermissionCache::IsAllowed(DENY_ONCE));
+  EXPECT_FALSE(XWalkExtensionPermissionCache::IsAllowed(DENY_ALWAYS));
+  EXPECT_FALSE(
+      XWalkExtensionPermissionCache::IsAllowed(UNDEFINED_RUNTIME_PERM));
+}
+
+}  // namespace extensions
+}  // namespace xwalk
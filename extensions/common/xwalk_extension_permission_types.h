@@ -5,6 +5,12 @@
 #ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_PERMISSION_TYPES_H_
 #define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_PERMISSION_TYPES_H_
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/callback.h"
+
 namespace xwalk {
 namespace extensions {
 
@@ -24,6 +30,11 @@ enum RuntimePermission {
 
 typedef base::Callback<void(RuntimePermission)> PermissionCallback;
 
+// Decisions known by the browser for the APIs of an extension, sent to the
+// extension process so it doesn't need to ask for them.
+typedef std::vector<std::pair<std::string, RuntimePermission>>
+    PermissionSnapshot;
+
 }  // namespace extensions
 }  // namespace xwalk
 
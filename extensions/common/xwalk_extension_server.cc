@@ -11,10 +11,12 @@
 #include "base/strings/string16.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/stl_util.h"
+#include "base/trace_event/trace_event.h"
 #include "content/public/browser/render_process_host.h"
 #include "ipc/ipc_message.h"
 #include "ipc/ipc_sender.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_stats.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 
 namespace xwalk {
@@ -25,7 +27,8 @@ const size_t kInlineMessageMaxSize = 256 * 1024;
 
 XWalkExtensionServer::XWalkExtensionServer()
     : channel_proxy_(NULL),
-      permissions_delegate_(NULL) {}
+      permissions_delegate_(NULL),
+      received_message_size_(0) {}
 
 XWalkExtensionServer::~XWalkExtensionServer() {
   DeleteInstanceMap();
@@ -33,6 +36,7 @@ XWalkExtensionServer::~XWalkExtensionServer() {
 }
 
 bool XWalkExtensionServer::OnMessageReceived(const IPC::Message& message) {
+  received_message_size_ = message.size();
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionServer, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionServerMsg_CreateInstance,
@@ -73,9 +77,10 @@ void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
     return;
   }
 
+  ExtensionStats* stats = XWalkExtensionStats::GetInstance()->ForExtension(name);
   instance->SetPostMessageCallback(
       base::Bind(&XWalkExtensionServer::PostMessageToJSCallback,
-                 base::Unretained(this), instance_id));
+                 base::Unretained(this), instance_id, stats));
 
   instance->SetSendSyncReplyCallback(
       base::Bind(&XWalkExtensionServer::SendSyncReplyToJSCallback,
@@ -83,13 +88,19 @@ void XWalkExtensionServer::OnCreateInstance(int64_t instance_id,
 
   InstanceExecutionData data;
   data.instance = instance;
+  data.stats = stats;
   data.pending_reply = NULL;
+  data.pending_reply_flow_id = 0;
 
   instances_[instance_id] = data;
 }
 
 void XWalkExtensionServer::OnPostMessageToNative(int64_t instance_id,
-    const base::ListValue& msg) {
+    uint64_t flow_id, const base::ListValue& msg) {
+  TRACE_EVENT_WITH_FLOW1(kExtensionTraceCategory,
+                         "XWalkExtensionServer::OnPostMessageToNative",
+                         flow_id, TRACE_EVENT_FLAG_FLOW_IN,
+                         "instance_id", instance_id);
   InstanceMap::const_iterator it = instances_.find(instance_id);
   if (it == instances_.end()) {
 #if TENTA_LOG_ENABLE == 1
@@ -100,6 +111,7 @@ void XWalkExtensionServer::OnPostMessageToNative(int64_t instance_id,
   }
 
   const InstanceExecutionData& data = it->second;
+  data.stats->RecordMessageToNative(received_message_size_, false);
 
   // The const_cast is needed to remove the only Value contained by the
   // ListValue (which is solely used as wrapper, since Value doesn't
@@ -120,8 +132,10 @@ void XWalkExtensionServer::Initialize(IPC::ChannelProxy* channelProxy) {
 
 bool XWalkExtensionServer::Send(IPC::Message* msg) {
   base::AutoLock l(channel_proxy_lock_);
-  if (!channel_proxy_)
+  if (!channel_proxy_) {
+    delete msg;
     return false;
+  }
   return channel_proxy_->Send(msg);
 }
 
@@ -202,13 +216,20 @@ bool XWalkExtensionServer::ContainsExtension(
 }
 
 void XWalkExtensionServer::PostMessageToJSCallback(
-    int64_t instance_id, std::unique_ptr<base::Value> msg) {
+    int64_t instance_id, ExtensionStats* stats,
+    std::unique_ptr<base::Value> msg) {
+  uint64_t flow_id = NextExtensionMessageFlowId();
+  TRACE_EVENT_WITH_FLOW1(kExtensionTraceCategory,
+                         "XWalkExtensionServer::PostMessageToJS", flow_id,
+                         TRACE_EVENT_FLAG_FLOW_OUT, "instance_id", instance_id);
   base::ListValue wrapped_msg;
   wrapped_msg.Append(msg.release());
 
   std::unique_ptr<IPC::Message> message(
-      new XWalkExtensionClientMsg_PostMessageToJS(instance_id, wrapped_msg));
+      new XWalkExtensionClientMsg_PostMessageToJS(instance_id, flow_id,
+                                                  wrapped_msg));
   if (message->size() <= kInlineMessageMaxSize) {
+    stats->RecordMessageToJS(message->size(), false);
     Send(message.release());
     return;
   }
@@ -238,6 +259,7 @@ void XWalkExtensionServer::PostMessageToJSCallback(
     return;
   }
 
+  stats->RecordMessageToJS(message->size(), true);
   Send(new XWalkExtensionClientMsg_PostOutOfLineMessageToJS(handle,
                                                             message->size()));
 }
@@ -263,10 +285,17 @@ void XWalkExtensionServer::SendSyncReplyToJSCallback(
     return;
   }
 
+  TRACE_EVENT_WITH_FLOW1(kExtensionTraceCategory,
+                         "XWalkExtensionServer::SendSyncReplyToJS",
+                         data.pending_reply_flow_id,
+                         TRACE_EVENT_FLAG_FLOW_IN | TRACE_EVENT_FLAG_FLOW_OUT,
+                         "instance_id", instance_id);
   base::ListValue wrapped_reply;
   wrapped_reply.Append(reply.release());
   XWalkExtensionServerMsg_SendSyncMessageToNative::WriteReplyParams(
       data.pending_reply, wrapped_reply);
+  data.stats->RecordMessageToJS(data.pending_reply->size(), false);
+  data.stats->RecordSyncWait(base::TimeTicks::Now() - data.pending_reply_time);
   Send(data.pending_reply);
 
   data.pending_reply = NULL;
@@ -313,7 +342,12 @@ bool XWalkExtensionServer::ValidateExtensionEntryPoints(
 }
 
 void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
-    const base::ListValue& msg, IPC::Message* ipc_reply) {
+    uint64_t flow_id, const base::ListValue& msg, IPC::Message* ipc_reply) {
+  TRACE_EVENT_WITH_FLOW1(kExtensionTraceCategory,
+                         "XWalkExtensionServer::OnSendSyncMessageToNative",
+                         flow_id,
+                         TRACE_EVENT_FLAG_FLOW_IN | TRACE_EVENT_FLAG_FLOW_OUT,
+                         "instance_id", instance_id);
   InstanceMap::iterator it = instances_.find(instance_id);
   if (it == instances_.end()) {
 #if TENTA_LOG_ENABLE == 1
@@ -333,6 +367,9 @@ void XWalkExtensionServer::OnSendSyncMessageToNative(int64_t instance_id,
   }
 
   data.pending_reply = ipc_reply;
+  data.pending_reply_flow_id = flow_id;
+  data.pending_reply_time = base::TimeTicks::Now();
+  data.stats->RecordMessageToNative(received_message_size_, true);
 
   // The const_cast is needed to remove the only Value contained by the
   // ListValue (which is solely used as wrapper, since Value doesn't
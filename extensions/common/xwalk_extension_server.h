@@ -14,6 +14,7 @@
 #include "base/memory/shared_memory.h"
 #include "base/memory/weak_ptr.h"
 #include "base/synchronization/lock.h"
+#include "base/time/time.h"
 #include "base/values.h"
 #include "ipc/ipc_channel_proxy.h"
 #include "ipc/ipc_listener.h"
@@ -37,6 +38,7 @@ class Sender;
 namespace xwalk {
 namespace extensions {
 
+class ExtensionStats;
 class XWalkExtensionInstance;
 
 // Manages the instances for a set of extensions. It communicates with one
@@ -83,16 +85,22 @@ class XWalkExtensionServer : public IPC::Listener,
  private:
   struct InstanceExecutionData {
     XWalkExtensionInstance* instance;
+    ExtensionStats* stats;
     IPC::Message* pending_reply;
+    // The flow and arrival time of the message |pending_reply| answers.
+    uint64_t pending_reply_flow_id;
+    base::TimeTicks pending_reply_time;
   };
 
   // Message Handlers
   void OnDestroyInstance(int64_t instance_id);
-  void OnPostMessageToNative(int64_t instance_id, const base::ListValue& msg);
-  void OnSendSyncMessageToNative(int64_t instance_id,
+  void OnPostMessageToNative(int64_t instance_id, uint64_t flow_id,
+      const base::ListValue& msg);
+  void OnSendSyncMessageToNative(int64_t instance_id, uint64_t flow_id,
       const base::ListValue& msg, IPC::Message* ipc_reply);
 
   void PostMessageToJSCallback(int64_t instance_id,
+                               ExtensionStats* stats,
                                std::unique_ptr<base::Value> msg);
 
   void SendSyncReplyToJSCallback(int64_t instance_id,
@@ -117,6 +125,9 @@ class XWalkExtensionServer : public IPC::Listener,
   ExtensionSymbolsSet extension_symbols_;
 
   XWalkExtension::PermissionsDelegate* permissions_delegate_;
+
+  // The size of the message being dispatched, for the stats.
+  size_t received_message_size_;
 };
 
 std::vector<std::string> RegisterExternalExtensionsInDirectory(
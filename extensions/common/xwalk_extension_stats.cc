@@ -0,0 +1,184 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_stats.h"
+
+#include <algorithm>
+
+#include "base/atomicops.h"
+#include "base/command_line.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "base/process/process_handle.h"
+#include "base/values.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+base::subtle::Atomic32 g_last_flow_sequence = 0;
+
+// Values hold doubles only, which is precise enough for the counters.
+void SetCounter(base::DictionaryValue* dict, const char* key, uint64_t value) {
+  dict->SetDouble(key, static_cast<double>(value));
+}
+
+}  // namespace
+
+const char kExtensionTraceCategory[] = "xwalk.extensions";
+
+uint64_t NextExtensionMessageFlowId() {
+  uint32_t sequence = static_cast<uint32_t>(
+      base::subtle::NoBarrier_AtomicIncrement(&g_last_flow_sequence, 1));
+  return (static_cast<uint64_t>(base::GetCurrentProcId()) << 32) | sequence;
+}
+
+const int ExtensionStats::kSyncWaitBucketsMs[] = {1, 4, 16, 64, 256, 1024};
+const size_t ExtensionStats::kSyncWaitBuckets =
+    arraysize(ExtensionStats::kSyncWaitBucketsMs) + 1;
+
+ExtensionStats::Counters::Counters()
+    : messages_to_native(0),
+      bytes_to_native(0),
+      sync_messages(0),
+      messages_to_js(0),
+      bytes_to_js(0),
+      inline_messages_to_js(0),
+      shared_memory_messages_to_js(0),
+      sync_wait_histogram(kSyncWaitBuckets, 0),
+      queue_depth(0),
+      max_queue_depth(0) {
+}
+
+ExtensionStats::Counters::Counters(const Counters& other) = default;
+
+ExtensionStats::Counters::~Counters() {
+}
+
+ExtensionStats::ExtensionStats() {
+}
+
+ExtensionStats::~ExtensionStats() {
+}
+
+void ExtensionStats::RecordMessageToNative(size_t bytes, bool sync) {
+  base::AutoLock lock(lock_);
+  ++counters_.messages_to_native;
+  counters_.bytes_to_native += bytes;
+  if (sync)
+    ++counters_.sync_messages;
+}
+
+void ExtensionStats::RecordMessageToJS(size_t bytes, bool shared_memory) {
+  base::AutoLock lock(lock_);
+  ++counters_.messages_to_js;
+  counters_.bytes_to_js += bytes;
+  if (shared_memory)
+    ++counters_.shared_memory_messages_to_js;
+  else
+    ++counters_.inline_messages_to_js;
+}
+
+void ExtensionStats::RecordSyncWait(base::TimeDelta wait) {
+  const int* bucket =
+      std::upper_bound(kSyncWaitBucketsMs,
+                       kSyncWaitBucketsMs + arraysize(kSyncWaitBucketsMs),
+                       static_cast<int>(wait.InMilliseconds()));
+  base::AutoLock lock(lock_);
+  ++counters_.sync_wait_histogram[bucket - kSyncWaitBucketsMs];
+}
+
+void ExtensionStats::RecordMessageQueued() {
+  base::AutoLock lock(lock_);
+  ++counters_.queue_depth;
+  counters_.max_queue_depth =
+      std::max(counters_.max_queue_depth, counters_.queue_depth);
+}
+
+void ExtensionStats::RecordMessageDequeued() {
+  base::AutoLock lock(lock_);
+  DCHECK_GT(counters_.queue_depth, 0);
+  --counters_.queue_depth;
+}
+
+ExtensionStats::Counters ExtensionStats::GetCounters() const {
+  base::AutoLock lock(lock_);
+  return counters_;
+}
+
+// static
+XWalkExtensionStats* XWalkExtensionStats::GetInstance() {
+  return base::Singleton<
+      XWalkExtensionStats,
+      base::LeakySingletonTraits<XWalkExtensionStats>>::get();
+}
+
+XWalkExtensionStats::XWalkExtensionStats() {
+}
+
+XWalkExtensionStats::~XWalkExtensionStats() {
+}
+
+ExtensionStats* XWalkExtensionStats::ForExtension(
+    const std::string& extension_name) {
+  base::AutoLock lock(lock_);
+  std::unique_ptr<ExtensionStats>& stats = stats_[extension_name];
+  if (!stats)
+    stats.reset(new ExtensionStats);
+  return stats.get();
+}
+
+std::map<std::string, ExtensionStats::Counters>
+XWalkExtensionStats::GetCounters() const {
+  std::map<std::string, ExtensionStats::Counters> counters;
+  base::AutoLock lock(lock_);
+  for (const auto& stats : stats_)
+    counters[stats.first] = stats.second->GetCounters();
+  return counters;
+}
+
+std::unique_ptr<base::DictionaryValue> XWalkExtensionStats::ToValue() const {
+  std::unique_ptr<base::DictionaryValue> value(new base::DictionaryValue);
+  for (const auto& it : GetCounters()) {
+    const ExtensionStats::Counters& counters = it.second;
+    std::unique_ptr<base::DictionaryValue> dict(new base::DictionaryValue);
+    SetCounter(dict.get(), "messages_to_native", counters.messages_to_native);
+    SetCounter(dict.get(), "bytes_to_native", counters.bytes_to_native);
+    SetCounter(dict.get(), "sync_messages", counters.sync_messages);
+    SetCounter(dict.get(), "messages_to_js", counters.messages_to_js);
+    SetCounter(dict.get(), "bytes_to_js", counters.bytes_to_js);
+    SetCounter(dict.get(), "inline_messages_to_js",
+               counters.inline_messages_to_js);
+    SetCounter(dict.get(), "shared_memory_messages_to_js",
+               counters.shared_memory_messages_to_js);
+    std::unique_ptr<base::ListValue> histogram(new base::ListValue);
+    for (uint64_t count : counters.sync_wait_histogram)
+      histogram->AppendDouble(static_cast<double>(count));
+    dict->Set("sync_wait_histogram", std::move(histogram));
+    SetCounter(dict.get(), "queue_depth", counters.queue_depth);
+    SetCounter(dict.get(), "max_queue_depth", counters.max_queue_depth);
+    // Extension names may contain dots, which Set() would take as a path.
+    value->SetWithoutPathExpansion(it.first, std::move(dict));
+  }
+  return value;
+}
+
+void XWalkExtensionStats::DumpIfRequested() const {
+  if (!base::CommandLine::ForCurrentProcess()->HasSwitch(
+          switches::kXWalkDumpExtensionStats)) {
+    return;
+  }
+  std::string json;
+  base::JSONWriter::WriteWithOptions(
+      *ToValue(), base::JSONWriter::OPTIONS_PRETTY_PRINT, &json);
+  LOG(INFO) << "Extension stats of process " << base::GetCurrentProcId()
+            << " (sync wait buckets end at 1, 4, 16, 64, 256 and 1024 ms):\n"
+            << json;
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,117 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_STATS_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/singleton.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+
+namespace base {
+class DictionaryValue;
+}
+
+namespace xwalk {
+namespace extensions {
+
+// The trace category of the extension messages. Each message carries a flow
+// id, so a trace links its steps across the renderer, browser and extension
+// processes.
+extern const char kExtensionTraceCategory[];
+
+// Returns an id unique across processes, for the flow of a message.
+uint64_t NextExtensionMessageFlowId();
+
+// The counters of the messages exchanged with the instances of one extension,
+// in the current process.
+class ExtensionStats {
+ public:
+  // Exclusive upper bounds of the buckets of the sync wait histogram. The
+  // last bucket holds the longer waits.
+  static const int kSyncWaitBucketsMs[];
+  static const size_t kSyncWaitBuckets;
+
+  struct Counters {
+    Counters();
+    Counters(const Counters& other);
+    ~Counters();
+
+    uint64_t messages_to_native;
+    uint64_t bytes_to_native;
+    uint64_t sync_messages;
+    uint64_t messages_to_js;
+    uint64_t bytes_to_js;
+    uint64_t inline_messages_to_js;
+    uint64_t shared_memory_messages_to_js;
+    // How long the instances took to reply to sync messages, counted in
+    // the buckets of kSyncWaitBucketsMs.
+    std::vector<uint64_t> sync_wait_histogram;
+    // Messages routed to the thread of the instances and not handled yet.
+    int64_t queue_depth;
+    int64_t max_queue_depth;
+  };
+
+  ExtensionStats();
+  ~ExtensionStats();
+
+  void RecordMessageToNative(size_t bytes, bool sync);
+  void RecordMessageToJS(size_t bytes, bool shared_memory);
+  void RecordSyncWait(base::TimeDelta wait);
+  void RecordMessageQueued();
+  void RecordMessageDequeued();
+
+  Counters GetCounters() const;
+
+ private:
+  mutable base::Lock lock_;
+  Counters counters_;
+
+  DISALLOW_COPY_AND_ASSIGN(ExtensionStats);
+};
+
+// The ExtensionStats of every extension which got a message in the current
+// process. Lives until the process exits.
+class XWalkExtensionStats {
+ public:
+  static XWalkExtensionStats* GetInstance();
+
+  // The returned object is never deleted, so callers can keep it for the
+  // lifetime of the instances of |extension_name|.
+  ExtensionStats* ForExtension(const std::string& extension_name);
+
+  std::map<std::string, ExtensionStats::Counters> GetCounters() const;
+
+  // Returns the counters keyed by extension name, e.g. for a debug page.
+  std::unique_ptr<base::DictionaryValue> ToValue() const;
+
+  // Logs the counters if the process was started with
+  // --dump-extension-stats.
+  void DumpIfRequested() const;
+
+ private:
+  friend struct base::DefaultSingletonTraits<XWalkExtensionStats>;
+
+  XWalkExtensionStats();
+  ~XWalkExtensionStats();
+
+  mutable base::Lock lock_;
+  std::map<std::string, std::unique_ptr<ExtensionStats>> stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExtensionStats);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTENSION_STATS_H_
@@ -0,0 +1,146 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_extension_stats.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "xwalk/extensions/common/xwalk_extension.h"
+#include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_server.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+const int64_t kInstanceId = 1;
+
+// Answers every message with the message itself.
+class EchoInstance : public XWalkExtensionInstance {
+ public:
+  EchoInstance() {}
+
+  void HandleMessage(std::unique_ptr<base::Value> msg) override {
+    PostMessageToJS(std::move(msg));
+  }
+
+  void HandleSyncMessage(std::unique_ptr<base::Value> msg) override {
+    SendSyncReplyToJS(std::move(msg));
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(EchoInstance);
+};
+
+class EchoExtension : public XWalkExtension {
+ public:
+  explicit EchoExtension(const std::string& name) {
+    set_name(name);
+    set_javascript_api("");
+  }
+
+  XWalkExtensionInstance* CreateInstance() override {
+    return new EchoInstance;
+  }
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(EchoExtension);
+};
+
+}  // namespace
+
+TEST(XWalkExtensionStatsTest, CountersAdvance) {
+  ExtensionStats stats;
+  stats.RecordMessageToNative(100, false);
+  stats.RecordMessageToNative(50, true);
+  stats.RecordMessageToJS(10, false);
+  stats.RecordMessageToJS(300000, true);
+  stats.RecordSyncWait(base::TimeDelta::FromMicroseconds(500));
+  stats.RecordSyncWait(base::TimeDelta::FromMilliseconds(20));
+  stats.RecordSyncWait(base::TimeDelta::FromSeconds(5));
+  stats.RecordMessageQueued();
+  stats.RecordMessageQueued();
+  stats.RecordMessageDequeued();
+
+  ExtensionStats::Counters counters = stats.GetCounters();
+  EXPECT_EQ(2u, counters.messages_to_native);
+  EXPECT_EQ(150u, counters.bytes_to_native);
+  EXPECT_EQ(1u, counters.sync_messages);
+  EXPECT_EQ(2u, counters.messages_to_js);
+  EXPECT_EQ(300010u, counters.bytes_to_js);
+  EXPECT_EQ(1u, counters.inline_messages_to_js);
+  EXPECT_EQ(1u, counters.shared_memory_messages_to_js);
+  ASSERT_EQ(ExtensionStats::kSyncWaitBuckets,
+            counters.sync_wait_histogram.size());
+  EXPECT_EQ(1u, counters.sync_wait_histogram[0]);
+  EXPECT_EQ(1u, counters.sync_wait_histogram[3]);
+  EXPECT_EQ(1u, counters.sync_wait_histogram.back());
+  EXPECT_EQ(1, counters.queue_depth);
+  EXPECT_EQ(2, counters.max_queue_depth);
+}
+
+TEST(XWalkExtensionStatsTest, ServerRecordsMessages) {
+  const std::string name = "stats_server_test";
+  XWalkExtensionServer server;
+  ASSERT_TRUE(server.RegisterExtension(
+      std::unique_ptr<XWalkExtension>(new EchoExtension(name))));
+  server.OnMessageReceived(
+      XWalkExtensionServerMsg_CreateInstance(kInstanceId, name));
+
+  base::ListValue contents;
+  contents.AppendString("ping");
+  XWalkExtensionServerMsg_PostMessageToNative post_message(
+      kInstanceId, NextExtensionMessageFlowId(), contents);
+  server.OnMessageReceived(post_message);
+
+  // The server has no channel, so the reply is dropped.
+  base::ListValue reply;
+  XWalkExtensionServerMsg_SendSyncMessageToNative sync_message(
+      kInstanceId, NextExtensionMessageFlowId(), contents, &reply);
+  server.OnMessageReceived(sync_message);
+
+  std::map<std::string, ExtensionStats::Counters> all_counters =
+      XWalkExtensionStats::GetInstance()->GetCounters();
+  ASSERT_TRUE(all_counters.count(name));
+  const ExtensionStats::Counters& counters = all_counters[name];
+  EXPECT_EQ(2u, counters.messages_to_native);
+  EXPECT_EQ(post_message.size() + sync_message.size(),
+            counters.bytes_to_native);
+  EXPECT_EQ(1u, counters.sync_messages);
+  // The echo of the posted message and the sync reply.
+  EXPECT_EQ(2u, counters.messages_to_js);
+  EXPECT_EQ(2u, counters.inline_messages_to_js);
+  EXPECT_EQ(0u, counters.shared_memory_messages_to_js);
+  EXPECT_GT(counters.bytes_to_js, 0u);
+  uint64_t sync_waits = 0;
+  for (uint64_t count : counters.sync_wait_histogram)
+    sync_waits += count;
+  EXPECT_EQ(1u, sync_waits);
+
+  std::unique_ptr<base::DictionaryValue> value =
+      XWalkExtensionStats::GetInstance()->ToValue();
+  base::DictionaryValue* dict = nullptr;
+  ASSERT_TRUE(value->GetDictionaryWithoutPathExpansion(name, &dict));
+  double messages_to_native = 0;
+  EXPECT_TRUE(dict->GetDouble("messages_to_native", &messages_to_native));
+  EXPECT_EQ(2, messages_to_native);
+}
+
+TEST(XWalkExtensionStatsTest, FlowIdsAreUnique) {
+  uint64_t first = NextExtensionMessageFlowId();
+  uint64_t second = NextExtensionMessageFlowId();
+  EXPECT_NE(first, second);
+  EXPECT_EQ(first >> 32, second >> 32);
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -26,4 +26,13 @@ const char kXWalkExtensionCmdPrefix[] = "xwalk-extension-cmd-prefix";
 // Disable XWalkExtensionSystem and all extensions
 const char kXWalkDisableExtensions[] = "disable-xwalk-extensions";
 
+// Don't keep an extension process launched in advance for the next render
+// process, e.g. when the extensions have side effects in XW_Initialize().
+const char kXWalkDisableSpareExtensionProcess[] =
+    "disable-spare-extension-process";
+
+// Logs the message counters of every extension when the browser and the
+// extension processes exit.
+const char kXWalkDumpExtensionStats[] = "dump-extension-stats";
+
 }  // namespace switches
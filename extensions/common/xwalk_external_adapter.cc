@@ -4,15 +4,15 @@
 
 #include "xwalk/extensions/common/xwalk_external_adapter.h"
 
+#include <string.h>
+
+#include "base/bind.h"
 #include "base/logging.h"
-#include "base/stl_util.h"
 
 namespace xwalk {
 namespace extensions {
 
-XWalkExternalAdapter::XWalkExternalAdapter()
-    : next_xw_extension_(1),
-      next_xw_instance_(1) {}
+XWalkExternalAdapter::XWalkExternalAdapter() {}
 
 XWalkExternalAdapter::~XWalkExternalAdapter() {}
 
@@ -20,42 +20,27 @@ XWalkExternalAdapter* XWalkExternalAdapter::GetInstance() {
   return base::Singleton<XWalkExternalAdapter>::get();
 }
 
-XW_Extension XWalkExternalAdapter::GetNextXWExtension() {
-  return next_xw_extension_++;
-}
-
-XW_Instance XWalkExternalAdapter::GetNextXWInstance() {
-  return next_xw_instance_++;
-}
-
-void XWalkExternalAdapter::RegisterExtension(
+XW_Extension XWalkExternalAdapter::RegisterExtension(
     XWalkExternalExtension* extension) {
-  XW_Extension xw_extension = extension->xw_extension_;
-  CHECK(IsValidXWExtension(xw_extension));
-  CHECK(!ContainsKey(extension_map_, xw_extension));
-  extension_map_[xw_extension] = extension;
+  XW_Extension xw_extension = extensions_.Add(extension);
+  CHECK(xw_extension);
+  return xw_extension;
 }
 
 void XWalkExternalAdapter::UnregisterExtension(
     XWalkExternalExtension* extension) {
-  XW_Extension xw_extension = extension->xw_extension_;
-  CHECK(IsValidXWExtension(xw_extension));
-  CHECK(ContainsKey(extension_map_, xw_extension));
-  extension_map_.erase(xw_extension);
+  extensions_.Remove(extension->xw_extension_);
 }
 
-void XWalkExternalAdapter::RegisterInstance(XWalkExternalInstance* context) {
-  XW_Instance xw_instance = context->xw_instance_;
-  CHECK(IsValidXWInstance(xw_instance));
-  CHECK(!ContainsKey(instance_map_, xw_instance));
-  instance_map_[xw_instance] = context;
+XW_Instance XWalkExternalAdapter::RegisterInstance(
+    XWalkExternalInstance* context) {
+  XW_Instance xw_instance = instances_.Add(context);
+  CHECK(xw_instance);
+  return xw_instance;
 }
 
 void XWalkExternalAdapter::UnregisterInstance(XWalkExternalInstance* context) {
-  XW_Instance xw_instance = context->xw_instance_;
-  CHECK(IsValidXWInstance(xw_instance));
-  CHECK(ContainsKey(instance_map_, xw_instance));
-  instance_map_.erase(xw_instance);
+  instances_.Remove(context->xw_instance_);
 }
 
 const void* XWalkExternalAdapter::GetInterface(const char* name) {
@@ -89,6 +74,20 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &messagingInterface2;
   }
 
+  if (!strcmp(name, XW_MESSAGING_INTERFACE_3)) {
+    static const XW_MessagingInterface_3 messagingInterface3 = {
+      Messaging3Register,
+      Messaging3PostMessage,
+      MessagingRegisterBinaryMessageCallback,
+      MessagingPostBinaryMessage,
+      Messaging3AllocateBuffer,
+      Messaging3FreeBuffer,
+      Messaging3PostBinaryBuffer,
+      Messaging3PostExternalBuffer
+    };
+    return &messagingInterface3;
+  }
+
   if (!strcmp(name, XW_INTERNAL_SYNC_MESSAGING_INTERFACE_1)) {
     static const XW_Internal_SyncMessagingInterface_1
         syncMessagingInterface1 = {
@@ -120,36 +119,39 @@ const void* XWalkExternalAdapter::GetInterface(const char* name) {
     return &permissionsInterface1;
   }
 
+  if (!strcmp(name, XW_INTERNAL_PERMISSIONS_INTERFACE_2)) {
+    static const XW_Internal_PermissionsInterface_2 permissionsInterface2 = {
+      PermissionsCheckAPIAccessControl,
+      PermissionsRegisterPermissions,
+      PermissionsCheckAPIAccessControlAsync
+    };
+    return &permissionsInterface2;
+  }
+
   LOG(WARNING) << "Interface '" << name << "' is not supported.";
   return NULL;
 }
 
-bool XWalkExternalAdapter::IsValidXWExtension(XW_Extension xw_extension) {
-  return xw_extension > 0 && xw_extension < next_xw_extension_;
+// static
+XWalkExternalHandleTable* XWalkExternalAdapter::GetExtensionTable() {
+  return &XWalkExternalAdapter::GetInstance()->extensions_;
 }
 
-bool XWalkExternalAdapter::IsValidXWInstance(XW_Instance xw_instance) {
-  return xw_instance > 0 && xw_instance < next_xw_instance_;
+// static
+XWalkExternalHandleTable* XWalkExternalAdapter::GetInstanceTable() {
+  return &XWalkExternalAdapter::GetInstance()->instances_;
 }
 
-XWalkExternalExtension* XWalkExternalAdapter::GetExtension(
-    XW_Extension xw_extension) {
-  XWalkExternalAdapter* adapter = XWalkExternalAdapter::GetInstance();
-  ExtensionMap::iterator it = adapter->extension_map_.find(xw_extension);
-  if (it == adapter->extension_map_.end())
-    return NULL;
-  return it->second;
-}
+namespace {
 
-XWalkExternalInstance* XWalkExternalAdapter::GetInstance(
-    XW_Instance xw_instance) {
-  XWalkExternalAdapter* adapter = XWalkExternalAdapter::GetInstance();
-  InstanceMap::iterator it = adapter->instance_map_.find(xw_instance);
-  if (it == adapter->instance_map_.end())
-    return NULL;
-  return it->second;
+void RunCheckAPIAccessControlCallback(
+    XW_Extension xw, XW_CheckAPIAccessControlCallback callback,
+    void* user_data, bool allowed) {
+  callback(xw, allowed ? XW_OK : XW_ERROR, user_data);
 }
 
+}  // namespace
+
 // static
 void XWalkExternalAdapter::LogInvalidCall(
     int32_t value, const char* type,
@@ -160,8 +162,8 @@ void XWalkExternalAdapter::LogInvalidCall(
 
 int XWalkExternalAdapter::PermissionsCheckAPIAccessControl(XW_Extension xw,
     const char* api_name) {
-  XWalkExtension* ptr = GetExtension(xw);
-  if (!ptr) {
+  ScopedExternalHandleRef<XWalkExternalExtension> ptr(GetExtensionTable(), xw);
+  if (!ptr.get()) {
     LogInvalidCall(xw, "Extension", "Permissions", "CheckAPIAccessControl");
     return XW_ERROR;
   }
@@ -170,13 +172,66 @@ int XWalkExternalAdapter::PermissionsCheckAPIAccessControl(XW_Extension xw,
 
 int XWalkExternalAdapter::PermissionsRegisterPermissions(XW_Extension xw,
     const char* perm_table) {
-  XWalkExtension* ptr = GetExtension(xw);
-  if (!ptr) {
+  ScopedExternalHandleRef<XWalkExternalExtension> ptr(GetExtensionTable(), xw);
+  if (!ptr.get()) {
     LogInvalidCall(xw, "Extension", "Permissions", "RegisterPermissions");
     return XW_ERROR;
   }
   return ptr->RegisterPermissions(perm_table) ? XW_OK : XW_ERROR;
 }
 
+void XWalkExternalAdapter::PermissionsCheckAPIAccessControlAsync(
+    XW_Extension xw, const char* api_name,
+    XW_CheckAPIAccessControlCallback callback, void* user_data) {
+  if (!callback)
+    return;
+  ScopedExternalHandleRef<XWalkExternalExtension> ptr(GetExtensionTable(), xw);
+  if (!ptr.get()) {
+    LogInvalidCall(xw, "Extension", "Permissions",
+                   "CheckAPIAccessControlAsync");
+    callback(xw, XW_ERROR, user_data);
+    return;
+  }
+  ptr->CheckAPIAccessControlAsync(api_name, base::Bind(
+      &RunCheckAPIAccessControlCallback, xw, callback, user_data));
+}
+
+// static
+char* XWalkExternalAdapter::Messaging3AllocateBuffer(size_t size) {
+  return new char[size];
+}
+
+// static
+void XWalkExternalAdapter::Messaging3FreeBuffer(char* buffer) {
+  delete[] buffer;
+}
+
+// static
+void XWalkExternalAdapter::Messaging3PostBinaryBuffer(XW_Instance xw,
+                                                      char* buffer,
+                                                      size_t size) {
+  ScopedExternalHandleRef<XWalkExternalInstance> ptr(GetInstanceTable(), xw);
+  if (!ptr.get()) {
+    LogInvalidCall(xw, "Instance", "Messaging3", "PostBinaryBuffer");
+    delete[] buffer;
+    return;
+  }
+  ptr->Messaging3PostBinaryBuffer(buffer, size);
+}
+
+// static
+void XWalkExternalAdapter::Messaging3PostExternalBuffer(
+    XW_Instance xw, const char* buffer, size_t size,
+    XW_ReleaseBufferCallback release, void* user_data) {
+  ScopedExternalHandleRef<XWalkExternalInstance> ptr(GetInstanceTable(), xw);
+  if (!ptr.get()) {
+    LogInvalidCall(xw, "Instance", "Messaging3", "PostExternalBuffer");
+    if (release)
+      release(buffer, user_data);
+    return;
+  }
+  ptr->Messaging3PostExternalBuffer(buffer, size, release, user_data);
+}
+
 }  // namespace extensions
 }  // namespace xwalk
@@ -5,34 +5,37 @@
 #ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_ADAPTER_H_
 #define XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_ADAPTER_H_
 
-#include <map>
 #include "base/memory/singleton.h"
 #include "xwalk/extensions/public/XW_Extension.h"
 #include "xwalk/extensions/public/XW_Extension_Message_2.h"
+#include "xwalk/extensions/public/XW_Extension_Message_3.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 #include "xwalk/extensions/public/XW_Extension_EntryPoints.h"
 #include "xwalk/extensions/public/XW_Extension_Permissions.h"
 #include "xwalk/extensions/public/XW_Extension_Runtime.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
+#include "xwalk/extensions/common/xwalk_external_handle_table.h"
 #include "xwalk/extensions/common/xwalk_external_instance.h"
 
 // NOTE: Those macros define functions that are used in the structs by
 // GetInterface(). They dispatch the function to the appropriate
-// extension or instance.
-
-#define DEFINE_FUNCTION_1(TYPE, INTERFACE, NAME, ARG1)          \
-  static void INTERFACE ## NAME(XW_ ## TYPE xw, ARG1 arg1) {    \
-    XWalkExternal ## TYPE * ptr = Get ## TYPE(xw);              \
-    if (!ptr)                                                   \
-      LogInvalidCall(xw, #TYPE, #INTERFACE, #NAME);             \
-    else                                                        \
-      ptr->INTERFACE ## NAME(arg1);                             \
+// extension or instance, which cannot be destroyed during the call.
+
+#define DEFINE_FUNCTION_1(TYPE, INTERFACE, NAME, ARG1)                  \
+  static void INTERFACE ## NAME(XW_ ## TYPE xw, ARG1 arg1) {            \
+    ScopedExternalHandleRef<XWalkExternal ## TYPE> ptr(                 \
+        Get ## TYPE ## Table(), xw);                                    \
+    if (!ptr.get())                                                     \
+      LogInvalidCall(xw, #TYPE, #INTERFACE, #NAME);                     \
+    else                                                                \
+      ptr->INTERFACE ## NAME(arg1);                                     \
   }
 
 #define DEFINE_FUNCTION_2(TYPE, INTERFACE, NAME, ARG1, ARG2)             \
   static void INTERFACE ## NAME(XW_ ## TYPE xw, ARG1 arg1, ARG2 arg2) {  \
-    XWalkExternal ## TYPE * ptr = Get ## TYPE(xw);                       \
-    if (!ptr)                                                            \
+    ScopedExternalHandleRef<XWalkExternal ## TYPE> ptr(                  \
+        Get ## TYPE ## Table(), xw);                                     \
+    if (!ptr.get())                                                      \
       LogInvalidCall(xw, #TYPE, #INTERFACE, #NAME);                      \
     else                                                                 \
       ptr->INTERFACE ## NAME(arg1, arg2);                                \
@@ -40,8 +43,9 @@
 
 #define DEFINE_FUNCTION_3(TYPE, INTERFACE, NAME, A1, A2, A3)           \
   static void INTERFACE ## NAME(XW_ ## TYPE xw, A1 a1, A2 a2, A3 a3) { \
-    XWalkExternal ## TYPE * ptr = Get ## TYPE(xw);                     \
-    if (ptr)                                                           \
+    ScopedExternalHandleRef<XWalkExternal ## TYPE> ptr(                \
+        Get ## TYPE ## Table(), xw);                                   \
+    if (ptr.get())                                                     \
       ptr->INTERFACE ## NAME(a1, a2, a3);                              \
     else                                                               \
       LogInvalidCall(xw, #TYPE, #INTERFACE, #NAME);                    \
@@ -49,8 +53,9 @@
 
 #define DEFINE_RET_FUNCTION_0(TYPE, INTERFACE, NAME, RET_ARG)   \
   static RET_ARG INTERFACE ## NAME(XW_ ## TYPE xw) {            \
-    XWalkExternal ## TYPE * ptr = Get ## TYPE(xw);              \
-    if (ptr)                                                    \
+    ScopedExternalHandleRef<XWalkExternal ## TYPE> ptr(         \
+        Get ## TYPE ## Table(), xw);                            \
+    if (ptr.get())                                              \
       return ptr->INTERFACE ## NAME();                          \
     LogInvalidCall(xw, #TYPE, #INTERFACE, #NAME);               \
     return NULL;                                                \
@@ -66,21 +71,23 @@ class XWalkExternalInstance;
 // functions from external extension to their implementations in
 // XWalkExternalExtension and XWalkExternalInstance. We have only one
 // adapter per process.
+//
+// The C functions can be called from any thread, the XW_Extension and
+// XW_Instance handles are resolved through XWalkExternalHandleTable.
 class XWalkExternalAdapter {
  public:
   static XWalkExternalAdapter* GetInstance();
 
-  XW_Extension GetNextXWExtension();
-  XW_Instance GetNextXWInstance();
-
-  // This adds the extension to the adapter's mapping, so C calls to
-  // its corresponding XW_Extension are correctly dispatched.
-  void RegisterExtension(XWalkExternalExtension* extension);
+  // This adds the extension to the adapter's mapping and returns its
+  // XW_Extension, so C calls to it are correctly dispatched.
+  XW_Extension RegisterExtension(XWalkExternalExtension* extension);
+  // Waits for the C calls to the extension running on other threads.
   void UnregisterExtension(XWalkExternalExtension* extension);
 
-  // This adds the context to the adapter's mapping, so C calls to
-  // its corresponding XW_Instance are correctly dispatched.
-  void RegisterInstance(XWalkExternalInstance* context);
+  // This adds the context to the adapter's mapping and returns its
+  // XW_Instance, so C calls to it are correctly dispatched.
+  XW_Instance RegisterInstance(XWalkExternalInstance* context);
+  // Waits for the C calls to the instance running on other threads.
   void UnregisterInstance(XWalkExternalInstance* context);
 
   // Returns the correct struct according to interface asked. This is
@@ -93,13 +100,10 @@ class XWalkExternalAdapter {
   XWalkExternalAdapter();
   ~XWalkExternalAdapter();
 
-  bool IsValidXWExtension(XW_Extension xw_extension);
-  bool IsValidXWInstance(XW_Instance xw_instance);
-
   // Used by the DEFINE_* macros to bridge the calls using C API identifiers
   // XW_Extension and XW_Instance to the right C++ object.
-  static XWalkExternalExtension* GetExtension(XW_Extension xw_extension);
-  static XWalkExternalInstance* GetInstance(XW_Instance xw_instance);
+  static XWalkExternalHandleTable* GetExtensionTable();
+  static XWalkExternalHandleTable* GetInstanceTable();
   static void LogInvalidCall(int32_t value, const char* type,
                              const char* interface, const char* function);
 
@@ -121,6 +125,11 @@ class XWalkExternalAdapter {
   static int PermissionsRegisterPermissions(XW_Extension xw,
       const char* perm_table);
 
+  // XW_Internal_PermissionsInterface_2 from XW_Extension_Permissions.h
+  static void PermissionsCheckAPIAccessControlAsync(XW_Extension xw,
+      const char* api_name, XW_CheckAPIAccessControlCallback callback,
+      void* user_data);
+
   // XW_MessagingInterface_1 from XW_Extension.h.
   DEFINE_FUNCTION_1(Extension, Messaging, Register, XW_HandleMessageCallback);
   DEFINE_FUNCTION_1(Instance, Messaging, PostMessage, const char*);
@@ -131,6 +140,21 @@ class XWalkExternalAdapter {
   DEFINE_FUNCTION_2(Instance, Messaging, PostBinaryMessage, const char*,
                     size_t);
 
+  // XW_MessagingInterface_3 from XW_Extension_Message_3.h. The functions
+  // transferring a buffer are written by hand since they must dispose of it
+  // when the instance is invalid.
+  DEFINE_FUNCTION_1(Extension, Messaging3, Register,
+                    XW_HandleSizedMessageCallback);
+  DEFINE_FUNCTION_2(Instance, Messaging3, PostMessage, const char*, size_t);
+  static char* Messaging3AllocateBuffer(size_t size);
+  static void Messaging3FreeBuffer(char* buffer);
+  static void Messaging3PostBinaryBuffer(XW_Instance xw, char* buffer,
+                                         size_t size);
+  static void Messaging3PostExternalBuffer(XW_Instance xw,
+                                           const char* buffer, size_t size,
+                                           XW_ReleaseBufferCallback release,
+                                           void* user_data);
+
   // XW_Internal_SyncMessaging_1 from XW_Extension_SyncMessage.h.
   DEFINE_FUNCTION_1(Extension, SyncMessaging, Register,
                     XW_HandleSyncMessageCallback);
@@ -140,14 +164,8 @@ class XWalkExternalAdapter {
   DEFINE_FUNCTION_3(Extension, Runtime, GetStringVariable, const char *,
                     char*, size_t);
 
-  typedef std::map<XW_Extension, XWalkExternalExtension*> ExtensionMap;
-  ExtensionMap extension_map_;
-
-  typedef std::map<XW_Instance, XWalkExternalInstance*> InstanceMap;
-  InstanceMap instance_map_;
-
-  XW_Extension next_xw_extension_;
-  XW_Instance next_xw_instance_;
+  XWalkExternalHandleTable extensions_;
+  XWalkExternalHandleTable instances_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExternalAdapter);
 };
@@ -25,6 +25,7 @@ XWalkExternalExtension::XWalkExternalExtension(const base::FilePath& path)
       handle_msg_callback_(NULL),
       handle_sync_msg_callback_(NULL),
       handle_binary_msg_callback_(NULL),
+      handle_sized_msg_callback_(NULL),
       initialized_(false) {
 }
 
@@ -66,10 +67,10 @@ bool XWalkExternalExtension::Initialize() {
   }
 
   XWalkExternalAdapter* external_adapter = XWalkExternalAdapter::GetInstance();
-  xw_extension_ = external_adapter->GetNextXWExtension();
-  external_adapter->RegisterExtension(this);
+  xw_extension_ = external_adapter->RegisterExtension(this);
   int ret = initialize(xw_extension_, XWalkExternalAdapter::GetInterface);
   if (ret != XW_OK) {
+    external_adapter->UnregisterExtension(this);
 #if TENTA_LOG_ENABLE == 1
     LOG(WARNING) << "Error loading extension '"
                  << library_path_.AsUTF8Unsafe() << "': "
@@ -83,9 +84,7 @@ bool XWalkExternalExtension::Initialize() {
 }
 
 XWalkExtensionInstance* XWalkExternalExtension::CreateInstance() {
-  XW_Instance xw_instance =
-      XWalkExternalAdapter::GetInstance()->GetNextXWInstance();
-  return new XWalkExternalInstance(this, xw_instance);
+  return new XWalkExternalInstance(this);
 }
 
 #define RETURN_IF_INITIALIZED(FUNCTION)                          \
@@ -132,6 +131,12 @@ void XWalkExternalExtension::MessagingRegisterBinaryMessageCallback(
   handle_binary_msg_callback_ = callback;
 }
 
+void XWalkExternalExtension::Messaging3Register(
+    XW_HandleSizedMessageCallback callback) {
+  RETURN_IF_INITIALIZED("Register from MessagingInterface_3");
+  handle_sized_msg_callback_ = callback;
+}
+
 void XWalkExternalExtension::SyncMessagingRegister(
     XW_HandleSyncMessageCallback callback) {
   RETURN_IF_INITIALIZED("Register from Internal_SyncMessagingInterface");
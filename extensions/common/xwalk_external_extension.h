@@ -12,6 +12,7 @@
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/public/XW_Extension.h"
 #include "xwalk/extensions/public/XW_Extension_Message_2.h"
+#include "xwalk/extensions/public/XW_Extension_Message_3.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 #include "base/memory/ptr_util.h"
 
@@ -72,6 +73,9 @@ class XWalkExternalExtension : public XWalkExtension {
   void MessagingRegisterBinaryMessageCallback(
       XW_HandleBinaryMessageCallback callback);
 
+  // XW_MessagingInterface_3 (from XW_Extension_Message_3.h) implementation.
+  void Messaging3Register(XW_HandleSizedMessageCallback callback);
+
   // XW_Internal_SyncMessagingInterface_1 (from XW_Extension.h) implementation.
   void SyncMessagingRegister(XW_HandleSyncMessageCallback callback);
 
@@ -88,6 +92,7 @@ class XWalkExternalExtension : public XWalkExtension {
   XW_HandleMessageCallback handle_msg_callback_;
   XW_HandleSyncMessageCallback handle_sync_msg_callback_;
   XW_HandleBinaryMessageCallback handle_binary_msg_callback_;
+  XW_HandleSizedMessageCallback handle_sized_msg_callback_;
 
   bool initialized_;
 
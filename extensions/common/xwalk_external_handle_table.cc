@@ -0,0 +1,152 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_external_handle_table.h"
+
+#include "base/logging.h"
+#include "base/threading/platform_thread.h"
+
+namespace xwalk {
+namespace extensions {
+
+namespace {
+
+const int kGenerationShift = 16;
+const int32_t kIndexMask = (1 << kGenerationShift) - 1;
+const int32_t kMaxGeneration = 0x7fff;
+
+const base::subtle::Atomic32 kRefCountMask = 0x7fff;
+const base::subtle::Atomic32 kInUseBit = 0x8000;
+
+int32_t GetIndex(int32_t handle) {
+  return handle & kIndexMask;
+}
+
+int32_t GetGeneration(int32_t value) {
+  return (value >> kGenerationShift) & kMaxGeneration;
+}
+
+}  // namespace
+
+const int32_t XWalkExternalHandleTable::kMaxHandles;
+
+XWalkExternalHandleTable::XWalkExternalHandleTable()
+    : next_unused_slot_(0) {
+  for (int i = 0; i < kPageCount; ++i)
+    pages_[i] = 0;
+}
+
+XWalkExternalHandleTable::~XWalkExternalHandleTable() {
+  for (int i = 0; i < kPageCount; ++i)
+    delete[] reinterpret_cast<Slot*>(pages_[i]);
+}
+
+int32_t XWalkExternalHandleTable::Add(void* object) {
+  DCHECK(object);
+  base::AutoLock lock(lock_);
+
+  int32_t index;
+  if (!free_slots_.empty()) {
+    index = free_slots_.front();
+    free_slots_.pop_front();
+  } else if (next_unused_slot_ < kMaxHandles) {
+    index = next_unused_slot_++;
+    int page = index / kSlotsPerPage;
+    if (!pages_[page]) {
+      Slot* slots = new Slot[kSlotsPerPage];
+      for (int i = 0; i < kSlotsPerPage; ++i) {
+        slots[i].state = 0;
+        slots[i].object = NULL;
+      }
+      base::subtle::Release_Store(&pages_[page],
+                                  reinterpret_cast<base::subtle::AtomicWord>(
+                                      slots));
+    }
+  } else {
+    LOG(ERROR) << "Too many external extension handles.";
+    return 0;
+  }
+
+  Slot* slot = GetSlot(index);
+  base::subtle::Atomic32 state = base::subtle::NoBarrier_Load(&slot->state);
+  DCHECK_EQ(0, state & (kRefCountMask | kInUseBit));
+
+  int32_t generation = GetGeneration(state) + 1;
+  if (generation > kMaxGeneration)
+    generation = 1;
+
+  // Publishing the new state makes |object| visible to Acquire().
+  slot->object = object;
+  base::subtle::Release_Store(&slot->state,
+                              (generation << kGenerationShift) | kInUseBit);
+
+  return (generation << kGenerationShift) | index;
+}
+
+void XWalkExternalHandleTable::Remove(int32_t handle) {
+  Slot* slot = GetSlot(GetIndex(handle));
+  CHECK(slot);
+
+  base::subtle::Atomic32 state;
+  for (;;) {
+    state = base::subtle::NoBarrier_Load(&slot->state);
+    CHECK(state & kInUseBit);
+    CHECK_EQ(GetGeneration(handle), GetGeneration(state));
+    if (base::subtle::Acquire_CompareAndSwap(
+            &slot->state, state, state & ~kInUseBit) == state)
+      break;
+  }
+
+  // No new reference can be taken from now on, wait for the current ones.
+  while (base::subtle::Acquire_Load(&slot->state) & kRefCountMask)
+    base::PlatformThread::YieldCurrentThread();
+
+  slot->object = NULL;
+
+  base::AutoLock lock(lock_);
+  free_slots_.push_back(GetIndex(handle));
+}
+
+void* XWalkExternalHandleTable::Acquire(int32_t handle) {
+  if (handle <= 0)
+    return NULL;
+
+  Slot* slot = GetSlot(GetIndex(handle));
+  if (!slot)
+    return NULL;
+
+  for (;;) {
+    base::subtle::Atomic32 state = base::subtle::NoBarrier_Load(&slot->state);
+    if (!(state & kInUseBit) ||
+        GetGeneration(state) != GetGeneration(handle))
+      return NULL;
+
+    if ((state & kRefCountMask) == kRefCountMask) {
+      LOG(ERROR) << "Too many concurrent calls for handle " << handle;
+      return NULL;
+    }
+
+    if (base::subtle::Acquire_CompareAndSwap(
+            &slot->state, state, state + 1) == state)
+      return slot->object;
+  }
+}
+
+void XWalkExternalHandleTable::Release(int32_t handle) {
+  Slot* slot = GetSlot(GetIndex(handle));
+  DCHECK(slot);
+  base::subtle::Barrier_AtomicIncrement(&slot->state, -1);
+}
+
+XWalkExternalHandleTable::Slot* XWalkExternalHandleTable::GetSlot(
+    int32_t index) const {
+  Slot* page = reinterpret_cast<Slot*>(
+      base::subtle::Acquire_Load(&pages_[index / kSlotsPerPage]));
+  if (!page)
+    return NULL;
+  return &page[index % kSlotsPerPage];
+}
+
+}  // namespace extensions
+}  // namespace xwalk
@@ -0,0 +1,105 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_HANDLE_TABLE_H_
+#define XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_HANDLE_TABLE_H_
+
+#include <stdint.h>
+
+#include <deque>
+
+#include "base/atomicops.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+
+namespace xwalk {
+namespace extensions {
+
+// Maps the integer handles of the C API (XW_Extension, XW_Instance) to the
+// objects implementing them.
+//
+// A handle packs the index of a slot and the generation of that slot. Slots
+// are recycled, but their generation changes every time, so a stale handle
+// never resolves to the object that took its slot.
+//
+// Resolving a handle is lock-free and can be done from any thread: Acquire()
+// pins the object until Release(), and Remove() waits for the pinned objects
+// to be released before returning. Adding and removing handles take a lock
+// and are expected to be rare.
+class XWalkExternalHandleTable {
+ public:
+  // Maximum number of handles alive at the same time.
+  static const int32_t kMaxHandles = 1 << 16;
+
+  XWalkExternalHandleTable();
+  ~XWalkExternalHandleTable();
+
+  // Returns a new handle for |object|, or 0 if the table is full.
+  int32_t Add(void* object);
+
+  // Invalidates |handle| and blocks until no other thread has it acquired.
+  // The calling thread must not have |handle| acquired.
+  void Remove(int32_t handle);
+
+  // Returns the object of |handle| and keeps it alive until Release() is
+  // called, or NULL if |handle| is invalid or was removed.
+  void* Acquire(int32_t handle);
+  void Release(int32_t handle);
+
+ private:
+  struct Slot {
+    // Bits 0-14 count the threads that acquired the slot, bit 15 is set
+    // while the slot is in use and bits 16-30 hold the generation.
+    base::subtle::Atomic32 state;
+    void* object;
+  };
+
+  static const int kSlotsPerPage = 1024;
+  static const int kPageCount = kMaxHandles / kSlotsPerPage;
+
+  // Returns NULL if the page of |index| was never allocated.
+  Slot* GetSlot(int32_t index) const;
+
+  // Pages are allocated on demand and never freed before the table, so
+  // readers do not need the lock to reach a slot.
+  base::subtle::AtomicWord pages_[kPageCount];
+
+  // Guards the slot allocation.
+  base::Lock lock_;
+  // Released slots, reused in FIFO order to make generations last longer.
+  std::deque<int32_t> free_slots_;
+  int32_t next_unused_slot_;
+
+  DISALLOW_COPY_AND_ASSIGN(XWalkExternalHandleTable);
+};
+
+// Pins the object behind a handle for the lifetime of the scope.
+template <typename T>
+class ScopedExternalHandleRef {
+ public:
+  ScopedExternalHandleRef(XWalkExternalHandleTable* table, int32_t handle)
+      : table_(table),
+        handle_(handle),
+        object_(static_cast<T*>(table->Acquire(handle))) {}
+
+  ~ScopedExternalHandleRef() {
+    if (object_)
+      table_->Release(handle_);
+  }
+
+  T* get() const { return object_; }
+  T* operator->() const { return object_; }
+
+ private:
+  XWalkExternalHandleTable* table_;
+  int32_t handle_;
+  T* object_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedExternalHandleRef);
+};
+
+}  // namespace extensions
+}  // namespace xwalk
+
+#endif  // XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_HANDLE_TABLE_H_
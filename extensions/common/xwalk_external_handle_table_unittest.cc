@@ -0,0 +1,117 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/common/xwalk_external_handle_table.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::extensions::ScopedExternalHandleRef;
+using xwalk::extensions::XWalkExternalHandleTable;
+
+namespace {
+
+class ResolvingThread : public base::SimpleThread {
+ public:
+  ResolvingThread(XWalkExternalHandleTable* table,
+                  int32_t handle,
+                  base::subtle::Atomic32* stop)
+      : base::SimpleThread("ResolvingThread"),
+        table_(table),
+        handle_(handle),
+        stop_(stop) {}
+
+  void Run() override {
+    while (!base::subtle::Acquire_Load(stop_)) {
+      ScopedExternalHandleRef<int> ref(table_, handle_);
+      if (!ref.get())
+        return;
+      EXPECT_EQ(42, *ref.get());
+    }
+  }
+
+ private:
+  XWalkExternalHandleTable* table_;
+  int32_t handle_;
+  base::subtle::Atomic32* stop_;
+};
+
+}  // namespace
+
+TEST(XWalkExternalHandleTableTest, AddAndResolve) {
+  XWalkExternalHandleTable table;
+  int a = 1;
+  int b = 2;
+
+  int32_t handle_a = table.Add(&a);
+  int32_t handle_b = table.Add(&b);
+  EXPECT_GT(handle_a, 0);
+  EXPECT_GT(handle_b, 0);
+  EXPECT_NE(handle_a, handle_b);
+
+  EXPECT_EQ(&a, table.Acquire(handle_a));
+  table.Release(handle_a);
+  EXPECT_EQ(&b, table.Acquire(handle_b));
+  table.Release(handle_b);
+
+  EXPECT_FALSE(table.Acquire(0));
+  EXPECT_FALSE(table.Acquire(-1));
+  EXPECT_FALSE(table.Acquire(handle_b + 1));
+}
+
+TEST(XWalkExternalHandleTableTest, StaleHandleDoesNotResolve) {
+  XWalkExternalHandleTable table;
+  int a = 1;
+  int b = 2;
+
+  int32_t handle_a = table.Add(&a);
+  table.Remove(handle_a);
+  EXPECT_FALSE(table.Acquire(handle_a));
+
+  // The slot is reused with a new generation.
+  int32_t handle_b = table.Add(&b);
+  EXPECT_NE(handle_a, handle_b);
+  EXPECT_FALSE(table.Acquire(handle_a));
+  EXPECT_EQ(&b, table.Acquire(handle_b));
+  table.Release(handle_b);
+}
+
+TEST(XWalkExternalHandleTableTest, GrowsPastOnePage) {
+  XWalkExternalHandleTable table;
+  std::vector<int> objects(3000);
+  std::vector<int32_t> handles;
+  for (size_t i = 0; i < objects.size(); ++i)
+    handles.push_back(table.Add(&objects[i]));
+
+  for (size_t i = 0; i < handles.size(); ++i) {
+    ASSERT_EQ(&objects[i], table.Acquire(handles[i]));
+    table.Release(handles[i]);
+  }
+}
+
+TEST(XWalkExternalHandleTableTest, RemoveWaitsForOtherThreads) {
+  XWalkExternalHandleTable table;
+  int object = 42;
+  int32_t handle = table.Add(&object);
+  base::subtle::Atomic32 stop = 0;
+
+  std::vector<std::unique_ptr<ResolvingThread>> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.push_back(std::unique_ptr<ResolvingThread>(
+        new ResolvingThread(&table, handle, &stop)));
+    threads.back()->Start();
+  }
+
+  // Once Remove() returns no thread can be using the object anymore.
+  table.Remove(handle);
+  object = 0;
+  base::subtle::Release_Store(&stop, 1);
+
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i]->Join();
+}
@@ -5,7 +5,10 @@
 #include "xwalk/extensions/common/xwalk_external_instance.h"
 
 #include <string>
+#include <utility>
+#include "base/bind.h"
 #include "base/logging.h"
+#include "base/threading/thread_task_runner_handle.h"
 #include "xwalk/extensions/common/xwalk_external_extension.h"
 #include "xwalk/extensions/common/xwalk_external_adapter.h"
 
@@ -13,12 +16,17 @@ namespace xwalk {
 namespace extensions {
 
 XWalkExternalInstance::XWalkExternalInstance(
-    XWalkExternalExtension* extension, XW_Instance xw_instance)
-    : xw_instance_(xw_instance),
+    XWalkExternalExtension* extension)
+    : xw_instance_(0),
       extension_(extension),
-      instance_data_(NULL),
-      is_handling_sync_msg_(false) {
-  XWalkExternalAdapter::GetInstance()->RegisterInstance(this);
+      instance_data_(0),
+      is_handling_sync_msg_(false),
+      weak_factory_(this) {
+  if (base::ThreadTaskRunnerHandle::IsSet())
+    task_runner_ = base::ThreadTaskRunnerHandle::Get();
+  weak_ptr_ = weak_factory_.GetWeakPtr();
+
+  xw_instance_ = XWalkExternalAdapter::GetInstance()->RegisterInstance(this);
   XW_CreatedInstanceCallback callback = extension_->created_instance_callback_;
   if (callback)
     callback(xw_instance_);
@@ -34,18 +42,25 @@ XWalkExternalInstance::~XWalkExternalInstance() {
 
 void XWalkExternalInstance::HandleMessage(std::unique_ptr<base::Value> msg) {
   XW_HandleMessageCallback callback = extension_->handle_msg_callback_;
+  XW_HandleSizedMessageCallback sized_callback =
+      extension_->handle_sized_msg_callback_;
   XW_HandleBinaryMessageCallback binary_callback =
       extension_->handle_binary_msg_callback_;
-  if (!callback && !binary_callback) {
+  if (!callback && !sized_callback && !binary_callback) {
     LOG(WARNING) << "Ignoring message sent for external extension '"
                  << extension_->name() << "' which doesn't support it.";
     return;
   }
 
-  std::string string_msg;
+  // The callbacks borrow the message's storage, it is never copied.
+  const base::StringValue* string_msg = nullptr;
   const base::BinaryValue* binary_msg = nullptr;
-  if (callback && msg->GetAsString(&string_msg)) {
-    callback(xw_instance_, string_msg.c_str());
+  if ((callback || sized_callback) && msg->GetAsString(&string_msg)) {
+    const std::string& str = string_msg->GetString();
+    if (sized_callback)
+      sized_callback(xw_instance_, str.data(), str.size());
+    else
+      callback(xw_instance_, str.c_str());
   } else if (binary_callback && msg->GetAsBinary(&binary_msg)) {
     binary_callback(xw_instance_, binary_msg->GetBuffer(),
                     binary_msg->GetSize());
@@ -73,25 +88,129 @@ void XWalkExternalInstance::HandleSyncMessage(std::unique_ptr<base::Value> msg)
 }
 
 void XWalkExternalInstance::CoreSetInstanceData(void* data) {
-  instance_data_ = data;
+  base::subtle::Release_Store(
+      &instance_data_, reinterpret_cast<base::subtle::AtomicWord>(data));
 }
 
 void* XWalkExternalInstance::CoreGetInstanceData() {
-  return instance_data_;
+  return GetInstanceData();
 }
 
 void XWalkExternalInstance::MessagingPostMessage(const char* msg) {
-  PostMessageToJS(std::unique_ptr<base::Value>(new base::StringValue(msg)));
+  PostToJS(std::unique_ptr<base::Value>(new base::StringValue(msg)), false);
 }
 
 void XWalkExternalInstance::MessagingPostBinaryMessage(const char* msg,
                                                        const size_t size) {
-  PostMessageToJS(std::unique_ptr<base::Value>(
-      base::BinaryValue::CreateWithCopiedBuffer(msg, size)));
+  PostToJS(std::unique_ptr<base::Value>(
+      base::BinaryValue::CreateWithCopiedBuffer(msg, size)), false);
+}
+
+void XWalkExternalInstance::Messaging3PostMessage(const char* msg,
+                                                  size_t size) {
+  PostToJS(std::unique_ptr<base::Value>(
+      new base::StringValue(std::string(msg, size))), false);
+}
+
+void XWalkExternalInstance::Messaging3PostBinaryBuffer(char* buffer,
+                                                       size_t size) {
+  PostToJS(std::unique_ptr<base::Value>(new base::BinaryValue(
+      std::unique_ptr<char[]>(buffer), size)), false);
+}
+
+void XWalkExternalInstance::Messaging3PostExternalBuffer(
+    const char* buffer, size_t size,
+    XW_ReleaseBufferCallback release, void* user_data) {
+  std::unique_ptr<ExternalBuffer> external_buffer(
+      new ExternalBuffer(buffer, size, release, user_data));
+  if (BelongsToInstanceThread()) {
+    PostMessageToJS(external_buffer->CreateValue());
+    return;
+  }
+
+  PendingMessage pending;
+  pending.is_sync_reply = false;
+  pending.external_buffer = std::move(external_buffer);
+  QueuePendingMessage(std::move(pending));
 }
 
 void XWalkExternalInstance::SyncMessagingSetSyncReply(const char* reply) {
-  SendSyncReplyToJS(std::unique_ptr<base::Value>(new base::StringValue(reply)));
+  PostToJS(std::unique_ptr<base::Value>(new base::StringValue(reply)), true);
+}
+
+void XWalkExternalInstance::PostToJS(std::unique_ptr<base::Value> msg,
+                                     bool is_sync_reply) {
+  if (BelongsToInstanceThread()) {
+    if (is_sync_reply)
+      SendSyncReplyToJS(std::move(msg));
+    else
+      PostMessageToJS(std::move(msg));
+    return;
+  }
+
+  PendingMessage pending;
+  pending.is_sync_reply = is_sync_reply;
+  pending.value = std::move(msg);
+  QueuePendingMessage(std::move(pending));
+}
+
+bool XWalkExternalInstance::BelongsToInstanceThread() const {
+  return !task_runner_ || task_runner_->BelongsToCurrentThread();
+}
+
+void XWalkExternalInstance::QueuePendingMessage(PendingMessage message) {
+  bool needs_flush;
+  {
+    base::AutoLock lock(pending_messages_lock_);
+    needs_flush = pending_messages_.empty();
+    pending_messages_.push_back(std::move(message));
+  }
+
+  // A single task delivers everything queued until it runs. If the instance
+  // is gone by then, the queue is dropped along with it.
+  if (needs_flush) {
+    task_runner_->PostTask(
+        FROM_HERE, base::Bind(&XWalkExternalInstance::FlushPendingMessages,
+                              weak_ptr_));
+  }
+}
+
+void XWalkExternalInstance::FlushPendingMessages() {
+  std::vector<PendingMessage> messages;
+  {
+    base::AutoLock lock(pending_messages_lock_);
+    messages.swap(pending_messages_);
+  }
+
+  for (size_t i = 0; i < messages.size(); ++i) {
+    if (messages[i].external_buffer) {
+      messages[i].value = messages[i].external_buffer->CreateValue();
+      messages[i].external_buffer.reset();
+    }
+    if (messages[i].is_sync_reply)
+      SendSyncReplyToJS(std::move(messages[i].value));
+    else
+      PostMessageToJS(std::move(messages[i].value));
+  }
+}
+
+XWalkExternalInstance::ExternalBuffer::ExternalBuffer(
+    const char* data, size_t size,
+    XW_ReleaseBufferCallback release, void* user_data)
+    : data_(data),
+      size_(size),
+      release_(release),
+      user_data_(user_data) {}
+
+XWalkExternalInstance::ExternalBuffer::~ExternalBuffer() {
+  if (release_)
+    release_(data_, user_data_);
+}
+
+std::unique_ptr<base::Value>
+XWalkExternalInstance::ExternalBuffer::CreateValue() const {
+  return std::unique_ptr<base::Value>(
+      base::BinaryValue::CreateWithCopiedBuffer(data_, size_));
 }
 
 }  // namespace extensions
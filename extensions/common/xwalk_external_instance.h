@@ -5,10 +5,17 @@
 #ifndef XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_INSTANCE_H_
 #define XWALK_EXTENSIONS_COMMON_XWALK_EXTERNAL_INSTANCE_H_
 
+#include <memory>
 #include <string>
+#include <vector>
+#include "base/atomicops.h"
+#include "base/memory/weak_ptr.h"
+#include "base/single_thread_task_runner.h"
+#include "base/synchronization/lock.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/extensions/public/XW_Extension.h"
 #include "xwalk/extensions/public/XW_Extension_Message_2.h"
+#include "xwalk/extensions/public/XW_Extension_Message_3.h"
 #include "xwalk/extensions/public/XW_Extension_SyncMessage.h"
 
 namespace xwalk {
@@ -26,13 +33,19 @@ typedef void* InstanceData;
 // library, and with XWalkExternalExtension to get the appropriate
 // callbacks. The associated XW_Instance is used to identify this context when
 // calling the shared library.
+//
+// The shared library can post messages from any thread. Messages posted from
+// threads other than the one the instance lives on are queued and handed to
+// that thread, where they are dropped if the instance is gone.
 class XWalkExternalInstance : public XWalkExtensionInstance {
  public:
-  XWalkExternalInstance(XWalkExternalExtension* extension,
-                        XW_Instance xw_instance);
+  explicit XWalkExternalInstance(XWalkExternalExtension* extension);
   ~XWalkExternalInstance() override;
 
-  InstanceData GetInstanceData() const { return instance_data_; }
+  InstanceData GetInstanceData() const {
+    return reinterpret_cast<InstanceData>(
+        base::subtle::Acquire_Load(&instance_data_));
+  }
 
  private:
   friend class XWalkExternalAdapter;
@@ -51,16 +64,64 @@ class XWalkExternalInstance : public XWalkExtensionInstance {
   // XW_MessagingInterface_2 (from XW_Extension_Message_2.h) implementation.
   void MessagingPostBinaryMessage(const char* msg, const size_t size);
 
+  // XW_MessagingInterface_3 (from XW_Extension_Message_3.h) implementation.
+  void Messaging3PostMessage(const char* msg, size_t size);
+  void Messaging3PostBinaryBuffer(char* buffer, size_t size);
+  void Messaging3PostExternalBuffer(const char* buffer, size_t size,
+                                    XW_ReleaseBufferCallback release,
+                                    void* user_data);
+
   // XW_Internal_SyncMessagingInterface_1 (from XW_Extension_SyncMessage.h)
   // implementation.
   void SyncMessagingSetSyncReply(const char* reply);
 
+  // Buffer owned by the shared library, given back to it on destruction.
+  class ExternalBuffer {
+   public:
+    ExternalBuffer(const char* data, size_t size,
+                   XW_ReleaseBufferCallback release, void* user_data);
+    ~ExternalBuffer();
+
+    std::unique_ptr<base::Value> CreateValue() const;
+
+   private:
+    const char* data_;
+    size_t size_;
+    XW_ReleaseBufferCallback release_;
+    void* user_data_;
+
+    DISALLOW_COPY_AND_ASSIGN(ExternalBuffer);
+  };
+
+  // Either |value| or |external_buffer| is set. External buffers are copied
+  // when the message is delivered, on the instance's thread.
+  struct PendingMessage {
+    bool is_sync_reply;
+    std::unique_ptr<base::Value> value;
+    std::unique_ptr<ExternalBuffer> external_buffer;
+  };
+
+  // Sends |msg| right away when called on the instance's thread, queues it
+  // otherwise.
+  void PostToJS(std::unique_ptr<base::Value> msg, bool is_sync_reply);
+  bool BelongsToInstanceThread() const;
+  void QueuePendingMessage(PendingMessage message);
+  void FlushPendingMessages();
+
   XW_Instance xw_instance_;
   std::string sync_reply_;
   XWalkExternalExtension* extension_;
-  InstanceData instance_data_;
+  base::subtle::AtomicWord instance_data_;
   bool is_handling_sync_msg_;
 
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+  base::Lock pending_messages_lock_;
+  std::vector<PendingMessage> pending_messages_;
+
+  // Created on the instance's thread, copied by the posting threads.
+  base::WeakPtr<XWalkExternalInstance> weak_ptr_;
+  base::WeakPtrFactory<XWalkExternalInstance> weak_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(XWalkExternalInstance);
 };
 
@@ -14,6 +14,7 @@
 #include "ipc/ipc_message_macros.h"
 #include "ipc/ipc_sync_channel.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_stats.h"
 
 namespace xwalk {
 namespace extensions {
@@ -22,7 +23,9 @@ XWalkExtensionProcess::XWalkExtensionProcess(
     const IPC::ChannelHandle& channel_handle)
     : shutdown_event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
                       base::WaitableEvent::InitialState::NOT_SIGNALED),
-      io_thread_("XWalkExtensionProcess_IOThread") {
+      io_thread_("XWalkExtensionProcess_IOThread"),
+      permission_generation_(0),
+      next_permission_request_id_(0) {
   io_thread_.StartWithOptions(
       base::Thread::Options(base::MessageLoop::TYPE_IO, 0));
 
@@ -37,6 +40,8 @@ XWalkExtensionProcess::~XWalkExtensionProcess() {
 
   shutdown_event_.Signal();
   io_thread_.Stop();
+
+  XWalkExtensionStats::GetInstance()->DumpIfRequested();
 }
 
 bool XWalkExtensionProcess::OnMessageReceived(const IPC::Message& message) {
@@ -44,6 +49,12 @@ bool XWalkExtensionProcess::OnMessageReceived(const IPC::Message& message) {
   IPC_BEGIN_MESSAGE_MAP(XWalkExtensionProcess, message)
     IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_RegisterExtensions,
                         OnRegisterExtensions)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_APIAccessControlResult,
+                        OnAPIAccessControlResult)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_SetPermissionSnapshot,
+                        OnSetPermissionSnapshot)
+    IPC_MESSAGE_HANDLER(XWalkExtensionProcessMsg_InvalidatePermissions,
+                        OnInvalidatePermissions)
     IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
   return handled;
@@ -127,26 +138,91 @@ void XWalkExtensionProcess::CreateRenderProcessChannel() {
 bool XWalkExtensionProcess::CheckAPIAccessControl(
     const std::string& extension_name,
     const std::string& api_name) {
-  PermissionCacheType::iterator iter =
-      permission_cache_.find(extension_name + api_name);
-  if (iter != permission_cache_.end())
-    return iter->second != ALLOW_ONCE;
+  int generation;
+  {
+    base::AutoLock lock(permission_lock_);
+    RuntimePermission cached =
+        permission_cache_.Lookup(extension_name, api_name);
+    if (cached != UNDEFINED_RUNTIME_PERM)
+      return XWalkExtensionPermissionCache::IsAllowed(cached);
+    generation = permission_generation_;
+  }
 
   RuntimePermission result = UNDEFINED_RUNTIME_PERM;
   browser_process_channel_->Send(
       new XWalkExtensionProcessHostMsg_CheckAPIAccessControl(
           extension_name, api_name, &result));
   DLOG(INFO) << extension_name << "." << api_name << "() --> " << result;
-  if (result == ALLOW_SESSION ||
-      result == ALLOW_ALWAYS ||
-      result == DENY_SESSION ||
-      result == DENY_ALWAYS) {
-    permission_cache_[extension_name+api_name] = result;
-    return (result == ALLOW_SESSION || result == ALLOW_ALWAYS);
+
+  {
+    base::AutoLock lock(permission_lock_);
+    if (generation == permission_generation_)
+      permission_cache_.Store(extension_name, api_name, result);
   }
 
-  // Could be allow/deny once or undefined here.
-  return (result == ALLOW_ONCE);
+  // Could be allow/deny once or undefined if not cacheable.
+  return XWalkExtensionPermissionCache::IsAllowed(result);
+}
+
+void XWalkExtensionProcess::CheckAPIAccessControlAsync(
+    const std::string& extension_name,
+    const std::string& api_name,
+    const base::Callback<void(bool)>& callback) {
+  int request_id;
+  {
+    base::AutoLock lock(permission_lock_);
+    RuntimePermission cached =
+        permission_cache_.Lookup(extension_name, api_name);
+    if (cached != UNDEFINED_RUNTIME_PERM) {
+      base::AutoUnlock unlock(permission_lock_);
+      callback.Run(XWalkExtensionPermissionCache::IsAllowed(cached));
+      return;
+    }
+
+    request_id = next_permission_request_id_++;
+    PendingPermissionCheck& check = pending_permission_checks_[request_id];
+    check.extension_name = extension_name;
+    check.api_name = api_name;
+    check.callback = callback;
+    check.generation = permission_generation_;
+  }
+
+  browser_process_channel_->Send(
+      new XWalkExtensionProcessHostMsg_RequestAPIAccessControl(
+          request_id, extension_name, api_name));
+}
+
+void XWalkExtensionProcess::OnAPIAccessControlResult(int request_id,
+                                                     RuntimePermission perm) {
+  base::Callback<void(bool)> callback;
+  {
+    base::AutoLock lock(permission_lock_);
+    std::map<int, PendingPermissionCheck>::iterator it =
+        pending_permission_checks_.find(request_id);
+    if (it == pending_permission_checks_.end())
+      return;
+
+    if (it->second.generation == permission_generation_) {
+      permission_cache_.Store(it->second.extension_name, it->second.api_name,
+                              perm);
+    }
+    callback = it->second.callback;
+    pending_permission_checks_.erase(it);
+  }
+
+  callback.Run(XWalkExtensionPermissionCache::IsAllowed(perm));
+}
+
+void XWalkExtensionProcess::OnSetPermissionSnapshot(
+    const std::string& extension_name, const PermissionSnapshot& snapshot) {
+  base::AutoLock lock(permission_lock_);
+  permission_cache_.SetSnapshot(extension_name, snapshot);
+}
+
+void XWalkExtensionProcess::OnInvalidatePermissions() {
+  base::AutoLock lock(permission_lock_);
+  permission_cache_.Clear();
+  ++permission_generation_;
 }
 
 bool XWalkExtensionProcess::RegisterPermissions(
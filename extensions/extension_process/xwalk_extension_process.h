@@ -9,10 +9,12 @@
 #include <string>
 
 #include "base/values.h"
+#include "base/synchronization/lock.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/threading/thread.h"
 #include "ipc/ipc_channel_handle.h"
 #include "ipc/ipc_listener.h"
+#include "xwalk/extensions/common/xwalk_extension_permission_cache.h"
 #include "xwalk/extensions/common/xwalk_extension_permission_types.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 
@@ -46,6 +48,9 @@ class XWalkExtensionProcess : public IPC::Listener,
   ~XWalkExtensionProcess() override;
   bool CheckAPIAccessControl(const std::string& extension_name,
       const std::string& api_name) override;
+  void CheckAPIAccessControlAsync(const std::string& extension_name,
+      const std::string& api_name,
+      const base::Callback<void(bool)>& callback) override;
   bool RegisterPermissions(const std::string& extension_name,
       const std::string& perm_table) override;
 
@@ -56,6 +61,10 @@ class XWalkExtensionProcess : public IPC::Listener,
   // Handlers for IPC messages from XWalkExtensionProcessHost.
   void OnRegisterExtensions(const base::FilePath& extension_path,
                             const base::ListValue& browser_variables);
+  void OnAPIAccessControlResult(int request_id, RuntimePermission perm);
+  void OnSetPermissionSnapshot(const std::string& extension_name,
+                               const PermissionSnapshot& snapshot);
+  void OnInvalidatePermissions();
 
   void CreateBrowserProcessChannel(const IPC::ChannelHandle& channel_handle);
 
@@ -67,8 +76,21 @@ class XWalkExtensionProcess : public IPC::Listener,
   XWalkExtensionServer extensions_server_;
   std::unique_ptr<IPC::SyncChannel> render_process_channel_;
   IPC::ChannelHandle rp_channel_handle_;
-  typedef std::map<std::string, RuntimePermission> PermissionCacheType;
-  PermissionCacheType permission_cache_;
+  struct PendingPermissionCheck {
+    std::string extension_name;
+    std::string api_name;
+    base::Callback<void(bool)> callback;
+    int generation;
+  };
+
+  // Permission checks come from the threads of the extensions.
+  base::Lock permission_lock_;
+  XWalkExtensionPermissionCache permission_cache_;
+  // Incremented when the cache is invalidated, so the decisions requested
+  // before are not stored.
+  int permission_generation_;
+  int next_permission_request_id_;
+  std::map<int, PendingPermissionCheck> pending_permission_checks_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkExtensionProcess);
 };
@@ -34,8 +34,12 @@
         'common/xwalk_extension.h',
         'common/xwalk_extension_messages.cc',
         'common/xwalk_extension_messages.h',
+        'common/xwalk_extension_permission_cache.cc',
+        'common/xwalk_extension_permission_cache.h',
         'common/xwalk_extension_server.cc',
         'common/xwalk_extension_server.h',
+        'common/xwalk_extension_stats.cc',
+        'common/xwalk_extension_stats.h',
         'common/xwalk_extension_switches.cc',
         'common/xwalk_extension_switches.h',
         'common/xwalk_extension_vector.h',
@@ -43,6 +47,8 @@
         'common/xwalk_external_adapter.h',
         'common/xwalk_external_extension.cc',
         'common/xwalk_external_extension.h',
+        'common/xwalk_external_handle_table.cc',
+        'common/xwalk_external_handle_table.h',
         'common/xwalk_external_instance.cc',
         'common/xwalk_external_instance.h',
         'common/xwalk_extension_permission_types.h',
@@ -54,6 +60,7 @@
         'extension_process/xwalk_extension_process_main.h',
         'public/XW_Extension.h',
         'public/XW_Extension_Message_2.h',
+        'public/XW_Extension_Message_3.h',
         'public/XW_Extension_Permissions.h',
         'public/XW_Extension_SyncMessage.h',
         'renderer/xwalk_extension_client.cc',
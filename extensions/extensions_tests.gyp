@@ -11,7 +11,10 @@
       ],
       'sources': [
         'browser/xwalk_extension_function_handler_unittest.cc',
+        'common/xwalk_extension_permission_cache_unittest.cc',
         'common/xwalk_extension_server_unittest.cc',
+        'common/xwalk_extension_stats_unittest.cc',
+        'common/xwalk_external_handle_table_unittest.cc',
       ],
     },
     {
@@ -53,6 +56,7 @@
         'test/internal_extension_browsertest.h',
         'test/nested_namespace.cc',
         'test/namespace_read_only.cc',
+        'test/spare_extension_process.cc',
         'test/test.idl',
         'test/v8tools_module.cc',
         'test/xwalk_extensions_browsertest.cc',
@@ -45,6 +45,26 @@
         }],
       ],
     },
+    {
+      'target_name': 'echo_extension_messaging_3',
+      'type': 'loadable_module',
+      'variables': {
+        # We do not strip the binaries on Mac because the tool that does that
+        # gets confused when you change the 'product_dir' (the binary output
+        # directory). Since these are only for testing, no harm is done.
+        'mac_strip': 0,
+      },
+      'sources': [
+        'test/echo_extension_messaging_3.c',
+      ],
+      'conditions': [
+        ['OS=="win"', {
+          'product_dir': '<(PRODUCT_DIR)\\tests\\extension\\echo_extension\\'
+        }, {
+          'product_dir': '<(PRODUCT_DIR)/tests/extension/echo_extension/'
+        }],
+      ],
+    },
     {
       'target_name': 'bad_extension',
       'type': 'loadable_module',
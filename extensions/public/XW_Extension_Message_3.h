@@ -0,0 +1,94 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_MESSAGE_3_H_
+#define XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_MESSAGE_3_H_
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_H_
+#error "You should include XW_Extension.h before this file"
+#endif
+
+#ifndef XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_MESSAGE_2_H_
+#error "You should include XW_Extension_Message_2.h before this file"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XW_MESSAGING_INTERFACE_3 "XW_MessagingInterface_3"
+
+// |message| is not NUL terminated and is only valid during the callback.
+typedef void (*XW_HandleSizedMessageCallback)(XW_Instance instance,
+                                              const char* message,
+                                              size_t size);
+
+// Called once Crosswalk is done with a buffer given to PostExternalBuffer().
+// It can be called from any thread.
+typedef void (*XW_ReleaseBufferCallback)(const char* buffer, void* user_data);
+
+struct XW_MessagingInterface_3 {
+  // Register a callback to be called when the JavaScript code associated
+  // with the extension posts a string message. Unlike the previous versions
+  // the message is given as a (pointer, size) view that is only valid
+  // during the callback, so it can contain NUL characters and is not copied
+  // before reaching the extension. Takes precedence over the callback
+  // registered through XW_MessagingInterface_1 or 2.
+  void (*Register)(XW_Extension extension,
+                   XW_HandleSizedMessageCallback handle_message);
+
+  // Post a string message of |size| bytes to the web content associated
+  // with the instance. |message| doesn't need to be NUL terminated.
+  //
+  // This function is thread-safe and can be called until the instance is
+  // destroyed.
+  void (*PostMessage)(XW_Instance instance, const char* message, size_t size);
+
+  // Same as in XW_MessagingInterface_2, the message is a view that is only
+  // valid during the callback.
+  void (*RegisterBinaryMessageCallback)(
+      XW_Extension extension,
+      XW_HandleBinaryMessageCallback handle_message);
+
+  // Same as in XW_MessagingInterface_2, the message is copied before this
+  // function returns.
+  void (*PostBinaryMessage)(XW_Instance instance,
+                            const char* message, size_t size);
+
+  // Allocate and free buffers that can be given to PostBinaryBuffer(). Both
+  // functions can be called from any thread.
+  char* (*AllocateBuffer)(size_t size);
+  void (*FreeBuffer)(char* buffer);
+
+  // Post a binary message using a buffer returned by AllocateBuffer(). The
+  // ownership of |buffer| is transferred to Crosswalk, which sends it
+  // without copying it. The extension must not touch |buffer| afterwards,
+  // even if the instance turns out to be invalid.
+  //
+  // This function is thread-safe and can be called until the instance is
+  // destroyed.
+  void (*PostBinaryBuffer)(XW_Instance instance, char* buffer, size_t size);
+
+  // Post a binary message using a buffer owned by the extension. The buffer
+  // must stay valid until |release| is called with |user_data|, which is
+  // guaranteed to happen exactly once, even if the instance is invalid.
+  // When called from a thread other than the one the instance lives on, the
+  // buffer is read on the instance's thread instead of being copied by the
+  // calling thread.
+  //
+  // This function is thread-safe and can be called until the instance is
+  // destroyed.
+  void (*PostExternalBuffer)(XW_Instance instance,
+                             const char* buffer, size_t size,
+                             XW_ReleaseBufferCallback release,
+                             void* user_data);
+};
+
+typedef struct XW_MessagingInterface_3 XW_MessagingInterface3;
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#endif  // XWALK_EXTENSIONS_PUBLIC_XW_EXTENSION_MESSAGE_3_H_
@@ -34,6 +34,32 @@ struct XW_Internal_PermissionsInterface_1 {
 typedef struct XW_Internal_PermissionsInterface_1
     XW_Internal_PermissionsInterface;
 
+#define XW_INTERNAL_PERMISSIONS_INTERFACE_2 \
+    "XW_Internal_PermissionsInterface_2"
+
+// |result| is XW_OK if the access is granted, XW_ERROR otherwise.
+typedef void (*XW_CheckAPIAccessControlCallback)(XW_Extension extension,
+                                                 int result,
+                                                 void* user_data);
+
+struct XW_Internal_PermissionsInterface_2 {
+  int (*CheckAPIAccessControl)(XW_Extension extension, const char* api_name);
+  int (*RegisterPermissions)(XW_Extension extension, const char* perm_table);
+
+  // Same as CheckAPIAccessControl() but doesn't block while the decision is
+  // requested from the browser, which may have to ask the user. |callback|
+  // is called exactly once, before this function returns if the decision is
+  // already known, otherwise later on the main thread of the extension
+  // process.
+  void (*CheckAPIAccessControlAsync)(XW_Extension extension,
+                                     const char* api_name,
+                                     XW_CheckAPIAccessControlCallback callback,
+                                     void* user_data);
+};
+
+typedef struct XW_Internal_PermissionsInterface_2
+    XW_Internal_PermissionsInterface2;
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -7,8 +7,10 @@
 #include "base/values.h"
 #include "base/numerics/safe_conversions.h"
 #include "base/stl_util.h"
+#include "base/trace_event/trace_event.h"
 #include "ipc/ipc_sender.h"
 #include "xwalk/extensions/common/xwalk_extension_messages.h"
+#include "xwalk/extensions/common/xwalk_extension_stats.h"
 
 namespace xwalk {
 namespace extensions {
@@ -62,7 +64,11 @@ XWalkExtensionClient::ExtensionCodePoints::~ExtensionCodePoints() {
 }
 
 void XWalkExtensionClient::OnPostMessageToJS(int64_t instance_id,
+                                             uint64_t flow_id,
                                              const base::ListValue& msg) {
+  TRACE_EVENT_WITH_FLOW1(kExtensionTraceCategory,
+                         "XWalkExtensionClient::OnPostMessageToJS", flow_id,
+                         TRACE_EVENT_FLAG_FLOW_IN, "instance_id", instance_id);
   HandlerMap::const_iterator it = handlers_.find(instance_id);
   if (it == handlers_.end()) {
     LOG(WARNING) << "Can't PostMessage to invalid Extension instance id: "
@@ -143,16 +149,31 @@ std::unique_ptr<base::ListValue> WrapValueInList(std::unique_ptr<base::Value> va
 
 void XWalkExtensionClient::PostMessageToNative(int64_t instance_id,
     std::unique_ptr<base::Value> msg) {
+  uint64_t flow_id = NextExtensionMessageFlowId();
+  TRACE_EVENT_WITH_FLOW1(kExtensionTraceCategory,
+                         "XWalkExtensionClient::PostMessageToNative", flow_id,
+                         TRACE_EVENT_FLAG_FLOW_OUT, "instance_id", instance_id);
   std::unique_ptr<base::ListValue> list_msg = WrapValueInList(std::move(msg));
-  Send(new XWalkExtensionServerMsg_PostMessageToNative(instance_id, *list_msg));
+  Send(new XWalkExtensionServerMsg_PostMessageToNative(instance_id, flow_id,
+                                                       *list_msg));
 }
 
 std::unique_ptr<base::Value> XWalkExtensionClient::SendSyncMessageToNative(
     int64_t instance_id, std::unique_ptr<base::Value> msg) {
+  uint64_t flow_id = NextExtensionMessageFlowId();
+  TRACE_EVENT_WITH_FLOW1(kExtensionTraceCategory,
+                         "XWalkExtensionClient::SendSyncMessageToNative",
+                         flow_id, TRACE_EVENT_FLAG_FLOW_OUT,
+                         "instance_id", instance_id);
   std::unique_ptr<base::ListValue> wrapped_msg = WrapValueInList(std::move(msg));
   base::ListValue* wrapped_reply = new base::ListValue;
   Send(new XWalkExtensionServerMsg_SendSyncMessageToNative(instance_id,
-      *wrapped_msg, wrapped_reply));
+      flow_id, *wrapped_msg, wrapped_reply));
+
+  // The reply carries on the flow of the message and ends it here.
+  TRACE_EVENT_WITH_FLOW0(kExtensionTraceCategory,
+                         "XWalkExtensionClient::OnSyncReply", flow_id,
+                         TRACE_EVENT_FLAG_FLOW_IN);
 
   std::unique_ptr<base::Value> reply;
   wrapped_reply->Remove(0, &reply);
@@ -73,7 +73,9 @@ class XWalkExtensionClient : public IPC::Listener {
 
   // Message Handlers.
   void OnInstanceDestroyed(int64_t instance_id);
-  void OnPostMessageToJS(int64_t instance_id, const base::ListValue& msg);
+  void OnPostMessageToJS(int64_t instance_id,
+                         uint64_t flow_id,
+                         const base::ListValue& msg);
   void OnPostOutOfLineMessageToJS(base::SharedMemoryHandle handle,
                                   size_t size);
 
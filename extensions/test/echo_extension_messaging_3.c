@@ -0,0 +1,98 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#if defined(__cplusplus)
+#error "This file is written in C to make sure the C API works as intended."
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "xwalk/extensions/public/XW_Extension.h"
+#include "xwalk/extensions/public/XW_Extension_Message_2.h"
+#include "xwalk/extensions/public/XW_Extension_Message_3.h"
+
+XW_Extension g_extension = 0;
+const XW_CoreInterface* g_core = NULL;
+const XW_MessagingInterface3* g_messaging_3 = NULL;
+int g_use_external_buffer = 0;
+
+void instance_created(XW_Instance instance) {
+  printf("Instance %d created!\n", instance);
+}
+
+void instance_destroyed(XW_Instance instance) {
+  printf("Instance %d destroyed!\n", instance);
+}
+
+void release_buffer(const char* buffer, void* user_data) {
+  free(user_data);
+}
+
+void handle_message(XW_Instance instance, const char* message, size_t size) {
+  g_messaging_3->PostMessage(instance, message, size);
+}
+
+// Binary messages are echoed alternately through a buffer handed over to
+// Crosswalk and through a buffer released by callback.
+void handle_binary_message(
+    XW_Instance instance, const char* message, const size_t size) {
+  char* buffer;
+  if (g_use_external_buffer) {
+    buffer = malloc(size);
+    memcpy(buffer, message, size);
+    g_messaging_3->PostExternalBuffer(
+        instance, buffer, size, release_buffer, buffer);
+  } else {
+    buffer = g_messaging_3->AllocateBuffer(size);
+    memcpy(buffer, message, size);
+    g_messaging_3->PostBinaryBuffer(instance, buffer, size);
+  }
+  g_use_external_buffer = !g_use_external_buffer;
+}
+
+void shutdown(XW_Extension extension) {
+  printf("Shutdown\n");
+}
+
+int32_t XW_Initialize(XW_Extension extension, XW_GetInterface get_interface) {
+  static const char* kAPI =
+      "var echoListener = null;"
+      "var echoBinaryListener = null;"
+      "extension.setMessageListener(function(msg) {"
+      "  if (msg instanceof ArrayBuffer) {"
+      "    if (echoBinaryListener instanceof Function)"
+      "      echoBinaryListener(msg);"
+      "  } else if (echoListener instanceof Function) {"
+      "    echoListener(msg);"
+      "  }"
+      "});"
+      "exports.echo = function(msg, callback) {"
+      "  echoListener = callback;"
+      "  extension.postMessage(msg);"
+      "};"
+      "exports.echoBinary = function(msg, callback) {"
+      "  echoBinaryListener = callback;"
+      "  extension.postMessage(msg);"
+      "};";
+
+  g_extension = extension;
+  g_core = get_interface(XW_CORE_INTERFACE);
+  if (g_core == NULL)
+    return XW_ERROR;
+  g_core->SetExtensionName(extension, "echo3");
+  g_core->SetJavaScriptAPI(extension, kAPI);
+  g_core->RegisterInstanceCallbacks(
+      extension, instance_created, instance_destroyed);
+  g_core->RegisterShutdownCallback(extension, shutdown);
+
+  g_messaging_3 = get_interface(XW_MESSAGING_INTERFACE_3);
+  if (g_messaging_3 == NULL)
+    return XW_ERROR;
+  g_messaging_3->Register(extension, handle_message);
+  g_messaging_3->RegisterBinaryMessageCallback(
+      extension, handle_binary_message);
+
+  return XW_OK;
+}
@@ -0,0 +1,131 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "base/command_line.h"
+#include "base/threading/platform_thread.h"
+#include "base/time/time.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/test/browser_test_utils.h"
+#include "content/public/test/test_utils.h"
+#include "xwalk/extensions/browser/xwalk_extension_service.h"
+#include "xwalk/extensions/common/xwalk_extension_switches.h"
+#include "xwalk/extensions/test/xwalk_extensions_test_base.h"
+#include "xwalk/runtime/browser/runtime.h"
+#include "xwalk/runtime/browser/xwalk_runner.h"
+#include "xwalk/test/base/xwalk_test_utils.h"
+
+using content::BrowserThread;
+using xwalk::extensions::XWalkExtensionService;
+using xwalk::Runtime;
+using xwalk::XWalkRunner;
+
+class SpareExtensionProcessTest : public XWalkExtensionsTestBase {
+ public:
+  void SetUp() override {
+    XWalkExtensionService::SetExternalExtensionsPathForTesting(
+        GetExternalExtensionTestPath(FILE_PATH_LITERAL("echo_extension")));
+    XWalkExtensionsTestBase::SetUp();
+  }
+
+  bool IsSupported() {
+    base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
+    return !cmd_line->HasSwitch(switches::kXWalkDisableExtensionProcess) &&
+           !cmd_line->HasSwitch(switches::kXWalkDisableSpareExtensionProcess);
+  }
+
+  XWalkExtensionService* service() {
+    return XWalkRunner::GetInstance()->extension_service();
+  }
+
+  // Runs the launch of the spare, and the death of its process.
+  void RunPendingTasks() {
+    content::RunAllPendingInMessageLoop();
+    content::RunAllPendingInMessageLoop(BrowserThread::IO);
+  }
+
+  // Creates a runtime, in a new render process, and checks that the echo
+  // extension works there.
+  void CreateEchoRuntime() {
+    GURL url = GetExtensionsTestURL(base::FilePath(),
+                                    base::FilePath().AppendASCII("echo.html"));
+    Runtime* runtime = CreateRuntime();
+    content::TitleWatcher title_watcher(runtime->web_contents(), kPassString);
+    title_watcher.AlsoWaitForTitle(kFailString);
+    xwalk_test_utils::NavigateToURL(runtime, url);
+    EXPECT_EQ(kPassString, title_watcher.WaitAndGetTitle());
+  }
+};
+
+IN_PROC_BROWSER_TEST_F(SpareExtensionProcessTest, TakeAndAttach) {
+  if (!IsSupported())
+    return;
+
+  // A single render process doesn't get a spare.
+  CreateEchoRuntime();
+  RunPendingTasks();
+  EXPECT_FALSE(service()->HasSpareExtensionProcessForTesting());
+
+  CreateEchoRuntime();
+  RunPendingTasks();
+  EXPECT_TRUE(service()->HasSpareExtensionProcessForTesting());
+
+  // The third render process takes the spare, and another one is launched.
+  CreateEchoRuntime();
+  RunPendingTasks();
+  EXPECT_TRUE(service()->HasSpareExtensionProcessForTesting());
+}
+
+IN_PROC_BROWSER_TEST_F(SpareExtensionProcessTest, SpareDies) {
+  if (!IsSupported())
+    return;
+
+  CreateEchoRuntime();
+  CreateEchoRuntime();
+  RunPendingTasks();
+  ASSERT_TRUE(service()->HasSpareExtensionProcessForTesting());
+
+  service()->TerminateSpareExtensionProcessForTesting();
+  base::TimeTicks deadline =
+      base::TimeTicks::Now() + base::TimeDelta::FromSeconds(10);
+  while (service()->HasSpareExtensionProcessForTesting() &&
+         base::TimeTicks::Now() < deadline) {
+    base::PlatformThread::Sleep(base::TimeDelta::FromMilliseconds(10));
+    RunPendingTasks();
+  }
+  EXPECT_FALSE(service()->HasSpareExtensionProcessForTesting());
+
+  // The next render process launches its own extension process.
+  CreateEchoRuntime();
+  RunPendingTasks();
+  EXPECT_TRUE(service()->HasSpareExtensionProcessForTesting());
+}
+
+IN_PROC_BROWSER_TEST_F(SpareExtensionProcessTest, TakeDyingSpare) {
+  if (!IsSupported())
+    return;
+
+  CreateEchoRuntime();
+  CreateEchoRuntime();
+  RunPendingTasks();
+  ASSERT_TRUE(service()->HasSpareExtensionProcessForTesting());
+
+  // The process may die before or after the render process takes it. The
+  // render process must not crash the browser either way.
+  service()->TerminateSpareExtensionProcessForTesting();
+  Runtime* runtime = CreateRuntime(GetExtensionsTestURL(
+      base::FilePath(), base::FilePath().AppendASCII("echo.html")));
+  RunPendingTasks();
+  EXPECT_TRUE(runtime->web_contents());
+}
+
+// The spare left at shutdown is discarded by the service.
+IN_PROC_BROWSER_TEST_F(SpareExtensionProcessTest, DiscardAtShutdown) {
+  if (!IsSupported())
+    return;
+
+  CreateEchoRuntime();
+  CreateEchoRuntime();
+  RunPendingTasks();
+  EXPECT_TRUE(service()->HasSpareExtensionProcessForTesting());
+}
@@ -0,0 +1,437 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/extensions/xesh/xesh_benchmark.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <utility>
+
+#include "base/files/file_util.h"
+#include "base/json/json_writer.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/single_thread_task_runner.h"
+
+namespace {
+
+const char kStringMessage[] = "xesh benchmark";
+
+// Binary messages grow by 16x from the smallest size up to the largest one.
+const size_t kMinBinarySize = 16;
+const size_t kMaxBinarySize = 64 * 1024 * 1024;
+// Caps the bytes sent for each binary size, so the largest messages don't
+// take minutes.
+const size_t kBinaryBudget = 256 * 1024 * 1024;
+
+double ToMicroseconds(base::TimeDelta delta) {
+  return delta.InMicrosecondsF();
+}
+
+double PerSecond(size_t count, base::TimeDelta elapsed) {
+  if (elapsed <= base::TimeDelta())
+    return 0;
+  return count / elapsed.InSecondsF();
+}
+
+// Returns the nearest-rank |percentile| of the sorted |samples|.
+base::TimeDelta Percentile(const std::vector<base::TimeDelta>& samples,
+                           double percentile) {
+  DCHECK(!samples.empty());
+  size_t rank = static_cast<size_t>(
+      std::ceil(percentile / 100 * samples.size()));
+  return samples[std::max<size_t>(rank, 1) - 1];
+}
+
+std::unique_ptr<base::DictionaryValue> SummarizeLatency(
+    std::vector<base::TimeDelta>* samples) {
+  std::unique_ptr<base::DictionaryValue> summary(new base::DictionaryValue);
+  summary->SetInteger("count", static_cast<int>(samples->size()));
+  if (samples->empty())
+    return summary;
+
+  std::sort(samples->begin(), samples->end());
+  base::TimeDelta total;
+  for (const base::TimeDelta& sample : *samples)
+    total += sample;
+  summary->SetDouble("min_us", ToMicroseconds(samples->front()));
+  summary->SetDouble("p50_us", ToMicroseconds(Percentile(*samples, 50)));
+  summary->SetDouble("p90_us", ToMicroseconds(Percentile(*samples, 90)));
+  summary->SetDouble("p99_us", ToMicroseconds(Percentile(*samples, 99)));
+  summary->SetDouble("max_us", ToMicroseconds(samples->back()));
+  summary->SetDouble("mean_us", ToMicroseconds(total / samples->size()));
+  return summary;
+}
+
+}  // namespace
+
+// Sends messages to one extension instance and times the echoes. Replies are
+// matched to the messages in order, which the server guarantees for each
+// instance.
+class XEShBenchmark::Instance
+    : public XWalkExtensionClient::InstanceHandler {
+ public:
+  Instance(XWalkExtensionClient* client, XEShBenchmark* benchmark)
+      : client_(client),
+        benchmark_(benchmark),
+        id_(0) {}
+  ~Instance() override {}
+
+  bool Create(const std::string& extension_name) {
+    id_ = client_->CreateInstance(extension_name, this);
+    return id_ != 0;
+  }
+
+  void Destroy() {
+    if (!id_)
+      return;
+    client_->DestroyInstance(id_);
+    id_ = 0;
+  }
+
+  void PostMessage(std::unique_ptr<base::Value> msg) {
+    send_times_.push(base::TimeTicks::Now());
+    client_->PostMessageToNative(id_, std::move(msg));
+  }
+
+  std::unique_ptr<base::Value> SendSyncMessage(
+      std::unique_ptr<base::Value> msg) {
+    base::TimeTicks start = base::TimeTicks::Now();
+    std::unique_ptr<base::Value> reply =
+        client_->SendSyncMessageToNative(id_, std::move(msg));
+    latencies_.push_back(base::TimeTicks::Now() - start);
+    return reply;
+  }
+
+  // XWalkExtensionClient::InstanceHandler implementation.
+  void HandleMessageFromNative(const base::Value& msg) override {
+    if (send_times_.empty()) {
+      LOG(WARNING) << "Unexpected message from instance " << id_;
+      return;
+    }
+    latencies_.push_back(base::TimeTicks::Now() - send_times_.front());
+    send_times_.pop();
+    benchmark_->OnReply();
+  }
+
+  bool has_pending_replies() const { return !send_times_.empty(); }
+  std::vector<base::TimeDelta>* latencies() { return &latencies_; }
+
+ private:
+  XWalkExtensionClient* client_;
+  XEShBenchmark* benchmark_;
+  int64_t id_;
+  std::queue<base::TimeTicks> send_times_;
+  std::vector<base::TimeDelta> latencies_;
+
+  DISALLOW_COPY_AND_ASSIGN(Instance);
+};
+
+const char XEShBenchmark::kPostMessage[] = "post_message";
+const char XEShBenchmark::kSyncMessage[] = "sync_message";
+const char XEShBenchmark::kBinary[] = "binary";
+const char XEShBenchmark::kInstances[] = "instances";
+const char XEShBenchmark::kConcurrent[] = "concurrent";
+
+XEShBenchmark::Options::Options()
+    : iterations(1000),
+      concurrent_instances(64),
+      timeout(base::TimeDelta::FromSeconds(30)) {
+}
+
+XEShBenchmark::Options::~Options() {
+}
+
+XEShBenchmark::XEShBenchmark(XWalkExtensionClient* client,
+                             const Options& options)
+    : client_(client),
+      options_(options),
+      waiting_for_(NULL),
+      run_loop_(NULL) {
+  DCHECK_GT(options_.iterations, 0);
+}
+
+XEShBenchmark::~XEShBenchmark() {
+  for (Instance* instance : instances_)
+    DestroyInstance(instance);
+}
+
+bool XEShBenchmark::Run() {
+  base::DictionaryValue results;
+  results.SetString("extension", options_.extension_name);
+  results.SetInteger("iterations", options_.iterations);
+
+  bool succeeded = true;
+  for (const std::string& workload : options_.workloads) {
+    std::unique_ptr<base::Value> result;
+    if (workload == kPostMessage) {
+      result = RunPostMessage();
+    } else if (workload == kSyncMessage) {
+      result = RunSyncMessage();
+    } else if (workload == kBinary) {
+      result = RunBinary();
+    } else if (workload == kInstances) {
+      result = RunInstances();
+    } else if (workload == kConcurrent) {
+      result = RunConcurrent();
+    } else {
+      LOG(ERROR) << "Unknown benchmark workload: " << workload;
+      succeeded = false;
+      continue;
+    }
+
+    // The instances are not reused, so a late reply can't skew the next
+    // workload.
+    for (Instance* instance : instances_)
+      DestroyInstance(instance);
+    instances_.clear();
+
+    if (!result) {
+      LOG(ERROR) << "Benchmark workload " << workload << " failed.";
+      results.SetStringWithoutPathExpansion(workload, "failed");
+      succeeded = false;
+      continue;
+    }
+    results.SetWithoutPathExpansion(workload, std::move(result));
+  }
+
+  std::string json;
+  base::JSONWriter::WriteWithOptions(
+      results, base::JSONWriter::OPTIONS_PRETTY_PRINT, &json);
+  if (options_.output_path.empty()) {
+    fprintf(stdout, "%s", json.c_str());
+    fflush(stdout);
+  } else if (base::WriteFile(options_.output_path, json.data(), json.size()) !=
+             static_cast<int>(json.size())) {
+    LOG(ERROR) << "Can't write the benchmark results to "
+               << options_.output_path.AsUTF8Unsafe();
+    return false;
+  }
+  return succeeded;
+}
+
+std::unique_ptr<base::Value> XEShBenchmark::RunPostMessage() {
+  Instance* instance = CreateInstance();
+  if (!instance)
+    return NULL;
+  std::vector<Instance*> instances(1, instance);
+
+  // The round trip of a message when nothing else is queued.
+  for (int i = 0; i < options_.iterations; ++i) {
+    instance->PostMessage(
+        std::unique_ptr<base::Value>(new base::StringValue(kStringMessage)));
+    if (!WaitForReplies(instances))
+      return NULL;
+  }
+  std::unique_ptr<base::DictionaryValue> result(new base::DictionaryValue);
+  result->Set("latency", SummarizeLatency(instance->latencies()));
+  instance->latencies()->clear();
+
+  // How fast messages go through when they are sent back to back.
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < options_.iterations; ++i) {
+    instance->PostMessage(
+        std::unique_ptr<base::Value>(new base::StringValue(kStringMessage)));
+  }
+  if (!WaitForReplies(instances))
+    return NULL;
+  result->SetDouble("messages_per_second",
+                    PerSecond(options_.iterations,
+                              base::TimeTicks::Now() - start));
+  return std::move(result);
+}
+
+std::unique_ptr<base::Value> XEShBenchmark::RunSyncMessage() {
+  Instance* instance = CreateInstance();
+  if (!instance)
+    return NULL;
+
+  // Sync messages block the v8 thread until the reply comes, so the latency
+  // and the throughput are measured by the same loop.
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < options_.iterations; ++i) {
+    if (!instance->SendSyncMessage(std::unique_ptr<base::Value>(
+            new base::StringValue(kStringMessage))))
+      return NULL;
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  std::unique_ptr<base::DictionaryValue> result(new base::DictionaryValue);
+  result->Set("latency", SummarizeLatency(instance->latencies()));
+  result->SetDouble("messages_per_second",
+                    PerSecond(options_.iterations, elapsed));
+  return std::move(result);
+}
+
+std::unique_ptr<base::Value> XEShBenchmark::RunBinary() {
+  std::unique_ptr<base::ListValue> result(new base::ListValue);
+  std::vector<char> data(kMaxBinarySize);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<char>(i);
+
+  for (size_t size = kMinBinarySize; size <= kMaxBinarySize; size *= 16) {
+    Instance* instance = CreateInstance();
+    if (!instance)
+      return NULL;
+    std::vector<Instance*> instances(1, instance);
+
+    int iterations = static_cast<int>(std::min<size_t>(
+        options_.iterations, std::max<size_t>(kBinaryBudget / size, 1)));
+    for (int i = 0; i < iterations; ++i) {
+      // Copying the payload into the message is part of what is measured,
+      // as the module system does it too.
+      instance->PostMessage(std::unique_ptr<base::Value>(
+          base::BinaryValue::CreateWithCopiedBuffer(&data.front(), size)));
+      if (!WaitForReplies(instances))
+        return NULL;
+    }
+
+    base::TimeDelta total;
+    for (const base::TimeDelta& latency : *instance->latencies())
+      total += latency;
+    std::unique_ptr<base::DictionaryValue> entry(new base::DictionaryValue);
+    entry->SetInteger("size", static_cast<int>(size));
+    entry->Set("latency", SummarizeLatency(instance->latencies()));
+    // Each message crosses the channel twice.
+    entry->SetDouble("bytes_per_second",
+                     PerSecond(2 * size * iterations, total));
+    result->Append(std::move(entry));
+  }
+  return std::move(result);
+}
+
+std::unique_ptr<base::Value> XEShBenchmark::RunInstances() {
+  // Creating and destroying instances has no reply, a message to a control
+  // instance tells when the server is done with them.
+  Instance* control = CreateInstance();
+  if (!control || !WaitForServer(control))
+    return NULL;
+
+  std::vector<Instance*> created;
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < options_.iterations; ++i) {
+    Instance* instance = CreateInstance();
+    if (!instance)
+      return NULL;
+    created.push_back(instance);
+  }
+  if (!WaitForServer(control))
+    return NULL;
+  base::TimeDelta create_time = base::TimeTicks::Now() - start;
+
+  start = base::TimeTicks::Now();
+  for (Instance* instance : created)
+    DestroyInstance(instance);
+  if (!WaitForServer(control))
+    return NULL;
+  base::TimeDelta destroy_time = base::TimeTicks::Now() - start;
+
+  std::unique_ptr<base::DictionaryValue> result(new base::DictionaryValue);
+  result->SetDouble("creates_per_second",
+                    PerSecond(options_.iterations, create_time));
+  result->SetDouble("destroys_per_second",
+                    PerSecond(options_.iterations, destroy_time));
+  return std::move(result);
+}
+
+std::unique_ptr<base::Value> XEShBenchmark::RunConcurrent() {
+  std::vector<Instance*> instances;
+  for (int i = 0; i < options_.concurrent_instances; ++i) {
+    Instance* instance = CreateInstance();
+    if (!instance)
+      return NULL;
+    instances.push_back(instance);
+  }
+
+  // Every instance has a message in flight at once, so the replies interleave
+  // on the channel.
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < options_.iterations; ++i) {
+    for (Instance* instance : instances) {
+      instance->PostMessage(
+          std::unique_ptr<base::Value>(new base::StringValue(kStringMessage)));
+    }
+    if (!WaitForReplies(instances))
+      return NULL;
+  }
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+  std::vector<base::TimeDelta> latencies;
+  for (Instance* instance : instances) {
+    latencies.insert(latencies.end(), instance->latencies()->begin(),
+                     instance->latencies()->end());
+  }
+
+  std::unique_ptr<base::DictionaryValue> result(new base::DictionaryValue);
+  result->SetInteger("instances", options_.concurrent_instances);
+  result->Set("latency", SummarizeLatency(&latencies));
+  result->SetDouble("messages_per_second",
+                    PerSecond(latencies.size(), elapsed));
+  return std::move(result);
+}
+
+XEShBenchmark::Instance* XEShBenchmark::CreateInstance() {
+  std::unique_ptr<Instance> instance(new Instance(client_, this));
+  if (!instance->Create(options_.extension_name)) {
+    LOG(ERROR) << "Can't create an instance of "
+               << options_.extension_name;
+    return NULL;
+  }
+  instances_.push_back(instance.release());
+  return instances_.back();
+}
+
+void XEShBenchmark::DestroyInstance(Instance* instance) {
+  // The client drops the replies still on their way to a destroyed instance,
+  // so the object itself may be deleted any time after this.
+  instance->Destroy();
+}
+
+bool XEShBenchmark::WaitForReplies(const std::vector<Instance*>& instances) {
+  DCHECK(!waiting_for_);
+  waiting_for_ = &instances;
+  if (!HaveAllReplied()) {
+    base::RunLoop run_loop;
+    run_loop_ = &run_loop;
+    base::MessageLoop* loop = base::MessageLoop::current();
+    loop->task_runner()->PostDelayedTask(FROM_HERE, run_loop.QuitClosure(),
+                                         options_.timeout);
+    // The replies are dispatched by tasks posted from the IO thread.
+    base::MessageLoop::ScopedNestableTaskAllower allow(loop);
+    run_loop.Run();
+    run_loop_ = NULL;
+  }
+  bool replied = HaveAllReplied();
+  waiting_for_ = NULL;
+  if (!replied)
+    LOG(ERROR) << "Timed out waiting for " << options_.extension_name;
+  return replied;
+}
+
+bool XEShBenchmark::HaveAllReplied() const {
+  DCHECK(waiting_for_);
+  for (const Instance* instance : *waiting_for_) {
+    if (instance->has_pending_replies())
+      return false;
+  }
+  return true;
+}
+
+void XEShBenchmark::OnReply() {
+  if (run_loop_ && HaveAllReplied())
+    run_loop_->Quit();
+}
+
+bool XEShBenchmark::WaitForServer(Instance* control) {
+  // The server handles the messages in the order they were sent.
+  control->PostMessage(
+      std::unique_ptr<base::Value>(new base::StringValue(kStringMessage)));
+  return WaitForReplies(std::vector<Instance*>(1, control));
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_EXTENSIONS_XESH_XESH_BENCHMARK_H_
+#define XWALK_EXTENSIONS_XESH_XESH_BENCHMARK_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/scoped_vector.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "xwalk/extensions/renderer/xwalk_extension_client.h"
+
+namespace base {
+class RunLoop;
+}
+
+using xwalk::extensions::XWalkExtensionClient;
+
+// Measures the extension messaging path without a browser, by talking to an
+// extension through XWalkExtensionClient the same way the module system does,
+// and writes latency percentiles and throughput of each workload as JSON.
+//
+// The extension under test must echo the messages it receives. The echo
+// extension from xwalk/extensions/test supports the "sync_message" workload
+// and echo3 the "binary" one, the other workloads work with both.
+//
+// This class lives on the v8 thread, the one the client dispatches on.
+class XEShBenchmark {
+ public:
+  struct Options {
+    Options();
+    ~Options();
+
+    std::string extension_name;
+    std::vector<std::string> workloads;
+    // Number of messages, or instances, measured by each workload.
+    int iterations;
+    // Number of instances for the "concurrent" workload.
+    int concurrent_instances;
+    // How long to wait for the replies to a batch of messages.
+    base::TimeDelta timeout;
+    // Where the results are written, stdout if empty.
+    base::FilePath output_path;
+  };
+
+  // Workload names, in the order they run by default.
+  static const char kPostMessage[];
+  static const char kSyncMessage[];
+  static const char kBinary[];
+  static const char kInstances[];
+  static const char kConcurrent[];
+
+  XEShBenchmark(XWalkExtensionClient* client, const Options& options);
+  ~XEShBenchmark();
+
+  // Runs the workloads and writes the results. Returns false if a workload
+  // failed, e.g. because the extension stopped replying.
+  bool Run();
+
+ private:
+  class Instance;
+
+  // Each workload returns NULL if it failed.
+  std::unique_ptr<base::Value> RunPostMessage();
+  std::unique_ptr<base::Value> RunSyncMessage();
+  std::unique_ptr<base::Value> RunBinary();
+  std::unique_ptr<base::Value> RunInstances();
+  std::unique_ptr<base::Value> RunConcurrent();
+
+  Instance* CreateInstance();
+  void DestroyInstance(Instance* instance);
+
+  // Runs nested message loops until all of |instances| got their replies or
+  // the timeout expires.
+  bool WaitForReplies(const std::vector<Instance*>& instances);
+  bool HaveAllReplied() const;
+  void OnReply();
+
+  // Returns once the extension handled all the messages sent so far.
+  bool WaitForServer(Instance* control);
+
+  XWalkExtensionClient* client_;
+  Options options_;
+
+  ScopedVector<Instance> instances_;
+  const std::vector<Instance*>* waiting_for_;
+  base::RunLoop* run_loop_;
+
+  DISALLOW_COPY_AND_ASSIGN(XEShBenchmark);
+};
+
+#endif  // XWALK_EXTENSIONS_XESH_XESH_BENCHMARK_H_
@@ -22,12 +22,15 @@
 #include "base/message_loop/message_loop.h"
 #include "base/message_loop/message_pump_libevent.h"
 #include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
 #include "base/synchronization/waitable_event.h"
 #include "base/task_runner_util.h"
 #include "base/threading/thread.h"
 #include "ipc/ipc_sync_channel.h"
 #include "xwalk/extensions/common/xwalk_extension_server.h"
 #include "xwalk/extensions/common/xwalk_extension_switches.h"
+#include "xwalk/extensions/xesh/xesh_benchmark.h"
 #include "xwalk/extensions/xesh/xesh_v8_runner.h"
 
 
@@ -36,6 +39,16 @@ using xwalk::extensions::XWalkExtensionServer;
 // Specifies which file XESh will use as input.
 const char kInputFilePath[] = "input-file";
 
+// Runs the benchmark against the named extension instead of the shell. See
+// XEShBenchmark for what the extension must support.
+const char kBenchmark[] = "benchmark";
+// Comma separated list of the benchmark workloads to run.
+const char kBenchmarkWorkloads[] = "benchmark-workloads";
+const char kBenchmarkIterations[] = "benchmark-iterations";
+const char kBenchmarkInstances[] = "benchmark-instances";
+// File receiving the JSON results, instead of stdout.
+const char kBenchmarkOutput[] = "benchmark-output";
+
 namespace {
 
 inline void PrintInitialInfo() {
@@ -139,6 +152,44 @@ class InputWatcher : public base::MessagePumpLibevent::Watcher {
   DISALLOW_COPY_AND_ASSIGN(InputWatcher);
 };
 
+XEShBenchmark::Options GetBenchmarkOptions() {
+  base::CommandLine* cmd_line = base::CommandLine::ForCurrentProcess();
+  XEShBenchmark::Options options;
+  options.extension_name = cmd_line->GetSwitchValueASCII(kBenchmark);
+
+  // The sync and binary workloads need an extension supporting them, see
+  // XEShBenchmark.
+  std::string workloads = cmd_line->GetSwitchValueASCII(kBenchmarkWorkloads);
+  if (workloads.empty()) {
+    workloads = std::string(XEShBenchmark::kPostMessage) + "," +
+                XEShBenchmark::kInstances + "," + XEShBenchmark::kConcurrent;
+  }
+  options.workloads = base::SplitString(
+      workloads, ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+
+  int value;
+  if (base::StringToInt(cmd_line->GetSwitchValueASCII(kBenchmarkIterations),
+                        &value) && value > 0)
+    options.iterations = value;
+  if (base::StringToInt(cmd_line->GetSwitchValueASCII(kBenchmarkInstances),
+                        &value) && value > 0)
+    options.concurrent_instances = value;
+  options.output_path = cmd_line->GetSwitchValuePath(kBenchmarkOutput);
+  return options;
+}
+
+bool RunBenchmark(XEShV8Runner* v8_runner,
+                  const XEShBenchmark::Options& options) {
+  XEShBenchmark benchmark(v8_runner->client(), options);
+  return benchmark.Run();
+}
+
+void OnBenchmarkFinished(bool* succeeded, const base::Closure& quit_closure,
+                         bool result) {
+  *succeeded = result;
+  quit_closure.Run();
+}
+
 // Creates and manages the lifetime of the native side of XWalkExtension's
 // Framework. That means managing XWalkExtensionServer and its IPC-related
 // objects.
@@ -218,14 +269,25 @@ int main(int argc, char* argv[]) {
                                        io_thread.task_runner(),
                                        extension_manager.ipc_channel_handle()));
 
+  base::RunLoop run_loop;
+  bool succeeded = true;
   InputWatcher input_watcher(&v8_runner, v8_thread.message_loop());
 
-  static_cast<base::MessageLoopForIO*>(io_thread.message_loop())->PostTask(
-      FROM_HERE, base::Bind(&InputWatcher::StartWatching,
-      base::Unretained(&input_watcher)));
+  if (base::CommandLine::ForCurrentProcess()->HasSwitch(kBenchmark)) {
+    PostTaskAndReplyWithResult(
+        v8_thread.task_runner().get(), FROM_HERE,
+        base::Bind(&RunBenchmark, base::Unretained(&v8_runner),
+                   GetBenchmarkOptions()),
+        base::Bind(&OnBenchmarkFinished, &succeeded,
+                   run_loop.QuitClosure()));
+  } else {
+    static_cast<base::MessageLoopForIO*>(io_thread.message_loop())->PostTask(
+        FROM_HERE, base::Bind(&InputWatcher::StartWatching,
+        base::Unretained(&input_watcher)));
+
+    PrintPromptLine();
+  }
 
-  PrintPromptLine();
-  base::RunLoop run_loop;
   run_loop.Run();
 
   static_cast<base::MessageLoopForIO*>(v8_thread.message_loop())->PostTask(
@@ -234,5 +296,5 @@ int main(int argc, char* argv[]) {
 
   io_thread.Stop();
   v8_thread.Stop();
-  return 0;
+  return succeeded ? 0 : 1;
 }
@@ -45,6 +45,8 @@ class XEShV8Runner {
   // Executes a string within the current v8 context.
   std::string ExecuteString(std::string statement);
 
+  XWalkExtensionClient* client() { return &client_; }
+
   static const char* GetV8Version() {
     return v8::V8::GetVersion();
   }
@@ -0,0 +1,37 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+package org.xwalk.core.internal;
+
+import org.chromium.base.annotations.JNINamespace;
+
+/**
+ * Clears the browsing data kept for the whole profile, as opposed to the
+ * data of a single XWalkView like its back/forward list.
+ */
+@JNINamespace("xwalk")
+public class XWalkBrowsingData {
+
+    /**
+     * Forgets the visited links of all the views, along with the URL history
+     * they are rebuilt from, which is kept unencrypted in the profile.
+     */
+    public static void clearVisitedLinks() {
+        nativeClearVisitedLinks();
+    }
+
+    /**
+     * Forgets the favicons stored for all the views.
+     */
+    public static void clearFavicons() {
+        nativeClearFavicons();
+    }
+
+    //--------------------------------------------------------------------------------------------
+    //  Native methods
+    //--------------------------------------------------------------------------------------------
+    private static native void nativeClearVisitedLinks();
+
+    private static native void nativeClearFavicons();
+}
@@ -17,6 +17,7 @@
 #include "xwalk/runtime/browser/android/xwalk_autofill_client_android.h"
 #include "xwalk/runtime/browser/android/xwalk_content.h"
 #include "xwalk/runtime/browser/android/xwalk_content_lifecycle_notifier.h"
+#include "xwalk/runtime/browser/android/xwalk_browsing_data.h"
 #include "xwalk/runtime/browser/android/xwalk_contents_client_bridge.h"
 #include "xwalk/runtime/browser/android/xwalk_contents_io_thread_client_impl.h"
 #include "xwalk/runtime/browser/android/xwalk_dev_tools_server.h"
@@ -44,6 +45,7 @@ static base::android::RegistrationMethod kXWalkRegisteredMethods[] = {
   { "WebContentsDelegateAndroid",
       web_contents_delegate_android::RegisterWebContentsDelegateAndroidJni },
   { "XWalkAutofillClient", RegisterXWalkAutofillClient },
+  { "XWalkBrowsingData", RegisterXWalkBrowsingData },
   { "XWalkContentsClientBridge", RegisterXWalkContentsClientBridge },
   { "XWalkContentsIoThreadClientImpl",
       RegisterXWalkContentsIoThreadClientImpl },
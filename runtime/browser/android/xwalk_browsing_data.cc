@@ -0,0 +1,33 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/android/xwalk_browsing_data.h"
+
+#include "base/android/jni_android.h"
+#include "content/public/browser/browser_thread.h"
+#include "xwalk/runtime/browser/favicon_store.h"
+#include "xwalk/runtime/browser/xwalk_browser_context.h"
+#include "jni/XWalkBrowsingData_jni.h"
+
+using content::BrowserThread;
+
+namespace xwalk {
+
+// static
+void ClearVisitedLinks(JNIEnv*, const JavaParamRef<jclass>&) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  XWalkBrowserContext::GetDefault()->ClearVisitedLinks();
+}
+
+// static
+void ClearFavicons(JNIEnv*, const JavaParamRef<jclass>&) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  XWalkBrowserContext::GetDefault()->GetFaviconStore()->ClearIcons();
+}
+
+bool RegisterXWalkBrowsingData(JNIEnv* env) {
+  return RegisterNativesImpl(env);
+}
+
+}  // namespace xwalk
@@ -0,0 +1,16 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_RUNTIME_BROWSER_ANDROID_XWALK_BROWSING_DATA_H_
+#define XWALK_RUNTIME_BROWSER_ANDROID_XWALK_BROWSING_DATA_H_
+
+#include <jni.h>
+
+namespace xwalk {
+
+bool RegisterXWalkBrowsingData(JNIEnv* env);
+
+}  // namespace xwalk
+
+#endif  // XWALK_RUNTIME_BROWSER_ANDROID_XWALK_BROWSING_DATA_H_
@@ -4,7 +4,6 @@
 
 #include "xwalk/runtime/browser/android/xwalk_contents_io_thread_client_impl.h"
 
-#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -15,7 +14,6 @@
 #include "base/android/jni_weak_ref.h"
 #include "base/lazy_instance.h"
 #include "base/memory/linked_ptr.h"
-#include "base/synchronization/lock.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/render_frame_host.h"
 #include "content/public/browser/render_process_host.h"
@@ -29,6 +27,7 @@
 #include "net/url_request/url_request.h"
 #include "url/gurl.h"
 #include "xwalk/runtime/browser/android/xwalk_web_resource_response_impl.h"
+#include "xwalk/runtime/browser/copy_on_write_map.h"
 
 using base::android::AttachCurrentThread;
 using base::android::ConvertUTF8ToJavaString;
@@ -39,7 +38,6 @@ using base::LazyInstance;
 using content::BrowserThread;
 using content::RenderFrameHost;
 using content::WebContents;
-using std::map;
 using std::pair;
 using std::string;
 using std::vector;
@@ -57,31 +55,36 @@ struct IoThreadClientData {
 
 IoThreadClientData::IoThreadClientData() : pending_association(false) {}
 
-typedef map<pair<int, int>, IoThreadClientData>
-    RenderFrameHostToIoThreadClientType;
-
 static pair<int, int> GetRenderFrameHostIdPair(RenderFrameHost* rfh) {
   return pair<int, int>(rfh->GetProcess()->GetID(), rfh->GetRoutingID());
 }
 
 // RfhToIoThreadClientMap -----------------------------------------------------
+// Looked up on the IO thread for every request, so lookups take no lock.
 class RfhToIoThreadClientMap {
  public:
+  RfhToIoThreadClientMap();
+
   static RfhToIoThreadClientMap* GetInstance();
   void Set(pair<int, int> rfh_id, const IoThreadClientData& client);
+  // Must be called on the IO thread.
   bool Get(pair<int, int> rfh_id, IoThreadClientData* client);
   void Erase(pair<int, int> rfh_id);
 
  private:
   static LazyInstance<RfhToIoThreadClientMap> g_instance_;
-  base::Lock map_lock_;
-  RenderFrameHostToIoThreadClientType rfh_to_io_thread_client_;
+  CopyOnWriteMap<pair<int, int>, IoThreadClientData> rfh_to_io_thread_client_;
 };
 
 // static
 LazyInstance<RfhToIoThreadClientMap> RfhToIoThreadClientMap::g_instance_ =
     LAZY_INSTANCE_INITIALIZER;
 
+RfhToIoThreadClientMap::RfhToIoThreadClientMap()
+    : rfh_to_io_thread_client_(
+          BrowserThread::GetTaskRunnerForThread(BrowserThread::IO)) {
+}
+
 // static
 RfhToIoThreadClientMap* RfhToIoThreadClientMap::GetInstance() {
   return g_instance_.Pointer();
@@ -89,25 +92,16 @@ RfhToIoThreadClientMap* RfhToIoThreadClientMap::GetInstance() {
 
 void RfhToIoThreadClientMap::Set(pair<int, int> rfh_id,
                                  const IoThreadClientData& client) {
-  base::AutoLock lock(map_lock_);
-  rfh_to_io_thread_client_[rfh_id] = client;
+  rfh_to_io_thread_client_.Set(rfh_id, client);
 }
 
 bool RfhToIoThreadClientMap::Get(
     pair<int, int> rfh_id, IoThreadClientData* client) {
-  base::AutoLock lock(map_lock_);
-  RenderFrameHostToIoThreadClientType::iterator iterator =
-      rfh_to_io_thread_client_.find(rfh_id);
-  if (iterator == rfh_to_io_thread_client_.end())
-    return false;
-
-  *client = iterator->second;
-  return true;
+  return rfh_to_io_thread_client_.Get(rfh_id, client);
 }
 
 void RfhToIoThreadClientMap::Erase(pair<int, int> rfh_id) {
-  base::AutoLock lock(map_lock_);
-  rfh_to_io_thread_client_.erase(rfh_id);
+  rfh_to_io_thread_client_.Erase(rfh_id);
 }
 
 // ClientMapEntryUpdater ------------------------------------------------------
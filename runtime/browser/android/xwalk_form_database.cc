@@ -24,12 +24,12 @@ XWalkFormDatabaseService* GetFormDatabaseService() {
 
 // static
 jboolean HasFormData(JNIEnv*, const JavaParamRef<jclass>&) {
-  return GetFormDatabaseService()->HasFormData();
+  return GetFormDatabaseService()->HasFormDataBlocking();
 }
 
 // static
 void ClearFormData(JNIEnv*, const JavaParamRef<jclass>&) {
-  GetFormDatabaseService()->ClearFormData();
+  GetFormDatabaseService()->ClearFormData(base::Closure());
 }
 
 bool RegisterXWalkFormDatabase(JNIEnv* env) {
@@ -11,7 +11,12 @@
 #include "content/public/browser/web_contents.h"
 #include "content/public/common/favicon_url.h"
 #include "third_party/skia/include/core/SkBitmap.h"
+#include "ui/display/display.h"
+#include "ui/display/screen.h"
+#include "ui/gfx/favicon_size.h"
 #include "ui/gfx/geometry/size.h"
+#include "xwalk/runtime/browser/favicon_store.h"
+#include "xwalk/runtime/browser/xwalk_browser_context.h"
 
 using content::BrowserThread;
 using content::WebContents;
@@ -31,9 +36,17 @@ void XWalkIconHelper::SetListener(Listener* listener) {
 }
 
 void XWalkIconHelper::DownloadIcon(const GURL& icon_url) {
+  const GURL& page_url = web_contents()->GetLastCommittedURL();
+  SkBitmap bitmap;
+  if (XWalkBrowserContext::FromWebContents(web_contents())->GetFaviconStore()
+          ->GetIcon(page_url, icon_url, GetDesiredIconSize(), &bitmap)) {
+    if (listener_) listener_->OnReceivedIcon(icon_url, bitmap);
+    return;
+  }
+
   web_contents()->DownloadImage(icon_url, true, 0, false,
       base::Bind(&XWalkIconHelper::DownloadFaviconCallback,
-                 base::Unretained(this)));
+                 base::Unretained(this), page_url));
 }
 
 void XWalkIconHelper::DidUpdateFaviconURL(
@@ -62,6 +75,7 @@ void XWalkIconHelper::DidUpdateFaviconURL(
 }
 
 void XWalkIconHelper::DownloadFaviconCallback(
+    const GURL& page_url,
     int id,
     int http_status_code,
     const GURL& image_url,
@@ -70,7 +84,21 @@ void XWalkIconHelper::DownloadFaviconCallback(
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
   if (http_status_code == 404 || bitmaps.size() == 0) return;
 
-  if (listener_) listener_->OnReceivedIcon(image_url, bitmaps[0]);
+  FaviconStore* store =
+      XWalkBrowserContext::FromWebContents(web_contents())->GetFaviconStore();
+  store->SetIcon(page_url, image_url, bitmaps);
+  SkBitmap bitmap;
+  if (!store->GetIcon(page_url, image_url, GetDesiredIconSize(), &bitmap))
+    bitmap = bitmaps[0];
+
+  if (listener_) listener_->OnReceivedIcon(image_url, bitmap);
+}
+
+int XWalkIconHelper::GetDesiredIconSize() const {
+  float scale = display::Screen::GetScreen()
+                    ->GetDisplayNearestWindow(web_contents()->GetNativeView())
+                    .device_scale_factor();
+  return static_cast<int>(gfx::kFaviconSize * scale + 0.5f);
 }
 
 }  // namespace xwalk
@@ -39,6 +39,7 @@ class XWalkIconHelper : public content::WebContentsObserver {
 
   void SetListener(Listener* listener);
 
+  // Icons already stored for the host of the page are not downloaded again.
   void DownloadIcon(const GURL& icon_url);
 
   // From WebContentsObserver
@@ -46,6 +47,7 @@ class XWalkIconHelper : public content::WebContentsObserver {
       const std::vector<content::FaviconURL>& candidates) override;
 
   void DownloadFaviconCallback(
+      const GURL& page_url,
       int id,
       int http_status_code,
       const GURL& image_url,
@@ -53,6 +55,9 @@ class XWalkIconHelper : public content::WebContentsObserver {
       const std::vector<gfx::Size>& original_bitmap_sizes);
 
  private:
+  // The size in pixels of the favicon bitmap handed to the listener.
+  int GetDesiredIconSize() const;
+
   Listener* listener_;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkIconHelper);
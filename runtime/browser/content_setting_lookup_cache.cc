@@ -0,0 +1,103 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/content_setting_lookup_cache.h"
+
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "base/atomic_sequence_num.h"
+#include "base/lazy_instance.h"
+#include "base/threading/thread_local_storage.h"
+#include "url/gurl.h"
+
+namespace xwalk {
+
+namespace {
+
+// The primary URL spec, the secondary URL spec and the type.
+typedef std::tuple<std::string, std::string, ContentSettingsType> LookupKey;
+
+struct ThreadCache {
+  ThreadCache() : generation(0) {}
+
+  base::subtle::Atomic32 generation;
+  std::map<LookupKey, ContentSetting> settings;
+};
+
+// The caches of the current thread, by ContentSettingLookupCache id.
+typedef std::map<int, ThreadCache> ThreadCaches;
+
+void DeleteThreadCaches(void* thread_caches) {
+  delete static_cast<ThreadCaches*>(thread_caches);
+}
+
+struct ThreadCachesSlot {
+  ThreadCachesSlot() : slot(&DeleteThreadCaches) {}
+
+  base::ThreadLocalStorage::Slot slot;
+};
+
+base::LazyInstance<ThreadCachesSlot>::Leaky g_thread_caches =
+    LAZY_INSTANCE_INITIALIZER;
+
+base::StaticAtomicSequenceNumber g_next_id;
+
+ThreadCaches* GetThreadCaches() {
+  base::ThreadLocalStorage::Slot& slot = g_thread_caches.Get().slot;
+  ThreadCaches* caches = static_cast<ThreadCaches*>(slot.Get());
+  if (!caches) {
+    caches = new ThreadCaches;
+    slot.Set(caches);
+  }
+  return caches;
+}
+
+}  // namespace
+
+const size_t ContentSettingLookupCache::kMaxEntriesPerThread;
+
+ContentSettingLookupCache::ContentSettingLookupCache(
+    const LookupCallback& lookup)
+    : id_(g_next_id.GetNext()),
+      lookup_(lookup),
+      generation_(0) {
+}
+
+ContentSettingLookupCache::~ContentSettingLookupCache() {
+  // The caches of the other threads are left until they exit; ids are not
+  // reused, so they are never looked up again.
+  GetThreadCaches()->erase(id_);
+}
+
+ContentSetting ContentSettingLookupCache::GetContentSetting(
+    const GURL& primary_url,
+    const GURL& secondary_url,
+    ContentSettingsType type) {
+  ThreadCache& cache = (*GetThreadCaches())[id_];
+  base::subtle::Atomic32 generation = base::subtle::Acquire_Load(&generation_);
+  if (cache.generation != generation ||
+      cache.settings.size() >= kMaxEntriesPerThread) {
+    cache.settings.clear();
+    cache.generation = generation;
+  }
+
+  LookupKey key(primary_url.spec(), secondary_url.spec(), type);
+  auto it = cache.settings.find(key);
+  if (it != cache.settings.end())
+    return it->second;
+
+  ContentSetting setting = lookup_.Run(primary_url, secondary_url, type);
+  // A rule changed during the lookup, which may have missed it.
+  if (base::subtle::Acquire_Load(&generation_) == generation)
+    cache.settings[key] = setting;
+  return setting;
+}
+
+void ContentSettingLookupCache::Invalidate() {
+  base::subtle::Barrier_AtomicIncrement(&generation_, 1);
+}
+
+}  // namespace xwalk
@@ -0,0 +1,60 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_RUNTIME_BROWSER_CONTENT_SETTING_LOOKUP_CACHE_H_
+#define XWALK_RUNTIME_BROWSER_CONTENT_SETTING_LOOKUP_CACHE_H_
+
+#include <stddef.h>
+
+#include "base/atomicops.h"
+#include "base/callback.h"
+#include "base/macros.h"
+#include "components/content_settings/core/common/content_settings.h"
+#include "components/content_settings/core/common/content_settings_types.h"
+
+class GURL;
+
+namespace xwalk {
+
+// Remembers the content settings looked up for a (primary URL, secondary
+// URL, type), so that repeated checks do not walk the rules of every
+// provider of HostContentSettingsMap, under their locks.
+//
+// Every thread has its own cache, stamped with the generation it was filled
+// in, so hits take no lock at all. Invalidate() bumps the generation, which
+// empties the caches on their next use. The caches of a thread are freed
+// when it exits.
+class ContentSettingLookupCache {
+ public:
+  typedef base::Callback<ContentSetting(const GURL& primary_url,
+                                        const GURL& secondary_url,
+                                        ContentSettingsType type)>
+      LookupCallback;
+
+  // Each thread keeps up to this many settings.
+  static const size_t kMaxEntriesPerThread = 1024;
+
+  // |lookup| is run on cache misses, on the calling thread.
+  explicit ContentSettingLookupCache(const LookupCallback& lookup);
+  ~ContentSettingLookupCache();
+
+  ContentSetting GetContentSetting(const GURL& primary_url,
+                                   const GURL& secondary_url,
+                                   ContentSettingsType type);
+
+  // Called when any rule changes. May be called on any thread.
+  void Invalidate();
+
+ private:
+  // Tells apart the caches of every instance in the thread caches.
+  const int id_;
+  LookupCallback lookup_;
+  base::subtle::Atomic32 generation_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContentSettingLookupCache);
+};
+
+}  // namespace xwalk
+
+#endif  // XWALK_RUNTIME_BROWSER_CONTENT_SETTING_LOOKUP_CACHE_H_
@@ -0,0 +1,134 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_RUNTIME_BROWSER_COPY_ON_WRITE_MAP_H_
+#define XWALK_RUNTIME_BROWSER_COPY_ON_WRITE_MAP_H_
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/single_thread_task_runner.h"
+#include "base/synchronization/lock.h"
+
+namespace xwalk {
+
+// A map read on a few threads without any lock or atomic read-modify-write,
+// and written on any thread.
+//
+// Readers use the snapshot of the map published last. Writers copy it, apply
+// their change to the copy and publish the copy. The values are shared
+// between the snapshots, so a copy only costs a reference per entry. The
+// replaced snapshot is deleted once a task posted to every reader thread has
+// run: as reads happen within a task, none of them can still be using it by
+// then.
+template <typename Key, typename Value>
+class CopyOnWriteMap {
+ public:
+  typedef std::vector<scoped_refptr<base::SingleThreadTaskRunner>>
+      TaskRunners;
+
+  explicit CopyOnWriteMap(
+      scoped_refptr<base::SingleThreadTaskRunner> reader_task_runner)
+      : CopyOnWriteMap(TaskRunners(1, reader_task_runner)) {}
+
+  explicit CopyOnWriteMap(const TaskRunners& reader_task_runners)
+      : reader_task_runners_(reader_task_runners),
+        snapshot_(reinterpret_cast<base::subtle::AtomicWord>(new Map)) {
+    DCHECK(!reader_task_runners_.empty());
+  }
+
+  ~CopyOnWriteMap() { delete GetSnapshot(); }
+
+  // Must be called on a reader thread.
+  bool Get(const Key& key, Value* value) const {
+    DCHECK(IsReaderThread());
+    const Map* map = GetSnapshot();
+    typename Map::const_iterator it = map->find(key);
+    if (it == map->end())
+      return false;
+    *value = it->second->data;
+    return true;
+  }
+
+  void Set(const Key& key, const Value& value) {
+    base::AutoLock lock(write_lock_);
+    Map* map = new Map(*GetSnapshot());
+    (*map)[key] = new base::RefCountedData<Value>(value);
+    Publish(map);
+  }
+
+  void Erase(const Key& key) {
+    base::AutoLock lock(write_lock_);
+    const Map* snapshot = GetSnapshot();
+    if (!snapshot->count(key))
+      return;
+    Map* map = new Map(*snapshot);
+    map->erase(key);
+    Publish(map);
+  }
+
+ private:
+  typedef std::map<Key, scoped_refptr<base::RefCountedData<Value>>> Map;
+
+  // Deletes a replaced snapshot with its last reference.
+  class RetiredSnapshot
+      : public base::RefCountedThreadSafe<RetiredSnapshot> {
+   public:
+    explicit RetiredSnapshot(const Map* map) : map_(map) {}
+
+   private:
+    friend class base::RefCountedThreadSafe<RetiredSnapshot>;
+    ~RetiredSnapshot() {}
+
+    std::unique_ptr<const Map> map_;
+  };
+
+  // The reference is dropped with the task, on the reader thread.
+  static void ReleaseSnapshot(scoped_refptr<RetiredSnapshot> snapshot) {}
+
+  bool IsReaderThread() const {
+    for (const auto& task_runner : reader_task_runners_) {
+      if (task_runner->BelongsToCurrentThread())
+        return true;
+    }
+    return false;
+  }
+
+  const Map* GetSnapshot() const {
+    return reinterpret_cast<const Map*>(
+        base::subtle::Acquire_Load(&snapshot_));
+  }
+
+  // Must be called with |write_lock_| held.
+  void Publish(Map* map) {
+    write_lock_.AssertAcquired();
+    const Map* old_map = GetSnapshot();
+    base::subtle::Release_Store(&snapshot_,
+                                reinterpret_cast<base::subtle::AtomicWord>(map));
+    // A reader thread which is already gone drops its reference right away.
+    scoped_refptr<RetiredSnapshot> retired(new RetiredSnapshot(old_map));
+    for (const auto& task_runner : reader_task_runners_) {
+      task_runner->PostTask(FROM_HERE,
+                            base::Bind(&ReleaseSnapshot, retired));
+    }
+  }
+
+  const TaskRunners reader_task_runners_;
+  base::Lock write_lock_;
+  // The current Map.
+  base::subtle::AtomicWord snapshot_;
+
+  DISALLOW_COPY_AND_ASSIGN(CopyOnWriteMap);
+};
+
+}  // namespace xwalk
+
+#endif  // XWALK_RUNTIME_BROWSER_COPY_ON_WRITE_MAP_H_
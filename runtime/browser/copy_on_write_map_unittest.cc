@@ -0,0 +1,148 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/copy_on_write_map.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/synchronization/cancellation_flag.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+
+namespace {
+
+typedef CopyOnWriteMap<int, std::string> TestMap;
+
+const int kStableKeys = 100;
+const int kWriters = 4;
+const int kKeysPerWriter = 100;
+const int kWritesPerWriter = 4000;
+const int kReadsPerTask = 1000;
+
+std::string ValueFor(int key) {
+  return base::IntToString(key * 10);
+}
+
+// Adds and removes frames, as the UI thread does.
+void ChurnKeys(TestMap* map, int writer) {
+  int first_key = kStableKeys + writer * kKeysPerWriter;
+  for (int i = 0; i < kWritesPerWriter; ++i) {
+    int key = first_key + i % kKeysPerWriter;
+    if ((i / kKeysPerWriter) % 2 == 0)
+      map->Set(key, ValueFor(key));
+    else
+      map->Erase(key);
+  }
+}
+
+// Looks up frames, as the IO thread does, until |done| is set.
+void LookUpKeys(TestMap* map,
+                const base::CancellationFlag* done,
+                int* reads) {
+  std::string value;
+  for (int i = 0; i < kReadsPerTask; ++i) {
+    int key = i % (kStableKeys + kWriters * kKeysPerWriter);
+    bool found = map->Get(key, &value);
+    if (key < kStableKeys)
+      EXPECT_TRUE(found);
+    if (found)
+      EXPECT_EQ(ValueFor(key), value);
+  }
+  *reads += kReadsPerTask;
+  if (done->IsSet())
+    return;
+  base::ThreadTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE, base::Bind(&LookUpKeys, map, done, reads));
+}
+
+// Every writer ends on a removal round.
+void CheckChurnedKeysErased(TestMap* map) {
+  std::string value;
+  for (int key = kStableKeys; key < kStableKeys + kWriters * kKeysPerWriter;
+       ++key) {
+    EXPECT_FALSE(map->Get(key, &value)) << key;
+  }
+}
+
+}  // namespace
+
+class CopyOnWriteMapTest : public testing::Test {
+ protected:
+  base::MessageLoop message_loop_;
+};
+
+TEST_F(CopyOnWriteMapTest, SetGetErase) {
+  TestMap map(base::ThreadTaskRunnerHandle::Get());
+  std::string value;
+  EXPECT_FALSE(map.Get(1, &value));
+
+  map.Set(1, "one");
+  map.Set(2, "two");
+  ASSERT_TRUE(map.Get(1, &value));
+  EXPECT_EQ("one", value);
+
+  map.Set(1, "uno");
+  ASSERT_TRUE(map.Get(1, &value));
+  EXPECT_EQ("uno", value);
+
+  map.Erase(1);
+  map.Erase(3);
+  EXPECT_FALSE(map.Get(1, &value));
+  ASSERT_TRUE(map.Get(2, &value));
+  EXPECT_EQ("two", value);
+
+  // Deletes the replaced snapshots.
+  base::RunLoop().RunUntilIdle();
+  ASSERT_TRUE(map.Get(2, &value));
+  EXPECT_EQ("two", value);
+}
+
+TEST_F(CopyOnWriteMapTest, ConcurrentChurnAndLookups) {
+  base::Thread reader("Reader");
+  ASSERT_TRUE(reader.Start());
+  std::unique_ptr<TestMap> map(new TestMap(reader.task_runner()));
+  for (int key = 0; key < kStableKeys; ++key)
+    map->Set(key, ValueFor(key));
+
+  base::CancellationFlag done;
+  int reads = 0;
+  reader.task_runner()->PostTask(
+      FROM_HERE, base::Bind(&LookUpKeys, map.get(), &done, &reads));
+
+  std::vector<std::unique_ptr<base::Thread>> writers;
+  for (int i = 0; i < kWriters; ++i) {
+    writers.push_back(std::unique_ptr<base::Thread>(
+        new base::Thread("Writer" + base::IntToString(i))));
+    ASSERT_TRUE(writers.back()->Start());
+    writers.back()->task_runner()->PostTask(
+        FROM_HERE, base::Bind(&ChurnKeys, map.get(), i));
+  }
+  for (const std::unique_ptr<base::Thread>& writer : writers)
+    writer->Stop();
+  done.Set();
+
+  // Runs the last lookups and the deletion of the replaced snapshots.
+  reader.task_runner()->PostTask(
+      FROM_HERE, base::Bind(&CheckChurnedKeysErased, map.get()));
+  base::WaitableEvent flushed(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                              base::WaitableEvent::InitialState::NOT_SIGNALED);
+  reader.task_runner()->PostTask(
+      FROM_HERE,
+      base::Bind(&base::WaitableEvent::Signal, base::Unretained(&flushed)));
+  flushed.Wait();
+  reader.Stop();
+  EXPECT_GT(reads, 0);
+}
+
+}  // namespace xwalk
@@ -0,0 +1,174 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/directory_enumerator.h"
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/single_thread_task_runner.h"
+#include "base/task_runner.h"
+#include "base/threading/thread_task_runner_handle.h"
+
+namespace xwalk {
+
+const size_t DirectoryEnumerator::kMaxChunkSize;
+const int DirectoryEnumerator::kMaxWorkers;
+
+DirectoryEnumerator::DirectoryEnumerator(const base::FilePath& root,
+                                         size_t max_files,
+                                         int64_t max_bytes,
+                                         Delegate* delegate)
+    : root_(root),
+      max_files_(max_files),
+      max_bytes_(max_bytes),
+      delegate_(delegate),
+      active_workers_(0),
+      file_count_(0),
+      byte_count_(0),
+      finished_(false) {
+}
+
+DirectoryEnumerator::~DirectoryEnumerator() {
+}
+
+void DirectoryEnumerator::Start(scoped_refptr<base::TaskRunner> task_runner) {
+  DCHECK(!task_runner_);
+  task_runner_ = task_runner;
+  origin_task_runner_ = base::ThreadTaskRunnerHandle::Get();
+  pending_directories_.push_back(root_);
+  active_workers_ = 1;
+  task_runner_->PostTask(
+      FROM_HERE, base::Bind(&DirectoryEnumerator::RunWorker, this));
+}
+
+void DirectoryEnumerator::Cancel() {
+  DCHECK(origin_task_runner_->BelongsToCurrentThread());
+  cancelled_.Set();
+  delegate_ = nullptr;
+}
+
+void DirectoryEnumerator::RunWorker() {
+  while (!cancelled_.IsSet()) {
+    base::FilePath directory;
+    {
+      base::AutoLock lock(lock_);
+      if (pending_directories_.empty())
+        break;
+      directory = pending_directories_.back();
+      pending_directories_.pop_back();
+    }
+    if (!ListDirectory(directory))
+      return;
+  }
+
+  bool done;
+  {
+    base::AutoLock lock(lock_);
+    done = --active_workers_ == 0 && pending_directories_.empty();
+  }
+  if (done && !cancelled_.IsSet())
+    Finish(RESULT_OK);
+}
+
+bool DirectoryEnumerator::ListDirectory(const base::FilePath& directory) {
+  if (directory == root_ && !base::DirectoryExists(root_)) {
+    Finish(RESULT_FAILED);
+    return false;
+  }
+
+  std::unique_ptr<std::vector<base::FilePath>> entries(
+      new std::vector<base::FilePath>);
+  int64_t bytes = 0;
+  base::FileEnumerator enumerator(
+      directory, false,
+      base::FileEnumerator::FILES | base::FileEnumerator::DIRECTORIES);
+  for (base::FilePath path = enumerator.Next();
+       !path.empty() && !cancelled_.IsSet(); path = enumerator.Next()) {
+    if (enumerator.GetInfo().IsDirectory()) {
+      entries->push_back(path.Append(FILE_PATH_LITERAL(".")));
+      // A link to a parent directory would be walked forever.
+      if (!base::IsLink(path)) {
+        bool add_worker;
+        {
+          base::AutoLock lock(lock_);
+          pending_directories_.push_back(path);
+          add_worker = active_workers_ < kMaxWorkers;
+          if (add_worker)
+            ++active_workers_;
+        }
+        if (add_worker) {
+          task_runner_->PostTask(
+              FROM_HERE, base::Bind(&DirectoryEnumerator::RunWorker, this));
+        }
+      }
+    } else {
+      entries->push_back(path);
+      bytes += enumerator.GetInfo().GetSize();
+    }
+
+    if (entries->size() == kMaxChunkSize) {
+      if (!PostEntries(std::move(entries), bytes))
+        return false;
+      entries.reset(new std::vector<base::FilePath>);
+      bytes = 0;
+    }
+  }
+  return entries->empty() || PostEntries(std::move(entries), bytes);
+}
+
+bool DirectoryEnumerator::PostEntries(
+    std::unique_ptr<std::vector<base::FilePath>> entries,
+    int64_t bytes) {
+  bool over_budget;
+  {
+    base::AutoLock lock(lock_);
+    file_count_ += entries->size();
+    byte_count_ += bytes;
+    over_budget = file_count_ > max_files_ || byte_count_ > max_bytes_;
+  }
+  if (over_budget) {
+    cancelled_.Set();
+    Finish(RESULT_OVER_BUDGET);
+    return false;
+  }
+
+  origin_task_runner_->PostTask(
+      FROM_HERE,
+      base::Bind(&DirectoryEnumerator::DispatchEntries, this,
+                 base::Passed(&entries)));
+  return true;
+}
+
+void DirectoryEnumerator::Finish(Result result) {
+  {
+    base::AutoLock lock(lock_);
+    if (finished_)
+      return;
+    finished_ = true;
+  }
+  origin_task_runner_->PostTask(
+      FROM_HERE,
+      base::Bind(&DirectoryEnumerator::DispatchDone, this, result));
+}
+
+void DirectoryEnumerator::DispatchEntries(
+    std::unique_ptr<std::vector<base::FilePath>> entries) {
+  if (delegate_)
+    delegate_->OnEntriesEnumerated(*entries);
+}
+
+void DirectoryEnumerator::DispatchDone(Result result) {
+  if (!delegate_)
+    return;
+  Delegate* delegate = delegate_;
+  delegate_ = nullptr;
+  delegate->OnEnumerationDone(result);
+}
+
+}  // namespace xwalk
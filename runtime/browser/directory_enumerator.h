@@ -0,0 +1,110 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_RUNTIME_BROWSER_DIRECTORY_ENUMERATOR_H_
+#define XWALK_RUNTIME_BROWSER_DIRECTORY_ENUMERATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/cancellation_flag.h"
+#include "base/synchronization/lock.h"
+
+namespace base {
+class SingleThreadTaskRunner;
+class TaskRunner;
+}
+
+namespace xwalk {
+
+// Recursively lists the entries of a directory, as picked for a
+// <input webkitdirectory>. The directories left to list are kept in a
+// depth-first work list, shared by at most kMaxWorkers tasks on the task
+// runner, so a wide tree doesn't take more threads than that.
+//
+// The entries are passed to the delegate on the thread that called Start(),
+// in chunks of at most kMaxChunkSize as they are found, rather than all at
+// once. Directories are reported as "<directory>/." so that empty ones are
+// included. The enumeration fails once there are more than |max_files|
+// entries, or files of more than |max_bytes| in total.
+class DirectoryEnumerator
+    : public base::RefCountedThreadSafe<DirectoryEnumerator> {
+ public:
+  enum Result {
+    RESULT_OK,
+    // The root is not a directory.
+    RESULT_FAILED,
+    RESULT_OVER_BUDGET,
+  };
+
+  class Delegate {
+   public:
+    virtual void OnEntriesEnumerated(
+        const std::vector<base::FilePath>& entries) = 0;
+    // Called once, after all the entries.
+    virtual void OnEnumerationDone(Result result) = 0;
+
+   protected:
+    virtual ~Delegate() {}
+  };
+
+  static const size_t kMaxChunkSize = 1000;
+  static const int kMaxWorkers = 4;
+
+  DirectoryEnumerator(const base::FilePath& root,
+                      size_t max_files,
+                      int64_t max_bytes,
+                      Delegate* delegate);
+
+  void Start(scoped_refptr<base::TaskRunner> task_runner);
+  // Stops the enumeration. The delegate is not called anymore.
+  void Cancel();
+
+ private:
+  friend class base::RefCountedThreadSafe<DirectoryEnumerator>;
+  ~DirectoryEnumerator();
+
+  // These run on |task_runner_|.
+  // Lists the directories of the work list until it is empty.
+  void RunWorker();
+  // Returns false if the enumeration is over.
+  bool ListDirectory(const base::FilePath& directory);
+  // Returns false if the budget is exceeded.
+  bool PostEntries(std::unique_ptr<std::vector<base::FilePath>> entries,
+                   int64_t bytes);
+  void Finish(Result result);
+
+  // These run on |origin_task_runner_|.
+  void DispatchEntries(std::unique_ptr<std::vector<base::FilePath>> entries);
+  void DispatchDone(Result result);
+
+  const base::FilePath root_;
+  const size_t max_files_;
+  const int64_t max_bytes_;
+  Delegate* delegate_;
+
+  scoped_refptr<base::TaskRunner> task_runner_;
+  scoped_refptr<base::SingleThreadTaskRunner> origin_task_runner_;
+  base::CancellationFlag cancelled_;
+
+  base::Lock lock_;
+  // Guarded by |lock_|.
+  std::vector<base::FilePath> pending_directories_;
+  int active_workers_;
+  size_t file_count_;
+  int64_t byte_count_;
+  bool finished_;
+
+  DISALLOW_COPY_AND_ASSIGN(DirectoryEnumerator);
+};
+
+}  // namespace xwalk
+
+#endif  // XWALK_RUNTIME_BROWSER_DIRECTORY_ENUMERATOR_H_
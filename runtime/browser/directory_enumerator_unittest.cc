@@ -0,0 +1,220 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/directory_enumerator.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/task_runner.h"
+#include "base/threading/worker_pool.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace xwalk {
+
+namespace {
+
+class TestDelegate : public DirectoryEnumerator::Delegate {
+ public:
+  TestDelegate()
+      : result_(DirectoryEnumerator::RESULT_FAILED),
+        chunks_(0),
+        largest_chunk_(0) {}
+  ~TestDelegate() override {}
+
+  void OnEntriesEnumerated(
+      const std::vector<base::FilePath>& entries) override {
+    ++chunks_;
+    largest_chunk_ = std::max(largest_chunk_, entries.size());
+    for (const base::FilePath& entry : entries)
+      EXPECT_TRUE(entries_.insert(entry).second);
+  }
+
+  void OnEnumerationDone(DirectoryEnumerator::Result result) override {
+    result_ = result;
+    run_loop_.Quit();
+  }
+
+  void WaitForDone() { run_loop_.Run(); }
+
+  const std::set<base::FilePath>& entries() const { return entries_; }
+  DirectoryEnumerator::Result result() const { return result_; }
+  int chunks() const { return chunks_; }
+  size_t largest_chunk() const { return largest_chunk_; }
+
+ private:
+  base::RunLoop run_loop_;
+  std::set<base::FilePath> entries_;
+  DirectoryEnumerator::Result result_;
+  int chunks_;
+  size_t largest_chunk_;
+};
+
+// Runs the tasks on the worker pool, and records how many ran at once.
+class CountingTaskRunner : public base::TaskRunner {
+ public:
+  CountingTaskRunner() : running_(0), max_running_(0) {}
+
+  bool PostDelayedTask(const tracked_objects::Location& from_here,
+                       const base::Closure& task,
+                       base::TimeDelta delay) override {
+    return base::WorkerPool::GetTaskRunner(true)->PostDelayedTask(
+        from_here, base::Bind(&CountingTaskRunner::Run, this, task), delay);
+  }
+
+  bool RunsTasksOnCurrentThread() const override { return false; }
+
+  int max_running() const {
+    base::AutoLock lock(lock_);
+    return max_running_;
+  }
+
+ private:
+  ~CountingTaskRunner() override {}
+
+  void Run(const base::Closure& task) {
+    {
+      base::AutoLock lock(lock_);
+      max_running_ = std::max(max_running_, ++running_);
+    }
+    task.Run();
+    base::AutoLock lock(lock_);
+    --running_;
+  }
+
+  mutable base::Lock lock_;
+  int running_;
+  int max_running_;
+};
+
+}  // namespace
+
+class DirectoryEnumeratorTest : public testing::Test {
+ protected:
+  void SetUp() override { ASSERT_TRUE(temp_dir_.CreateUniqueTempDir()); }
+
+  // Creates |directories| directories of |subdirectories| directories of
+  // |files| files each, and returns the entries expected from them.
+  std::set<base::FilePath> CreateTree(int directories,
+                                      int subdirectories,
+                                      int files) {
+    std::set<base::FilePath> entries;
+    for (int i = 0; i < directories; ++i) {
+      base::FilePath directory =
+          temp_dir_.path().AppendASCII(base::StringPrintf("dir%d", i));
+      EXPECT_TRUE(base::CreateDirectory(directory));
+      entries.insert(directory.Append(FILE_PATH_LITERAL(".")));
+      for (int j = 0; j < subdirectories; ++j) {
+        base::FilePath subdirectory =
+            directory.AppendASCII(base::StringPrintf("sub%d", j));
+        EXPECT_TRUE(base::CreateDirectory(subdirectory));
+        entries.insert(subdirectory.Append(FILE_PATH_LITERAL(".")));
+        for (int k = 0; k < files; ++k) {
+          base::FilePath file =
+              subdirectory.AppendASCII(base::StringPrintf("file%d.txt", k));
+          EXPECT_EQ(1, base::WriteFile(file, "x", 1));
+          entries.insert(file);
+        }
+      }
+    }
+    return entries;
+  }
+
+  base::MessageLoop message_loop_;
+  base::ScopedTempDir temp_dir_;
+};
+
+TEST_F(DirectoryEnumeratorTest, LargeTree) {
+  std::set<base::FilePath> expected = CreateTree(20, 10, 50);
+  ASSERT_EQ(20u + 200u + 10000u, expected.size());
+
+  TestDelegate delegate;
+  scoped_refptr<DirectoryEnumerator> enumerator(new DirectoryEnumerator(
+      temp_dir_.path(), expected.size(), expected.size(), &delegate));
+  enumerator->Start(base::WorkerPool::GetTaskRunner(true));
+  delegate.WaitForDone();
+
+  EXPECT_EQ(DirectoryEnumerator::RESULT_OK, delegate.result());
+  EXPECT_EQ(expected, delegate.entries());
+  // The entries were streamed in bounded chunks.
+  EXPECT_GT(delegate.chunks(), 1);
+  EXPECT_LE(delegate.largest_chunk(), DirectoryEnumerator::kMaxChunkSize);
+}
+
+TEST_F(DirectoryEnumeratorTest, BoundedWorkers) {
+  std::set<base::FilePath> expected = CreateTree(100, 5, 1);
+
+  TestDelegate delegate;
+  scoped_refptr<CountingTaskRunner> task_runner(new CountingTaskRunner);
+  scoped_refptr<DirectoryEnumerator> enumerator(new DirectoryEnumerator(
+      temp_dir_.path(), expected.size(), expected.size(), &delegate));
+  enumerator->Start(task_runner);
+  delegate.WaitForDone();
+
+  EXPECT_EQ(DirectoryEnumerator::RESULT_OK, delegate.result());
+  EXPECT_EQ(expected, delegate.entries());
+  EXPECT_GE(task_runner->max_running(), 1);
+  EXPECT_LE(task_runner->max_running(), DirectoryEnumerator::kMaxWorkers);
+}
+
+TEST_F(DirectoryEnumeratorTest, EmptyDirectory) {
+  base::FilePath empty = temp_dir_.path().AppendASCII("empty");
+  ASSERT_TRUE(base::CreateDirectory(empty));
+
+  TestDelegate delegate;
+  scoped_refptr<DirectoryEnumerator> enumerator(
+      new DirectoryEnumerator(temp_dir_.path(), 10, 10, &delegate));
+  enumerator->Start(base::WorkerPool::GetTaskRunner(true));
+  delegate.WaitForDone();
+
+  EXPECT_EQ(DirectoryEnumerator::RESULT_OK, delegate.result());
+  ASSERT_EQ(1u, delegate.entries().size());
+  EXPECT_EQ(empty.Append(FILE_PATH_LITERAL(".")), *delegate.entries().begin());
+}
+
+TEST_F(DirectoryEnumeratorTest, MissingDirectory) {
+  TestDelegate delegate;
+  scoped_refptr<DirectoryEnumerator> enumerator(new DirectoryEnumerator(
+      temp_dir_.path().AppendASCII("missing"), 10, 10, &delegate));
+  enumerator->Start(base::WorkerPool::GetTaskRunner(true));
+  delegate.WaitForDone();
+
+  EXPECT_EQ(DirectoryEnumerator::RESULT_FAILED, delegate.result());
+  EXPECT_TRUE(delegate.entries().empty());
+}
+
+TEST_F(DirectoryEnumeratorTest, FileBudget) {
+  CreateTree(4, 4, 100);
+
+  TestDelegate delegate;
+  scoped_refptr<DirectoryEnumerator> enumerator(
+      new DirectoryEnumerator(temp_dir_.path(), 1000, 1000000, &delegate));
+  enumerator->Start(base::WorkerPool::GetTaskRunner(true));
+  delegate.WaitForDone();
+
+  EXPECT_EQ(DirectoryEnumerator::RESULT_OVER_BUDGET, delegate.result());
+}
+
+TEST_F(DirectoryEnumeratorTest, ByteBudget) {
+  CreateTree(2, 2, 10);
+
+  TestDelegate delegate;
+  scoped_refptr<DirectoryEnumerator> enumerator(
+      new DirectoryEnumerator(temp_dir_.path(), 1000, 39, &delegate));
+  enumerator->Start(base::WorkerPool::GetTaskRunner(true));
+  delegate.WaitForDone();
+
+  EXPECT_EQ(DirectoryEnumerator::RESULT_OVER_BUDGET, delegate.result());
+}
+
+}  // namespace xwalk
@@ -0,0 +1,393 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/favicon_store.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <set>
+
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/memory/ptr_util.h"
+#include "base/pickle.h"
+#include "base/sequenced_task_runner.h"
+#include "base/sha1.h"
+#include "base/strings/stringprintf.h"
+#include "base/task_runner_util.h"
+#include "base/time/clock.h"
+#include "ui/gfx/codec/png_codec.h"
+#include "ui/gfx/geometry/size.h"
+#include "url/gurl.h"
+
+namespace xwalk {
+
+namespace {
+
+// Bumped whenever the layout of the file changes; files of another version
+// are ignored.
+const int kFileVersion = 2;
+
+// The digest tells apart bitmaps of different sizes with the same pixels.
+std::string ComputeDigest(const SkBitmap& bitmap) {
+  SkAutoLockPixels lock(bitmap);
+  std::string digest = base::StringPrintf("%dx%d:", bitmap.width(),
+                                          bitmap.height());
+  unsigned char hash[base::kSHA1Length];
+  base::SHA1HashBytes(static_cast<const unsigned char*>(bitmap.getPixels()),
+                      bitmap.getSize(), hash);
+  digest.append(reinterpret_cast<const char*>(hash), sizeof(hash));
+  return digest;
+}
+
+}  // namespace
+
+struct FaviconStore::LoadedIcons {
+  std::map<std::string, StoredBitmap> bitmaps;
+  // Least recently used first.
+  std::vector<std::pair<IconKey, Icon>> icons;
+};
+
+FaviconStore::Icon::Icon() {
+}
+
+FaviconStore::Icon::Icon(const Icon& other) = default;
+
+FaviconStore::Icon::~Icon() {
+}
+
+FaviconStore::StoredBitmap::StoredBitmap() : icon_count(0) {
+}
+
+FaviconStore::StoredBitmap::StoredBitmap(const StoredBitmap& other) = default;
+
+FaviconStore::StoredBitmap::~StoredBitmap() {
+}
+
+FaviconStore::FaviconStore(
+    const base::FilePath& path,
+    scoped_refptr<base::SequencedTaskRunner> task_runner,
+    size_t max_icons,
+    base::TimeDelta max_age,
+    std::unique_ptr<base::Clock> clock)
+    : task_runner_(task_runner),
+      max_icons_(max_icons),
+      max_age_(max_age),
+      clock_(std::move(clock)),
+      icons_(base::MRUCache<IconKey, Icon>::NO_AUTO_EVICT),
+      weak_ptr_factory_(this) {
+  if (!path.empty())
+    writer_.reset(new base::ImportantFileWriter(path, task_runner));
+}
+
+FaviconStore::~FaviconStore() {
+  // The bitmaps still being encoded are not saved.
+  if (writer_ && writer_->HasPendingWrite())
+    writer_->DoScheduledWrite();
+}
+
+void FaviconStore::Load() {
+  if (!writer_)
+    return;
+  base::PostTaskAndReplyWithResult(
+      task_runner_.get(), FROM_HERE,
+      base::Bind(&FaviconStore::ReadIcons, writer_->path()),
+      base::Bind(&FaviconStore::OnIconsLoaded,
+                 weak_ptr_factory_.GetWeakPtr()));
+}
+
+bool FaviconStore::GetIcon(const GURL& page_url,
+                           const GURL& icon_url,
+                           int desired_size,
+                           SkBitmap* bitmap) {
+  auto it = icons_.Get(IconKey(page_url.host(), icon_url.spec()));
+  if (it == icons_.end())
+    return false;
+
+  // The caller downloads the icon again, which sets it anew.
+  if (IsExpired(it->second)) {
+    ReleaseIcon(it->second);
+    icons_.Erase(it);
+    ScheduleWrite();
+    return false;
+  }
+
+  const Icon& icon = it->second;
+  std::vector<gfx::Size> sizes;
+  for (const std::string& digest : icon.digests) {
+    const SkBitmap& stored = bitmaps_[digest].bitmap;
+    sizes.push_back(gfx::Size(stored.width(), stored.height()));
+  }
+  *bitmap =
+      bitmaps_[icon.digests[SelectBestSize(sizes, desired_size)]].bitmap;
+  return true;
+}
+
+void FaviconStore::SetIcon(const GURL& page_url,
+                           const GURL& icon_url,
+                           const std::vector<SkBitmap>& bitmaps) {
+  Icon icon;
+  std::map<std::string, StoredBitmap> new_bitmaps;
+  for (const SkBitmap& bitmap : bitmaps) {
+    if (bitmap.isNull() || bitmap.colorType() != kN32_SkColorType)
+      continue;
+    std::string digest = ComputeDigest(bitmap);
+    if (std::find(icon.digests.begin(), icon.digests.end(), digest) !=
+        icon.digests.end())
+      continue;
+    icon.digests.push_back(digest);
+    if (!bitmaps_.count(digest))
+      new_bitmaps[digest].bitmap = bitmap;
+  }
+  if (icon.digests.empty())
+    return;
+
+  icon.time = clock_->Now();
+  bitmaps_.insert(new_bitmaps.begin(), new_bitmaps.end());
+  AddIcon(IconKey(page_url.host(), icon_url.spec()), icon);
+
+  // The new bitmaps are written once encoded.
+  if (writer_) {
+    for (const auto& it : new_bitmaps) {
+      base::PostTaskAndReplyWithResult(
+          task_runner_.get(), FROM_HERE,
+          base::Bind(&FaviconStore::EncodeBitmap, it.second.bitmap),
+          base::Bind(&FaviconStore::OnBitmapEncoded,
+                     weak_ptr_factory_.GetWeakPtr(), it.first));
+    }
+  }
+  ScheduleWrite();
+}
+
+void FaviconStore::ClearIcons() {
+  // Neither the icons being loaded nor the bitmaps being encoded are kept.
+  weak_ptr_factory_.InvalidateWeakPtrs();
+  icons_.Clear();
+  bitmaps_.clear();
+  ScheduleWrite();
+}
+
+// static
+size_t FaviconStore::SelectBestSize(const std::vector<gfx::Size>& sizes,
+                                    int desired_size) {
+  DCHECK(!sizes.empty());
+  size_t best = 0;
+  int best_distance = 0;
+  int best_edge = 0;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    int edge = std::max(sizes[i].width(), sizes[i].height());
+    int distance = abs(edge - desired_size);
+    if (i == 0 || distance < best_distance ||
+        (distance == best_distance && edge > best_edge)) {
+      best = i;
+      best_distance = distance;
+      best_edge = edge;
+    }
+  }
+  return best;
+}
+
+bool FaviconStore::SerializeData(std::string* data) {
+  base::Pickle pickle;
+  pickle.WriteInt(kFileVersion);
+
+  // The bitmaps are written once and referred to by index. Those not
+  // encoded yet, and the icons using them, are left to a later write.
+  std::map<std::string, int> indices;
+  std::vector<const std::string*> png_data;
+  for (const auto& it : bitmaps_) {
+    if (it.second.png_data.empty())
+      continue;
+    indices[it.first] = static_cast<int>(png_data.size());
+    png_data.push_back(&it.second.png_data);
+  }
+  pickle.WriteUInt32(png_data.size());
+  for (const std::string* data : png_data)
+    pickle.WriteString(*data);
+
+  // Least recently used first, as they are added back when loading.
+  std::vector<const std::pair<IconKey, Icon>*> icons;
+  for (auto it = icons_.rbegin(); it != icons_.rend(); ++it) {
+    bool encoded = true;
+    for (const std::string& digest : it->second.digests)
+      encoded = encoded && indices.count(digest);
+    if (encoded)
+      icons.push_back(&*it);
+  }
+  pickle.WriteUInt32(icons.size());
+  for (const auto* icon : icons) {
+    pickle.WriteString(icon->first.first);
+    pickle.WriteString(icon->first.second);
+    pickle.WriteInt64(icon->second.time.ToInternalValue());
+    pickle.WriteUInt32(icon->second.digests.size());
+    for (const std::string& digest : icon->second.digests)
+      pickle.WriteInt(indices[digest]);
+  }
+
+  data->assign(static_cast<const char*>(pickle.data()), pickle.size());
+  return true;
+}
+
+// static
+std::unique_ptr<FaviconStore::LoadedIcons> FaviconStore::ReadIcons(
+    const base::FilePath& path) {
+  std::unique_ptr<LoadedIcons> loaded(new LoadedIcons);
+  std::string data;
+  if (!base::ReadFileToString(path, &data))
+    return loaded;
+
+  base::Pickle pickle(data.data(), data.size());
+  base::PickleIterator iter(pickle);
+  int version;
+  uint32_t bitmap_count;
+  if (!iter.ReadInt(&version) || version != kFileVersion ||
+      !iter.ReadUInt32(&bitmap_count))
+    return loaded;
+
+  // A bitmap that can't be decoded leaves a hole, and the icons using it
+  // are dropped.
+  std::vector<std::string> digests;
+  for (uint32_t i = 0; i < bitmap_count; ++i) {
+    StoredBitmap stored;
+    if (!iter.ReadString(&stored.png_data))
+      return base::WrapUnique(new LoadedIcons);
+    if (!gfx::PNGCodec::Decode(
+            reinterpret_cast<const unsigned char*>(stored.png_data.data()),
+            stored.png_data.size(), &stored.bitmap)) {
+      digests.push_back(std::string());
+      continue;
+    }
+    digests.push_back(ComputeDigest(stored.bitmap));
+    loaded->bitmaps[digests.back()] = stored;
+  }
+
+  uint32_t icon_count;
+  if (!iter.ReadUInt32(&icon_count))
+    return base::WrapUnique(new LoadedIcons);
+  for (uint32_t i = 0; i < icon_count; ++i) {
+    IconKey key;
+    int64_t time;
+    uint32_t size;
+    if (!iter.ReadString(&key.first) || !iter.ReadString(&key.second) ||
+        !iter.ReadInt64(&time) || !iter.ReadUInt32(&size))
+      return base::WrapUnique(new LoadedIcons);
+
+    Icon icon;
+    icon.time = base::Time::FromInternalValue(time);
+    bool complete = true;
+    for (uint32_t j = 0; j < size; ++j) {
+      int index;
+      if (!iter.ReadInt(&index))
+        return base::WrapUnique(new LoadedIcons);
+      if (index < 0 || static_cast<size_t>(index) >= digests.size() ||
+          digests[index].empty()) {
+        complete = false;
+        continue;
+      }
+      icon.digests.push_back(digests[index]);
+    }
+    if (complete && !icon.digests.empty())
+      loaded->icons.push_back(std::make_pair(key, icon));
+  }
+  return loaded;
+}
+
+void FaviconStore::OnIconsLoaded(std::unique_ptr<LoadedIcons> loaded) {
+  bitmaps_.insert(loaded->bitmaps.begin(), loaded->bitmaps.end());
+
+  // The icons set since Load() was called are more recent than the loaded
+  // ones, and replace them.
+  std::vector<std::pair<IconKey, Icon>> current(icons_.rbegin(),
+                                                icons_.rend());
+  std::set<IconKey> current_keys;
+  for (const auto& icon : current)
+    current_keys.insert(icon.first);
+  std::vector<std::pair<IconKey, Icon>> older;
+  for (const auto& icon : loaded->icons) {
+    if (!current_keys.count(icon.first) && !IsExpired(icon.second))
+      older.push_back(icon);
+  }
+
+  icons_.Clear();
+  for (auto& it : bitmaps_)
+    it.second.icon_count = 0;
+  // Only the most recent loaded icons fit next to the current ones, which
+  // avoids evicting anything below.
+  size_t room = max_icons_ > current.size() ? max_icons_ - current.size() : 0;
+  size_t skipped = older.size() > room ? older.size() - room : 0;
+  for (size_t i = skipped; i < older.size(); ++i)
+    AddIcon(older[i].first, older[i].second);
+  for (const auto& icon : current)
+    AddIcon(icon.first, icon.second);
+
+  // Drop the loaded bitmaps no icon uses.
+  for (auto it = bitmaps_.begin(); it != bitmaps_.end();) {
+    if (it->second.icon_count == 0)
+      it = bitmaps_.erase(it);
+    else
+      ++it;
+  }
+}
+
+// static
+std::string FaviconStore::EncodeBitmap(const SkBitmap& bitmap) {
+  std::vector<unsigned char> png;
+  if (!gfx::PNGCodec::EncodeBGRASkBitmap(bitmap, false, &png))
+    return std::string();
+  return std::string(png.begin(), png.end());
+}
+
+void FaviconStore::OnBitmapEncoded(const std::string& digest,
+                                   const std::string& png_data) {
+  // The icons using the bitmap may have been evicted meanwhile.
+  auto it = bitmaps_.find(digest);
+  if (it == bitmaps_.end() || png_data.empty())
+    return;
+  it->second.png_data = png_data;
+  ScheduleWrite();
+}
+
+bool FaviconStore::IsExpired(const Icon& icon) const {
+  base::Time now = clock_->Now();
+  return icon.time > now || now - icon.time >= max_age_;
+}
+
+void FaviconStore::AddIcon(const IconKey& key, const Icon& icon) {
+  // Counted before the replaced icon is released, so that the bitmaps they
+  // share are kept.
+  for (const std::string& digest : icon.digests)
+    ++bitmaps_[digest].icon_count;
+
+  auto existing = icons_.Peek(key);
+  if (existing != icons_.end()) {
+    ReleaseIcon(existing->second);
+    icons_.Erase(existing);
+  }
+  icons_.Put(key, icon);
+
+  while (icons_.size() > max_icons_) {
+    auto oldest = icons_.rbegin();
+    ReleaseIcon(oldest->second);
+    icons_.Erase(oldest);
+  }
+}
+
+void FaviconStore::ReleaseIcon(const Icon& icon) {
+  for (const std::string& digest : icon.digests) {
+    auto it = bitmaps_.find(digest);
+    if (it != bitmaps_.end() && --it->second.icon_count == 0)
+      bitmaps_.erase(it);
+  }
+}
+
+void FaviconStore::ScheduleWrite() {
+  if (writer_)
+    writer_->ScheduleWrite(this);
+}
+
+}  // namespace xwalk
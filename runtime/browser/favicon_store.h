@@ -0,0 +1,143 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_RUNTIME_BROWSER_FAVICON_STORE_H_
+#define XWALK_RUNTIME_BROWSER_FAVICON_STORE_H_
+
+#include <stddef.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/containers/mru_cache.h"
+#include "base/files/file_path.h"
+#include "base/files/important_file_writer.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+
+class GURL;
+
+namespace base {
+class Clock;
+class SequencedTaskRunner;
+}
+
+namespace gfx {
+class Size;
+}
+
+namespace xwalk {
+
+// Keeps the favicons downloaded in a browser context, so that pages showing
+// the same icon again do not fetch it.
+//
+// The icons are keyed by the host of the page and the URL of the icon, and
+// the least recently used ones are evicted past |max_icons|. An icon holds
+// all the bitmaps of its image, and identical bitmaps, like those of an
+// icon shared by several hosts, are only kept once. An icon expires
+// |max_age| after it was set, however often it is used, so that a changed
+// icon is downloaded again.
+//
+// Unless |path| is empty, the store is saved there as PNG images in a
+// pickle, the encoding and file IO being done on |task_runner|.
+class FaviconStore : public base::ImportantFileWriter::DataSerializer {
+ public:
+  FaviconStore(const base::FilePath& path,
+               scoped_refptr<base::SequencedTaskRunner> task_runner,
+               size_t max_icons,
+               base::TimeDelta max_age,
+               std::unique_ptr<base::Clock> clock);
+  ~FaviconStore() override;
+
+  // Reads the icons saved by a previous run. Icons set in the meantime take
+  // precedence over the loaded ones.
+  void Load();
+
+  // Sets |bitmap| to the bitmap of the icon closest to |desired_size|
+  // pixels. Returns false if the icon is not stored or has expired.
+  bool GetIcon(const GURL& page_url,
+               const GURL& icon_url,
+               int desired_size,
+               SkBitmap* bitmap);
+  void SetIcon(const GURL& page_url,
+               const GURL& icon_url,
+               const std::vector<SkBitmap>& bitmaps);
+  // Forgets all the icons, including those a pending Load() would read.
+  void ClearIcons();
+
+  size_t icon_count() const { return icons_.size(); }
+  size_t bitmap_count() const { return bitmaps_.size(); }
+
+  // Returns the index of the size closest to |desired_size| pixels wide or
+  // high. Downscaling a larger bitmap looks better than upscaling, so the
+  // larger one wins among equally close sizes.
+  static size_t SelectBestSize(const std::vector<gfx::Size>& sizes,
+                               int desired_size);
+
+  // base::ImportantFileWriter::DataSerializer implementation.
+  bool SerializeData(std::string* data) override;
+
+ private:
+  // The host of the page and the spec of the icon URL.
+  typedef std::pair<std::string, std::string> IconKey;
+
+  struct Icon {
+    Icon();
+    Icon(const Icon& other);
+    ~Icon();
+
+    // The digests of the bitmaps.
+    std::vector<std::string> digests;
+    // When the icon was set.
+    base::Time time;
+  };
+
+  struct StoredBitmap {
+    StoredBitmap();
+    StoredBitmap(const StoredBitmap& other);
+    ~StoredBitmap();
+
+    SkBitmap bitmap;
+    // Empty until encoded on the task runner.
+    std::string png_data;
+    int icon_count;
+  };
+
+  struct LoadedIcons;
+
+  static std::unique_ptr<LoadedIcons> ReadIcons(const base::FilePath& path);
+  void OnIconsLoaded(std::unique_ptr<LoadedIcons> loaded);
+
+  static std::string EncodeBitmap(const SkBitmap& bitmap);
+  void OnBitmapEncoded(const std::string& digest, const std::string& png_data);
+
+  bool IsExpired(const Icon& icon) const;
+
+  void AddIcon(const IconKey& key, const Icon& icon);
+  void ReleaseIcon(const Icon& icon);
+  void ScheduleWrite();
+
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+  std::unique_ptr<base::ImportantFileWriter> writer_;
+  size_t max_icons_;
+  base::TimeDelta max_age_;
+  std::unique_ptr<base::Clock> clock_;
+  base::MRUCache<IconKey, Icon> icons_;
+  // Keyed by the digest of the pixels.
+  std::map<std::string, StoredBitmap> bitmaps_;
+
+  base::WeakPtrFactory<FaviconStore> weak_ptr_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(FaviconStore);
+};
+
+}  // namespace xwalk
+
+#endif  // XWALK_RUNTIME_BROWSER_FAVICON_STORE_H_
@@ -0,0 +1,280 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/favicon_store.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/memory/ptr_util.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/simple_test_clock.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "ui/gfx/geometry/size.h"
+#include "url/gurl.h"
+
+namespace xwalk {
+
+namespace {
+
+SkBitmap MakeBitmap(int size, SkColor color) {
+  SkBitmap bitmap;
+  bitmap.allocN32Pixels(size, size);
+  bitmap.eraseColor(color);
+  return bitmap;
+}
+
+GURL PageURL(int host) {
+  return GURL(base::StringPrintf("https://host%d.example.com/page", host));
+}
+
+const char kIconURL[] = "https://cdn.example.com/favicon.ico";
+
+const int kMaxAgeDays = 7;
+
+}  // namespace
+
+class FaviconStoreTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    path_ = temp_dir_.path().AppendASCII("Favicons");
+  }
+
+  std::unique_ptr<FaviconStore> CreateStore(const base::FilePath& path,
+                                            size_t max_icons) {
+    clock_ = new base::SimpleTestClock;
+    return std::unique_ptr<FaviconStore>(new FaviconStore(
+        path, base::ThreadTaskRunnerHandle::Get(), max_icons,
+        base::TimeDelta::FromDays(kMaxAgeDays), base::WrapUnique(clock_)));
+  }
+
+  base::MessageLoop message_loop_;
+  base::ScopedTempDir temp_dir_;
+  base::FilePath path_;
+  // Owned by the last store created.
+  base::SimpleTestClock* clock_;
+};
+
+TEST_F(FaviconStoreTest, SelectBestSize) {
+  std::vector<gfx::Size> sizes;
+  sizes.push_back(gfx::Size(16, 16));
+  sizes.push_back(gfx::Size(32, 32));
+  sizes.push_back(gfx::Size(64, 48));
+
+  EXPECT_EQ(0u, FaviconStore::SelectBestSize(sizes, 8));
+  EXPECT_EQ(0u, FaviconStore::SelectBestSize(sizes, 16));
+  EXPECT_EQ(1u, FaviconStore::SelectBestSize(sizes, 30));
+  // Equally close to 16 and 32, the larger one is downscaled.
+  EXPECT_EQ(1u, FaviconStore::SelectBestSize(sizes, 24));
+  // The largest edge is compared.
+  EXPECT_EQ(2u, FaviconStore::SelectBestSize(sizes, 60));
+  EXPECT_EQ(2u, FaviconStore::SelectBestSize(sizes, 512));
+}
+
+TEST_F(FaviconStoreTest, GetIconClosestToSize) {
+  std::unique_ptr<FaviconStore> store = CreateStore(base::FilePath(), 10);
+  std::vector<SkBitmap> bitmaps;
+  bitmaps.push_back(MakeBitmap(16, SK_ColorRED));
+  bitmaps.push_back(MakeBitmap(48, SK_ColorRED));
+  bitmaps.push_back(MakeBitmap(32, SK_ColorRED));
+  store->SetIcon(PageURL(0), GURL(kIconURL), bitmaps);
+
+  SkBitmap bitmap;
+  ASSERT_TRUE(store->GetIcon(PageURL(0), GURL(kIconURL), 32, &bitmap));
+  EXPECT_EQ(32, bitmap.width());
+  ASSERT_TRUE(store->GetIcon(PageURL(0), GURL(kIconURL), 64, &bitmap));
+  EXPECT_EQ(48, bitmap.width());
+
+  // The icon is kept for its host only.
+  EXPECT_FALSE(store->GetIcon(PageURL(1), GURL(kIconURL), 32, &bitmap));
+  EXPECT_FALSE(store->GetIcon(
+      PageURL(0), GURL("https://cdn.example.com/other.ico"), 32, &bitmap));
+}
+
+TEST_F(FaviconStoreTest, IdenticalBitmapsAreKeptOnce) {
+  std::unique_ptr<FaviconStore> store = CreateStore(base::FilePath(), 10);
+  std::vector<SkBitmap> bitmaps;
+  bitmaps.push_back(MakeBitmap(16, SK_ColorBLUE));
+  bitmaps.push_back(MakeBitmap(16, SK_ColorBLUE));
+  bitmaps.push_back(MakeBitmap(32, SK_ColorBLUE));
+  for (int i = 0; i < 5; ++i)
+    store->SetIcon(PageURL(i), GURL(kIconURL), bitmaps);
+
+  EXPECT_EQ(5u, store->icon_count());
+  EXPECT_EQ(2u, store->bitmap_count());
+}
+
+TEST_F(FaviconStoreTest, SetIconTwice) {
+  std::unique_ptr<FaviconStore> store = CreateStore(path_, 10);
+  std::vector<SkBitmap> bitmaps;
+  bitmaps.push_back(MakeBitmap(16, SK_ColorRED));
+  bitmaps.push_back(MakeBitmap(32, SK_ColorRED));
+  store->SetIcon(PageURL(0), GURL(kIconURL), bitmaps);
+  store->SetIcon(PageURL(0), GURL(kIconURL), bitmaps);
+
+  EXPECT_EQ(1u, store->icon_count());
+  EXPECT_EQ(2u, store->bitmap_count());
+  SkBitmap bitmap;
+  ASSERT_TRUE(store->GetIcon(PageURL(0), GURL(kIconURL), 32, &bitmap));
+  ASSERT_FALSE(bitmap.isNull());
+  EXPECT_EQ(32, bitmap.width());
+
+  // The bitmaps are still saved.
+  base::RunLoop().RunUntilIdle();
+  store.reset();
+  base::RunLoop().RunUntilIdle();
+  store = CreateStore(path_, 10);
+  store->Load();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(1u, store->icon_count());
+  EXPECT_EQ(2u, store->bitmap_count());
+}
+
+TEST_F(FaviconStoreTest, LeastRecentlyUsedIsEvicted) {
+  std::unique_ptr<FaviconStore> store = CreateStore(base::FilePath(), 3);
+  for (int i = 0; i < 3; ++i) {
+    store->SetIcon(PageURL(i), GURL(kIconURL),
+                   std::vector<SkBitmap>(1, MakeBitmap(16, SK_ColorRED + i)));
+  }
+
+  SkBitmap bitmap;
+  EXPECT_TRUE(store->GetIcon(PageURL(0), GURL(kIconURL), 16, &bitmap));
+  store->SetIcon(PageURL(3), GURL(kIconURL),
+                 std::vector<SkBitmap>(1, MakeBitmap(16, SK_ColorGREEN)));
+
+  EXPECT_EQ(3u, store->icon_count());
+  EXPECT_TRUE(store->GetIcon(PageURL(0), GURL(kIconURL), 16, &bitmap));
+  EXPECT_FALSE(store->GetIcon(PageURL(1), GURL(kIconURL), 16, &bitmap));
+  EXPECT_TRUE(store->GetIcon(PageURL(3), GURL(kIconURL), 16, &bitmap));
+  // The bitmap of the evicted icon is gone with it.
+  EXPECT_EQ(3u, store->bitmap_count());
+}
+
+TEST_F(FaviconStoreTest, ReloadFromDisk) {
+  std::unique_ptr<FaviconStore> store = CreateStore(path_, 10);
+  std::vector<SkBitmap> bitmaps;
+  bitmaps.push_back(MakeBitmap(16, SK_ColorRED));
+  bitmaps.push_back(MakeBitmap(32, SK_ColorRED));
+  store->SetIcon(PageURL(0), GURL(kIconURL), bitmaps);
+  store->SetIcon(PageURL(1), GURL(kIconURL), bitmaps);
+  // Lets the bitmaps be encoded.
+  base::RunLoop().RunUntilIdle();
+  store.reset();
+  base::RunLoop().RunUntilIdle();
+  ASSERT_TRUE(base::PathExists(path_));
+
+  store = CreateStore(path_, 10);
+  store->SetIcon(PageURL(2), GURL(kIconURL),
+                 std::vector<SkBitmap>(1, MakeBitmap(16, SK_ColorGREEN)));
+  store->Load();
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(3u, store->icon_count());
+  EXPECT_EQ(3u, store->bitmap_count());
+  SkBitmap bitmap;
+  ASSERT_TRUE(store->GetIcon(PageURL(1), GURL(kIconURL), 32, &bitmap));
+  EXPECT_EQ(32, bitmap.width());
+  SkAutoLockPixels lock(bitmap);
+  EXPECT_EQ(SK_ColorRED, bitmap.getColor(0, 0));
+}
+
+TEST_F(FaviconStoreTest, DamagedFileIsIgnored) {
+  const char kGarbage[] = "not a favicon store";
+  ASSERT_EQ(static_cast<int>(sizeof(kGarbage)),
+            base::WriteFile(path_, kGarbage, sizeof(kGarbage)));
+
+  std::unique_ptr<FaviconStore> store = CreateStore(path_, 10);
+  store->Load();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0u, store->icon_count());
+}
+
+TEST_F(FaviconStoreTest, IconsExpire) {
+  std::unique_ptr<FaviconStore> store = CreateStore(base::FilePath(), 10);
+  store->SetIcon(PageURL(0), GURL(kIconURL),
+                 std::vector<SkBitmap>(1, MakeBitmap(16, SK_ColorRED)));
+
+  // Using the icon does not extend its life.
+  SkBitmap bitmap;
+  clock_->Advance(base::TimeDelta::FromDays(kMaxAgeDays - 1));
+  EXPECT_TRUE(store->GetIcon(PageURL(0), GURL(kIconURL), 16, &bitmap));
+  clock_->Advance(base::TimeDelta::FromDays(1));
+  EXPECT_FALSE(store->GetIcon(PageURL(0), GURL(kIconURL), 16, &bitmap));
+  EXPECT_EQ(0u, store->icon_count());
+  EXPECT_EQ(0u, store->bitmap_count());
+
+  // Setting the icon again starts a new life.
+  store->SetIcon(PageURL(0), GURL(kIconURL),
+                 std::vector<SkBitmap>(1, MakeBitmap(16, SK_ColorRED)));
+  EXPECT_TRUE(store->GetIcon(PageURL(0), GURL(kIconURL), 16, &bitmap));
+}
+
+TEST_F(FaviconStoreTest, ExpiredIconsAreNotLoaded) {
+  std::unique_ptr<FaviconStore> store = CreateStore(path_, 10);
+  store->SetIcon(PageURL(0), GURL(kIconURL),
+                 std::vector<SkBitmap>(1, MakeBitmap(16, SK_ColorRED)));
+  clock_->Advance(base::TimeDelta::FromDays(1));
+  store->SetIcon(PageURL(1), GURL(kIconURL),
+                 std::vector<SkBitmap>(1, MakeBitmap(16, SK_ColorBLUE)));
+  base::RunLoop().RunUntilIdle();
+  store.reset();
+  base::RunLoop().RunUntilIdle();
+
+  store = CreateStore(path_, 10);
+  clock_->Advance(base::TimeDelta::FromDays(kMaxAgeDays));
+  store->Load();
+  base::RunLoop().RunUntilIdle();
+
+  EXPECT_EQ(1u, store->icon_count());
+  EXPECT_EQ(1u, store->bitmap_count());
+  SkBitmap bitmap;
+  EXPECT_FALSE(store->GetIcon(PageURL(0), GURL(kIconURL), 16, &bitmap));
+  EXPECT_TRUE(store->GetIcon(PageURL(1), GURL(kIconURL), 16, &bitmap));
+}
+
+TEST_F(FaviconStoreTest, UnencodedBitmapsAreNotWritten) {
+  std::unique_ptr<FaviconStore> store = CreateStore(path_, 10);
+  store->SetIcon(PageURL(0), GURL(kIconURL),
+                 std::vector<SkBitmap>(1, MakeBitmap(16, SK_ColorRED)));
+  // The store is gone before the bitmap is encoded.
+  store.reset();
+  base::RunLoop().RunUntilIdle();
+
+  store = CreateStore(path_, 10);
+  store->Load();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0u, store->icon_count());
+}
+
+TEST_F(FaviconStoreTest, ClearIcons) {
+  std::unique_ptr<FaviconStore> store = CreateStore(path_, 10);
+  store->SetIcon(PageURL(0), GURL(kIconURL),
+                 std::vector<SkBitmap>(1, MakeBitmap(16, SK_ColorRED)));
+  base::RunLoop().RunUntilIdle();
+  store.reset();
+  base::RunLoop().RunUntilIdle();
+
+  // The icons being loaded are cleared too.
+  store = CreateStore(path_, 10);
+  store->Load();
+  store->ClearIcons();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0u, store->icon_count());
+  EXPECT_EQ(0u, store->bitmap_count());
+  store.reset();
+  base::RunLoop().RunUntilIdle();
+
+  store = CreateStore(path_, 10);
+  store->Load();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(0u, store->icon_count());
+}
+
+}  // namespace xwalk
@@ -4,78 +4,360 @@
 
 #include "xwalk/runtime/browser/image_util.h"
 
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "base/bind.h"
 #include "base/files/file_util.h"
+#include "base/location.h"
+#include "base/logging.h"
 #include "base/strings/string_util.h"
-#include "ui/gfx/geometry/size.h"
-#include "ui/gfx/image/image_skia.h"
-#include "ui/gfx/image/image_util.h"
-
-#if defined(OS_WIN)
-#include "ui/gfx/icon_util.h"
-#endif
+#include "base/task_runner.h"
+#include "base/task_runner_util.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "content/public/browser/browser_thread.h"
+#include "third_party/skia/include/core/SkColorPriv.h"
+#include "ui/gfx/codec/jpeg_codec.h"
+#include "ui/gfx/codec/png_codec.h"
 
 namespace xwalk_utils {
 
-gfx::Image LoadImageFromFilePath(const base::FilePath& filename) {
+namespace {
+
+// Enough for a few hundred launch icons.
+const size_t kMaxCacheBytes = 16 * 1024 * 1024;
+
+// The sizes of the ICONDIR and ICONDIRENTRY structures.
+const size_t kICOHeaderSize = 6;
+const size_t kICOEntrySize = 16;
+// The size of a BITMAPINFOHEADER.
+const size_t kDIBHeaderSize = 40;
+const int kMaxICOFrameSize = 256;
+
+const unsigned char kPNGSignature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a,
+                                       '\n'};
+
+uint16_t ReadUInt16(const unsigned char* data) {
+  return data[0] | (data[1] << 8);
+}
+
+uint32_t ReadUInt32(const unsigned char* data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) |
+         (static_cast<uint32_t>(data[3]) << 24);
+}
+
+struct ICOFrame {
+  int size;
+  int bit_count;
+  uint32_t data_size;
+  uint32_t data_offset;
+};
+
+// Returns whether |a| fits |desired_size| better than |b|. A |desired_size|
+// of 0 prefers the largest frame.
+bool IsBetterFrame(const ICOFrame& a, const ICOFrame& b, int desired_size) {
+  if (desired_size <= 0 && a.size != b.size)
+    return a.size > b.size;
+  bool a_large_enough = a.size >= desired_size;
+  bool b_large_enough = b.size >= desired_size;
+  if (a_large_enough != b_large_enough)
+    return a_large_enough;
+  if (a.size != b.size)
+    return a_large_enough ? a.size < b.size : a.size > b.size;
+  return a.bit_count > b.bit_count;
+}
+
+// Decodes an uncompressed DIB with its AND mask, as stored in ICO files.
+bool DecodeDIB(const unsigned char* data, size_t size, SkBitmap* bitmap) {
+  if (size < kDIBHeaderSize)
+    return false;
+  uint32_t header_size = ReadUInt32(data);
+  int32_t width = static_cast<int32_t>(ReadUInt32(data + 4));
+  // The height covers both the color bitmap and the mask.
+  int32_t height = static_cast<int32_t>(ReadUInt32(data + 8)) / 2;
+  int bit_count = ReadUInt16(data + 14);
+  uint32_t compression = ReadUInt32(data + 16);
+  uint32_t colors_used = ReadUInt32(data + 32);
+  if (header_size < kDIBHeaderSize || header_size > size || width <= 0 ||
+      width > kMaxICOFrameSize || height <= 0 || height > kMaxICOFrameSize ||
+      compression != 0) {
+    return false;
+  }
+  if (bit_count != 1 && bit_count != 4 && bit_count != 8 && bit_count != 24 &&
+      bit_count != 32) {
+    return false;
+  }
+
+  size_t palette_size = 0;
+  if (bit_count <= 8) {
+    palette_size = colors_used ? colors_used : 1u << bit_count;
+    if (palette_size > (1u << bit_count))
+      return false;
+  }
+  size_t pixels_offset = header_size + palette_size * 4;
+  size_t pixels_stride = ((width * bit_count + 31) / 32) * 4;
+  size_t mask_offset = pixels_offset + pixels_stride * height;
+  size_t mask_stride = ((width + 31) / 32) * 4;
+  // Some encoders leave out the mask of 32-bit frames.
+  bool has_mask = mask_offset + mask_stride * height <= size;
+  if (!has_mask && (bit_count != 32 || mask_offset > size))
+    return false;
+  const unsigned char* palette = data + header_size;
+  const unsigned char* pixels = data + pixels_offset;
+  const unsigned char* mask = data + mask_offset;
+
+  // 32-bit frames with no alpha at all rely on the mask, like the others.
+  bool has_alpha = false;
+  if (bit_count == 32) {
+    for (int y = 0; y < height && !has_alpha; ++y) {
+      const unsigned char* row = pixels + pixels_stride * y;
+      for (int x = 0; x < width && !has_alpha; ++x)
+        has_alpha = row[x * 4 + 3] != 0;
+    }
+  }
+
+  bitmap->allocN32Pixels(width, height);
+  for (int y = 0; y < height; ++y) {
+    // Rows are stored bottom-up.
+    const unsigned char* row = pixels + pixels_stride * (height - 1 - y);
+    uint32_t* dest = bitmap->getAddr32(0, y);
+    for (int x = 0; x < width; ++x) {
+      const unsigned char* color;
+      unsigned alpha = 255;
+      if (bit_count == 32) {
+        color = row + x * 4;
+        if (has_alpha)
+          alpha = color[3];
+      } else if (bit_count == 24) {
+        color = row + x * 3;
+      } else {
+        int bit = x * bit_count;
+        unsigned index = (row[bit / 8] >> (8 - bit_count - bit % 8)) &
+                         ((1 << bit_count) - 1);
+        if (index >= palette_size)
+          index = 0;
+        color = palette + index * 4;
+      }
+      dest[x] = SkPreMultiplyARGB(alpha, color[2], color[1], color[0]);
+    }
+  }
+
+  // The mask only matters when the color bitmap has no alpha of its own.
+  if (has_alpha || !has_mask)
+    return true;
+  for (int y = 0; y < height; ++y) {
+    const unsigned char* row = mask + mask_stride * (height - 1 - y);
+    uint32_t* dest = bitmap->getAddr32(0, y);
+    for (int x = 0; x < width; ++x) {
+      if (row[x / 8] & (0x80 >> (x % 8)))
+        dest[x] = 0;
+    }
+  }
+  return true;
+}
+
+bool ReadFileBytes(const base::FilePath& filename, std::string* contents) {
+  if (!base::ReadFileToString(filename, contents)) {
+    LOG(WARNING) << "Could not read " << filename.value();
+    return false;
+  }
+  return true;
+}
+
+SkBitmap DecodeImageFile(const base::FilePath& filename, int desired_size) {
   const base::FilePath::StringType kPNGFormat(FILE_PATH_LITERAL(".png"));
   const base::FilePath::StringType kICOFormat(FILE_PATH_LITERAL(".ico"));
   const base::FilePath::StringType kJPGFormat(FILE_PATH_LITERAL(".jpg"));
   const base::FilePath::StringType kJPEGFormat(FILE_PATH_LITERAL(".jpeg"));
 
+  SkBitmap bitmap;
+  std::string contents;
+  const unsigned char* data;
+
   if (base::EndsWith(filename.value(), kPNGFormat,
                      base::CompareCase::INSENSITIVE_ASCII)) {
-    std::string contents;
-    base::ReadFileToString(filename, &contents);
-    return gfx::Image::CreateFrom1xPNGBytes(
-        reinterpret_cast<const unsigned char*>(contents.data()),
-            contents.size());
+    if (ReadFileBytes(filename, &contents)) {
+      data = reinterpret_cast<const unsigned char*>(contents.data());
+      if (!gfx::PNGCodec::Decode(data, contents.size(), &bitmap))
+        bitmap.reset();
+    }
+    return bitmap;
   }
 
   if (base::EndsWith(filename.value(), kJPGFormat,
                      base::CompareCase::INSENSITIVE_ASCII) ||
       base::EndsWith(filename.value(), kJPEGFormat,
                      base::CompareCase::INSENSITIVE_ASCII)) {
-    std::string contents;
-    base::ReadFileToString(filename, &contents);
-    return gfx::ImageFrom1xJPEGEncodedData(
-        reinterpret_cast<const unsigned char*>(contents.data()),
-        contents.size());
+    if (ReadFileBytes(filename, &contents)) {
+      data = reinterpret_cast<const unsigned char*>(contents.data());
+      std::unique_ptr<SkBitmap> decoded(
+          gfx::JPEGCodec::Decode(data, contents.size()));
+      if (decoded)
+        bitmap = *decoded;
+    }
+    return bitmap;
   }
 
   if (base::EndsWith(filename.value(), kICOFormat,
                      base::CompareCase::INSENSITIVE_ASCII)) {
-#if defined(OS_WIN)
-    HICON icon = static_cast<HICON>(LoadImage(NULL,
-                                    filename.value().c_str(),
-                                    IMAGE_ICON,
-                                    0,
-                                    0,
-                                    LR_LOADTRANSPARENT | LR_LOADFROMFILE));
-    if (icon == NULL)
-      return gfx::Image();
-
-    gfx::Image image;
-    std::unique_ptr<SkBitmap> bitmap(IconUtil::CreateSkBitmapFromHICON(icon));
-    if (bitmap.get()) {
-      gfx::ImageSkia image_skia = gfx::ImageSkia::CreateFrom1xBitmap(*bitmap);
-      image = gfx::Image(image_skia);
+    if (ReadFileBytes(filename, &contents)) {
+      data = reinterpret_cast<const unsigned char*>(contents.data());
+      if (!DecodeICO(data, contents.size(), desired_size, &bitmap))
+        bitmap.reset();
     }
-    DestroyIcon(icon);
+    return bitmap;
+  }
 
-    return image;
-#elif defined(USE_AURA) && defined(OS_LINUX)
-    NOTIMPLEMENTED();
+  LOG(INFO) << "Only support png, jpeg and ico file format.";
+  return bitmap;
+}
+
+gfx::Image CreateImage(const SkBitmap& bitmap) {
+  if (bitmap.isNull())
     return gfx::Image();
-#else
-  NOTREACHED();
-  return gfx::Image();
-#endif
+  return gfx::Image::CreateFrom1xBitmap(bitmap);
+}
+
+void RunLoadCallback(const ImageLoader::LoadCallback& callback,
+                     const SkBitmap& bitmap) {
+  callback.Run(CreateImage(bitmap));
+}
+
+}  // namespace
+
+gfx::Image LoadImageFromFilePath(const base::FilePath& filename) {
+  return CreateImage(DecodeImageFile(filename, 0));
+}
+
+bool DecodeICO(const unsigned char* data,
+               size_t size,
+               int desired_size,
+               SkBitmap* bitmap) {
+  if (size < kICOHeaderSize || ReadUInt16(data) != 0 ||
+      ReadUInt16(data + 2) != 1) {
+    return false;
+  }
+  size_t count = ReadUInt16(data + 4);
+  if (count == 0 || kICOHeaderSize + count * kICOEntrySize > size)
+    return false;
+
+  // Only the directory is read to pick the frame.
+  std::vector<ICOFrame> frames;
+  for (size_t i = 0; i < count; ++i) {
+    const unsigned char* entry = data + kICOHeaderSize + i * kICOEntrySize;
+    ICOFrame frame;
+    // A dimension of 0 stands for 256.
+    int width = entry[0] ? entry[0] : kMaxICOFrameSize;
+    int height = entry[1] ? entry[1] : kMaxICOFrameSize;
+    frame.size = std::max(width, height);
+    frame.bit_count = ReadUInt16(entry + 6);
+    frame.data_size = ReadUInt32(entry + 8);
+    frame.data_offset = ReadUInt32(entry + 12);
+    if (frame.data_offset > size || frame.data_size > size - frame.data_offset)
+      continue;
+    frames.push_back(frame);
   }
+  std::stable_sort(frames.begin(), frames.end(),
+                   [desired_size](const ICOFrame& a, const ICOFrame& b) {
+                     return IsBetterFrame(a, b, desired_size);
+                   });
 
-  LOG(INFO) << "Only support png and ico file format.";
-  return gfx::Image();
+  // A frame which fails to decode is replaced by the next best one.
+  for (const ICOFrame& frame : frames) {
+    const unsigned char* frame_data = data + frame.data_offset;
+    bool decoded;
+    if (frame.data_size >= sizeof(kPNGSignature) &&
+        std::equal(kPNGSignature, kPNGSignature + sizeof(kPNGSignature),
+                   frame_data)) {
+      decoded = gfx::PNGCodec::Decode(frame_data, frame.data_size, bitmap);
+    } else {
+      decoded = DecodeDIB(frame_data, frame.data_size, bitmap);
+    }
+    if (decoded)
+      return true;
+    bitmap->reset();
+  }
+  return false;
+}
+
+// static
+ImageLoader* ImageLoader::GetInstance() {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  static ImageLoader* instance = nullptr;
+  if (!instance) {
+    base::SequencedWorkerPool* pool =
+        content::BrowserThread::GetBlockingPool();
+    instance = new ImageLoader(
+        pool->GetTaskRunnerWithShutdownBehavior(
+            base::SequencedWorkerPool::SKIP_ON_SHUTDOWN),
+        kMaxCacheBytes);
+    // Leaked, like the other process-wide services.
+    instance->AddRef();
+  }
+  return instance;
+}
+
+ImageLoader::ImageLoader(scoped_refptr<base::TaskRunner> task_runner,
+                         size_t max_cache_bytes)
+    : task_runner_(task_runner),
+      max_cache_bytes_(max_cache_bytes),
+      cache_(base::MRUCache<Key, SkBitmap>::NO_AUTO_EVICT),
+      cache_bytes_(0) {
+}
+
+ImageLoader::~ImageLoader() {
+}
+
+void ImageLoader::LoadImage(const base::FilePath& filename,
+                            int desired_size,
+                            const LoadCallback& callback) {
+  base::PostTaskAndReplyWithResult(
+      task_runner_.get(), FROM_HERE,
+      base::Bind(&ImageLoader::LoadBitmap, this, filename, desired_size),
+      base::Bind(&RunLoadCallback, callback));
+}
+
+SkBitmap ImageLoader::LoadBitmap(const base::FilePath& filename,
+                                 int desired_size) {
+  base::File::Info info;
+  if (!base::GetFileInfo(filename, &info) || info.is_directory)
+    return SkBitmap();
+
+  // Only the frame of ICO files depends on the desired size.
+  bool is_ico = base::EndsWith(filename.value(), FILE_PATH_LITERAL(".ico"),
+                               base::CompareCase::INSENSITIVE_ASCII);
+  Key key(filename, info.last_modified.ToInternalValue(),
+          is_ico ? desired_size : 0);
+  {
+    base::AutoLock lock(lock_);
+    auto it = cache_.Get(key);
+    if (it != cache_.end())
+      return it->second;
+  }
+
+  // Two threads may decode the same file at once; the last one is kept.
+  SkBitmap bitmap = DecodeImageFile(filename, desired_size);
+  if (bitmap.isNull() || bitmap.getSize() > max_cache_bytes_)
+    return bitmap;
+  // The pixels are shared with every image made from the cache.
+  bitmap.setImmutable();
+
+  base::AutoLock lock(lock_);
+  auto it = cache_.Peek(key);
+  if (it != cache_.end()) {
+    cache_bytes_ -= it->second.getSize();
+    cache_.Erase(it);
+  }
+  while (cache_bytes_ + bitmap.getSize() > max_cache_bytes_) {
+    auto oldest = cache_.rbegin();
+    cache_bytes_ -= oldest->second.getSize();
+    cache_.Erase(oldest);
+  }
+  cache_.Put(key, bitmap);
+  cache_bytes_ += bitmap.getSize();
+  return bitmap;
 }
 
 }  // namespace xwalk_utils
@@ -5,14 +5,81 @@
 #ifndef XWALK_RUNTIME_BROWSER_IMAGE_UTIL_H_
 #define XWALK_RUNTIME_BROWSER_IMAGE_UTIL_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
+#include <tuple>
+
+#include "base/callback.h"
+#include "base/containers/mru_cache.h"
 #include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "third_party/skia/include/core/SkBitmap.h"
 #include "ui/gfx/image/image.h"
 
+namespace base {
+class TaskRunner;
+}
+
 namespace xwalk_utils {
 
-// Load a gfx::Image from a PNG file or ICO file.
+// Load a gfx::Image from a PNG, JPEG or ICO file. The largest frame of an ICO
+// file is used.
 gfx::Image LoadImageFromFilePath(const base::FilePath& filename);
 
+// Decodes the frame of an ICO file that fits |desired_size| pixels best: the
+// smallest one at least that large, or else the largest one. Only that frame
+// is decoded, unless it is broken, in which case the next best frame is
+// tried. A |desired_size| of 0 picks the largest frame.
+bool DecodeICO(const unsigned char* data,
+               size_t size,
+               int desired_size,
+               SkBitmap* bitmap);
+
+// Loads images like LoadImageFromFilePath(), but reads and decodes them on a
+// worker pool. The decoded images are kept, up to a total size, for as long
+// as their file is not modified.
+class ImageLoader : public base::RefCountedThreadSafe<ImageLoader> {
+ public:
+  typedef base::Callback<void(const gfx::Image&)> LoadCallback;
+
+  // The loader of the runtime, which decodes on the blocking pool. Must be
+  // called on the UI thread.
+  static ImageLoader* GetInstance();
+
+  ImageLoader(scoped_refptr<base::TaskRunner> task_runner,
+              size_t max_cache_bytes);
+
+  // Runs |callback| on the calling thread, with an empty image if the file
+  // could not be decoded. |desired_size| is the size in pixels at which the
+  // image will be shown; it picks the frame of ICO files.
+  void LoadImage(const base::FilePath& filename,
+                 int desired_size,
+                 const LoadCallback& callback);
+
+ private:
+  friend class base::RefCountedThreadSafe<ImageLoader>;
+  ~ImageLoader();
+
+  // The path, the modification time and the desired size.
+  typedef std::tuple<base::FilePath, int64_t, int> Key;
+
+  // Runs on |task_runner_|.
+  SkBitmap LoadBitmap(const base::FilePath& filename, int desired_size);
+
+  scoped_refptr<base::TaskRunner> task_runner_;
+  const size_t max_cache_bytes_;
+
+  base::Lock lock_;
+  // Guarded by |lock_|.
+  base::MRUCache<Key, SkBitmap> cache_;
+  size_t cache_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(ImageLoader);
+};
+
 }  // namespace xwalk_utils
 
 #endif  // XWALK_RUNTIME_BROWSER_IMAGE_UTIL_H_
@@ -0,0 +1,294 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/image_util.h"
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/message_loop/message_loop.h"
+#include "base/path_service.h"
+#include "base/run_loop.h"
+#include "base/threading/worker_pool.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "ui/gfx/codec/png_codec.h"
+
+namespace xwalk_utils {
+
+namespace {
+
+struct TestFrame {
+  int size;
+  int bit_count;
+  std::vector<unsigned char> data;
+};
+
+void AppendUInt16(std::vector<unsigned char>* data, uint16_t value) {
+  data->push_back(value & 0xff);
+  data->push_back(value >> 8);
+}
+
+void AppendUInt32(std::vector<unsigned char>* data, uint32_t value) {
+  AppendUInt16(data, value & 0xffff);
+  AppendUInt16(data, value >> 16);
+}
+
+SkBitmap MakeBitmap(int size, SkColor color) {
+  SkBitmap bitmap;
+  bitmap.allocN32Pixels(size, size);
+  bitmap.eraseColor(color);
+  return bitmap;
+}
+
+TestFrame PNGFrame(int size, SkColor color) {
+  TestFrame frame = {size, 32, std::vector<unsigned char>()};
+  EXPECT_TRUE(gfx::PNGCodec::EncodeBGRASkBitmap(MakeBitmap(size, color), false,
+                                                &frame.data));
+  return frame;
+}
+
+// A 24-bit DIB of |color|, whose top left pixel is masked out.
+TestFrame DIBFrame(int size, SkColor color) {
+  TestFrame frame = {size, 24, std::vector<unsigned char>()};
+  std::vector<unsigned char>& data = frame.data;
+  AppendUInt32(&data, 40);
+  AppendUInt32(&data, size);
+  AppendUInt32(&data, size * 2);
+  AppendUInt16(&data, 1);
+  AppendUInt16(&data, 24);
+  for (int i = 0; i < 6; ++i)
+    AppendUInt32(&data, 0);
+
+  size_t stride = ((size * 24 + 31) / 32) * 4;
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      data.push_back(SkColorGetB(color));
+      data.push_back(SkColorGetG(color));
+      data.push_back(SkColorGetR(color));
+    }
+    data.resize(data.size() + stride - size * 3);
+  }
+  size_t mask_stride = ((size + 31) / 32) * 4;
+  for (int y = 0; y < size; ++y) {
+    // The last row stored is the top one.
+    data.push_back(y == size - 1 ? 0x80 : 0);
+    data.resize(data.size() + mask_stride - 1);
+  }
+  return frame;
+}
+
+std::vector<unsigned char> MakeICO(const std::vector<TestFrame>& frames) {
+  std::vector<unsigned char> ico;
+  AppendUInt16(&ico, 0);
+  AppendUInt16(&ico, 1);
+  AppendUInt16(&ico, frames.size());
+  size_t offset = 6 + frames.size() * 16;
+  for (const TestFrame& frame : frames) {
+    ico.push_back(frame.size % 256);
+    ico.push_back(frame.size % 256);
+    ico.push_back(0);
+    ico.push_back(0);
+    AppendUInt16(&ico, 1);
+    AppendUInt16(&ico, frame.bit_count);
+    AppendUInt32(&ico, frame.data.size());
+    AppendUInt32(&ico, offset);
+    offset += frame.data.size();
+  }
+  for (const TestFrame& frame : frames)
+    ico.insert(ico.end(), frame.data.begin(), frame.data.end());
+  return ico;
+}
+
+base::FilePath GetTestDataPath(const char* name) {
+  base::FilePath path;
+  PathService::Get(base::DIR_SOURCE_ROOT, &path);
+  return path.AppendASCII("xwalk").AppendASCII("test").AppendASCII("data")
+      .AppendASCII("favicon").AppendASCII(name);
+}
+
+}  // namespace
+
+class ImageUtilTest : public testing::Test {
+ protected:
+  void SetUp() override { ASSERT_TRUE(temp_dir_.CreateUniqueTempDir()); }
+
+  base::FilePath WritePNG(const char* name, int size, SkColor color) {
+    base::FilePath path = temp_dir_.path().AppendASCII(name);
+    std::vector<unsigned char> png = PNGFrame(size, color).data;
+    EXPECT_EQ(static_cast<int>(png.size()),
+              base::WriteFile(path, reinterpret_cast<const char*>(png.data()),
+                              png.size()));
+    return path;
+  }
+
+  // Overwrites |path| with garbage, but keeps its modification time.
+  void CorruptKeepingTime(const base::FilePath& path) {
+    base::File::Info info;
+    ASSERT_TRUE(base::GetFileInfo(path, &info));
+    ASSERT_EQ(7, base::WriteFile(path, "garbage", 7));
+    ASSERT_TRUE(base::TouchFile(path, info.last_accessed, info.last_modified));
+  }
+
+  gfx::Image Load(ImageLoader* loader,
+                  const base::FilePath& path,
+                  int desired_size) {
+    gfx::Image image;
+    base::RunLoop run_loop;
+    loader->LoadImage(path, desired_size,
+                      base::Bind(&ImageUtilTest::OnImageLoaded, &image,
+                                 run_loop.QuitClosure()));
+    run_loop.Run();
+    return image;
+  }
+
+  static void OnImageLoaded(gfx::Image* result,
+                            const base::Closure& quit_closure,
+                            const gfx::Image& image) {
+    *result = image;
+    quit_closure.Run();
+  }
+
+  base::MessageLoop message_loop_;
+  base::ScopedTempDir temp_dir_;
+};
+
+TEST_F(ImageUtilTest, LoadFixtures) {
+  gfx::Image png = LoadImageFromFilePath(GetTestDataPath("48x48.png"));
+  ASSERT_FALSE(png.IsEmpty());
+  EXPECT_EQ(48, png.Width());
+  EXPECT_EQ(48, png.Height());
+
+  gfx::Image ico = LoadImageFromFilePath(GetTestDataPath("16x16.ico"));
+  ASSERT_FALSE(ico.IsEmpty());
+  EXPECT_EQ(16, ico.Width());
+  EXPECT_EQ(16, ico.Height());
+
+  EXPECT_TRUE(LoadImageFromFilePath(GetTestDataPath("missing.png")).IsEmpty());
+}
+
+TEST_F(ImageUtilTest, DecodeICOPicksBestFrame) {
+  std::vector<TestFrame> frames;
+  frames.push_back(PNGFrame(16, SK_ColorRED));
+  frames.push_back(DIBFrame(32, SK_ColorGREEN));
+  frames.push_back(PNGFrame(48, SK_ColorBLUE));
+  // The best fit for sizes above 48, and for the largest frame, but not
+  // decodable.
+  TestFrame broken = {64, 32, std::vector<unsigned char>(100, 0xff)};
+  frames.push_back(broken);
+  std::vector<unsigned char> ico = MakeICO(frames);
+
+  SkBitmap bitmap;
+  ASSERT_TRUE(DecodeICO(ico.data(), ico.size(), 16, &bitmap));
+  EXPECT_EQ(16, bitmap.width());
+  EXPECT_EQ(SK_ColorRED, bitmap.getColor(8, 8));
+
+  ASSERT_TRUE(DecodeICO(ico.data(), ico.size(), 20, &bitmap));
+  EXPECT_EQ(32, bitmap.width());
+  EXPECT_EQ(32, bitmap.height());
+  EXPECT_EQ(SK_ColorGREEN, bitmap.getColor(8, 8));
+  // Masked out.
+  EXPECT_EQ(SK_ColorTRANSPARENT, bitmap.getColor(0, 0));
+
+  ASSERT_TRUE(DecodeICO(ico.data(), ico.size(), 40, &bitmap));
+  EXPECT_EQ(48, bitmap.width());
+  EXPECT_EQ(SK_ColorBLUE, bitmap.getColor(8, 8));
+
+  // The next best frame is used instead of the broken one.
+  ASSERT_TRUE(DecodeICO(ico.data(), ico.size(), 100, &bitmap));
+  EXPECT_EQ(48, bitmap.width());
+  EXPECT_EQ(SK_ColorBLUE, bitmap.getColor(8, 8));
+
+  // A desired size of 0 picks the largest frame.
+  ASSERT_TRUE(DecodeICO(ico.data(), ico.size(), 0, &bitmap));
+  EXPECT_EQ(48, bitmap.width());
+  EXPECT_EQ(SK_ColorBLUE, bitmap.getColor(8, 8));
+  frames.pop_back();
+  frames.push_back(DIBFrame(24, SK_ColorGREEN));
+  ico = MakeICO(frames);
+  ASSERT_TRUE(DecodeICO(ico.data(), ico.size(), 0, &bitmap));
+  EXPECT_EQ(48, bitmap.width());
+
+  // No frame can be decoded.
+  frames.clear();
+  frames.push_back(broken);
+  ico = MakeICO(frames);
+  EXPECT_FALSE(DecodeICO(ico.data(), ico.size(), 64, &bitmap));
+}
+
+TEST_F(ImageUtilTest, DecodeICORejectsTruncatedFiles) {
+  std::vector<TestFrame> frames;
+  frames.push_back(DIBFrame(32, SK_ColorGREEN));
+  std::vector<unsigned char> ico = MakeICO(frames);
+
+  SkBitmap bitmap;
+  EXPECT_FALSE(DecodeICO(ico.data(), 4, 32, &bitmap));
+  EXPECT_FALSE(DecodeICO(ico.data(), 30, 32, &bitmap));
+  EXPECT_FALSE(DecodeICO(ico.data(), ico.size() - 1, 32, &bitmap));
+  EXPECT_TRUE(DecodeICO(ico.data(), ico.size(), 32, &bitmap));
+}
+
+TEST_F(ImageUtilTest, LoaderCachesUntilModified) {
+  scoped_refptr<ImageLoader> loader(
+      new ImageLoader(base::WorkerPool::GetTaskRunner(true), 1024 * 1024));
+  base::FilePath path = WritePNG("icon.png", 32, SK_ColorRED);
+
+  gfx::Image image = Load(loader.get(), path, 32);
+  ASSERT_FALSE(image.IsEmpty());
+  EXPECT_EQ(32, image.Width());
+
+  // Served from the cache.
+  CorruptKeepingTime(path);
+  image = Load(loader.get(), path, 32);
+  ASSERT_FALSE(image.IsEmpty());
+  EXPECT_EQ(32, image.Width());
+
+  // Decoded again once modified.
+  base::File::Info info;
+  ASSERT_TRUE(base::GetFileInfo(path, &info));
+  ASSERT_TRUE(base::TouchFile(path, info.last_accessed,
+                              info.last_modified +
+                                  base::TimeDelta::FromSeconds(10)));
+  EXPECT_TRUE(Load(loader.get(), path, 32).IsEmpty());
+}
+
+TEST_F(ImageUtilTest, LoaderCacheIsBounded) {
+  // Room for a single 16x16 bitmap.
+  scoped_refptr<ImageLoader> loader(
+      new ImageLoader(base::WorkerPool::GetTaskRunner(true), 16 * 16 * 4));
+  base::FilePath first = WritePNG("first.png", 16, SK_ColorRED);
+  base::FilePath second = WritePNG("second.png", 16, SK_ColorBLUE);
+
+  EXPECT_FALSE(Load(loader.get(), first, 16).IsEmpty());
+  EXPECT_FALSE(Load(loader.get(), second, 16).IsEmpty());
+
+  CorruptKeepingTime(first);
+  CorruptKeepingTime(second);
+  EXPECT_TRUE(Load(loader.get(), first, 16).IsEmpty());
+  EXPECT_FALSE(Load(loader.get(), second, 16).IsEmpty());
+}
+
+TEST_F(ImageUtilTest, LoaderPicksICOFrameBySize) {
+  std::vector<TestFrame> frames;
+  frames.push_back(PNGFrame(16, SK_ColorRED));
+  frames.push_back(PNGFrame(48, SK_ColorBLUE));
+  std::vector<unsigned char> ico = MakeICO(frames);
+  base::FilePath path = temp_dir_.path().AppendASCII("icon.ico");
+  ASSERT_EQ(static_cast<int>(ico.size()),
+            base::WriteFile(path, reinterpret_cast<const char*>(ico.data()),
+                            ico.size()));
+
+  scoped_refptr<ImageLoader> loader(
+      new ImageLoader(base::WorkerPool::GetTaskRunner(true), 1024 * 1024));
+  EXPECT_EQ(16, Load(loader.get(), path, 16).Width());
+  EXPECT_EQ(48, Load(loader.get(), path, 32).Width());
+  EXPECT_EQ(16, Load(loader.get(), path, 16).Width());
+}
+
+}  // namespace xwalk_utils
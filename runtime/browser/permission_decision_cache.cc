@@ -0,0 +1,109 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/permission_decision_cache.h"
+
+#include <tuple>
+#include <utility>
+
+#include "base/time/tick_clock.h"
+
+using blink::mojom::PermissionStatus;
+
+namespace xwalk {
+
+PermissionDecisionCache::Key::Key(content::PermissionType permission,
+                                  const GURL& requesting_origin,
+                                  const GURL& embedding_origin)
+    : permission(permission),
+      requesting_origin(requesting_origin),
+      embedding_origin(embedding_origin) {
+}
+
+PermissionDecisionCache::Key::Key(const Key& other) = default;
+
+PermissionDecisionCache::Key::~Key() {
+}
+
+bool PermissionDecisionCache::Key::operator<(const Key& other) const {
+  return std::tie(permission, requesting_origin, embedding_origin) <
+         std::tie(other.permission, other.requesting_origin,
+                  other.embedding_origin);
+}
+
+PermissionDecisionCache::PermissionDecisionCache(
+    base::TimeDelta ttl,
+    std::unique_ptr<base::TickClock> clock)
+    : ttl_(ttl),
+      clock_(std::move(clock)) {
+}
+
+PermissionDecisionCache::~PermissionDecisionCache() {
+}
+
+bool PermissionDecisionCache::GetDecision(const Key& key,
+                                          PermissionStatus* status) {
+  auto it = decisions_.find(key);
+  if (it == decisions_.end())
+    return false;
+
+  if (clock_->NowTicks() >= it->second.expiry) {
+    decisions_.erase(it);
+    return false;
+  }
+  *status = it->second.status;
+  return true;
+}
+
+void PermissionDecisionCache::SetDecision(const Key& key,
+                                          PermissionStatus status) {
+  if (ttl_ <= base::TimeDelta())
+    return;
+
+  Decision& decision = decisions_[key];
+  decision.status = status;
+  decision.expiry = clock_->NowTicks() + ttl_;
+}
+
+void PermissionDecisionCache::RemoveDecision(const Key& key) {
+  decisions_.erase(key);
+}
+
+bool PermissionDecisionCache::AddPendingRequest(const Key& key,
+                                                int request_id) {
+  std::set<int>& requests = pending_requests_[key];
+  requests.insert(request_id);
+  return requests.size() == 1;
+}
+
+bool PermissionDecisionCache::RemovePendingRequest(const Key& key,
+                                                   int request_id) {
+  auto it = pending_requests_.find(key);
+  if (it == pending_requests_.end())
+    return true;
+
+  it->second.erase(request_id);
+  if (!it->second.empty())
+    return false;
+  pending_requests_.erase(it);
+  return true;
+}
+
+std::vector<int> PermissionDecisionCache::TakePendingRequests(const Key& key) {
+  std::vector<int> requests;
+  auto it = pending_requests_.find(key);
+  if (it == pending_requests_.end())
+    return requests;
+
+  requests.assign(it->second.begin(), it->second.end());
+  pending_requests_.erase(it);
+  return requests;
+}
+
+void PermissionDecisionCache::SetClockForTesting(
+    std::unique_ptr<base::TickClock> clock) {
+  clock_ = std::move(clock);
+}
+
+}  // namespace xwalk
@@ -0,0 +1,83 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_RUNTIME_BROWSER_PERMISSION_DECISION_CACHE_H_
+#define XWALK_RUNTIME_BROWSER_PERMISSION_DECISION_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "content/public/browser/permission_type.h"
+#include "third_party/WebKit/public/platform/modules/permissions/permission_status.mojom.h"
+#include "url/gurl.h"
+
+namespace base {
+class TickClock;
+}
+
+namespace xwalk {
+
+// Remembers the answers to permission prompts for |ttl|, and the requests
+// waiting for a prompt, so that identical requests share a single prompt.
+// Requests are identified by the ids given by XWalkPermissionManager.
+class PermissionDecisionCache {
+ public:
+  struct Key {
+    Key(content::PermissionType permission,
+        const GURL& requesting_origin,
+        const GURL& embedding_origin);
+    Key(const Key& other);
+    ~Key();
+
+    bool operator<(const Key& other) const;
+
+    content::PermissionType permission;
+    GURL requesting_origin;
+    GURL embedding_origin;
+  };
+
+  PermissionDecisionCache(base::TimeDelta ttl,
+                          std::unique_ptr<base::TickClock> clock);
+  ~PermissionDecisionCache();
+
+  // Returns true and sets |status| if there is a decision for |key| that has
+  // not expired.
+  bool GetDecision(const Key& key, blink::mojom::PermissionStatus* status);
+  void SetDecision(const Key& key, blink::mojom::PermissionStatus status);
+  void RemoveDecision(const Key& key);
+
+  // Adds |request_id| to the requests waiting for |key|. Returns true if it
+  // is the first one, which has to show the prompt.
+  bool AddPendingRequest(const Key& key, int request_id);
+  // Returns false if there are other requests waiting for |key|, in which
+  // case the prompt must be kept.
+  bool RemovePendingRequest(const Key& key, int request_id);
+  // Returns the requests waiting for |key| in the order they were made, and
+  // forgets them.
+  std::vector<int> TakePendingRequests(const Key& key);
+
+  void SetClockForTesting(std::unique_ptr<base::TickClock> clock);
+
+ private:
+  struct Decision {
+    blink::mojom::PermissionStatus status;
+    base::TimeTicks expiry;
+  };
+
+  base::TimeDelta ttl_;
+  std::unique_ptr<base::TickClock> clock_;
+  std::map<Key, Decision> decisions_;
+  // Ids increase, so each set is in request order.
+  std::map<Key, std::set<int>> pending_requests_;
+
+  DISALLOW_COPY_AND_ASSIGN(PermissionDecisionCache);
+};
+
+}  // namespace xwalk
+
+#endif  // XWALK_RUNTIME_BROWSER_PERMISSION_DECISION_CACHE_H_
@@ -0,0 +1,124 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/permission_decision_cache.h"
+
+#include <vector>
+
+#include "base/memory/ptr_util.h"
+#include "base/strings/stringprintf.h"
+#include "base/test/simple_test_tick_clock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using blink::mojom::PermissionStatus;
+using content::PermissionType;
+
+namespace xwalk {
+
+class PermissionDecisionCacheTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    clock_ = new base::SimpleTestTickClock;
+    cache_.reset(new PermissionDecisionCache(
+        base::TimeDelta::FromMinutes(10), base::WrapUnique(clock_)));
+  }
+
+  PermissionDecisionCache::Key MakeKey(PermissionType permission,
+                                       int origin) {
+    return PermissionDecisionCache::Key(
+        permission,
+        GURL(base::StringPrintf("https://origin%d.example.com/", origin)),
+        GURL("https://embedder.example.com/"));
+  }
+
+  // Owned by |cache_|.
+  base::SimpleTestTickClock* clock_;
+  std::unique_ptr<PermissionDecisionCache> cache_;
+};
+
+TEST_F(PermissionDecisionCacheTest, DecisionExpires) {
+  PermissionDecisionCache::Key key = MakeKey(PermissionType::GEOLOCATION, 0);
+  PermissionStatus status;
+  EXPECT_FALSE(cache_->GetDecision(key, &status));
+
+  cache_->SetDecision(key, PermissionStatus::GRANTED);
+  ASSERT_TRUE(cache_->GetDecision(key, &status));
+  EXPECT_EQ(PermissionStatus::GRANTED, status);
+
+  // Other permissions and origins are not affected.
+  EXPECT_FALSE(cache_->GetDecision(
+      MakeKey(PermissionType::NOTIFICATIONS, 0), &status));
+  EXPECT_FALSE(cache_->GetDecision(
+      MakeKey(PermissionType::GEOLOCATION, 1), &status));
+
+  clock_->Advance(base::TimeDelta::FromMinutes(9));
+  EXPECT_TRUE(cache_->GetDecision(key, &status));
+  clock_->Advance(base::TimeDelta::FromMinutes(1));
+  EXPECT_FALSE(cache_->GetDecision(key, &status));
+}
+
+TEST_F(PermissionDecisionCacheTest, RemoveDecision) {
+  PermissionDecisionCache::Key key = MakeKey(PermissionType::NOTIFICATIONS, 0);
+  cache_->SetDecision(key, PermissionStatus::DENIED);
+  cache_->RemoveDecision(key);
+  PermissionStatus status;
+  EXPECT_FALSE(cache_->GetDecision(key, &status));
+}
+
+TEST_F(PermissionDecisionCacheTest, ZeroTTLDisablesCaching) {
+  PermissionDecisionCache cache(
+      base::TimeDelta(), base::WrapUnique(new base::SimpleTestTickClock));
+  PermissionDecisionCache::Key key = MakeKey(PermissionType::GEOLOCATION, 0);
+  cache.SetDecision(key, PermissionStatus::GRANTED);
+  PermissionStatus status;
+  EXPECT_FALSE(cache.GetDecision(key, &status));
+}
+
+TEST_F(PermissionDecisionCacheTest, ConcurrentRequestsShareAPrompt) {
+  const int kOrigins = 4;
+  const int kRequestsPerOrigin = 250;
+
+  // Requests for the different origins are interleaved, as when several
+  // frames ask in a loop.
+  int prompts = 0;
+  int request_id = 0;
+  for (int i = 0; i < kRequestsPerOrigin; ++i) {
+    for (int origin = 0; origin < kOrigins; ++origin) {
+      if (cache_->AddPendingRequest(
+              MakeKey(PermissionType::GEOLOCATION, origin), ++request_id))
+        ++prompts;
+    }
+  }
+  EXPECT_EQ(kOrigins, prompts);
+
+  for (int origin = 0; origin < kOrigins; ++origin) {
+    std::vector<int> requests = cache_->TakePendingRequests(
+        MakeKey(PermissionType::GEOLOCATION, origin));
+    ASSERT_EQ(static_cast<size_t>(kRequestsPerOrigin), requests.size());
+    for (int i = 0; i < kRequestsPerOrigin; ++i)
+      EXPECT_EQ(i * kOrigins + origin + 1, requests[i]);
+  }
+
+  // Once answered, the next request shows a new prompt.
+  EXPECT_TRUE(cache_->AddPendingRequest(
+      MakeKey(PermissionType::GEOLOCATION, 0), ++request_id));
+}
+
+TEST_F(PermissionDecisionCacheTest, CancelKeepsPromptForOtherRequests) {
+  PermissionDecisionCache::Key key = MakeKey(PermissionType::GEOLOCATION, 0);
+  const int kRequests = 300;
+  for (int i = 1; i <= kRequests; ++i)
+    cache_->AddPendingRequest(key, i);
+
+  // Every request but the last one leaves the prompt to the others.
+  for (int i = 1; i < kRequests; i += 2)
+    EXPECT_FALSE(cache_->RemovePendingRequest(key, i));
+  for (int i = 2; i < kRequests; i += 2)
+    EXPECT_FALSE(cache_->RemovePendingRequest(key, i));
+  EXPECT_TRUE(cache_->RemovePendingRequest(key, kRequests));
+
+  EXPECT_TRUE(cache_->TakePendingRequests(key).empty());
+}
+
+}  // namespace xwalk
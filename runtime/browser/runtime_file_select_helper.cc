@@ -4,15 +4,19 @@
 
 #include "xwalk/runtime/browser/runtime_file_select_helper.h"
 
+#include <stdint.h>
+
 #include <string>
 #include <utility>
 
 #include "base/bind.h"
 #include "base/files/file.h"
 #include "base/files/file_util.h"
+#include "base/logging.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/threading/sequenced_worker_pool.h"
 #include "xwalk/runtime/browser/runtime_platform_util.h"
 #include "xwalk/runtime/browser/runtime_select_file_policy.h"
 #include "content/public/browser/browser_thread.h"
@@ -45,6 +49,11 @@ namespace {
 // the renderer must start at 0 and increase.
 const int kFileSelectEnumerationId = -1;
 
+// Directory picks beyond these are refused rather than handed to the
+// renderer in a single message.
+const size_t kMaxEnumeratedEntries = 100000;
+const int64_t kMaxEnumeratedBytes = 4LL * 1024 * 1024 * 1024;
+
 void NotifyRenderFrameHost(content::RenderFrameHost* render_frame_host,
                           const std::vector<ui::SelectedFileInfo>& files,
                           FileChooserParams::Mode dialog_mode) {
@@ -74,8 +83,8 @@ std::vector<ui::SelectedFileInfo> FilePathListToSelectedFileInfoList(
 struct RuntimeFileSelectHelper::ActiveDirectoryEnumeration {
   ActiveDirectoryEnumeration() : render_view_host_(nullptr) {}
 
-  std::unique_ptr<DirectoryListerDispatchDelegate> delegate_;
-  std::unique_ptr<net::DirectoryLister> lister_;
+  std::unique_ptr<EnumerationDispatchDelegate> delegate_;
+  scoped_refptr<xwalk::DirectoryEnumerator> enumerator_;
   RenderViewHost* render_view_host_;
   std::vector<base::FilePath> results_;
 };
@@ -101,19 +110,19 @@ RuntimeFileSelectHelper::~RuntimeFileSelectHelper() {
   for (iter = directory_enumerations_.begin();
        iter != directory_enumerations_.end();
        ++iter) {
-    iter->second->lister_.reset();
+    iter->second->enumerator_->Cancel();
     delete iter->second;
   }
 }
 
-void RuntimeFileSelectHelper::DirectoryListerDispatchDelegate::OnListFile(
-    const net::DirectoryLister::DirectoryListerData& data) {
-  parent_->OnListFile(id_, data);
+void RuntimeFileSelectHelper::EnumerationDispatchDelegate::OnEntriesEnumerated(
+    const std::vector<base::FilePath>& entries) {
+  parent_->OnEntriesEnumerated(id_, entries);
 }
 
-void RuntimeFileSelectHelper::DirectoryListerDispatchDelegate::OnListDone(
-    int error) {
-  parent_->OnListDone(id_, error);
+void RuntimeFileSelectHelper::EnumerationDispatchDelegate::OnEnumerationDone(
+    xwalk::DirectoryEnumerator::Result result) {
+  parent_->OnEnumerationDone(id_, result);
 }
 
 void RuntimeFileSelectHelper::FileSelected(const base::FilePath& path,
@@ -188,60 +197,85 @@ void RuntimeFileSelectHelper::StartNewEnumeration(
     const base::FilePath& path,
     int request_id,
     RenderViewHost* render_view_host) {
-  std::unique_ptr<ActiveDirectoryEnumeration> entry(new ActiveDirectoryEnumeration);
+  std::unique_ptr<ActiveDirectoryEnumeration> entry(
+      new ActiveDirectoryEnumeration);
   entry->render_view_host_ = render_view_host;
-  entry->delegate_.reset(new DirectoryListerDispatchDelegate(this, request_id));
-  entry->lister_.reset(new net::DirectoryLister(path,
-                               net::DirectoryLister::NO_SORT_RECURSIVE,
-                               entry->delegate_.get()));
-  if (!entry->lister_->Start(base::WorkerPool::GetTaskRunner(true).get())) {
-    if (request_id == kFileSelectEnumerationId)
-      FileSelectionCanceled(NULL);
-    else
-      render_view_host->DirectoryEnumerationFinished(request_id,
-                                                     entry->results_);
-  } else {
-    directory_enumerations_[request_id] = entry.release();
+  entry->delegate_.reset(new EnumerationDispatchDelegate(this, request_id));
+  entry->enumerator_ = new xwalk::DirectoryEnumerator(
+      path, kMaxEnumeratedEntries, kMaxEnumeratedBytes,
+      entry->delegate_.get());
+
+  // The enumeration is stopped if the renderer goes away meanwhile.
+  content::Source<RenderWidgetHost> source(render_view_host->GetWidget());
+  if (!notification_registrar_.IsRegistered(
+          this, content::NOTIFICATION_RENDER_WIDGET_HOST_DESTROYED, source)) {
+    notification_registrar_.Add(
+        this, content::NOTIFICATION_RENDER_WIDGET_HOST_DESTROYED, source);
   }
+
+  // The blocking pool has a bounded number of threads, of which the
+  // enumeration takes at most DirectoryEnumerator::kMaxWorkers.
+  entry->enumerator_->Start(
+      BrowserThread::GetBlockingPool()->GetTaskRunnerWithShutdownBehavior(
+          base::SequencedWorkerPool::CONTINUE_ON_SHUTDOWN));
+  directory_enumerations_[request_id] = entry.release();
 }
 
-void RuntimeFileSelectHelper::OnListFile(
+void RuntimeFileSelectHelper::OnEntriesEnumerated(
     int id,
-    const net::DirectoryLister::DirectoryListerData& data) {
+    const std::vector<base::FilePath>& entries) {
   ActiveDirectoryEnumeration* entry = directory_enumerations_[id];
-
-  // Directory upload returns directories via a "." file, so that
-  // empty directories are included.  This util call just checks
-  // the flags in the structure; there's no file I/O going on.
-  if (data.info.IsDirectory())
-    entry->results_.push_back(data.path.Append(FILE_PATH_LITERAL(".")));
-  else
-    entry->results_.push_back(data.path);
+  entry->results_.insert(entry->results_.end(), entries.begin(),
+                         entries.end());
 }
 
-void RuntimeFileSelectHelper::OnListDone(int id, int error) {
+void RuntimeFileSelectHelper::OnEnumerationDone(
+    int id,
+    xwalk::DirectoryEnumerator::Result result) {
   // This entry needs to be cleaned up when this function is done.
-  std::unique_ptr<ActiveDirectoryEnumeration> entry(directory_enumerations_[id]);
+  std::unique_ptr<ActiveDirectoryEnumeration> entry(
+      directory_enumerations_[id]);
   directory_enumerations_.erase(id);
-  if (!entry->render_view_host_)
-    return;
-  if (error) {
-    FileSelectionCanceled(NULL);
-    return;
-  }
+  if (result == xwalk::DirectoryEnumerator::RESULT_OVER_BUDGET)
+    LOG(WARNING) << "Too many files in the selected directory.";
 
-  std::vector<ui::SelectedFileInfo> selected_files =
-      FilePathListToSelectedFileInfoList(entry->results_);
-
-  if (id == kFileSelectEnumerationId)
+  if (id == kFileSelectEnumerationId) {
+    if (result != xwalk::DirectoryEnumerator::RESULT_OK) {
+      FileSelectionCanceled(NULL);
+      return;
+    }
     NotifyRenderFrameHost(
-        render_frame_host_, selected_files, dialog_mode_);
-  else
+        render_frame_host_, FilePathListToSelectedFileInfoList(entry->results_),
+        dialog_mode_);
+  } else {
+    if (result != xwalk::DirectoryEnumerator::RESULT_OK)
+      entry->results_.clear();
     entry->render_view_host_->DirectoryEnumerationFinished(id, entry->results_);
+  }
 
   EnumerateDirectoryEnd();
 }
 
+void RuntimeFileSelectHelper::CancelEnumerations(
+    RenderWidgetHost* render_widget_host) {
+  std::map<int, ActiveDirectoryEnumeration*>::iterator iter =
+      directory_enumerations_.begin();
+  while (iter != directory_enumerations_.end()) {
+    ActiveDirectoryEnumeration* entry = iter->second;
+    if (entry->render_view_host_->GetWidget() != render_widget_host) {
+      ++iter;
+      continue;
+    }
+    entry->enumerator_->Cancel();
+    delete entry;
+    directory_enumerations_.erase(iter++);
+    // Released later, as this may be the last reference.
+    BrowserThread::PostTask(
+        BrowserThread::UI, FROM_HERE,
+        base::Bind(&RuntimeFileSelectHelper::EnumerateDirectoryEnd, this));
+  }
+}
+
 std::unique_ptr<ui::SelectFileDialog::FileTypeInfo>
 RuntimeFileSelectHelper::GetFileTypesFromAcceptType(
     const std::vector<base::string16>& accept_types) {
@@ -480,9 +514,14 @@ void RuntimeFileSelectHelper::Observe(
     const content::NotificationDetails& details) {
   switch (type) {
     case content::NOTIFICATION_RENDER_WIDGET_HOST_DESTROYED: {
-      DCHECK(content::Source<RenderWidgetHost>(source).ptr() ==
-            render_frame_host_->GetRenderViewHost()->GetWidget());
-      render_frame_host_ = NULL;
+      RenderWidgetHost* render_widget_host =
+          content::Source<RenderWidgetHost>(source).ptr();
+      if (render_frame_host_ &&
+          render_frame_host_->GetRenderViewHost()->GetWidget() ==
+              render_widget_host) {
+        render_frame_host_ = NULL;
+      }
+      CancelEnumerations(render_widget_host);
       break;
     }
 
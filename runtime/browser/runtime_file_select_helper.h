@@ -11,16 +11,16 @@
 
 #include "base/compiler_specific.h"
 #include "base/gtest_prod_util.h"
-#include "base/threading/worker_pool.h"
 #include "content/public/browser/notification_observer.h"
 #include "content/public/browser/notification_registrar.h"
 #include "content/public/common/file_chooser_params.h"
-#include "net/base/directory_lister.h"
 #include "ui/shell_dialogs/select_file_dialog.h"
+#include "xwalk/runtime/browser/directory_enumerator.h"
 
 namespace content {
 class RenderViewHost;
 class RenderFrameHost;
+class RenderWidgetHost;
 class WebContents;
 }
 
@@ -51,24 +51,24 @@ class RuntimeFileSelectHelper
   RuntimeFileSelectHelper();
   ~RuntimeFileSelectHelper() override;
 
-  // Utility class which can listen for directory lister events and relay
+  // Utility class which can listen for directory enumerator events and relay
   // them to the main object with the correct tracking id.
-  class DirectoryListerDispatchDelegate
-      : public net::DirectoryLister::DirectoryListerDelegate {
+  class EnumerationDispatchDelegate
+      : public xwalk::DirectoryEnumerator::Delegate {
    public:
-    DirectoryListerDispatchDelegate(RuntimeFileSelectHelper* parent, int id)
+    EnumerationDispatchDelegate(RuntimeFileSelectHelper* parent, int id)
         : parent_(parent),
           id_(id) {}
-    ~DirectoryListerDispatchDelegate() override {}
-    void OnListFile(
-        const net::DirectoryLister::DirectoryListerData& data) override;
-    void OnListDone(int error) override;
+    ~EnumerationDispatchDelegate() override {}
+    void OnEntriesEnumerated(
+        const std::vector<base::FilePath>& entries) override;
+    void OnEnumerationDone(xwalk::DirectoryEnumerator::Result result) override;
    private:
     // This RuntimeFileSelectHelper owns this object.
     RuntimeFileSelectHelper* parent_;
     int id_;
 
-    DISALLOW_COPY_AND_ASSIGN(DirectoryListerDispatchDelegate);
+    DISALLOW_COPY_AND_ASSIGN(EnumerationDispatchDelegate);
   };
 
   void RunFileChooser(content::RenderFrameHost* render_frame_host,
@@ -112,10 +112,13 @@ class RuntimeFileSelectHelper
                            content::RenderViewHost* render_view_host);
 
   // Callbacks from directory enumeration.
-  virtual void OnListFile(
-      int id,
-      const net::DirectoryLister::DirectoryListerData& data);
-  virtual void OnListDone(int id, int error);
+  virtual void OnEntriesEnumerated(int id,
+                                   const std::vector<base::FilePath>& entries);
+  virtual void OnEnumerationDone(int id,
+                                 xwalk::DirectoryEnumerator::Result result);
+
+  // Stops the enumerations for |render_widget_host|, which is going away.
+  void CancelEnumerations(content::RenderWidgetHost* render_widget_host);
 
   // Cleans up and releases this instance. This must be called after the last
   // callback is received from the enumeration code.
@@ -6,11 +6,13 @@
 
 #include <vector>
 
+#include "base/bind.h"
 #include "base/command_line.h"
 #include "content/public/browser/notification_service.h"
 #include "content/public/browser/web_contents.h"
 #include "grit/xwalk_resources.h"
 #include "ui/base/resource/resource_bundle.h"
+#include "ui/display/display.h"
 #include "ui/display/screen.h"
 #include "ui/views/controls/webview/webview.h"
 #include "components/constrained_window/constrained_window_views.h"
@@ -44,7 +46,8 @@ NativeAppWindowViews::NativeAppWindowViews(
       is_fullscreen_(false),
       minimum_size_(create_params.minimum_size),
       maximum_size_(create_params.maximum_size),
-      resizable_(create_params.resizable) {
+      resizable_(create_params.resizable),
+      weak_ptr_factory_(this) {
 }
 
 NativeAppWindowViews::~NativeAppWindowViews() {}
@@ -67,16 +70,20 @@ void NativeAppWindowViews::Initialize() {
     params.type = views::Widget::InitParams::TYPE_WINDOW;
     params.bounds = create_params_.bounds;
   }
-  // Set the app icon if it is passed from command line.
+  // Use the default icon for Crosswalk app until the one passed from command
+  // line, if any, is decoded.
+  ui::ResourceBundle& rb = ui::ResourceBundle::GetSharedInstance();
+  icon_ = rb.GetNativeImageNamed(IDR_XWALK_ICON_48);
   base::CommandLine* command_line = base::CommandLine::ForCurrentProcess();
   if (command_line->HasSwitch(switches::kAppIcon)) {
     base::FilePath icon_file =
       command_line->GetSwitchValuePath(switches::kAppIcon);
-    icon_ = xwalk_utils::LoadImageFromFilePath(icon_file);
-  } else {
-    // Otherwise, use the default icon for Crosswalk app.
-    ui::ResourceBundle& rb = ui::ResourceBundle::GetSharedInstance();
-    icon_ = rb.GetNativeImageNamed(IDR_XWALK_ICON_48);
+    float scale = display::Screen::GetScreen()->GetPrimaryDisplay()
+        .device_scale_factor();
+    xwalk_utils::ImageLoader::GetInstance()->LoadImage(
+        icon_file, static_cast<int>(icon_.Width() * scale),
+        base::Bind(&NativeAppWindowViews::OnAppIconLoaded,
+                   weak_ptr_factory_.GetWeakPtr()));
   }
 
   window_->Init(params);
@@ -100,6 +107,11 @@ void NativeAppWindowViews::UpdateIcon(const gfx::Image& icon) {
   window_->UpdateWindowIcon();
 }
 
+void NativeAppWindowViews::OnAppIconLoaded(const gfx::Image& icon) {
+  if (!icon.IsEmpty())
+    UpdateIcon(icon);
+}
+
 void NativeAppWindowViews::UpdateTitle(const base::string16& title) {
   title_ = title;
   window_->UpdateWindowTitle();
@@ -7,6 +7,7 @@
 
 #include <string>
 
+#include "base/memory/weak_ptr.h"
 #include "xwalk/runtime/browser/ui/native_app_window.h"
 #include "ui/gfx/geometry/rect.h"
 #include "ui/gfx/image/image_skia.h"
@@ -115,6 +116,8 @@ class NativeAppWindowViews : public NativeAppWindow,
   void OnWidgetBoundsChanged(
       views::Widget* widget, const gfx::Rect& new_bounds) override;
 
+  void OnAppIconLoaded(const gfx::Image& icon);
+
   NativeAppWindow::CreateParams create_params_;
 
   views::Widget* window_;
@@ -128,6 +131,8 @@ class NativeAppWindowViews : public NativeAppWindow,
 
   std::unique_ptr<ExclusiveAccessBubbleViews> exclusive_access_bubble_;
 
+  base::WeakPtrFactory<NativeAppWindowViews> weak_ptr_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(NativeAppWindowViews);
 };
 
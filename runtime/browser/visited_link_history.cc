@@ -0,0 +1,236 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/visited_link_history.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/files/file.h"
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/sequenced_task_runner.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_piece.h"
+#include "base/time/time.h"
+#include "url/gurl.h"
+
+namespace xwalk {
+
+struct VisitedLinkHistory::Visit {
+  std::string url;
+  // In seconds since the epoch.
+  int64_t time;
+};
+
+namespace {
+
+void AppendLine(int64_t time, const std::string& url, std::string* data) {
+  data->append(base::Int64ToString(time));
+  data->push_back(' ');
+  data->append(url);
+  data->push_back('\n');
+}
+
+}  // namespace
+
+const int64_t VisitedLinkHistory::kMinCompactionSize;
+const size_t VisitedLinkHistory::kMaxURLs;
+const int VisitedLinkHistory::kMaxAgeDays;
+
+VisitedLinkHistory::VisitedLinkHistory(
+    const base::FilePath& path,
+    scoped_refptr<base::SequencedTaskRunner> task_runner)
+    : path_(path),
+      task_runner_(task_runner),
+      file_size_(-1),
+      compacted_size_(-1) {
+}
+
+VisitedLinkHistory::~VisitedLinkHistory() {
+}
+
+void VisitedLinkHistory::AddURLs(const std::vector<GURL>& urls) {
+  int64_t now = base::Time::Now().ToTimeT();
+  std::string lines;
+  for (const GURL& url : urls) {
+    if (url.is_valid())
+      AppendLine(now, url.spec(), &lines);
+  }
+  if (lines.empty())
+    return;
+
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::Bind(&VisitedLinkHistory::AppendOnSequence, this, lines));
+}
+
+void VisitedLinkHistory::DeleteAllURLs() {
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::Bind(&VisitedLinkHistory::DeleteAllOnSequence, this));
+}
+
+void VisitedLinkHistory::EnumerateURLs(
+    const scoped_refptr<visitedlink::VisitedLinkDelegate::URLEnumerator>&
+        enumerator) {
+  task_runner_->PostTask(
+      FROM_HERE,
+      base::Bind(&VisitedLinkHistory::EnumerateOnSequence, this, enumerator));
+}
+
+void VisitedLinkHistory::AppendOnSequence(const std::string& lines) {
+  DCHECK(task_runner_->RunsTasksOnCurrentThread());
+  // This also drops a line cut short by a crash of the previous run, which
+  // must not be glued to the first URL of this run.
+  if (file_size_ < 0)
+    Compact();
+
+  base::File file(path_, base::File::FLAG_OPEN_ALWAYS |
+                             base::File::FLAG_APPEND);
+  if (!file.IsValid()) {
+    LOG(WARNING) << "Failed to open " << path_.value();
+    return;
+  }
+  int written = file.WriteAtCurrentPos(lines.data(), lines.size());
+  if (written > 0)
+    file_size_ += written;
+  file.Close();
+
+  if (file_size_ >= kMinCompactionSize && file_size_ >= 2 * compacted_size_)
+    Compact();
+}
+
+void VisitedLinkHistory::DeleteAllOnSequence() {
+  DCHECK(task_runner_->RunsTasksOnCurrentThread());
+  base::DeleteFile(path_, false);
+  file_size_ = 0;
+  compacted_size_ = 0;
+}
+
+void VisitedLinkHistory::EnumerateOnSequence(
+    const scoped_refptr<visitedlink::VisitedLinkDelegate::URLEnumerator>&
+        enumerator) {
+  DCHECK(task_runner_->RunsTasksOnCurrentThread());
+  std::vector<Visit> visits;
+  int64_t file_size;
+  int64_t kept_size;
+  if (!ReadURLs(&visits, &file_size, &kept_size)) {
+    // Nothing has been visited yet.
+    enumerator->OnComplete(true);
+    return;
+  }
+
+  for (const Visit& visit : visits) {
+    GURL url(visit.url);
+    if (url.is_valid())
+      enumerator->OnURL(url);
+  }
+  enumerator->OnComplete(true);
+
+  Rewrite(visits, file_size, kept_size);
+}
+
+bool VisitedLinkHistory::ReadURLs(std::vector<Visit>* visits,
+                                  int64_t* file_size,
+                                  int64_t* kept_size) {
+  *file_size = 0;
+  *kept_size = 0;
+  if (!base::GetFileSize(path_, file_size) || *file_size == 0)
+    return false;
+
+  // The file is mapped rather than read, so that no copy of it is made.
+  base::MemoryMappedFile mapped_file;
+  if (!mapped_file.Initialize(path_)) {
+    LOG(WARNING) << "Failed to map " << path_.value();
+    return false;
+  }
+
+  // The last time each URL was added, in the order the URLs were first
+  // added.
+  std::vector<std::pair<int64_t, base::StringPiece>> lines;
+  std::unordered_map<base::StringPiece, size_t, base::StringPieceHash> seen;
+  base::StringPiece data(reinterpret_cast<const char*>(mapped_file.data()),
+                         mapped_file.length());
+  size_t start = 0;
+  while (start < data.size()) {
+    size_t end = data.find('\n', start);
+    // A last line without its newline was cut short.
+    if (end == base::StringPiece::npos)
+      break;
+    base::StringPiece line = data.substr(start, end - start);
+    start = end + 1;
+
+    size_t separator = line.find(' ');
+    int64_t time;
+    if (separator == base::StringPiece::npos ||
+        !base::StringToInt64(line.substr(0, separator), &time))
+      continue;
+    base::StringPiece url = line.substr(separator + 1);
+    if (url.empty())
+      continue;
+    auto inserted = seen.insert(std::make_pair(url, lines.size()));
+    if (inserted.second)
+      lines.push_back(std::make_pair(time, url));
+    else
+      lines[inserted.first->second].first = time;
+  }
+
+  std::stable_sort(lines.begin(), lines.end(),
+                   [](const std::pair<int64_t, base::StringPiece>& a,
+                      const std::pair<int64_t, base::StringPiece>& b) {
+                     return a.first < b.first;
+                   });
+  int64_t min_time = (base::Time::Now() -
+                      base::TimeDelta::FromDays(kMaxAgeDays)).ToTimeT();
+  size_t first = lines.size() > kMaxURLs ? lines.size() - kMaxURLs : 0;
+  for (size_t i = first; i < lines.size(); ++i) {
+    if (lines[i].first < min_time)
+      continue;
+    Visit visit;
+    visit.url = lines[i].second.as_string();
+    visit.time = lines[i].first;
+    *kept_size += base::Int64ToString(visit.time).size() + visit.url.size() + 2;
+    visits->push_back(visit);
+  }
+  return true;
+}
+
+void VisitedLinkHistory::Compact() {
+  std::vector<Visit> visits;
+  int64_t file_size;
+  int64_t kept_size;
+  if (!ReadURLs(&visits, &file_size, &kept_size)) {
+    file_size_ = file_size;
+    compacted_size_ = file_size;
+    return;
+  }
+  Rewrite(visits, file_size, kept_size);
+}
+
+void VisitedLinkHistory::Rewrite(const std::vector<Visit>& visits,
+                                 int64_t file_size,
+                                 int64_t kept_size) {
+  file_size_ = file_size;
+  compacted_size_ = file_size;
+  if (kept_size == file_size)
+    return;
+
+  std::string data;
+  data.reserve(kept_size);
+  for (const Visit& visit : visits)
+    AppendLine(visit.time, visit.url, &data);
+  // The file is replaced atomically, so a crash keeps either version.
+  if (!base::ImportantFileWriter::WriteFileAtomically(path_, data))
+    return;
+  file_size_ = data.size();
+  compacted_size_ = file_size_;
+}
+
+}  // namespace xwalk
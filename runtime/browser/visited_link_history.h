@@ -0,0 +1,97 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_RUNTIME_BROWSER_VISITED_LINK_HISTORY_H_
+#define XWALK_RUNTIME_BROWSER_VISITED_LINK_HISTORY_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "components/visitedlink/browser/visitedlink_delegate.h"
+
+class GURL;
+
+namespace base {
+class SequencedTaskRunner;
+}
+
+namespace xwalk {
+
+// Keeps the URLs added to the :visited table in a file of the profile, so
+// that VisitedLinkMaster can rebuild its table when its own file is missing
+// or damaged.
+//
+// The file holds one URL per line, after the time it was added, and is only
+// appended to, all the file IO being done on |task_runner|. A line cut short
+// by a crash is skipped when the file is read back. The file is compacted on
+// the first append of a run, and once it has grown past twice its size after
+// the last compaction: the duplicate URLs are dropped, as are the URLs older
+// than kMaxAgeDays and all but the kMaxURLs most recent ones.
+//
+// The file is a browsing history in plain text, unlike the encrypted tab
+// history, and outlives the :visited table it backs. Whatever clears the
+// visited links of the profile has to call DeleteAllURLs(), which removes the
+// file.
+class VisitedLinkHistory
+    : public base::RefCountedThreadSafe<VisitedLinkHistory> {
+ public:
+  // The file is not compacted for growth before it reaches this size.
+  static const int64_t kMinCompactionSize = 1024 * 1024;
+  static const size_t kMaxURLs = 50000;
+  static const int kMaxAgeDays = 90;
+
+  VisitedLinkHistory(const base::FilePath& path,
+                     scoped_refptr<base::SequencedTaskRunner> task_runner);
+
+  void AddURLs(const std::vector<GURL>& urls);
+  // Called when the visited links are cleared. Deletes the file.
+  void DeleteAllURLs();
+
+  // Passes every URL kept in the file, once, to |enumerator| on
+  // |task_runner|.
+  void EnumerateURLs(
+      const scoped_refptr<visitedlink::VisitedLinkDelegate::URLEnumerator>&
+          enumerator);
+
+ private:
+  friend class base::RefCountedThreadSafe<VisitedLinkHistory>;
+  ~VisitedLinkHistory();
+
+  void AppendOnSequence(const std::string& lines);
+  void DeleteAllOnSequence();
+  void EnumerateOnSequence(
+      const scoped_refptr<visitedlink::VisitedLinkDelegate::URLEnumerator>&
+          enumerator);
+
+  struct Visit;
+
+  // Reads the URLs to keep from the file, with the time they were last
+  // added, oldest first. Sets |kept_size| to the size they take in the file.
+  bool ReadURLs(std::vector<Visit>* visits,
+                int64_t* file_size,
+                int64_t* kept_size);
+  // Rewrites the file with the URLs to keep only, if it has anything else.
+  void Compact();
+  void Rewrite(const std::vector<Visit>& visits,
+               int64_t file_size,
+               int64_t kept_size);
+
+  const base::FilePath path_;
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
+
+  // Only used on |task_runner_|. A negative size is not known yet.
+  int64_t file_size_;
+  int64_t compacted_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(VisitedLinkHistory);
+};
+
+}  // namespace xwalk
+
+#endif  // XWALK_RUNTIME_BROWSER_VISITED_LINK_HISTORY_H_
@@ -0,0 +1,196 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/visited_link_history.h"
+
+#include <string>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace xwalk {
+
+namespace {
+
+class TestURLEnumerator
+    : public visitedlink::VisitedLinkDelegate::URLEnumerator {
+ public:
+  TestURLEnumerator() : completed_(false) {}
+
+  void OnURL(const GURL& url) override { urls_.push_back(url); }
+  void OnComplete(bool success) override { completed_ = success; }
+
+  const std::vector<GURL>& urls() const { return urls_; }
+  bool completed() const { return completed_; }
+
+ private:
+  ~TestURLEnumerator() override {}
+
+  std::vector<GURL> urls_;
+  bool completed_;
+};
+
+GURL MakeURL(int i) {
+  return GURL(base::StringPrintf("https://example%d.com/page", i));
+}
+
+// Formats a line of the file.
+std::string MakeLine(const GURL& url, base::Time time) {
+  return base::Int64ToString(time.ToTimeT()) + " " + url.spec() + "\n";
+}
+
+}  // namespace
+
+class VisitedLinkHistoryTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    path_ = temp_dir_.path().AppendASCII("Visited Links History");
+  }
+
+  // Creates a new history as done on startup.
+  scoped_refptr<VisitedLinkHistory> CreateHistory() {
+    return new VisitedLinkHistory(path_, base::ThreadTaskRunnerHandle::Get());
+  }
+
+  scoped_refptr<TestURLEnumerator> Enumerate(VisitedLinkHistory* history) {
+    scoped_refptr<TestURLEnumerator> enumerator(new TestURLEnumerator);
+    history->EnumerateURLs(enumerator);
+    base::RunLoop().RunUntilIdle();
+    EXPECT_TRUE(enumerator->completed());
+    return enumerator;
+  }
+
+  int64_t FileSize() {
+    int64_t size = 0;
+    base::GetFileSize(path_, &size);
+    return size;
+  }
+
+  base::MessageLoop message_loop_;
+  base::ScopedTempDir temp_dir_;
+  base::FilePath path_;
+};
+
+TEST_F(VisitedLinkHistoryTest, EmptyHistory) {
+  scoped_refptr<VisitedLinkHistory> history = CreateHistory();
+  EXPECT_TRUE(Enumerate(history.get())->urls().empty());
+}
+
+TEST_F(VisitedLinkHistoryTest, ReloadAfterRestart) {
+  scoped_refptr<VisitedLinkHistory> history = CreateHistory();
+  history->AddURLs({MakeURL(0), MakeURL(1)});
+  history->AddURLs({MakeURL(0), GURL(), MakeURL(2)});
+  base::RunLoop().RunUntilIdle();
+
+  scoped_refptr<TestURLEnumerator> enumerator =
+      Enumerate(CreateHistory().get());
+  ASSERT_EQ(3u, enumerator->urls().size());
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(MakeURL(i), enumerator->urls()[i]);
+
+  history->DeleteAllURLs();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_TRUE(Enumerate(history.get())->urls().empty());
+}
+
+TEST_F(VisitedLinkHistoryTest, LineCutShortByCrash) {
+  std::string data =
+      MakeLine(MakeURL(0), base::Time::Now()) + "1466000000 https://exam";
+  ASSERT_EQ(static_cast<int>(data.size()),
+            base::WriteFile(path_, data.data(), data.size()));
+
+  // The cut line is skipped, and the next URL does not extend it.
+  scoped_refptr<VisitedLinkHistory> history = CreateHistory();
+  history->AddURLs({MakeURL(1)});
+  base::RunLoop().RunUntilIdle();
+
+  scoped_refptr<TestURLEnumerator> enumerator = Enumerate(history.get());
+  ASSERT_EQ(2u, enumerator->urls().size());
+  EXPECT_EQ(MakeURL(0), enumerator->urls()[0]);
+  EXPECT_EQ(MakeURL(1), enumerator->urls()[1]);
+}
+
+TEST_F(VisitedLinkHistoryTest, GrowthIsBoundedByCompaction) {
+  const int kUniqueURLs = 100;
+  scoped_refptr<VisitedLinkHistory> history = CreateHistory();
+  std::vector<GURL> urls;
+  for (int i = 0; i < kUniqueURLs; ++i)
+    urls.push_back(MakeURL(i));
+
+  // Revisiting the same pages only grows the file up to the compaction
+  // threshold.
+  int64_t batch_size = 0;
+  for (const GURL& url : urls)
+    batch_size += MakeLine(url, base::Time::Now()).size();
+  int batches = static_cast<int>(
+      3 * VisitedLinkHistory::kMinCompactionSize / batch_size);
+  for (int i = 0; i < batches; ++i)
+    history->AddURLs(urls);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_LT(FileSize(), VisitedLinkHistory::kMinCompactionSize);
+
+  scoped_refptr<TestURLEnumerator> enumerator = Enumerate(history.get());
+  EXPECT_EQ(static_cast<size_t>(kUniqueURLs), enumerator->urls().size());
+}
+
+TEST_F(VisitedLinkHistoryTest, OldURLsAreDropped) {
+  base::Time now = base::Time::Now();
+  std::string data =
+      MakeLine(MakeURL(0), now - base::TimeDelta::FromDays(
+                                     VisitedLinkHistory::kMaxAgeDays + 1)) +
+      MakeLine(MakeURL(1), now - base::TimeDelta::FromDays(1)) +
+      MakeLine(MakeURL(0), now - base::TimeDelta::FromDays(
+                                     VisitedLinkHistory::kMaxAgeDays + 2));
+  ASSERT_EQ(static_cast<int>(data.size()),
+            base::WriteFile(path_, data.data(), data.size()));
+
+  scoped_refptr<VisitedLinkHistory> history = CreateHistory();
+  scoped_refptr<TestURLEnumerator> enumerator = Enumerate(history.get());
+  ASSERT_EQ(1u, enumerator->urls().size());
+  EXPECT_EQ(MakeURL(1), enumerator->urls()[0]);
+
+  // The file was rewritten without them.
+  EXPECT_EQ(static_cast<int64_t>(
+                MakeLine(MakeURL(1), now - base::TimeDelta::FromDays(1))
+                    .size()),
+            FileSize());
+}
+
+// Rebuilding the table on startup goes through all the URLs kept.
+TEST_F(VisitedLinkHistoryTest, RebuildWith100kURLs) {
+  const int kURLs = 100000;
+  base::Time now = base::Time::Now();
+  std::string data;
+  for (int i = 0; i < kURLs; ++i)
+    data.append(MakeLine(MakeURL(i), now));
+  ASSERT_EQ(static_cast<int>(data.size()),
+            base::WriteFile(path_, data.data(), data.size()));
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  scoped_refptr<TestURLEnumerator> enumerator =
+      Enumerate(CreateHistory().get());
+  base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+  LOG(INFO) << "Enumerated " << kURLs << " visited URLs in "
+            << elapsed.InMilliseconds() << " ms";
+
+  // Only the most recent ones are kept.
+  ASSERT_EQ(VisitedLinkHistory::kMaxURLs, enumerator->urls().size());
+  EXPECT_EQ(MakeURL(kURLs - static_cast<int>(VisitedLinkHistory::kMaxURLs)),
+            enumerator->urls().front());
+  EXPECT_EQ(MakeURL(kURLs - 1), enumerator->urls().back());
+  EXPECT_LT(FileSize(), static_cast<int64_t>(data.size()));
+}
+
+}  // namespace xwalk
@@ -5,12 +5,14 @@
 #include "xwalk/runtime/browser/xwalk_app_extension_bridge.h"
 
 #include <string>
+#include <utility>
 
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/notification_service.h"
 #include "xwalk/application/browser/application.h"
 #include "xwalk/application/browser/application_service.h"
 #include "xwalk/application/browser/application_system.h"
+#include "xwalk/runtime/browser/xwalk_runner.h"
 
 namespace xwalk {
 
@@ -24,6 +26,15 @@ XWalkAppExtensionBridge::XWalkAppExtensionBridge()
 
 XWalkAppExtensionBridge::~XWalkAppExtensionBridge() {}
 
+void XWalkAppExtensionBridge::SetApplicationSystem(
+    application::ApplicationSystem* app_system) {
+  if (app_system_)
+    app_system_->application_service()->RemoveObserver(this);
+  app_system_ = app_system;
+  if (app_system_)
+    app_system_->application_service()->AddObserver(this);
+}
+
 void XWalkAppExtensionBridge::CheckAPIAccessControl(
     int render_process_id,
     const std::string& extension_name,
@@ -60,6 +71,36 @@ bool XWalkAppExtensionBridge::RegisterPermissions(
   return service->RegisterPermissions(app->id(), extension_name, perm_table);
 }
 
+void XWalkAppExtensionBridge::GetPermissionSnapshot(
+    int render_process_id,
+    const std::string& extension_name,
+    extensions::PermissionSnapshot* snapshot) {
+  CHECK(app_system_);
+  application::ApplicationService *service =
+      app_system_->application_service();
+  application::Application *app =
+      service->GetApplicationByRenderHostID(render_process_id);
+  if (!app)
+    return;
+
+  // Both enums are kept aligned, see xwalk_extension_permission_types.h.
+  application::PermissionSnapshot app_snapshot;
+  service->GetPermissionSnapshot(app->id(), extension_name, &app_snapshot);
+  for (size_t i = 0; i < app_snapshot.size(); ++i) {
+    snapshot->push_back(std::make_pair(
+        app_snapshot[i].first,
+        static_cast<extensions::RuntimePermission>(app_snapshot[i].second)));
+  }
+}
+
+void XWalkAppExtensionBridge::DidChangeApplicationPermissions(
+    application::Application* app) {
+  extensions::XWalkExtensionService* extension_service =
+      XWalkRunner::GetInstance()->extension_service();
+  if (extension_service)
+    extension_service->InvalidatePermissions(app->GetRenderProcessHostID());
+}
+
 Application* XWalkAppExtensionBridge::GetApplication(int render_process_id) {
   CHECK(app_system_);
   ApplicationService* service =
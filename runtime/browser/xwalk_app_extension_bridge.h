@@ -7,6 +7,7 @@
 
 #include <string>
 
+#include "xwalk/application/browser/application_service.h"
 #include "xwalk/application/browser/application_system.h"
 #include "xwalk/extensions/browser/xwalk_extension_service.h"
 #include "xwalk/extensions/common/xwalk_extension_permission_types.h"
@@ -25,14 +26,14 @@ class Application;
 // between application and extension takes place, just like a 'bridge'.
 // The class instance will be owned by xwalk_runner.
 class XWalkAppExtensionBridge
-    : public extensions::XWalkExtensionService::Delegate {
+    : public extensions::XWalkExtensionService::Delegate,
+      public application::ApplicationService::Observer {
  public:
   XWalkAppExtensionBridge();
   ~XWalkAppExtensionBridge() override;
 
-  void SetApplicationSystem(application::ApplicationSystem* app_system) {
-    app_system_ = app_system;
-  }
+  // Must be reset to NULL before |app_system| is destroyed.
+  void SetApplicationSystem(application::ApplicationSystem* app_system);
   // XWalkExtensionService::Delegate implementation
   void CheckAPIAccessControl(
       int render_process_id,
@@ -43,6 +44,14 @@ class XWalkAppExtensionBridge
       int render_process_id,
       const std::string& extension_name,
       const std::string& perm_table) override;
+  void GetPermissionSnapshot(
+      int render_process_id,
+      const std::string& extension_name,
+      extensions::PermissionSnapshot* snapshot) override;
+
+  // ApplicationService::Observer implementation
+  void DidChangeApplicationPermissions(
+      application::Application* app) override;
 
  private:
   application::Application* GetApplication(int render_process_id);
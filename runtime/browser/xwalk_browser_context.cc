@@ -11,7 +11,10 @@
 
 #include "base/command_line.h"
 #include "base/logging.h"
+#include "base/memory/ptr_util.h"
 #include "base/path_service.h"
+#include "base/threading/sequenced_worker_pool.h"
+#include "base/time/default_clock.h"
 #include "components/prefs/pref_registry_simple.h"
 #include "components/prefs/pref_service.h"
 #include "components/prefs/pref_service_factory.h"
@@ -30,8 +33,10 @@
 #include "xwalk/application/browser/application_service.h"
 #include "xwalk/application/browser/application_system.h"
 #include "xwalk/application/common/constants.h"
+#include "xwalk/runtime/browser/favicon_store.h"
 #include "xwalk/runtime/browser/runtime_download_manager_delegate.h"
 #include "xwalk/runtime/browser/runtime_url_request_context_getter.h"
+#include "xwalk/runtime/browser/visited_link_history.h"
 #include "xwalk/runtime/browser/xwalk_content_settings.h"
 #include "xwalk/runtime/browser/xwalk_permission_manager.h"
 #include "xwalk/runtime/browser/xwalk_pref_store.h"
@@ -84,6 +89,20 @@ class XWalkBrowserContext::RuntimeResourceContext :
 
 XWalkBrowserContext* g_browser_context = nullptr;
 
+// Kept next to the "Visited Links" table of VisitedLinkMaster. Holds the
+// visited URLs in plain text, see VisitedLinkHistory.
+const base::FilePath::CharType kVisitedLinkHistoryFilename[] =
+    FILE_PATH_LITERAL("Visited Links History");
+
+const base::FilePath::CharType kFaviconStoreFilename[] =
+    FILE_PATH_LITERAL("Favicons");
+
+// Icons beyond this are evicted, least recently used first.
+const size_t kMaxStoredFavicons = 512;
+
+// Icons older than this are downloaded again.
+const int kMaxFaviconAgeDays = 7;
+
 void HandleReadError(PersistentPrefStore::PrefReadError error) {
   LOG(ERROR) << "Failed to read preference, error num: " << error;
 }
@@ -344,6 +363,21 @@ XWalkFormDatabaseService* XWalkBrowserContext::GetFormDatabaseService() {
   return form_database_service_.get();
 }
 
+FaviconStore* XWalkBrowserContext::GetFaviconStore() {
+  if (!favicon_store_) {
+    base::SequencedWorkerPool* pool = BrowserThread::GetBlockingPool();
+    favicon_store_.reset(new FaviconStore(
+        GetPath().Append(kFaviconStoreFilename),
+        pool->GetSequencedTaskRunnerWithShutdownBehavior(
+            pool->GetSequenceToken(),
+            base::SequencedWorkerPool::BLOCK_SHUTDOWN),
+        kMaxStoredFavicons, base::TimeDelta::FromDays(kMaxFaviconAgeDays),
+        base::WrapUnique(new base::DefaultClock)));
+    favicon_store_->Load();
+  }
+  return favicon_store_.get();
+}
+
 // Create user pref service for autofill functionality.
 void XWalkBrowserContext::CreateUserPrefServiceIfNecessary() {
   if (user_pref_service_) return;
@@ -402,22 +436,36 @@ std::string XWalkBrowserContext::GetCSPString() const {
 #endif
 
 void XWalkBrowserContext::InitVisitedLinkMaster() {
+  base::SequencedWorkerPool* pool = BrowserThread::GetBlockingPool();
+  visited_link_history_ = new VisitedLinkHistory(
+      GetPath().Append(kVisitedLinkHistoryFilename),
+      pool->GetSequencedTaskRunnerWithShutdownBehavior(
+          pool->GetSequenceToken(),
+          base::SequencedWorkerPool::BLOCK_SHUTDOWN));
+  // The table is kept in the "Visited Links" file of the profile, so the
+  // links visited in previous runs are still styled.
   visitedlink_master_.reset(
-      new visitedlink::VisitedLinkMaster(this, this, false));
+      new visitedlink::VisitedLinkMaster(this, this, true));
   visitedlink_master_->Init();
 }
 
 void XWalkBrowserContext::AddVisitedURLs(const std::vector<GURL>& urls) {
   DCHECK(visitedlink_master_.get());
   visitedlink_master_->AddURLs(urls);
+  visited_link_history_->AddURLs(urls);
+}
+
+void XWalkBrowserContext::ClearVisitedLinks() {
+  DCHECK(visitedlink_master_.get());
+  visitedlink_master_->DeleteAllURLs();
+  visited_link_history_->DeleteAllURLs();
 }
 
 void XWalkBrowserContext::RebuildTable(
     const scoped_refptr<URLEnumerator>& enumerator) {
-  // XWalkView rebuilds from XWalkWebChromeClient.getVisitedHistory. The client
-  // can change in the lifetime of this XWalkView and may not yet be set here.
-  // Therefore this initialization path is not used.
-  enumerator->OnComplete(true);
+  // Called when the table file is missing or damaged. The URLs are read on
+  // the blocking pool, VisitedLinkMaster builds the table off this thread.
+  visited_link_history_->EnumerateURLs(enumerator);
 }
 
 }  // namespace xwalk
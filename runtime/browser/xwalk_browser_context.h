@@ -42,7 +42,9 @@ class PrefService;
 
 namespace xwalk {
 
+class FaviconStore;
 class RuntimeDownloadManagerDelegate;
+class VisitedLinkHistory;
 
 namespace application {
 class ApplicationService;
@@ -94,6 +96,7 @@ class XWalkBrowserContext
       const std::string& pkg_id);
   void InitFormDatabaseService();
   XWalkFormDatabaseService* GetFormDatabaseService();
+  FaviconStore* GetFaviconStore();
   void CreateUserPrefServiceIfNecessary();
   void UpdateAcceptLanguages(const std::string& accept_languages);
   void set_save_form_data(bool enable) { save_form_data_ = enable; }
@@ -115,6 +118,9 @@ class XWalkBrowserContext
 #endif
   // These methods map to Add methods in visitedlink::VisitedLinkMaster.
   void AddVisitedURLs(const std::vector<GURL>& urls);
+  // Forgets the visited links of the profile, and deletes the plain text URL
+  // history they are rebuilt from.
+  void ClearVisitedLinks();
   // visitedlink::VisitedLinkDelegate implementation.
   void RebuildTable(
       const scoped_refptr<URLEnumerator>& enumerator) override;
@@ -140,6 +146,8 @@ class XWalkBrowserContext
   std::string csp_;
 #endif
   std::unique_ptr<visitedlink::VisitedLinkMaster> visitedlink_master_;
+  scoped_refptr<VisitedLinkHistory> visited_link_history_;
+  std::unique_ptr<FaviconStore> favicon_store_;
 
   typedef std::map<base::FilePath::StringType,
       scoped_refptr<RuntimeURLRequestContextGetter> >
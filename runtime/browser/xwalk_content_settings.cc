@@ -7,6 +7,7 @@
 #include <string>
 
 #include "base/base_paths.h"
+#include "base/bind.h"
 #include "base/files/file_util.h"
 #include "base/path_service.h"
 #include "components/prefs/pref_filter.h"
@@ -55,10 +56,15 @@ void XWalkContentSettings::Init() {
   HostContentSettingsMap::RegisterProfilePrefs(pref_registry_.get());
   host_content_settings_map_ =
       new HostContentSettingsMap(pref_service_.get(), false, false);
+  lookup_cache_.reset(new ContentSettingLookupCache(
+      base::Bind(&XWalkContentSettings::LookupPermission,
+                 base::Unretained(this))));
+  host_content_settings_map_->AddObserver(this);
 }
 
 void XWalkContentSettings::Shutdown() {
   pref_store_->CommitPendingWrite();
+  host_content_settings_map_->RemoveObserver(this);
   host_content_settings_map_->ShutdownOnUIThread();
 }
 
@@ -66,6 +72,22 @@ ContentSetting XWalkContentSettings::GetPermission(
     ContentSettingsType type,
     const GURL& requesting_origin,
     const GURL& embedding_origin) {
+  return lookup_cache_->GetContentSetting(requesting_origin, embedding_origin,
+                                          type);
+}
+
+void XWalkContentSettings::OnContentSettingChanged(
+    const ContentSettingsPattern& primary_pattern,
+    const ContentSettingsPattern& secondary_pattern,
+    ContentSettingsType content_type,
+    std::string resource_identifier) {
+  lookup_cache_->Invalidate();
+}
+
+ContentSetting XWalkContentSettings::LookupPermission(
+    const GURL& requesting_origin,
+    const GURL& embedding_origin,
+    ContentSettingsType type) {
   return host_content_settings_map_->GetContentSetting(
       requesting_origin,
       embedding_origin,
@@ -7,17 +7,24 @@
 
 #include <memory>
 
+#include <string>
+
 #include "base/memory/singleton.h"
 #include "components/prefs/pref_service.h"
 #include "components/prefs/json_pref_store.h"
+#include "components/content_settings/core/browser/content_settings_observer.h"
 #include "components/content_settings/core/browser/host_content_settings_map.h"
+#include "xwalk/runtime/browser/content_setting_lookup_cache.h"
 
 namespace xwalk {
 
 // This class (a singleton) manages the content settings for XWalk.
 // It writes them on disk in the user data under the filename Preferences.
 // These settings are persistent across runs.
-class XWalkContentSettings {
+//
+// GetPermission() may be called on any thread. Its answers are cached until
+// a setting changes.
+class XWalkContentSettings : public content_settings::Observer {
  public:
   static XWalkContentSettings* GetInstance();
   // This function needs to be called on startup while I/O is allowed.
@@ -33,9 +40,20 @@ class XWalkContentSettings {
       const GURL& requesting_origin,
       const GURL& embedding_origin);
 
+  // content_settings::Observer implementation.
+  void OnContentSettingChanged(
+      const ContentSettingsPattern& primary_pattern,
+      const ContentSettingsPattern& secondary_pattern,
+      ContentSettingsType content_type,
+      std::string resource_identifier) override;
+
  private:
   XWalkContentSettings();
-  ~XWalkContentSettings();
+  ~XWalkContentSettings() override;
+
+  ContentSetting LookupPermission(const GURL& requesting_origin,
+                                  const GURL& embedding_origin,
+                                  ContentSettingsType type);
 
   base::FilePath GetPrefFilePathFromPath(const base::FilePath& path);
 
@@ -44,6 +62,7 @@ class XWalkContentSettings {
   scoped_refptr<JsonPrefStore> pref_store_;
   scoped_refptr<base::SequencedTaskRunner> sequenced_task_runner_;
   scoped_refptr<HostContentSettingsMap> host_content_settings_map_;
+  std::unique_ptr<ContentSettingLookupCache> lookup_cache_;
   friend struct base::DefaultSingletonTraits<XWalkContentSettings>;
 
   DISALLOW_COPY_AND_ASSIGN(XWalkContentSettings);
@@ -5,9 +5,14 @@
 
 #include "xwalk/runtime/browser/xwalk_form_database_service.h"
 
+#include "base/bind.h"
+#include "base/bind_helpers.h"
 #include "base/logging.h"
 #include "base/synchronization/waitable_event.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "components/autofill/core/browser/webdata/autofill_change.h"
 #include "components/autofill/core/browser/webdata/autofill_table.h"
+#include "components/autofill/core/browser/webdata/autofill_webdata_service_observer.h"
 #include "components/webdata/common/webdata_constants.h"
 #include "content/public/browser/browser_thread.h"
 
@@ -22,11 +27,101 @@ void DatabaseErrorCallback(sql::InitStatus status) {
   LOG(WARNING) << "initializing autocomplete database failed";
 }
 
+int GetCount(const WDTypedResult* result) {
+  if (!result)
+    return 0;
+  DCHECK_EQ(AUTOFILL_VALUE_RESULT, result->GetType());
+  return static_cast<const WDResult<int>*>(result)->GetValue();
+}
+
+// Counts the stored values for a caller blocked on the UI thread. The
+// request is made on the DB thread, so that its result is delivered there.
+class BlockingCountQuery : public WebDataServiceConsumer {
+ public:
+  BlockingCountQuery()
+      : completion_(WaitableEvent::ResetPolicy::AUTOMATIC,
+                    WaitableEvent::InitialState::NOT_SIGNALED),
+        count_(0) {}
+
+  int Run(autofill::AutofillWebDataService* service) {
+    BrowserThread::PostTask(
+        BrowserThread::DB, FROM_HERE,
+        base::Bind(&BlockingCountQuery::Start, base::Unretained(this),
+                   base::Unretained(service)));
+    completion_.Wait();
+    return count_;
+  }
+
+  // WebDataServiceConsumer implementation.
+  void OnWebDataServiceRequestDone(WebDataServiceBase::Handle h,
+                                   const WDTypedResult* result) override {
+    DCHECK(BrowserThread::CurrentlyOn(BrowserThread::DB));
+    count_ = GetCount(result);
+    completion_.Signal();
+  }
+
+ private:
+  void Start(autofill::AutofillWebDataService* service) {
+    service->GetCountOfValuesContainedBetween(
+        base::Time(), base::Time::Max(), this);
+  }
+
+  WaitableEvent completion_;
+  int count_;
+
+  DISALLOW_COPY_AND_ASSIGN(BlockingCountQuery);
+};
+
 }  // namespace
 
 namespace xwalk {
 
-XWalkFormDatabaseService::XWalkFormDatabaseService(const base::FilePath path) {
+// Reports the changes of the autocomplete entries to the UI thread.
+class XWalkFormDatabaseService::EntriesObserver
+    : public autofill::AutofillWebDataServiceObserverOnDBThread {
+ public:
+  explicit EntriesObserver(base::WeakPtr<XWalkFormDatabaseService> service)
+      : service_(service) {}
+
+  static void Add(scoped_refptr<autofill::AutofillWebDataService> data,
+                  EntriesObserver* observer) {
+    data->AddObserver(observer);
+  }
+
+  static void Remove(scoped_refptr<autofill::AutofillWebDataService> data,
+                     std::unique_ptr<EntriesObserver> observer) {
+    data->RemoveObserver(observer.get());
+  }
+
+  // autofill::AutofillWebDataServiceObserverOnDBThread implementation.
+  void AutofillEntriesChanged(
+      const autofill::AutofillChangeList& changes) override {
+    bool added = false;
+    bool removed = false;
+    for (const autofill::AutofillChange& change : changes) {
+      if (change.type() == autofill::AutofillChange::REMOVE)
+        removed = true;
+      else
+        added = true;
+    }
+    BrowserThread::PostTask(
+        BrowserThread::UI, FROM_HERE,
+        base::Bind(&XWalkFormDatabaseService::OnEntriesChanged, service_,
+                   added, removed));
+  }
+
+ private:
+  base::WeakPtr<XWalkFormDatabaseService> service_;
+
+  DISALLOW_COPY_AND_ASSIGN(EntriesObserver);
+};
+
+XWalkFormDatabaseService::XWalkFormDatabaseService(const base::FilePath path)
+    : form_data_state_(FORM_DATA_UNKNOWN),
+      generation_(0),
+      pending_query_(0),
+      pending_query_generation_(0),
+      weak_factory_(this) {
   CHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
   web_database_ = new WebDatabaseService(path.Append(kWebDataFilename),
       BrowserThread::GetMessageLoopProxyForThread(BrowserThread::UI),
@@ -40,6 +135,15 @@ XWalkFormDatabaseService::XWalkFormDatabaseService(const base::FilePath path) {
       BrowserThread::GetMessageLoopProxyForThread(BrowserThread::DB),
       base::Bind(&DatabaseErrorCallback));
   autofill_data_->Init();
+
+  entries_observer_.reset(new EntriesObserver(weak_factory_.GetWeakPtr()));
+  BrowserThread::PostTask(
+      BrowserThread::DB, FROM_HERE,
+      base::Bind(&EntriesObserver::Add, autofill_data_,
+                 base::Unretained(entries_observer_.get())));
+
+  // Most callers then get the answer without waiting.
+  QueryFormData();
 }
 
 XWalkFormDatabaseService::~XWalkFormDatabaseService() {
@@ -48,10 +152,21 @@ XWalkFormDatabaseService::~XWalkFormDatabaseService() {
 
 void XWalkFormDatabaseService::Shutdown() {
   DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
-  DCHECK(result_map_.empty());
-  // TODO(sgurun) we don't run into this logic right now,
-  // but if we do, then we need to implement cancellation
-  // of pending queries.
+  if (!entries_observer_)
+    return;
+
+  // The pending callbacks are dropped without being run.
+  if (pending_query_) {
+    autofill_data_->CancelRequest(pending_query_);
+    pending_query_ = 0;
+  }
+  pending_callbacks_.clear();
+  weak_factory_.InvalidateWeakPtrs();
+  BrowserThread::PostTask(
+      BrowserThread::DB, FROM_HERE,
+      base::Bind(&EntriesObserver::Remove, autofill_data_,
+                 base::Passed(&entries_observer_)));
+
   autofill_data_->ShutdownOnUIThread();
   web_database_->ShutdownDatabase();
 }
@@ -61,69 +176,110 @@ XWalkFormDatabaseService::get_autofill_webdata_service() {
   return autofill_data_;
 }
 
-void XWalkFormDatabaseService::ClearFormData() {
-  BrowserThread::PostTask(
-      BrowserThread::DB,
-      FROM_HERE,
-      base::Bind(&XWalkFormDatabaseService::ClearFormDataImpl,
-                 base::Unretained(this)));
-}
+void XWalkFormDatabaseService::ClearFormData(const base::Closure& callback) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  ++generation_;
+  // An "added" notification already posted by EntriesObserver may still
+  // set the state back to present, until the one of the removal arrives.
+  SetFormDataState(FORM_DATA_ABSENT);
 
-void XWalkFormDatabaseService::ClearFormDataImpl() {
   base::Time begin;
   base::Time end = base::Time::Max();
   autofill_data_->RemoveFormElementsAddedBetween(begin, end);
   autofill_data_->RemoveAutofillDataModifiedBetween(begin, end);
+
+  // The removals above are queued on the DB thread before this task.
+  if (!callback.is_null()) {
+    BrowserThread::PostTaskAndReply(BrowserThread::DB, FROM_HERE,
+                                    base::Bind(&base::DoNothing), callback);
+  }
 }
 
-bool XWalkFormDatabaseService::HasFormData() {
-  WaitableEvent completion(
-      base::WaitableEvent::ResetPolicy::AUTOMATIC,
-      base::WaitableEvent::InitialState::NOT_SIGNALED);
-  bool result = false;
-  BrowserThread::PostTask(
-      BrowserThread::DB,
-      FROM_HERE,
-      base::Bind(&XWalkFormDatabaseService::HasFormDataImpl,
-                 base::Unretained(this),
-                 &completion,
-                 &result));
-  completion.Wait();
-  return result;
+void XWalkFormDatabaseService::HasFormData(
+    const HasFormDataCallback& callback) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if (form_data_state_ != FORM_DATA_UNKNOWN) {
+    base::ThreadTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE,
+        base::Bind(callback, form_data_state_ == FORM_DATA_PRESENT));
+    return;
+  }
+  pending_callbacks_.push_back(callback);
+  QueryFormData();
+}
+
+bool XWalkFormDatabaseService::HasFormDataBlocking() {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if (form_data_state_ == FORM_DATA_UNKNOWN) {
+    // The entries change on the DB thread, where the count is queued behind
+    // the writes requested so far, so it sees all of them. A later write is
+    // reported by EntriesObserver afterwards, and updates the state again.
+    BlockingCountQuery query;
+    SetFormDataState(query.Run(autofill_data_.get()) > 0 ?
+                     FORM_DATA_PRESENT : FORM_DATA_ABSENT);
+  }
+  return form_data_state_ == FORM_DATA_PRESENT;
+}
+
+void XWalkFormDatabaseService::OnEntriesChanged(bool added, bool removed) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if (!added && !removed)
+    return;
+  ++generation_;
+  if (added) {
+    SetFormDataState(FORM_DATA_PRESENT);
+  } else if (form_data_state_ != FORM_DATA_ABSENT) {
+    // Other entries may be left. A count in flight may have missed the
+    // removal, so it is started again.
+    form_data_state_ = FORM_DATA_UNKNOWN;
+    if (pending_query_)
+      QueryFormData();
+  }
+}
+
+void XWalkFormDatabaseService::SetFormDataState(FormDataState state) {
+  DCHECK_NE(FORM_DATA_UNKNOWN, state);
+  form_data_state_ = state;
+  if (pending_query_) {
+    autofill_data_->CancelRequest(pending_query_);
+    pending_query_ = 0;
+  }
+
+  bool has_form_data = form_data_state_ == FORM_DATA_PRESENT;
+  std::vector<HasFormDataCallback> callbacks;
+  callbacks.swap(pending_callbacks_);
+  for (const HasFormDataCallback& callback : callbacks)
+    callback.Run(has_form_data);
 }
 
-void XWalkFormDatabaseService::HasFormDataImpl(
-    WaitableEvent* completion,
-    bool* result) {
-  WebDataServiceBase::Handle pending_query_handle =
-      autofill_data_->GetCountOfValuesContainedBetween(
-          base::Time(), base::Time::Max(), this);
-  PendingQuery query;
-  query.result = result;
-  query.completion = completion;
-  result_map_[pending_query_handle] = query;
+void XWalkFormDatabaseService::QueryFormData() {
+  if (pending_query_) {
+    if (pending_query_generation_ == generation_)
+      return;
+    autofill_data_->CancelRequest(pending_query_);
+  }
+  pending_query_ = autofill_data_->GetCountOfValuesContainedBetween(
+      base::Time(), base::Time::Max(), this);
+  pending_query_generation_ = generation_;
 }
 
 void XWalkFormDatabaseService::OnWebDataServiceRequestDone(
     WebDataServiceBase::Handle h,
     const WDTypedResult* result) {
-
-  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::DB));
-  bool has_form_data = false;
-  if (result) {
-    DCHECK_EQ(AUTOFILL_VALUE_RESULT, result->GetType());
-    const WDResult<int>* autofill_result =
-        static_cast<const WDResult<int>*>(result);
-    has_form_data = autofill_result->GetValue() > 0;
-  }
-  QueryMap::const_iterator it = result_map_.find(h);
-  if (it == result_map_.end()) {
+  DCHECK(BrowserThread::CurrentlyOn(BrowserThread::UI));
+  if (h != pending_query_) {
     LOG(WARNING) << "Received unexpected callback from web data service";
     return;
   }
-  *(it->second.result) = has_form_data;
-  it->second.completion->Signal();
-  result_map_.erase(h);
+  pending_query_ = 0;
+
+  // The entries changed while counting.
+  if (pending_query_generation_ != generation_) {
+    QueryFormData();
+    return;
+  }
+  SetFormDataState(GetCount(result) > 0 ?
+                   FORM_DATA_PRESENT : FORM_DATA_ABSENT);
 }
 
 }  // namespace xwalk
@@ -6,37 +6,49 @@
 #ifndef XWALK_RUNTIME_BROWSER_XWALK_FORM_DATABASE_SERVICE_H_
 #define XWALK_RUNTIME_BROWSER_XWALK_FORM_DATABASE_SERVICE_H_
 
-#include <map>
+#include <memory>
+#include <vector>
 
+#include "base/callback.h"
 #include "base/files/file_path.h"
+#include "base/memory/weak_ptr.h"
 #include "components/autofill/core/browser/webdata/autofill_webdata_service.h"
 #include "components/webdata/common/web_data_service_consumer.h"
 #include "components/webdata/common/web_database_service.h"
 
-namespace base {
-class WaitableEvent;
-};
-
 namespace xwalk {
 
 // Handles the database operations necessary to implement the autocomplete
 // functionality. This includes creating and initializing the components that
-// handle the database backend, and providing a synchronous interface when
-// needed (the chromium database components have an async. interface).
+// handle the database backend, and answering whether any form data is stored.
+//
+// That answer comes from a cached state, kept up to date with the changes of
+// the autocomplete entries, so that the database is only queried when the
+// state is unknown: at startup and after some entries were removed.
+//
+// Must be used on the UI thread.
 class XWalkFormDatabaseService : public WebDataServiceConsumer {
  public:
+  typedef base::Callback<void(bool has_form_data)> HasFormDataCallback;
+
   explicit XWalkFormDatabaseService(const base::FilePath path);
 
   ~XWalkFormDatabaseService() override;
 
   void Shutdown();
 
-  // Returns whether the database has any data stored. May do
-  // IO access and block.
-  bool HasFormData();
+  // Runs |callback| with whether the database has any form data stored.
+  // Never runs |callback| synchronously.
+  void HasFormData(const HasFormDataCallback& callback);
 
-  // Clear any saved form data. Executes asynchronously.
-  void ClearFormData();
+  // Same as HasFormData(), for callers which need the answer right away.
+  // Blocks on the DB thread when the cached state is unknown.
+  bool HasFormDataBlocking();
+
+  // Clears any saved form data. Runs |callback|, which may be null, once
+  // the data is gone. HasFormData() reports no data from now on, unless
+  // new data is saved.
+  void ClearFormData(const base::Closure& callback);
 
   scoped_refptr<autofill::AutofillWebDataService>
       get_autofill_webdata_service();
@@ -46,20 +58,42 @@ class XWalkFormDatabaseService : public WebDataServiceConsumer {
       WebDataServiceBase::Handle h, const WDTypedResult* result) override;
 
  private:
-  struct PendingQuery {
-    bool* result;
-    base::WaitableEvent* completion;
+  class EntriesObserver;
+
+  enum FormDataState {
+    FORM_DATA_UNKNOWN,
+    FORM_DATA_ABSENT,
+    FORM_DATA_PRESENT,
   };
-  typedef std::map<WebDataServiceBase::Handle, PendingQuery> QueryMap;
 
-  void ClearFormDataImpl();
-  void HasFormDataImpl(base::WaitableEvent* completion, bool* result);
+  // Called when autocomplete entries were added or updated, or removed.
+  void OnEntriesChanged(bool added, bool removed);
 
-  QueryMap result_map_;
+  // Cancels the count in flight, if any, and answers the pending callers.
+  void SetFormDataState(FormDataState state);
+
+  // Counts the stored values, unless a count started since the last change
+  // is in flight.
+  void QueryFormData();
+
+  FormDataState form_data_state_;
+  // Incremented whenever the stored values change, so that the result of a
+  // count started before is not cached.
+  int generation_;
+
+  // The count in flight, or 0, and the generation it started at.
+  WebDataServiceBase::Handle pending_query_;
+  int pending_query_generation_;
+  std::vector<HasFormDataCallback> pending_callbacks_;
 
   scoped_refptr<autofill::AutofillWebDataService> autofill_data_;
   scoped_refptr<WebDatabaseService> web_database_;
 
+  // Lives on the DB thread.
+  std::unique_ptr<EntriesObserver> entries_observer_;
+
+  base::WeakPtrFactory<XWalkFormDatabaseService> weak_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(XWalkFormDatabaseService);
 };
 
@@ -0,0 +1,173 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/xwalk_form_database_service.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/utf_string_conversions.h"
+#include "components/autofill/core/common/form_field_data.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/test/test_browser_thread_bundle.h"
+#include "content/public/test/test_utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using content::BrowserThread;
+
+namespace xwalk {
+
+namespace {
+
+void AppendResult(std::vector<bool>* results, bool has_form_data) {
+  results->push_back(has_form_data);
+}
+
+void SetTrue(bool* value) {
+  *value = true;
+}
+
+}  // namespace
+
+class XWalkFormDatabaseServiceTest : public testing::Test {
+ protected:
+  XWalkFormDatabaseServiceTest()
+      : thread_bundle_(content::TestBrowserThreadBundle::REAL_DB_THREAD) {}
+
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    service_.reset(new XWalkFormDatabaseService(temp_dir_.path()));
+    WaitForDatabase();
+  }
+
+  void TearDown() override {
+    service_.reset();
+    WaitForDatabase();
+  }
+
+  // Runs the queued database tasks and the replies they post, including the
+  // counts started by those replies.
+  void WaitForDatabase() {
+    for (int i = 0; i < 3; ++i) {
+      content::RunAllPendingInMessageLoop(BrowserThread::DB);
+      base::RunLoop().RunUntilIdle();
+    }
+  }
+
+  void RestartService() {
+    service_.reset();
+    WaitForDatabase();
+    service_.reset(new XWalkFormDatabaseService(temp_dir_.path()));
+  }
+
+  void AddFormField(const std::string& name, const std::string& value) {
+    autofill::FormFieldData field;
+    field.name = base::ASCIIToUTF16(name);
+    field.value = base::ASCIIToUTF16(value);
+    service_->get_autofill_webdata_service()->AddFormFields(
+        std::vector<autofill::FormFieldData>(1, field));
+  }
+
+  void QueryFormData(std::vector<bool>* results) {
+    service_->HasFormData(base::Bind(&AppendResult, results));
+  }
+
+  content::TestBrowserThreadBundle thread_bundle_;
+  base::ScopedTempDir temp_dir_;
+  std::unique_ptr<XWalkFormDatabaseService> service_;
+};
+
+TEST_F(XWalkFormDatabaseServiceTest, EmptyDatabase) {
+  std::vector<bool> results;
+  QueryFormData(&results);
+  EXPECT_TRUE(results.empty());
+  WaitForDatabase();
+  ASSERT_EQ(1u, results.size());
+  EXPECT_FALSE(results[0]);
+  EXPECT_FALSE(service_->HasFormDataBlocking());
+}
+
+TEST_F(XWalkFormDatabaseServiceTest, AddAndClear) {
+  AddFormField("name", "value");
+  WaitForDatabase();
+  EXPECT_TRUE(service_->HasFormDataBlocking());
+
+  bool cleared = false;
+  service_->ClearFormData(base::Bind(&SetTrue, &cleared));
+  // Reported right away, before the removal is done.
+  EXPECT_FALSE(service_->HasFormDataBlocking());
+  WaitForDatabase();
+  EXPECT_TRUE(cleared);
+  EXPECT_FALSE(service_->HasFormDataBlocking());
+
+  // The data survives a restart.
+  AddFormField("name", "value");
+  WaitForDatabase();
+  RestartService();
+  std::vector<bool> results;
+  QueryFormData(&results);
+  WaitForDatabase();
+  ASSERT_EQ(1u, results.size());
+  EXPECT_TRUE(results[0]);
+}
+
+TEST_F(XWalkFormDatabaseServiceTest, ConcurrentClearsAndQueries) {
+  std::vector<bool> before_clear;
+  std::vector<bool> after_clear;
+  std::vector<bool> after_last_clear;
+  for (int round = 0; round < 10; ++round) {
+    AddFormField("name" + base::IntToString(round), "value");
+    QueryFormData(&before_clear);
+    service_->ClearFormData(base::Closure());
+    QueryFormData(&after_clear);
+    AddFormField("other" + base::IntToString(round), "value");
+    service_->ClearFormData(base::Closure());
+    QueryFormData(&after_last_clear);
+  }
+  WaitForDatabase();
+
+  // Every query is answered, and none issued after a clear sees the data
+  // it removed.
+  EXPECT_EQ(10u, before_clear.size());
+  ASSERT_EQ(10u, after_clear.size());
+  ASSERT_EQ(10u, after_last_clear.size());
+  for (size_t i = 0; i < after_clear.size(); ++i) {
+    EXPECT_FALSE(after_clear[i]);
+    EXPECT_FALSE(after_last_clear[i]);
+  }
+
+  // The adds which raced with the clears are gone too.
+  std::vector<bool> results;
+  QueryFormData(&results);
+  WaitForDatabase();
+  ASSERT_EQ(1u, results.size());
+  EXPECT_FALSE(results[0]);
+  EXPECT_FALSE(service_->HasFormDataBlocking());
+
+  // A value saved after the clears is reported.
+  AddFormField("name", "value");
+  WaitForDatabase();
+  results.clear();
+  QueryFormData(&results);
+  WaitForDatabase();
+  ASSERT_EQ(1u, results.size());
+  EXPECT_TRUE(results[0]);
+}
+
+TEST_F(XWalkFormDatabaseServiceTest, QueriesDuringShutdownAreDropped) {
+  // A new service waits for its first count, which is still in flight.
+  RestartService();
+  std::vector<bool> results;
+  QueryFormData(&results);
+  service_.reset();
+  WaitForDatabase();
+  EXPECT_TRUE(results.empty());
+}
+
+}  // namespace xwalk
@@ -6,21 +6,45 @@
 #include "xwalk/runtime/browser/xwalk_permission_manager.h"
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/callback.h"
+#include "base/command_line.h"
+#include "base/memory/ptr_util.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/time/default_tick_clock.h"
+#include "base/time/tick_clock.h"
 #include "content/public/browser/permission_type.h"
 #include "content/public/browser/render_frame_host.h"
 #include "content/public/browser/render_process_host.h"
 #include "content/public/browser/web_contents.h"
 #include "xwalk/application/browser/application.h"
 #include "xwalk/application/browser/application_service.h"
+#include "xwalk/runtime/common/xwalk_switches.h"
 
 using blink::mojom::PermissionStatus;
 using content::PermissionType;
 
 namespace xwalk {
 
+namespace {
+
+// Long enough for the identical requests of a burst, e.g. from several
+// frames or a loop of the page, to share an answer.
+const int kDefaultDecisionTTLSeconds = 1;
+
+base::TimeDelta GetDecisionTTL() {
+  int seconds;
+  std::string value = base::CommandLine::ForCurrentProcess()->
+      GetSwitchValueASCII(switches::kPermissionDecisionTTL);
+  if (value.empty() || !base::StringToInt(value, &seconds) || seconds < 0)
+    seconds = kDefaultDecisionTTLSeconds;
+  return base::TimeDelta::FromSeconds(seconds);
+}
+
+}  // namespace
+
 struct XWalkPermissionManager::PendingRequest {
  public:
   PendingRequest(PermissionType permission,
@@ -49,6 +73,8 @@ struct XWalkPermissionManager::PendingRequest {
 XWalkPermissionManager::XWalkPermissionManager(
     application::ApplicationService* application_service)
     : content::PermissionManager(),
+      decision_cache_(GetDecisionTTL(),
+                      base::WrapUnique(new base::DefaultTickClock)),
       application_service_(application_service),
       weak_ptr_factory_(this) {
 }
@@ -71,62 +97,29 @@ int XWalkPermissionManager::RequestPermission(
       content::RenderFrameHost* render_frame_host,
       const GURL& requesting_origin,
       const base::Callback<void(PermissionStatus)>& callback) {
-  bool should_delegate_request = true;
-  for (PendingRequestsMap::Iterator<PendingRequest> it(&pending_requests_);
-      !it.IsAtEnd(); it.Advance()) {
-    if (permission == it.GetCurrentValue()->permission) {
-      should_delegate_request = false;
-      break;
-    }
-  }
-
   const GURL& embedding_origin =
       content::WebContents::FromRenderFrameHost(render_frame_host)
           ->GetLastCommittedURL().GetOrigin();
   int request_id = kNoPendingOperation;
 
   switch (permission) {
-    case content::PermissionType::GEOLOCATION: {
+    case content::PermissionType::GEOLOCATION:
+    case content::PermissionType::NOTIFICATIONS: {
+      PermissionDecisionCache::Key key(permission, requesting_origin,
+                                       embedding_origin);
+      PermissionStatus status;
+      if (decision_cache_.GetDecision(key, &status)) {
+        callback.Run(status);
+        break;
+      }
+
       request_id = pending_requests_.Add(new PendingRequest(
           permission, requesting_origin,
           embedding_origin, render_frame_host,
           callback));
-
-      if (should_delegate_request) {
-        if (!geolocation_permission_context_.get()) {
-          geolocation_permission_context_ =
-              new RuntimeGeolocationPermissionContext();
-        }
-        std::string app_name;
-        GetApplicationName(render_frame_host, &app_name);
-        geolocation_permission_context_->RequestGeolocationPermission(
-            content::WebContents::FromRenderFrameHost(render_frame_host),
-            requesting_origin,
-            app_name,
-            base::Bind(&OnRequestResponse, weak_ptr_factory_.GetWeakPtr(),
-                       request_id, callback));
-      }
-      break;
-    }
-    case content::PermissionType::NOTIFICATIONS: {
-      request_id = pending_requests_.Add(new PendingRequest(
-        permission, requesting_origin,
-        embedding_origin, render_frame_host,
-        callback));
-      if (should_delegate_request) {
-        if (!notification_permission_context_.get()) {
-          notification_permission_context_ =
-              new RuntimeNotificationPermissionContext();
-        }
-        std::string app_name;
-        GetApplicationName(render_frame_host, &app_name);
-        notification_permission_context_->RequestNotificationPermission(
-            content::WebContents::FromRenderFrameHost(render_frame_host),
-            requesting_origin,
-            app_name,
-            base::Bind(&OnRequestResponse, weak_ptr_factory_.GetWeakPtr(),
-                request_id, callback));
-      }
+      // Identical requests made while a prompt is shown get its answer.
+      if (decision_cache_.AddPendingRequest(key, request_id))
+        ShowPrompt(key, render_frame_host);
       break;
     }
     case content::PermissionType::PROTECTED_MEDIA_IDENTIFIER:
@@ -151,6 +144,44 @@ int XWalkPermissionManager::RequestPermission(
   return request_id;
 }
 
+void XWalkPermissionManager::ShowPrompt(
+    const PermissionDecisionCache::Key& key,
+    content::RenderFrameHost* render_frame_host) {
+  base::Callback<void(bool)> callback =
+      base::Bind(&XWalkPermissionManager::OnRequestResponse,
+                 weak_ptr_factory_.GetWeakPtr(), key);
+  if (!prompt_for_testing_.is_null()) {
+    prompt_for_testing_.Run(key.permission, key.requesting_origin, callback);
+    return;
+  }
+
+  std::string app_name;
+  GetApplicationName(render_frame_host, &app_name);
+
+  if (key.permission == content::PermissionType::GEOLOCATION) {
+    if (!geolocation_permission_context_.get()) {
+      geolocation_permission_context_ =
+          new RuntimeGeolocationPermissionContext();
+    }
+    geolocation_permission_context_->RequestGeolocationPermission(
+        content::WebContents::FromRenderFrameHost(render_frame_host),
+        key.requesting_origin,
+        app_name,
+        callback);
+  } else {
+    DCHECK(key.permission == content::PermissionType::NOTIFICATIONS);
+    if (!notification_permission_context_.get()) {
+      notification_permission_context_ =
+          new RuntimeNotificationPermissionContext();
+    }
+    notification_permission_context_->RequestNotificationPermission(
+        content::WebContents::FromRenderFrameHost(render_frame_host),
+        key.requesting_origin,
+        app_name,
+        callback);
+  }
+}
+
 int XWalkPermissionManager::RequestPermissions(
     const std::vector<content::PermissionType>& permissions,
     content::RenderFrameHost* render_frame_host,
@@ -167,6 +198,16 @@ void XWalkPermissionManager::CancelPermissionRequest(int request_id) {
   PendingRequest* pending_request = pending_requests_.Lookup(request_id);
   if (!pending_request)
     return;
+
+  // The prompt stays as long as other requests wait for it.
+  PermissionDecisionCache::Key key(pending_request->permission,
+                                   pending_request->requesting_origin,
+                                   pending_request->embedding_origin);
+  if (!decision_cache_.RemovePendingRequest(key, request_id)) {
+    pending_requests_.Remove(request_id);
+    return;
+  }
+
   content::RenderFrameHost* render_frame_host =
       content::RenderFrameHost::FromID(pending_request->render_process_id,
           pending_request->render_frame_id);
@@ -177,6 +218,11 @@ void XWalkPermissionManager::CancelPermissionRequest(int request_id) {
           content::WebContents::FromRenderFrameHost(render_frame_host),
           pending_request->requesting_origin);
       break;
+    case content::PermissionType::NOTIFICATIONS:
+      notification_permission_context_->CancelNotificationPermissionRequest(
+          content::WebContents::FromRenderFrameHost(render_frame_host),
+          pending_request->requesting_origin);
+      break;
     case content::PermissionType::PROTECTED_MEDIA_IDENTIFIER:
       break;
     case content::PermissionType::AUDIO_CAPTURE:
@@ -184,7 +230,6 @@ void XWalkPermissionManager::CancelPermissionRequest(int request_id) {
     case content::PermissionType::DURABLE_STORAGE:
     case content::PermissionType::MIDI:
     case content::PermissionType::MIDI_SYSEX:
-    case content::PermissionType::NOTIFICATIONS:
     case content::PermissionType::PUSH_MESSAGING:
     case content::PermissionType::VIDEO_CAPTURE:
       NOTIMPLEMENTED() << "CancelPermission not implemented for "
@@ -197,37 +242,34 @@ void XWalkPermissionManager::CancelPermissionRequest(int request_id) {
   pending_requests_.Remove(request_id);
 }
 
-// static
 void XWalkPermissionManager::OnRequestResponse(
-    const base::WeakPtr<XWalkPermissionManager>& manager,
-    int request_id,
-    const base::Callback<void(PermissionStatus)>& callback,
+    const PermissionDecisionCache::Key& key,
     bool allowed) {
   PermissionStatus status = allowed ? PermissionStatus::GRANTED
                                     : PermissionStatus::DENIED;
-  if (manager.get()) {
-    PendingRequest* pending_request =
-    manager->pending_requests_.Lookup(request_id);
-
-    for (PendingRequestsMap::Iterator<PendingRequest> it(
-            &manager->pending_requests_);
-         !it.IsAtEnd(); it.Advance()) {
-      if (pending_request->permission == it.GetCurrentValue()->permission &&
-          it.GetCurrentKey() != request_id) {
-        it.GetCurrentValue()->callback.Run(status);
-        manager->pending_requests_.Remove(it.GetCurrentKey());
-      }
-    }
+  decision_cache_.SetDecision(key, status);
 
-    manager->pending_requests_.Remove(request_id);
+  // The callbacks may make new requests, so they run once the answered
+  // requests are gone.
+  std::vector<base::Callback<void(PermissionStatus)>> callbacks;
+  for (int request_id : decision_cache_.TakePendingRequests(key)) {
+    PendingRequest* pending_request = pending_requests_.Lookup(request_id);
+    if (!pending_request)
+      continue;
+    callbacks.push_back(pending_request->callback);
+    pending_requests_.Remove(request_id);
   }
-  callback.Run(status);
+
+  for (const auto& callback : callbacks)
+    callback.Run(status);
 }
 
 void XWalkPermissionManager::ResetPermission(
     content::PermissionType permission,
     const GURL& requesting_origin,
     const GURL& embedding_origin) {
+  decision_cache_.RemoveDecision(PermissionDecisionCache::Key(
+      permission, requesting_origin, embedding_origin));
 }
 
 PermissionStatus XWalkPermissionManager::GetPermissionStatus(
@@ -237,6 +279,11 @@ PermissionStatus XWalkPermissionManager::GetPermissionStatus(
   if (permission == content::PermissionType::PROTECTED_MEDIA_IDENTIFIER)
     return PermissionStatus::GRANTED;
 
+  PermissionStatus status;
+  if (decision_cache_.GetDecision(PermissionDecisionCache::Key(
+          permission, requesting_origin, embedding_origin), &status))
+    return status;
+
   return PermissionStatus::DENIED;
 }
 
@@ -258,4 +305,14 @@ void XWalkPermissionManager::UnsubscribePermissionStatusChange(
     int subscription_id) {
 }
 
+void XWalkPermissionManager::SetPromptForTesting(
+    const PromptCallback& prompt) {
+  prompt_for_testing_ = prompt;
+}
+
+void XWalkPermissionManager::SetClockForTesting(
+    std::unique_ptr<base::TickClock> clock) {
+  decision_cache_.SetClockForTesting(std::move(clock));
+}
+
 }  // namespace xwalk
@@ -6,25 +6,42 @@
 #ifndef XWALK_RUNTIME_BROWSER_XWALK_PERMISSION_MANAGER_H_
 #define XWALK_RUNTIME_BROWSER_XWALK_PERMISSION_MANAGER_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
-#include "base/callback_forward.h"
+#include "base/callback.h"
 #include "base/id_map.h"
 #include "base/macros.h"
 #include "base/memory/weak_ptr.h"
 #include "content/public/browser/permission_manager.h"
+#include "xwalk/runtime/browser/permission_decision_cache.h"
 #include "xwalk/runtime/browser/runtime_geolocation_permission_context.h"
 #include "xwalk/runtime/browser/runtime_notification_permission_context.h"
 
+namespace base {
+class TickClock;
+}
+
 namespace xwalk {
 
 namespace application {
 class ApplicationService;
 }
 
+// Answers the permission requests with prompts. The answer to a prompt is
+// reused for the identical requests made within a short burst, see
+// kPermissionDecisionTTL: a permission can be revoked outside of this class,
+// e.g. in the Android geolocation permissions or by the embedder, so it is
+// asked again afterwards.
 class XWalkPermissionManager : public content::PermissionManager {
  public:
+  // Shows a prompt for |permission| and runs |callback| with its answer.
+  using PromptCallback = base::Callback<void(
+      content::PermissionType permission,
+      const GURL& requesting_origin,
+      const base::Callback<void(bool)>& callback)>;
+
   XWalkPermissionManager(
       application::ApplicationService* application_service);
   ~XWalkPermissionManager() override;
@@ -62,6 +79,10 @@ class XWalkPermissionManager : public content::PermissionManager {
       override;
   void UnsubscribePermissionStatusChange(int subscription_id) override;
 
+  // Replaces the prompts of the permission contexts.
+  void SetPromptForTesting(const PromptCallback& prompt);
+  void SetClockForTesting(std::unique_ptr<base::TickClock> clock);
+
  private:
   struct PendingRequest;
   using PendingRequestsMap = IDMap<PendingRequest, IDMapOwnPointer>;
@@ -69,18 +90,20 @@ class XWalkPermissionManager : public content::PermissionManager {
   void GetApplicationName(
       content::RenderFrameHost* render_frame_host,
       std::string* name);
-  static void OnRequestResponse(
-      const base::WeakPtr<XWalkPermissionManager>& manager,
-      int request_id,
-      const base::Callback<void(blink::mojom::PermissionStatus)>& callback,
-      bool allowed);
+  // Shows the prompt answering all the requests for |key|.
+  void ShowPrompt(const PermissionDecisionCache::Key& key,
+                  content::RenderFrameHost* render_frame_host);
+  void OnRequestResponse(const PermissionDecisionCache::Key& key,
+                         bool allowed);
 
   PendingRequestsMap pending_requests_;
+  PermissionDecisionCache decision_cache_;
   scoped_refptr<RuntimeGeolocationPermissionContext>
       geolocation_permission_context_;
   scoped_refptr<RuntimeNotificationPermissionContext>
       notification_permission_context_;
   application::ApplicationService* application_service_;
+  PromptCallback prompt_for_testing_;
   base::WeakPtrFactory<XWalkPermissionManager> weak_ptr_factory_;
   DISALLOW_COPY_AND_ASSIGN(XWalkPermissionManager);
 };
@@ -0,0 +1,123 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/browser/xwalk_permission_manager.h"
+
+#include <memory>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/memory/ptr_util.h"
+#include "base/test/simple_test_tick_clock.h"
+#include "content/public/browser/permission_type.h"
+#include "content/public/test/test_renderer_host.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using blink::mojom::PermissionStatus;
+using content::PermissionType;
+
+namespace xwalk {
+
+namespace {
+
+const char kOrigin[] = "https://www.example.com/";
+
+void AppendStatus(std::vector<PermissionStatus>* statuses,
+                  PermissionStatus status) {
+  statuses->push_back(status);
+}
+
+}  // namespace
+
+class XWalkPermissionManagerTest : public content::RenderViewHostTestHarness {
+ protected:
+  void SetUp() override {
+    content::RenderViewHostTestHarness::SetUp();
+    NavigateAndCommit(GURL(kOrigin));
+
+    manager_.reset(new XWalkPermissionManager(nullptr));
+    manager_->SetPromptForTesting(base::Bind(
+        &XWalkPermissionManagerTest::ShowPrompt, base::Unretained(this)));
+    clock_ = new base::SimpleTestTickClock;
+    manager_->SetClockForTesting(base::WrapUnique(clock_));
+  }
+
+  void TearDown() override {
+    manager_.reset();
+    content::RenderViewHostTestHarness::TearDown();
+  }
+
+  void ShowPrompt(PermissionType permission,
+                  const GURL& requesting_origin,
+                  const base::Callback<void(bool)>& callback) {
+    prompts_.push_back(callback);
+  }
+
+  void RequestGeolocation() {
+    manager_->RequestPermission(
+        PermissionType::GEOLOCATION, main_rfh(), GURL(kOrigin),
+        base::Bind(&AppendStatus, &statuses_));
+  }
+
+  PermissionStatus GetGeolocationStatus() {
+    return manager_->GetPermissionStatus(
+        PermissionType::GEOLOCATION, GURL(kOrigin), GURL(kOrigin));
+  }
+
+  std::unique_ptr<XWalkPermissionManager> manager_;
+  // Owned by |manager_|.
+  base::SimpleTestTickClock* clock_;
+  std::vector<base::Callback<void(bool)>> prompts_;
+  std::vector<PermissionStatus> statuses_;
+};
+
+TEST_F(XWalkPermissionManagerTest, BurstSharesAPrompt) {
+  RequestGeolocation();
+  RequestGeolocation();
+  ASSERT_EQ(1u, prompts_.size());
+  EXPECT_TRUE(statuses_.empty());
+
+  prompts_[0].Run(true);
+  ASSERT_EQ(2u, statuses_.size());
+  EXPECT_EQ(PermissionStatus::GRANTED, statuses_[0]);
+  EXPECT_EQ(PermissionStatus::GRANTED, statuses_[1]);
+
+  // The requests right after the answer are part of the same burst.
+  RequestGeolocation();
+  EXPECT_EQ(1u, prompts_.size());
+  ASSERT_EQ(3u, statuses_.size());
+  EXPECT_EQ(PermissionStatus::GRANTED, statuses_[2]);
+  EXPECT_EQ(PermissionStatus::GRANTED, GetGeolocationStatus());
+}
+
+TEST_F(XWalkPermissionManagerTest, GrantIsNotReusedAfterTheBurst) {
+  RequestGeolocation();
+  ASSERT_EQ(1u, prompts_.size());
+  prompts_[0].Run(true);
+
+  // The permission may have been revoked since, so the next request asks
+  // again and gets the new answer.
+  clock_->Advance(base::TimeDelta::FromSeconds(1));
+  EXPECT_EQ(PermissionStatus::DENIED, GetGeolocationStatus());
+  RequestGeolocation();
+  ASSERT_EQ(2u, prompts_.size());
+  prompts_[1].Run(false);
+  ASSERT_EQ(2u, statuses_.size());
+  EXPECT_EQ(PermissionStatus::DENIED, statuses_[1]);
+}
+
+TEST_F(XWalkPermissionManagerTest, ResetPermission) {
+  RequestGeolocation();
+  ASSERT_EQ(1u, prompts_.size());
+  prompts_[0].Run(true);
+
+  manager_->ResetPermission(PermissionType::GEOLOCATION, GURL(kOrigin),
+                            GURL(kOrigin));
+  EXPECT_EQ(PermissionStatus::DENIED, GetGeolocationStatus());
+  RequestGeolocation();
+  EXPECT_EQ(2u, prompts_.size());
+  EXPECT_EQ(1u, statuses_.size());
+}
+
+}  // namespace xwalk
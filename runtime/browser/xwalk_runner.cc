@@ -84,6 +84,7 @@ void XWalkRunner::PreMainMessageLoopRun() {
 }
 
 void XWalkRunner::PostMainMessageLoopRun() {
+  app_extension_bridge_->SetApplicationSystem(NULL);
   DestroyComponents();
   extension_service_.reset();
   browser_context_.reset();
@@ -0,0 +1,396 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/common/async_log_sink.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/time/time.h"
+
+namespace logging {
+
+namespace {
+
+// How long the writer sleeps between two drains when nobody wakes it up.
+const int kDrainIntervalMs = 100;
+
+// A record is written into a ring as a RingRecordHeader followed by the file
+// name and the formatted message, padded to a multiple of the header size.
+struct RingRecordHeader {
+  uint32_t size;  // Whole record, including the header and the padding.
+  int32_t severity;
+  int32_t line;
+  uint32_t file_length;
+  uint32_t str_length;
+  uint32_t message_start;
+  int64_t time;
+};
+
+const size_t kRecordAlignment = sizeof(RingRecordHeader);
+static_assert((kRecordAlignment & (kRecordAlignment - 1)) == 0,
+              "Ring records must have a power of two alignment");
+
+// Marks the end of the ring when a record did not fit before wrapping.
+const int32_t kPaddingRecord = -1000;
+
+AsyncLogSink* g_installed_sink = nullptr;
+bool g_echo_errors = false;
+
+bool AsyncLogMessageHandler(int severity,
+                            const char* file,
+                            int line,
+                            size_t message_start,
+                            const std::string& str) {
+  AsyncLogSink* sink = g_installed_sink;
+  if (!sink)
+    return false;
+
+  sink->Enqueue(severity, file, line, message_start, str);
+  if (severity >= LOG_FATAL) {
+    // The process is about to die, make sure the message is on disk.
+    sink->Flush();
+  }
+
+  // Returning false lets base logging output the message as well, i.e. to
+  // stderr since the log file is handled here.
+  return !(g_echo_errors && severity >= LOG_ERROR);
+}
+
+}  // namespace
+
+const char AsyncLogSink::kBinaryLogMagic[] = "XWLOG001";
+
+// Written as is, so it must have the same layout on every ABI.
+static_assert(sizeof(AsyncLogSink::BinaryRecordHeader) == 32,
+              "BinaryRecordHeader must have no implicit padding");
+
+// Single-producer/single-consumer byte ring. The producer is the thread
+// owning the ring, the consumer is whoever holds AsyncLogSink::drain_lock_.
+// |head_| and |tail_| are free running offsets, only their difference
+// modulo the capacity is meaningful.
+class AsyncLogSink::RingBuffer {
+ public:
+  explicit RingBuffer(uint32_t thread_id)
+      : thread_id_(thread_id),
+        head_(0),
+        tail_(0),
+        dropped_(0),
+        orphaned_(0) {
+    static_assert((kRingCapacity & (kRingCapacity - 1)) == 0,
+                  "Ring capacity must be a power of two");
+  }
+
+  // Producer side.
+  bool Write(int severity,
+             const char* file,
+             int line,
+             size_t message_start,
+             const std::string& str) {
+    size_t file_length = file ? strlen(file) : 0;
+    size_t str_length = str.size();
+    // A single record may not take more than half of the ring.
+    const size_t max_payload = kRingCapacity / 2 - sizeof(RingRecordHeader);
+    file_length = std::min(file_length, max_payload / 4);
+    str_length = std::min(str_length, max_payload - file_length);
+
+    uint32_t size = AlignRecord(
+        sizeof(RingRecordHeader) + file_length + str_length);
+
+    uint32_t head = static_cast<uint32_t>(base::subtle::NoBarrier_Load(&head_));
+    uint32_t tail = static_cast<uint32_t>(base::subtle::Acquire_Load(&tail_));
+    uint32_t offset = head & (kRingCapacity - 1);
+    uint32_t contiguous = kRingCapacity - offset;
+    uint32_t needed = size <= contiguous ? size : contiguous + size;
+    if (kRingCapacity - (head - tail) < needed) {
+      base::subtle::NoBarrier_AtomicIncrement(&dropped_, 1);
+      return false;
+    }
+
+    if (size > contiguous) {
+      RingRecordHeader* padding =
+          reinterpret_cast<RingRecordHeader*>(buffer_ + offset);
+      padding->size = contiguous;
+      padding->severity = kPaddingRecord;
+      head += contiguous;
+      offset = 0;
+    }
+
+    RingRecordHeader* header =
+        reinterpret_cast<RingRecordHeader*>(buffer_ + offset);
+    header->size = size;
+    header->severity = severity;
+    header->line = line;
+    header->file_length = static_cast<uint32_t>(file_length);
+    header->str_length = static_cast<uint32_t>(str_length);
+    header->message_start = static_cast<uint32_t>(
+        std::min(message_start, str_length));
+    header->time = base::Time::Now().ToInternalValue();
+    char* payload = buffer_ + offset + sizeof(RingRecordHeader);
+    memcpy(payload, file, file_length);
+    memcpy(payload + file_length, str.data(), str_length);
+
+    base::subtle::Release_Store(&head_,
+                                static_cast<base::subtle::Atomic32>(
+                                    head + size));
+    return true;
+  }
+
+  // Consumer side. Calls |sink|->AppendRecord() for every pending record.
+  void Drain(AsyncLogSink* sink) {
+    uint32_t head = static_cast<uint32_t>(base::subtle::Acquire_Load(&head_));
+    uint32_t tail = static_cast<uint32_t>(base::subtle::NoBarrier_Load(&tail_));
+    while (tail != head) {
+      const char* record = buffer_ + (tail & (kRingCapacity - 1));
+      const RingRecordHeader* header =
+          reinterpret_cast<const RingRecordHeader*>(record);
+      if (header->severity != kPaddingRecord)
+        sink->AppendRecord(record, header->size, thread_id_);
+      tail += header->size;
+    }
+    base::subtle::Release_Store(&tail_,
+                                static_cast<base::subtle::Atomic32>(tail));
+  }
+
+  uint32_t dropped() const {
+    return static_cast<uint32_t>(base::subtle::NoBarrier_Load(&dropped_));
+  }
+
+  void set_orphaned() { base::subtle::Release_Store(&orphaned_, 1); }
+  bool orphaned() const { return base::subtle::Acquire_Load(&orphaned_); }
+
+ private:
+  static uint32_t AlignRecord(size_t size) {
+    return static_cast<uint32_t>(
+        (size + kRecordAlignment - 1) & ~(kRecordAlignment - 1));
+  }
+
+  uint32_t thread_id_;
+  base::subtle::Atomic32 head_;
+  base::subtle::Atomic32 tail_;
+  base::subtle::Atomic32 dropped_;
+  base::subtle::Atomic32 orphaned_;
+  alignas(RingRecordHeader) char buffer_[kRingCapacity];
+
+  DISALLOW_COPY_AND_ASSIGN(RingBuffer);
+};
+
+AsyncLogSink::AsyncLogSink(const base::FilePath& log_path,
+                           Format format,
+                           OldFileDeletionState delete_old)
+    : log_path_(log_path),
+      format_(format),
+      delete_old_(delete_old),
+      retired_dropped_(0),
+      ring_slot_(&AsyncLogSink::OnThreadExit),
+      stopping_(0),
+      wake_up_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+               base::WaitableEvent::InitialState::NOT_SIGNALED),
+      started_(false),
+      reported_dropped_(0),
+      written_(0) {
+}
+
+AsyncLogSink::~AsyncLogSink() {
+  if (g_installed_sink == this)
+    Install(nullptr, false);
+  Stop();
+  for (size_t i = 0; i < rings_.size(); ++i)
+    delete rings_[i];
+}
+
+bool AsyncLogSink::Start() {
+  DCHECK(!started_);
+  uint32_t flags = base::File::FLAG_WRITE;
+  flags |= delete_old_ == DELETE_OLD_LOG_FILE ?
+      base::File::FLAG_CREATE_ALWAYS :
+      base::File::FLAG_OPEN_ALWAYS | base::File::FLAG_APPEND;
+  file_.Initialize(log_path_, flags);
+  if (!file_.IsValid())
+    return false;
+
+  if (format_ == FORMAT_BINARY && file_.GetLength() == 0)
+    file_.WriteAtCurrentPos(kBinaryLogMagic, strlen(kBinaryLogMagic));
+
+  if (!base::PlatformThread::Create(0, this, &writer_thread_))
+    return false;
+  started_ = true;
+  return true;
+}
+
+void AsyncLogSink::Stop() {
+  if (!started_)
+    return;
+
+  base::subtle::Release_Store(&stopping_, 1);
+  wake_up_.Signal();
+  base::PlatformThread::Join(writer_thread_);
+  started_ = false;
+  // Pick up anything logged while the writer was exiting.
+  Drain();
+}
+
+bool AsyncLogSink::Enqueue(int severity,
+                           const char* file,
+                           int line,
+                           size_t message_start,
+                           const std::string& str) {
+  return GetRingForCurrentThread()->Write(
+      severity, file, line, message_start, str);
+}
+
+void AsyncLogSink::Flush() {
+  Drain();
+}
+
+uint64_t AsyncLogSink::dropped_count() const {
+  base::AutoLock lock(const_cast<base::Lock&>(rings_lock_));
+  uint64_t dropped = retired_dropped_;
+  for (size_t i = 0; i < rings_.size(); ++i)
+    dropped += rings_[i]->dropped();
+  return dropped;
+}
+
+uint64_t AsyncLogSink::written_count() const {
+  base::AutoLock lock(const_cast<base::Lock&>(drain_lock_));
+  return written_;
+}
+
+// static
+void AsyncLogSink::Install(AsyncLogSink* sink, bool echo_errors) {
+  g_echo_errors = echo_errors;
+  g_installed_sink = sink;
+  SetLogMessageHandler(sink ? &AsyncLogMessageHandler : nullptr);
+}
+
+// static
+AsyncLogSink* AsyncLogSink::GetInstalled() {
+  return g_installed_sink;
+}
+
+void AsyncLogSink::ThreadMain() {
+  base::PlatformThread::SetName("XWalkAsyncLog");
+  while (!base::subtle::Acquire_Load(&stopping_)) {
+    wake_up_.TimedWait(base::TimeDelta::FromMilliseconds(kDrainIntervalMs));
+    Drain();
+  }
+}
+
+AsyncLogSink::RingBuffer* AsyncLogSink::GetRingForCurrentThread() {
+  RingBuffer* ring = static_cast<RingBuffer*>(ring_slot_.Get());
+  if (ring)
+    return ring;
+
+  ring = new RingBuffer(
+      static_cast<uint32_t>(base::PlatformThread::CurrentId()));
+  {
+    base::AutoLock lock(rings_lock_);
+    rings_.push_back(ring);
+  }
+  ring_slot_.Set(ring);
+  return ring;
+}
+
+// static
+void AsyncLogSink::OnThreadExit(void* ring) {
+  // The writer frees the ring once it has been drained.
+  static_cast<RingBuffer*>(ring)->set_orphaned();
+}
+
+void AsyncLogSink::Drain() {
+  base::AutoLock drain_lock(drain_lock_);
+
+  std::vector<RingBuffer*> rings;
+  uint64_t dropped = 0;
+  {
+    base::AutoLock lock(rings_lock_);
+    rings = rings_;
+    dropped = retired_dropped_;
+  }
+
+  std::vector<RingBuffer*> finished;
+  for (size_t i = 0; i < rings.size(); ++i) {
+    // Check orphaned before draining: once set, the owning thread is gone
+    // and the ring can not be written anymore.
+    bool orphaned = rings[i]->orphaned();
+    rings[i]->Drain(this);
+    dropped += rings[i]->dropped();
+    if (orphaned)
+      finished.push_back(rings[i]);
+  }
+
+  if (dropped > reported_dropped_) {
+    AppendDroppedReport(dropped - reported_dropped_);
+    reported_dropped_ = dropped;
+  }
+
+  if (!write_buffer_.empty() && file_.IsValid()) {
+    file_.WriteAtCurrentPos(write_buffer_.data(),
+                            static_cast<int>(write_buffer_.size()));
+  }
+  write_buffer_.clear();
+
+  if (finished.empty())
+    return;
+
+  base::AutoLock lock(rings_lock_);
+  for (size_t i = 0; i < finished.size(); ++i) {
+    retired_dropped_ += finished[i]->dropped();
+    rings_.erase(std::find(rings_.begin(), rings_.end(), finished[i]));
+    delete finished[i];
+  }
+}
+
+void AsyncLogSink::AppendRecord(const char* record,
+                                size_t size,
+                                uint32_t thread_id) {
+  const RingRecordHeader* header =
+      reinterpret_cast<const RingRecordHeader*>(record);
+  const char* file = record + sizeof(RingRecordHeader);
+  const char* str = file + header->file_length;
+  ++written_;
+
+  if (format_ == FORMAT_TEXT) {
+    write_buffer_.append(str, header->str_length);
+    if (!header->str_length || str[header->str_length - 1] != '\n')
+      write_buffer_.push_back('\n');
+    return;
+  }
+
+  BinaryRecordHeader binary = {};
+  binary.time = header->time;
+  binary.thread_id = thread_id;
+  binary.severity = header->severity;
+  binary.line = header->line;
+  binary.file_length = header->file_length;
+  binary.message_length = header->str_length - header->message_start;
+  write_buffer_.append(reinterpret_cast<const char*>(&binary), sizeof(binary));
+  write_buffer_.append(file, header->file_length);
+  write_buffer_.append(str + header->message_start, binary.message_length);
+}
+
+void AsyncLogSink::AppendDroppedReport(uint64_t count) {
+  if (format_ == FORMAT_TEXT) {
+    write_buffer_.append(base::StringPrintf(
+        "[AsyncLogSink] %llu log messages dropped\n",
+        static_cast<unsigned long long>(count)));
+    return;
+  }
+
+  std::string message = base::Uint64ToString(count);
+  BinaryRecordHeader binary = {};
+  binary.time = base::Time::Now().ToInternalValue();
+  binary.thread_id = 0;
+  binary.severity = kDroppedMessagesSeverity;
+  binary.line = 0;
+  binary.file_length = 0;
+  binary.message_length = static_cast<uint32_t>(message.size());
+  write_buffer_.append(reinterpret_cast<const char*>(&binary), sizeof(binary));
+  write_buffer_.append(message);
+}
+
+}  // namespace logging
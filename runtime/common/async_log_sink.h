@@ -0,0 +1,143 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_RUNTIME_COMMON_ASYNC_LOG_SINK_H_
+#define XWALK_RUNTIME_COMMON_ASYNC_LOG_SINK_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread_local_storage.h"
+
+namespace logging {
+
+// AsyncLogSink takes log messages off the logging thread. Every thread that
+// logs gets its own single-producer/single-consumer ring buffer, so emitting
+// a message only costs a copy into thread-local memory, with no lock and no
+// file IO. A background writer thread drains all the rings into the log file.
+//
+// The memory is bounded: when a ring is full the message is dropped and a
+// counter is incremented. The writer reports the number of dropped messages
+// in the log itself, in both formats.
+//
+// In FORMAT_BINARY the file starts with kBinaryLogMagic and holds a sequence
+// of records laid out as:
+//   BinaryRecordHeader
+//   file name (file_length bytes, not NUL terminated)
+//   message (message_length bytes, without the base logging prefix)
+// Dropped messages are reported by a record of severity
+// kDroppedMessagesSeverity, with no file name, whose message is the number
+// of messages dropped since the previous report, in decimal.
+class AsyncLogSink : public base::PlatformThread::Delegate {
+ public:
+  enum Format {
+    FORMAT_TEXT,
+    FORMAT_BINARY,
+  };
+
+  struct BinaryRecordHeader {
+    int64_t time;  // base::Time internal value.
+    uint32_t thread_id;
+    int32_t severity;
+    int32_t line;
+    uint32_t file_length;
+    uint32_t message_length;
+    uint32_t reserved;  // Zero. Makes the padding explicit.
+  };
+
+  static const char kBinaryLogMagic[];
+  // Below the severities of base logging, VLOG levels included.
+  static const int32_t kDroppedMessagesSeverity = -1001;
+
+  // Size of the ring buffer allocated for each logging thread.
+  static const size_t kRingCapacity = 64 * 1024;
+
+  AsyncLogSink(const base::FilePath& log_path,
+               Format format,
+               OldFileDeletionState delete_old);
+  ~AsyncLogSink() override;
+
+  // Opens the log file and starts the writer thread.
+  bool Start();
+  // Drains everything that was logged so far and stops the writer thread.
+  void Stop();
+
+  // Copies the message into the calling thread's ring. Returns false if the
+  // message had to be dropped. |str| is the message as formatted by base
+  // logging; the prefix ends at |message_start|.
+  bool Enqueue(int severity,
+               const char* file,
+               int line,
+               size_t message_start,
+               const std::string& str);
+
+  // Synchronously writes everything enqueued so far to the file.
+  void Flush();
+
+  uint64_t dropped_count() const;
+  uint64_t written_count() const;
+
+  // Installs |sink| as the log message handler of base logging. Messages of
+  // severity ERROR and above are also handed back to base logging when
+  // |echo_errors| is true, so they still show up on stderr. Pass NULL to
+  // uninstall.
+  static void Install(AsyncLogSink* sink, bool echo_errors);
+  static AsyncLogSink* GetInstalled();
+
+  // base::PlatformThread::Delegate implementation.
+  void ThreadMain() override;
+
+ private:
+  class RingBuffer;
+
+  RingBuffer* GetRingForCurrentThread();
+  // Drains the rings into the file. Only one drain runs at a time.
+  void Drain();
+  void AppendRecord(const char* record, size_t size, uint32_t thread_id);
+  void AppendDroppedReport(uint64_t count);
+
+  static void OnThreadExit(void* ring);
+
+  base::FilePath log_path_;
+  Format format_;
+  OldFileDeletionState delete_old_;
+  base::File file_;
+
+  // Lock-free on the logging path: rings are only registered here, once per
+  // thread.
+  base::Lock rings_lock_;
+  std::vector<RingBuffer*> rings_;
+  // Messages dropped by threads which have exited since.
+  uint64_t retired_dropped_;
+  base::ThreadLocalStorage::Slot ring_slot_;
+
+  // Serializes the consumers (the writer thread and Flush()).
+  base::Lock drain_lock_;
+  std::string write_buffer_;
+
+  base::subtle::Atomic32 stopping_;
+  base::WaitableEvent wake_up_;
+  base::PlatformThreadHandle writer_thread_;
+  bool started_;
+
+  // Guarded by |drain_lock_|.
+  uint64_t reported_dropped_;
+  uint64_t written_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncLogSink);
+};
+
+}  // namespace logging
+
+#endif  // XWALK_RUNTIME_COMMON_ASYNC_LOG_SINK_H_
@@ -0,0 +1,191 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/runtime/common/async_log_sink.h"
+
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "base/threading/simple_thread.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using logging::AsyncLogSink;
+
+namespace {
+
+class LoggingThread : public base::SimpleThread {
+ public:
+  LoggingThread(AsyncLogSink* sink, int count)
+      : base::SimpleThread("LoggingThread"),
+        sink_(sink),
+        count_(count) {}
+
+  void Run() override {
+    for (int i = 0; i < count_; ++i) {
+      sink_->Enqueue(logging::LOG_INFO, __FILE__, __LINE__, 0,
+                     "message " + base::IntToString(i) + "\n");
+    }
+  }
+
+ private:
+  AsyncLogSink* sink_;
+  int count_;
+};
+
+}  // namespace
+
+class AsyncLogSinkTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    log_path_ = temp_dir_.path().AppendASCII("test.log");
+  }
+
+  std::string ReadLog() {
+    std::string content;
+    EXPECT_TRUE(base::ReadFileToString(log_path_, &content));
+    return content;
+  }
+
+  base::ScopedTempDir temp_dir_;
+  base::FilePath log_path_;
+};
+
+TEST_F(AsyncLogSinkTest, WritesTextRecords) {
+  AsyncLogSink sink(log_path_, AsyncLogSink::FORMAT_TEXT,
+                    logging::DELETE_OLD_LOG_FILE);
+  ASSERT_TRUE(sink.Start());
+  sink.Enqueue(logging::LOG_INFO, __FILE__, __LINE__, 0, "first\n");
+  sink.Enqueue(logging::LOG_ERROR, __FILE__, __LINE__, 0, "second");
+  sink.Stop();
+
+  EXPECT_EQ("first\nsecond\n", ReadLog());
+  EXPECT_EQ(2u, sink.written_count());
+  EXPECT_EQ(0u, sink.dropped_count());
+}
+
+TEST_F(AsyncLogSinkTest, WritesBinaryRecords) {
+  AsyncLogSink sink(log_path_, AsyncLogSink::FORMAT_BINARY,
+                    logging::DELETE_OLD_LOG_FILE);
+  ASSERT_TRUE(sink.Start());
+  const std::string prefix = "[prefix] ";
+  sink.Enqueue(logging::LOG_WARNING, "file.cc", 42, prefix.size(),
+               prefix + "payload");
+  sink.Stop();
+
+  std::string content = ReadLog();
+  size_t magic_length = strlen(AsyncLogSink::kBinaryLogMagic);
+  ASSERT_GE(content.size(), magic_length + sizeof(
+      AsyncLogSink::BinaryRecordHeader));
+  EXPECT_TRUE(base::StartsWith(content, AsyncLogSink::kBinaryLogMagic,
+                               base::CompareCase::SENSITIVE));
+
+  AsyncLogSink::BinaryRecordHeader header;
+  memcpy(&header, content.data() + magic_length, sizeof(header));
+  EXPECT_EQ(logging::LOG_WARNING, header.severity);
+  EXPECT_EQ(42, header.line);
+  ASSERT_EQ(7u, header.file_length);
+  ASSERT_EQ(7u, header.message_length);
+  EXPECT_EQ("file.ccpayload",
+            content.substr(magic_length + sizeof(header)));
+}
+
+TEST_F(AsyncLogSinkTest, DropsWhenRingIsFull) {
+  // Without a writer thread nothing drains the ring.
+  AsyncLogSink sink(log_path_, AsyncLogSink::FORMAT_TEXT,
+                    logging::DELETE_OLD_LOG_FILE);
+  const std::string message(1024, 'x');
+  int accepted = 0;
+  for (size_t i = 0; i < 2 * AsyncLogSink::kRingCapacity / message.size();
+       ++i) {
+    if (sink.Enqueue(logging::LOG_INFO, __FILE__, __LINE__, 0, message))
+      ++accepted;
+  }
+
+  EXPECT_GT(accepted, 0);
+  EXPECT_LT(static_cast<size_t>(accepted),
+            AsyncLogSink::kRingCapacity / message.size());
+  EXPECT_GT(sink.dropped_count(), 0u);
+}
+
+TEST_F(AsyncLogSinkTest, ReportsBinaryDrops) {
+  AsyncLogSink sink(log_path_, AsyncLogSink::FORMAT_BINARY,
+                    logging::DELETE_OLD_LOG_FILE);
+  // The ring is filled before the writer starts, so that some messages are
+  // dropped.
+  const std::string message(1024, 'x');
+  for (size_t i = 0; i < 2 * AsyncLogSink::kRingCapacity / message.size();
+       ++i)
+    sink.Enqueue(logging::LOG_INFO, "file.cc", 1, 0, message);
+  ASSERT_GT(sink.dropped_count(), 0u);
+  ASSERT_TRUE(sink.Start());
+  sink.Stop();
+
+  std::string content = ReadLog();
+  size_t offset = strlen(AsyncLogSink::kBinaryLogMagic);
+  uint64_t records = 0;
+  uint64_t reported = 0;
+  while (offset < content.size()) {
+    AsyncLogSink::BinaryRecordHeader header;
+    ASSERT_LE(offset + sizeof(header), content.size());
+    memcpy(&header, content.data() + offset, sizeof(header));
+    offset += sizeof(header);
+    ASSERT_LE(offset + header.file_length + header.message_length,
+              content.size());
+    std::string file = content.substr(offset, header.file_length);
+    offset += header.file_length;
+    std::string payload = content.substr(offset, header.message_length);
+    offset += header.message_length;
+
+    if (header.severity != AsyncLogSink::kDroppedMessagesSeverity) {
+      EXPECT_EQ("file.cc", file);
+      EXPECT_EQ(message, payload);
+      ++records;
+      continue;
+    }
+    EXPECT_TRUE(file.empty());
+    uint64_t count;
+    ASSERT_TRUE(base::StringToUint64(payload, &count));
+    reported += count;
+  }
+  EXPECT_EQ(sink.written_count(), records);
+  EXPECT_EQ(sink.dropped_count(), reported);
+}
+
+TEST_F(AsyncLogSinkTest, DrainsManyThreads) {
+  const int kThreads = 8;
+  const int kMessagesPerThread = 200;
+
+  AsyncLogSink sink(log_path_, AsyncLogSink::FORMAT_TEXT,
+                    logging::DELETE_OLD_LOG_FILE);
+  ASSERT_TRUE(sink.Start());
+
+  std::vector<std::unique_ptr<LoggingThread>> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.push_back(
+        std::unique_ptr<LoggingThread>(
+            new LoggingThread(&sink, kMessagesPerThread)));
+    threads.back()->Start();
+  }
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i]->Join();
+  sink.Stop();
+
+  EXPECT_EQ(kThreads * kMessagesPerThread,
+            static_cast<int>(sink.written_count() + sink.dropped_count()));
+
+  std::string content = ReadLog();
+  uint64_t lines = 0;
+  for (size_t pos = content.find("message "); pos != std::string::npos;
+       pos = content.find("message ", pos + 1))
+    ++lines;
+  EXPECT_EQ(sink.written_count(), lines);
+}
@@ -29,6 +29,7 @@
 #include "xwalk/runtime/common/logging_xwalk.h"
 
 #include <fstream>  // NOLINT
+#include <memory>  // NOLINT
 #include <string>  // NOLINT
 
 #include "base/base_switches.h"
@@ -36,6 +37,7 @@
 #include "base/compiler_specific.h"
 #include "base/debug/debugger.h"
 #include "base/debug/dump_without_crashing.h"
+#include "base/debug/leak_annotations.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
 #include "base/path_service.h"
@@ -46,7 +48,9 @@
 #include "base/threading/thread_restrictions.h"
 #include "content/public/common/content_switches.h"
 #include "ipc/ipc_logging.h"
+#include "xwalk/runtime/common/async_log_sink.h"
 #include "xwalk/runtime/common/xwalk_paths.h"
+#include "xwalk/runtime/common/xwalk_switches.h"
 
 #if defined(OS_WIN)
 #include <initguid.h>
@@ -66,6 +70,19 @@ bool xwalk_logging_failed_ = false;
 // InitXwalkLogging() and the beginning of CleanupXwalkLogging().
 bool xwalk_logging_redirected_ = false;
 
+// Set when the log file is written by an AsyncLogSink.
+logging::AsyncLogSink* xwalk_async_log_sink_ = nullptr;
+
+// Only the browser process may spawn the writer thread this early: child
+// processes get here before the sandbox (and the zygote fork) and must stay
+// single-threaded.
+bool ShouldUseAsyncLogging(const base::CommandLine& command_line,
+                           logging::LoggingDestination logging_dest) {
+  return (logging_dest & logging::LOG_TO_FILE) != 0 &&
+      command_line.HasSwitch(switches::kAsyncLogging) &&
+      command_line.GetSwitchValueASCII(switches::kProcessType).empty();
+}
+
 #if defined(OS_WIN)
 // {7FE69228-633E-4f06-80C1-527FEA23E3A7}
 const GUID kXwalkTraceProviderName = {
@@ -123,6 +140,27 @@ void InitXwalkLogging(const base::CommandLine& command_line,
     log_locking_state = DONT_LOCK_LOG_FILE;
   }
 
+  if (ShouldUseAsyncLogging(command_line, logging_dest)) {
+    AsyncLogSink::Format format =
+        command_line.GetSwitchValueASCII(switches::kAsyncLogging) == "binary" ?
+        AsyncLogSink::FORMAT_BINARY : AsyncLogSink::FORMAT_TEXT;
+    std::unique_ptr<AsyncLogSink> sink(
+        new AsyncLogSink(log_path, format, delete_old_log_file));
+    if (sink->Start()) {
+      // The file belongs to the sink now, base logging keeps the other
+      // destinations and never takes the log file lock.
+      xwalk_async_log_sink_ = sink.release();
+      AsyncLogSink::Install(xwalk_async_log_sink_,
+                            (logging_dest & LOG_TO_SYSTEM_DEBUG_LOG) != 0);
+      logging_dest = static_cast<LoggingDestination>(
+          logging_dest & ~LOG_TO_FILE);
+      log_path = base::FilePath();
+      log_locking_state = DONT_LOCK_LOG_FILE;
+    } else {
+      DPLOG(ERROR) << "Unable to start async logging to " << log_path.value();
+    }
+  }
+
   logging::LoggingSettings settings;
   settings.logging_dest = logging_dest;
   settings.log_file = log_path.value().c_str();
@@ -183,6 +221,15 @@ void CleanupXwalkLogging() {
   DCHECK(xwalk_logging_initialized_) <<
       "Attempted to clean up logging when it wasn't initialized.";
 
+  if (xwalk_async_log_sink_) {
+    AsyncLogSink::Install(nullptr, false);
+    xwalk_async_log_sink_->Stop();
+    // Threads which are still running may be inside the message handler or
+    // exit later and touch their ring, so the sink is intentionally leaked.
+    ANNOTATE_LEAKING_OBJECT_PTR(xwalk_async_log_sink_);
+    xwalk_async_log_sink_ = nullptr;
+  }
+
   CloseLogFile();
 
   xwalk_logging_initialized_ = false;
@@ -24,6 +24,9 @@ namespace logging {
 // setting delete_old_log_file, but the renderer processes should not, or
 // they will delete each others' logs.
 //
+// With --async-logging the browser process writes its log file from a
+// background thread, see AsyncLogSink.
+//
 // XXX
 // Setting suppress_error_dialogs to true disables any dialogs that would
 // normally appear for assertions and crashes, and makes any catchable
@@ -10,6 +10,11 @@ namespace switches {
 // Specifies the icon file for the app window.
 const char kAppIcon[] = "app-icon";
 
+// Writes the browser process log file from a background thread instead of
+// the thread emitting the message. Use "binary" as the value to get the
+// compact record format described in async_log_sink.h.
+const char kAsyncLogging[] = "async-logging";
+
 // Disables the usage of Portable Native Client.
 const char kDisablePnacl[] = "disable-pnacl";
 
@@ -51,6 +56,12 @@ const char kAllowRunningInsecureContent[]   = "allow-running-insecure-content";
 // page. This switch overrides this to block this lesser mixed-content problem.
 const char kNoDisplayingInsecureContent[]   = "no-displaying-insecure-content";
 
+// How long, in seconds, the answer to a permission prompt is reused for the
+// same origins. Zero prompts every time. A permission revoked outside of
+// Crosswalk, e.g. in the Android geolocation permissions, is only asked again
+// once the answer expires.
+const char kPermissionDecisionTTL[] = "permission-decision-ttl";
+
 #if defined(ENABLE_PLUGINS)
 // Use the PPAPI (Pepper) Flash found at the given path.
 const char kPpapiFlashPath[] = "ppapi-flash-path";
@@ -69,4 +80,8 @@ const char kUserDataDir[] = "user-data-dir";
 // apps/origins.
 const char kUnlimitedStorage[] = "unlimited-storage";
 
+// Checks the files of an installed package against the hashes recorded when
+// it was extracted before launching it again.
+const char kVerifyInstalledPackages[] = "verify-installed-packages";
+
 }  // namespace switches
@@ -11,6 +11,7 @@
 namespace switches {
 
 extern const char kAppIcon[];
+extern const char kAsyncLogging[];
 extern const char kDisablePnacl[];
 extern const char kDiskCacheSize[];
 extern const char kExperimentalFeatures[];
@@ -23,6 +24,7 @@ extern const char kXWalkDisableSaveFormData[];
 #endif
 extern const char kAllowRunningInsecureContent[];
 extern const char kNoDisplayingInsecureContent[];
+extern const char kPermissionDecisionTTL[];
 
 #if defined(OS_ANDROID)
 extern const char kXWalkProfileName[];
@@ -37,6 +39,8 @@ extern const char kUserDataDir[];
 
 extern const char kUnlimitedStorage[];
 
+extern const char kVerifyInstalledPackages[];
+
 }  // namespace switches
 
 #endif  // XWALK_RUNTIME_COMMON_XWALK_SWITCHES_H_
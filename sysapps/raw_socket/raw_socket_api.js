@@ -13,6 +13,15 @@ internal.setupInternalExtension(extension);
 var common = requireNative('sysapps_common');
 common.setupSysAppsCommon(internal, v8tools);
 
+// Default value of the highWaterMark option, send() starts returning false
+// when more than this amount of bytes is waiting to be sent.
+var DEFAULT_HIGH_WATER_MARK = 65536;
+
+// Size of |data| once converted to UTF-8 by the native side.
+function utf8Length(data) {
+  return unescape(encodeURIComponent(data)).length;
+}
+
 // The ReadyStateObserver is a proxy object that will
 // subscribe to the parent's |readystate| event. An object
 // cannot subscribe to its own events otherwise it will
@@ -23,20 +32,39 @@ var ReadyStateObserver = function(object_id, initial_state) {
   common.EventTarget.call(this);
 
   this._addEvent("readystate");
+  this._addEvent("bufferedamount");
   this.readyState = initial_state;
+  this.sentBytes = 0;
+  this.writtenBytes = 0;
 
   var that = this;
   this.onreadystate = function(event) {
     that.readyState = event.data;
   };
+  this.onbufferedamount = function(event) {
+    that.writtenBytes = event.data;
+  };
 
   this.destructor = function() {
     this.onreadystate = null;
+    this.onbufferedamount = null;
   };
 };
 
 ReadyStateObserver.prototype = new common.EventTargetPrototype();
 
+ReadyStateObserver.prototype.bufferedAmount = function() {
+  return this.sentBytes - this.writtenBytes;
+};
+
+// Accounts for |data| being queued by send() and returns whether the caller
+// can keep sending. When it cannot, a "drain" event will be fired once the
+// native write queue is empty.
+ReadyStateObserver.prototype.queue = function(data, highWaterMark) {
+  this.sentBytes += utf8Length(data);
+  return this.bufferedAmount() < highWaterMark;
+};
+
 // TCPSocket interface.
 //
 // TODO(tmpsantos): We are currently not throwing any exceptions
@@ -63,6 +91,10 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
     options.noDelay = true;
   if (!options.useSecureTransport)
     options.useSecureTransport = false;
+  if (!options.highWaterMark)
+    options.highWaterMark = DEFAULT_HIGH_WATER_MARK;
+  if (!options.batchReads)
+    options.batchReads = false;
 
   this._addMethod("_close");
   this._addMethod("_halfclose");
@@ -77,14 +109,9 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
   this._addEvent("data");
 
   function sendWrapper(data) {
-    this._sendString(data);
-
-    // FIXME(tmpsantos): The spec says that send() should always
-    // return if you can keep sending data. This can only be
-    // verified in the native implementation, which makes this
-    // call sync. We are returning always true here to keep the
-    // implementation async.
-    return true;
+    var canSend = this._readyStateObserver.queue(data, options.highWaterMark);
+    this._sendString(data, !canSend);
+    return canSend;
   };
 
   function closeWrapper(data) {
@@ -148,7 +175,7 @@ var TCPSocket = function(remoteAddress, remotePort, options, object_id) {
       enumerable: true,
     },
     "bufferedAmount": {
-      value: 0,
+      get: function() { return this._readyStateObserver.bufferedAmount(); },
       enumerable: true,
     },
     "readyState": {
@@ -196,22 +223,37 @@ var TCPServerSocket = function(options) {
     options.addressReuse = true;
   if (!options.useSecureTransport)
     options.useSecureTransport = false;
+  if (!options.batchConnections)
+    options.batchConnections = false;
 
   this._addMethod("_close");
   this._addMethod("suspend");
   this._addMethod("resume");
 
-  // FIXME(tmpsantos): Get the real remote IP and port
-  // from the native backend.
-  function ConnectEvent(type, data) {
+  function createConnectedSocket(data) {
     var object_id = data[0];
     var options = data[1];
 
-    this.type = type;
-    this.connectedSocket = new TCPSocket(
+    return new TCPSocket(
         options.localAddress, options.localPort, {}, object_id);
   }
 
+  // FIXME(tmpsantos): Get the real remote IP and port
+  // from the native backend.
+  //
+  // With the batchConnections option a single event carries every
+  // connection accepted in a row in |connectedSockets|, |connectedSocket|
+  // is the first one.
+  function ConnectEvent(type, data) {
+    this.type = type;
+    if (Array.isArray(data[0])) {
+      this.connectedSockets = data.map(createConnectedSocket);
+      this.connectedSocket = this.connectedSockets[0];
+    } else {
+      this.connectedSocket = createConnectedSocket(data);
+    }
+  }
+
   this._addEvent("open");
   this._addEvent("connect", ConnectEvent);
   this._addEvent("error");
@@ -295,15 +337,35 @@ var UDPSocket = function(options) {
     options.addressReuse = true;
   if (!options.loopback)
     options.loopback = false;
+  if (!options.highWaterMark)
+    options.highWaterMark = DEFAULT_HIGH_WATER_MARK;
+  if (!options.batchMessages)
+    options.batchMessages = false;
+  if (!options.receiveBufferSize)
+    options.receiveBufferSize = 0;
+  if (!options.sendBufferSize)
+    options.sendBufferSize = 0;
+  if (!options.multicastTTL)
+    options.multicastTTL = 1;
+  if (!options.broadcast)
+    options.broadcast = false;
 
   this._addMethod("_close");
   this._addMethod("suspend");
   this._addMethod("resume");
-  this._addMethod("joinMulticast");
-  this._addMethod("leaveMulticast");
+  this._addMethodWithPromise("joinMulticast");
+  this._addMethodWithPromise("leaveMulticast");
   this._addMethod("_sendString");
 
+  // With the batchMessages option a single event carries every datagram
+  // received in a row in |messages|, the other attributes describe the
+  // first one.
   function MessageEvent(type, data) {
+    if (Array.isArray(data)) {
+      this.messages = data;
+      data = data[0];
+    }
+
     this.type = type;
     this.data = data.data;
     this.remotePort = data.remotePort;
@@ -316,14 +378,9 @@ var UDPSocket = function(options) {
   this._addEvent("message", MessageEvent);
 
   function sendWrapper(data, remoteAddress, remotePort) {
-    this._sendString(data, remoteAddress, remotePort);
-
-    // FIXME(tmpsantos): The spec says that send() should always
-    // return if you can keep sending data. This can only be
-    // verified in the native implementation, which makes this
-    // call sync. We are returning always true here to keep the
-    // implementation async.
-    return true;
+    var canSend = this._readyStateObserver.queue(data, options.highWaterMark);
+    this._sendString(data, remoteAddress, remotePort, !canSend);
+    return canSend;
   };
 
   function closeWrapper(data) {
@@ -373,8 +430,24 @@ var UDPSocket = function(options) {
       value: options.loopback,
       enumerable: true,
     },
+    "receiveBufferSize": {
+      value: options.receiveBufferSize,
+      enumerable: true,
+    },
+    "sendBufferSize": {
+      value: options.sendBufferSize,
+      enumerable: true,
+    },
+    "multicastTTL": {
+      value: options.multicastTTL,
+      enumerable: true,
+    },
+    "broadcast": {
+      value: options.broadcast,
+      enumerable: true,
+    },
     "bufferedAmount": {
-      value: 0,
+      get: function() { return this._readyStateObserver.bufferedAmount(); },
       enumerable: true,
     },
     "readyState": {
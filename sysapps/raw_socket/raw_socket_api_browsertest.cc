@@ -2,11 +2,16 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include "base/files/file_util.h"
+#include "base/json/string_escape.h"
 #include "base/path_service.h"
 #include "base/strings/utf_string_conversions.h"
 #include "content/public/test/browser_test_utils.h"
 #include "content/public/test/test_utils.h"
 #include "net/base/filename_util.h"
+#include "net/cert/test_root_certs.h"
+#include "net/test/cert_test_util.h"
+#include "net/test/test_data_directory.h"
 #include "xwalk/extensions/browser/xwalk_extension_service.h"
 #include "xwalk/extensions/common/xwalk_extension.h"
 #include "xwalk/runtime/browser/runtime.h"
@@ -25,12 +30,16 @@ class SysAppsRawSocketTestInstance : public XWalkExtensionInstance {
   void HandleMessage(std::unique_ptr<base::Value> msg) override {}
 };
 
+// Also hands the page the certificate and the key of the TLS server.
 class SysAppsRawSocketTestExtension : public XWalkExtension {
  public:
-  SysAppsRawSocketTestExtension() {
+  explicit SysAppsRawSocketTestExtension(
+      const std::string& certificate_and_key) {
     set_name("sysapps_raw_socket_test");
     set_javascript_api(
-        "exports.v8tools = requireNative('v8tools');");
+        "exports.v8tools = requireNative('v8tools');"
+        "exports.tlsCertificateAndKey = " +
+        base::GetQuotedJSONString(certificate_and_key) + ";");
   }
 
   XWalkExtensionInstance* CreateInstance() override {
@@ -41,6 +50,16 @@ class SysAppsRawSocketTestExtension : public XWalkExtension {
 class SysAppsRawSocketTest : public InProcessBrowserTest {
  public:
   void SetUp() override {
+    // The certificate is issued for 127.0.0.1 by the test root, which the
+    // TLS clients have to trust.
+    base::FilePath certs_dir = net::GetTestCertsDirectory();
+    ASSERT_TRUE(base::ReadFileToString(certs_dir.AppendASCII("ok_cert.pem"),
+                                       &certificate_and_key_));
+    scoped_refptr<net::X509Certificate> root =
+        net::ImportCertFromFile(certs_dir, "root_ca_cert.pem");
+    ASSERT_TRUE(root.get());
+    test_root_.reset(new net::ScopedTestRoot(root.get()));
+
     XWalkExtensionService::SetCreateUIThreadExtensionsCallbackForTesting(
         base::Bind(&SysAppsRawSocketTest::CreateExtensions,
                    base::Unretained(this)));
@@ -48,8 +67,13 @@ class SysAppsRawSocketTest : public InProcessBrowserTest {
   }
 
   void CreateExtensions(XWalkExtensionVector* extensions) {
-    extensions->push_back(new SysAppsRawSocketTestExtension);
+    extensions->push_back(
+        new SysAppsRawSocketTestExtension(certificate_and_key_));
   }
+
+ private:
+  std::string certificate_and_key_;
+  std::unique_ptr<net::ScopedTestRoot> test_root_;
 };
 
 }  // namespace
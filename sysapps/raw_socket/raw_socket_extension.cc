@@ -75,7 +75,7 @@ void RawSocketInstance::OnTCPSocketConstructor(
     return;
   }
 
-  std::unique_ptr<BindingObject> obj(new TCPSocketObject);
+  std::unique_ptr<BindingObject> obj(new TCPSocketObject(&secure_transport_));
   store_.AddBindingObject(params->object_id, std::move(obj));
 }
 
@@ -8,6 +8,7 @@
 #include <string>
 #include "base/values.h"
 #include "xwalk/sysapps/common/binding_object_store.h"
+#include "xwalk/sysapps/raw_socket/secure_transport.h"
 
 namespace xwalk {
 namespace sysapps {
@@ -43,6 +44,8 @@ class RawSocketInstance : public XWalkExtensionInstance {
   void OnUDPSocketConstructor(std::unique_ptr<XWalkExtensionFunctionInfo> info);
 
   XWalkExtensionFunctionHandler handler_;
+  // Declared before |store_|, the sockets use it until they are destroyed.
+  SecureTransportContext secure_transport_;
   BindingObjectStore store_;
 };
 
@@ -0,0 +1,45 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/read_buffer_sizer.h"
+
+#include <algorithm>
+
+namespace {
+
+// Number of consecutive small reads before the buffer shrinks.
+const int kShrinkThreshold = 8;
+
+}  // namespace
+
+namespace xwalk {
+namespace sysapps {
+
+const int ReadBufferSizer::kMinSize;
+const int ReadBufferSizer::kMaxSize;
+
+ReadBufferSizer::ReadBufferSizer()
+    : size_(kMinSize),
+      small_reads_(0) {}
+
+void ReadBufferSizer::DidRead(int bytes_read, int buffer_size) {
+  if (bytes_read >= buffer_size) {
+    size_ = std::min(size_ * 2, kMaxSize);
+    small_reads_ = 0;
+    return;
+  }
+
+  if (bytes_read >= size_ / 4) {
+    small_reads_ = 0;
+    return;
+  }
+
+  if (++small_reads_ >= kShrinkThreshold) {
+    size_ = std::max(size_ / 2, kMinSize);
+    small_reads_ = 0;
+  }
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
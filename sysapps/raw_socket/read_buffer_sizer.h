@@ -0,0 +1,40 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_RAW_SOCKET_READ_BUFFER_SIZER_H_
+#define XWALK_SYSAPPS_RAW_SOCKET_READ_BUFFER_SIZER_H_
+
+#include "base/macros.h"
+
+namespace xwalk {
+namespace sysapps {
+
+// Picks the size of a stream socket read buffer from the traffic seen so
+// far. The size doubles every time a read fills the buffer and halves after
+// a run of reads using less than a quarter of it, so idle connections keep a
+// small footprint while bulk transfers need fewer reads.
+class ReadBufferSizer {
+ public:
+  static const int kMinSize = 4 * 1024;
+  static const int kMaxSize = 64 * 1024;
+
+  ReadBufferSizer();
+
+  int size() const { return size_; }
+
+  // Accounts for a read of |bytes_read| bytes into a buffer with
+  // |buffer_size| bytes of free space.
+  void DidRead(int bytes_read, int buffer_size);
+
+ private:
+  int size_;
+  int small_reads_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReadBufferSizer);
+};
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_RAW_SOCKET_READ_BUFFER_SIZER_H_
@@ -0,0 +1,45 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/read_buffer_sizer.h"
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::sysapps::ReadBufferSizer;
+
+TEST(ReadBufferSizerTest, GrowsOnFullReads) {
+  ReadBufferSizer sizer;
+  EXPECT_EQ(ReadBufferSizer::kMinSize, sizer.size());
+
+  sizer.DidRead(sizer.size(), sizer.size());
+  EXPECT_EQ(2 * ReadBufferSizer::kMinSize, sizer.size());
+
+  for (int i = 0; i < 10; ++i)
+    sizer.DidRead(sizer.size(), sizer.size());
+  EXPECT_EQ(ReadBufferSizer::kMaxSize, sizer.size());
+}
+
+TEST(ReadBufferSizerTest, ShrinksAfterSmallReads) {
+  ReadBufferSizer sizer;
+  while (sizer.size() < ReadBufferSizer::kMaxSize)
+    sizer.DidRead(sizer.size(), sizer.size());
+
+  // A single small read is not enough.
+  sizer.DidRead(1, sizer.size());
+  EXPECT_EQ(ReadBufferSizer::kMaxSize, sizer.size());
+
+  for (int i = 0; i < 100; ++i)
+    sizer.DidRead(1, sizer.size());
+  EXPECT_EQ(ReadBufferSizer::kMinSize, sizer.size());
+}
+
+TEST(ReadBufferSizerTest, MediumReadsKeepTheSize) {
+  ReadBufferSizer sizer;
+  sizer.DidRead(sizer.size(), sizer.size());
+  int size = sizer.size();
+
+  for (int i = 0; i < 100; ++i)
+    sizer.DidRead(size / 2, size);
+  EXPECT_EQ(size, sizer.size());
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/secure_transport.h"
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+#include "base/logging.h"
+#include "crypto/rsa_private_key.h"
+#include "crypto/scoped_openssl_types.h"
+#include "net/base/host_port_pair.h"
+#include "net/cert/cert_verifier.h"
+#include "net/cert/ct_policy_enforcer.h"
+#include "net/cert/multi_log_ct_verifier.h"
+#include "net/cert/pem_tokenizer.h"
+#include "net/cert/x509_certificate.h"
+#include "net/http/transport_security_state.h"
+#include "net/socket/client_socket_factory.h"
+#include "net/socket/client_socket_handle.h"
+#include "net/socket/ssl_client_socket.h"
+#include "net/ssl/ssl_config.h"
+#include "net/ssl/ssl_server_config.h"
+#include "third_party/boringssl/src/include/openssl/bytestring.h"
+#include "third_party/boringssl/src/include/openssl/evp.h"
+#include "third_party/boringssl/src/include/openssl/rsa.h"
+
+namespace xwalk {
+namespace sysapps {
+
+namespace {
+
+// The TLS sessions are cached by host and port within this shard, which is
+// shared by every raw socket of the process.
+const char kSessionCacheShard[] = "xwalk_raw_socket";
+
+const char kPKCS8BlockType[] = "PRIVATE KEY";
+const char kPKCS1BlockType[] = "RSA PRIVATE KEY";
+
+std::unique_ptr<crypto::RSAPrivateKey> ParsePrivateKey(
+    const std::string& pem) {
+  std::vector<std::string> block_types;
+  block_types.push_back(kPKCS8BlockType);
+  block_types.push_back(kPKCS1BlockType);
+  net::PEMTokenizer tokenizer(pem, block_types);
+  if (!tokenizer.GetNext())
+    return std::unique_ptr<crypto::RSAPrivateKey>();
+
+  const std::string& der = tokenizer.data();
+  if (tokenizer.block_type() == kPKCS8BlockType) {
+    return std::unique_ptr<crypto::RSAPrivateKey>(
+        crypto::RSAPrivateKey::CreateFromPrivateKeyInfo(
+            std::vector<uint8_t>(der.begin(), der.end())));
+  }
+
+  CBS cbs;
+  CBS_init(&cbs, reinterpret_cast<const uint8_t*>(der.data()), der.size());
+  crypto::ScopedRSA rsa(RSA_parse_private_key(&cbs));
+  if (!rsa || CBS_len(&cbs) != 0)
+    return std::unique_ptr<crypto::RSAPrivateKey>();
+
+  crypto::ScopedEVP_PKEY key(EVP_PKEY_new());
+  if (!key || !EVP_PKEY_set1_RSA(key.get(), rsa.get()))
+    return std::unique_ptr<crypto::RSAPrivateKey>();
+  return std::unique_ptr<crypto::RSAPrivateKey>(
+      crypto::RSAPrivateKey::CreateFromKey(key.get()));
+}
+
+}  // namespace
+
+SecureTransportContext::SecureTransportContext() {
+}
+
+SecureTransportContext::~SecureTransportContext() {
+}
+
+std::unique_ptr<net::SSLClientSocket>
+SecureTransportContext::CreateClientSocket(
+    std::unique_ptr<net::StreamSocket> transport,
+    const net::HostPortPair& host) {
+  // Most pages never use TLS, so the verifiers are only created when needed.
+  if (!cert_verifier_) {
+    cert_verifier_ = net::CertVerifier::CreateDefault();
+    transport_security_state_.reset(new net::TransportSecurityState);
+    ct_verifier_.reset(new net::MultiLogCTVerifier);
+    ct_policy_enforcer_.reset(new net::CTPolicyEnforcer);
+  }
+
+  std::unique_ptr<net::ClientSocketHandle> handle(
+      new net::ClientSocketHandle);
+  handle->SetSocket(std::move(transport));
+
+  net::SSLClientSocketContext context(
+      cert_verifier_.get(), NULL, transport_security_state_.get(),
+      ct_verifier_.get(), ct_policy_enforcer_.get(), kSessionCacheShard);
+  return net::ClientSocketFactory::GetDefaultFactory()->CreateSSLClientSocket(
+      std::move(handle), host, net::SSLConfig(), context);
+}
+
+scoped_refptr<SharedSSLServerContext> CreateSharedSSLServerContext(
+    const std::string& certificate, const std::string& private_key) {
+  net::CertificateList certificates =
+      net::X509Certificate::CreateCertificateListFromBytes(
+          certificate.data(), certificate.size(),
+          net::X509Certificate::FORMAT_AUTO);
+  if (certificates.empty()) {
+    LOG(WARNING) << "Invalid TLS server certificate.";
+    return NULL;
+  }
+
+  std::unique_ptr<crypto::RSAPrivateKey> key = ParsePrivateKey(private_key);
+  if (!key) {
+    LOG(WARNING) << "Invalid TLS server private key.";
+    return NULL;
+  }
+
+  scoped_refptr<SharedSSLServerContext> context(new SharedSSLServerContext);
+  context->data = net::CreateSSLServerContext(
+      certificates[0].get(), *key, net::SSLServerConfig());
+  return context;
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
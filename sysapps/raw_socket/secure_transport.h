@@ -0,0 +1,67 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_RAW_SOCKET_SECURE_TRANSPORT_H_
+#define XWALK_SYSAPPS_RAW_SOCKET_SECURE_TRANSPORT_H_
+
+#include <memory>
+#include <string>
+
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "net/socket/ssl_server_socket.h"
+
+namespace net {
+class CertVerifier;
+class CTPolicyEnforcer;
+class HostPortPair;
+class MultiLogCTVerifier;
+class SSLClientSocket;
+class StreamSocket;
+class TransportSecurityState;
+}
+
+namespace xwalk {
+namespace sysapps {
+
+// Holds what the TLS client sockets of a RawSocketInstance need to verify
+// the servers, which must outlive the sockets.
+//
+// All the sockets share the same session cache, so connecting again to a
+// host resumes the previous TLS session instead of doing a full handshake.
+class SecureTransportContext {
+ public:
+  SecureTransportContext();
+  ~SecureTransportContext();
+
+  // Wraps the connected |transport| in a TLS client socket for |host|, which
+  // still has to be connected.
+  std::unique_ptr<net::SSLClientSocket> CreateClientSocket(
+      std::unique_ptr<net::StreamSocket> transport,
+      const net::HostPortPair& host);
+
+ private:
+  std::unique_ptr<net::CertVerifier> cert_verifier_;
+  std::unique_ptr<net::TransportSecurityState> transport_security_state_;
+  std::unique_ptr<net::MultiLogCTVerifier> ct_verifier_;
+  std::unique_ptr<net::CTPolicyEnforcer> ct_policy_enforcer_;
+
+  DISALLOW_COPY_AND_ASSIGN(SecureTransportContext);
+};
+
+// The sockets created by a TLS server keep its context alive, as they may
+// outlive the server.
+typedef base::RefCountedData<std::unique_ptr<net::SSLServerContext>>
+    SharedSSLServerContext;
+
+// Creates the context of a TLS server from a PEM encoded certificate and RSA
+// private key, either PKCS #8 or PKCS #1. Returns NULL if they can't be
+// parsed.
+scoped_refptr<SharedSSLServerContext> CreateSharedSSLServerContext(
+    const std::string& certificate, const std::string& private_key);
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_RAW_SOCKET_SECURE_TRANSPORT_H_
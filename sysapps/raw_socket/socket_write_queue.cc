@@ -0,0 +1,81 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/socket_write_queue.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/numerics/safe_conversions.h"
+
+namespace xwalk {
+namespace sysapps {
+
+const size_t SocketWriteQueue::kMaxGatherSize;
+
+SocketWriteQueue::SocketWriteQueue()
+    : buffered_amount_(0) {}
+
+SocketWriteQueue::~SocketWriteQueue() {}
+
+void SocketWriteQueue::Push(const std::string& data) {
+  if (data.empty())
+    return;
+
+  scoped_refptr<net::IOBuffer> buffer(new net::IOBuffer(data.size()));
+  memcpy(buffer->data(), data.data(), data.size());
+  buffers_.push_back(new net::DrainableIOBuffer(
+      buffer.get(), base::checked_cast<int>(data.size())));
+  buffered_amount_ += data.size();
+}
+
+scoped_refptr<net::IOBuffer> SocketWriteQueue::GetWriteBuffer(int* size) {
+  DCHECK(!buffers_.empty());
+
+  net::DrainableIOBuffer* front = buffers_.front().get();
+  size_t front_size = front->BytesRemaining();
+  if (buffers_.size() == 1 || front_size >= kMaxGatherSize / 2) {
+    *size = base::checked_cast<int>(front_size);
+    return front;
+  }
+
+  size_t gather_size = std::min(buffered_amount_, kMaxGatherSize);
+  scoped_refptr<net::IOBuffer> gathered(new net::IOBuffer(gather_size));
+  size_t offset = 0;
+  for (size_t i = 0; i < buffers_.size() && offset < gather_size; ++i) {
+    net::DrainableIOBuffer* buffer = buffers_[i].get();
+    size_t chunk = std::min(static_cast<size_t>(buffer->BytesRemaining()),
+                            gather_size - offset);
+    memcpy(gathered->data() + offset, buffer->data(), chunk);
+    offset += chunk;
+  }
+
+  *size = base::checked_cast<int>(offset);
+  return gathered;
+}
+
+void SocketWriteQueue::Consume(size_t size) {
+  DCHECK_LE(size, buffered_amount_);
+  buffered_amount_ -= size;
+
+  while (size && !buffers_.empty()) {
+    net::DrainableIOBuffer* front = buffers_.front().get();
+    size_t chunk = std::min(static_cast<size_t>(front->BytesRemaining()),
+                            size);
+    front->DidConsume(base::checked_cast<int>(chunk));
+    size -= chunk;
+    if (!front->BytesRemaining())
+      buffers_.pop_front();
+  }
+}
+
+void SocketWriteQueue::Clear() {
+  buffers_.clear();
+  buffered_amount_ = 0;
+}
+
+}  // namespace sysapps
+}  // namespace xwalk
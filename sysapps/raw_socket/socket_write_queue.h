@@ -0,0 +1,61 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef XWALK_SYSAPPS_RAW_SOCKET_SOCKET_WRITE_QUEUE_H_
+#define XWALK_SYSAPPS_RAW_SOCKET_SOCKET_WRITE_QUEUE_H_
+
+#include <stddef.h>
+
+#include <deque>
+#include <string>
+
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "net/base/io_buffer.h"
+
+namespace xwalk {
+namespace sysapps {
+
+// Queue of pending writes for a stream socket. There is no limit on the
+// amount of data that can be queued, flow control is left to the caller by
+// means of buffered_amount().
+//
+// net::StreamSocket has no vectored write, so small buffers sitting at the
+// head of the queue are gathered into a single write buffer instead, which
+// saves one round trip through the socket per buffer. Large buffers are
+// written directly, without an extra copy.
+class SocketWriteQueue {
+ public:
+  // Upper bound of a gathered write.
+  static const size_t kMaxGatherSize = 64 * 1024;
+
+  SocketWriteQueue();
+  ~SocketWriteQueue();
+
+  void Push(const std::string& data);
+
+  bool empty() const { return buffers_.empty(); }
+  size_t buffered_amount() const { return buffered_amount_; }
+
+  // Returns the buffer to be passed to the next Write() call and sets |size|
+  // to the number of bytes to write. Must not be called if the queue is
+  // empty. The buffer stays valid until Consume() is called.
+  scoped_refptr<net::IOBuffer> GetWriteBuffer(int* size);
+
+  // Removes the first |size| bytes of the queue after they have been written.
+  void Consume(size_t size);
+
+  void Clear();
+
+ private:
+  std::deque<scoped_refptr<net::DrainableIOBuffer>> buffers_;
+  size_t buffered_amount_;
+
+  DISALLOW_COPY_AND_ASSIGN(SocketWriteQueue);
+};
+
+}  // namespace sysapps
+}  // namespace xwalk
+
+#endif  // XWALK_SYSAPPS_RAW_SOCKET_SOCKET_WRITE_QUEUE_H_
@@ -0,0 +1,85 @@
+// Copyright (c) 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "xwalk/sysapps/raw_socket/socket_write_queue.h"
+
+#include <string>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+using xwalk::sysapps::SocketWriteQueue;
+
+namespace {
+
+std::string ReadWriteBuffer(SocketWriteQueue* queue) {
+  int size = 0;
+  scoped_refptr<net::IOBuffer> buffer = queue->GetWriteBuffer(&size);
+  return std::string(buffer->data(), size);
+}
+
+}  // namespace
+
+TEST(SocketWriteQueueTest, EmptyDataIsIgnored) {
+  SocketWriteQueue queue;
+  queue.Push(std::string());
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(0u, queue.buffered_amount());
+}
+
+TEST(SocketWriteQueueTest, PartialWrites) {
+  SocketWriteQueue queue;
+  queue.Push("hello");
+  EXPECT_EQ(5u, queue.buffered_amount());
+  EXPECT_EQ("hello", ReadWriteBuffer(&queue));
+
+  queue.Consume(2);
+  EXPECT_EQ(3u, queue.buffered_amount());
+  EXPECT_EQ("llo", ReadWriteBuffer(&queue));
+
+  queue.Consume(3);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(0u, queue.buffered_amount());
+}
+
+TEST(SocketWriteQueueTest, GathersSmallBuffers) {
+  SocketWriteQueue queue;
+  queue.Push("foo");
+  queue.Push("bar");
+  queue.Push("baz");
+  EXPECT_EQ("foobarbaz", ReadWriteBuffer(&queue));
+
+  // A write can end in the middle of a buffer.
+  queue.Consume(4);
+  EXPECT_EQ(5u, queue.buffered_amount());
+  EXPECT_EQ("arbaz", ReadWriteBuffer(&queue));
+
+  queue.Consume(5);
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(SocketWriteQueueTest, GatherIsBounded) {
+  SocketWriteQueue queue;
+  const std::string chunk(SocketWriteQueue::kMaxGatherSize / 4, 'x');
+  for (int i = 0; i < 8; ++i)
+    queue.Push(chunk);
+
+  int size = 0;
+  queue.GetWriteBuffer(&size);
+  EXPECT_EQ(SocketWriteQueue::kMaxGatherSize, static_cast<size_t>(size));
+  EXPECT_EQ(2 * SocketWriteQueue::kMaxGatherSize, queue.buffered_amount());
+}
+
+TEST(SocketWriteQueueTest, LargeBufferIsNotCopied) {
+  SocketWriteQueue queue;
+  queue.Push(std::string(SocketWriteQueue::kMaxGatherSize, 'x'));
+  queue.Push("tail");
+
+  int size = 0;
+  queue.GetWriteBuffer(&size);
+  EXPECT_EQ(SocketWriteQueue::kMaxGatherSize, static_cast<size_t>(size));
+
+  queue.Clear();
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(0u, queue.buffered_amount());
+}
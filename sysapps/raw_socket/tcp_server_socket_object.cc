@@ -7,6 +7,7 @@
 #include <string.h>
 #include "base/guid.h"
 #include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
 #include "net/base/ip_endpoint.h"
 #include "net/base/net_errors.h"
 #include "net/socket/stream_socket.h"
@@ -18,12 +19,29 @@
 using namespace xwalk::jsapi::tcp_server_socket; // NOLINT
 using namespace xwalk::jsapi::raw_socket; // NOLINT
 
+namespace {
+
+// Length of the queue of connections waiting to be accepted, when not set by
+// the options. The system may cap it further.
+const int kDefaultBacklog = 128;
+
+// Upper bound of the number of connections dispatched in a single event.
+const size_t kMaxBatchedConnections = 64;
+
+const int kAcceptRetryDelayMs = 100;
+
+}  // namespace
+
 namespace xwalk {
 namespace sysapps {
 
 TCPServerSocketObject::TCPServerSocketObject(RawSocketInstance* instance)
   : is_suspended_(false),
     is_accepting_(false),
+    has_accept_pending_(false),
+    batch_connections_(false),
+    next_connection_id_(0),
+    pending_connections_(new base::ListValue),
     instance_(instance) {
   handler_.Register("init",
       base::Bind(&TCPServerSocketObject::OnInit, base::Unretained(this)));
@@ -38,9 +56,92 @@ TCPServerSocketObject::TCPServerSocketObject(RawSocketInstance* instance)
 TCPServerSocketObject::~TCPServerSocketObject() {}
 
 void TCPServerSocketObject::DoAccept() {
-  socket_->Accept(&accepted_socket_,
-                  base::Bind(&TCPServerSocketObject::OnAccept,
-                             base::Unretained(this)));
+  while (!has_accept_pending_ && socket_) {
+    int ret = socket_->Accept(&accepted_socket_,
+                              base::Bind(&TCPServerSocketObject::OnAccept,
+                                         base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_accept_pending_ = true;
+      // No other connection is waiting, dispatch the current batch.
+      FlushConnections();
+      return;
+    }
+
+    if (!DidAccept(ret))
+      return;
+  }
+}
+
+bool TCPServerSocketObject::DidAccept(int status) {
+  if (status != net::OK) {
+    LOG(WARNING) << "Failed to accept a connection: "
+                 << net::ErrorToString(status);
+    FlushConnections();
+    DispatchEvent("connecterror");
+    accept_retry_timer_.Start(
+        FROM_HERE, base::TimeDelta::FromMilliseconds(kAcceptRetryDelayMs),
+        base::Bind(&TCPServerSocketObject::DoAccept, base::Unretained(this)));
+    return false;
+  }
+
+  if (!is_accepting_ || is_suspended_) {
+    // The spec is not really clear about what to do when we get a incoming
+    // connection but nobody is listening. We are just closing the socket in
+    // this case.
+    accepted_socket_.reset();
+    return true;
+  }
+
+  net::IPEndPoint local_address;
+  accepted_socket_->GetLocalAddress(&local_address);
+
+  jsapi::tcp_socket::TCPOptions options;
+  options.local_address = local_address.ToStringWithoutPort();
+  options.local_port = local_address.port();
+  options.address_reuse = false;
+  options.no_delay = true;
+  options.use_secure_transport = !!ssl_context_;
+
+  std::string object_id = connection_id_prefix_ +
+      base::Int64ToString(next_connection_id_++);
+  std::unique_ptr<BindingObject> obj;
+  if (ssl_context_) {
+    obj.reset(new TCPSocketObject(
+        ssl_context_->data->CreateSSLServerSocket(std::move(accepted_socket_)),
+        ssl_context_));
+  } else {
+    obj.reset(new TCPSocketObject(std::move(accepted_socket_)));
+  }
+  instance_->AddBindingObject(object_id, std::move(obj));
+
+  std::unique_ptr<base::ListValue> dataList(new base::ListValue);
+  dataList->AppendString(object_id);
+  dataList->Append(options.ToValue().release());
+  pending_connections_->Append(dataList.release());
+
+  if (!batch_connections_ ||
+      pending_connections_->GetSize() >= kMaxBatchedConnections)
+    FlushConnections();
+
+  return true;
+}
+
+void TCPServerSocketObject::FlushConnections() {
+  if (pending_connections_->empty())
+    return;
+
+  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  if (batch_connections_) {
+    eventData->Append(pending_connections_.release());
+    pending_connections_.reset(new base::ListValue);
+  } else {
+    std::unique_ptr<base::Value> connection;
+    pending_connections_->Remove(0, &connection);
+    eventData->Append(connection.release());
+  }
+
+  DispatchEvent("connect", std::move(eventData));
 }
 
 void TCPServerSocketObject::StartEvent(const std::string& type) {
@@ -72,10 +173,30 @@ void TCPServerSocketObject::OnInit(
     return;
   }
 
+  int backlog = kDefaultBacklog;
+  if (params->options.backlog && *params->options.backlog > 0)
+    backlog = *params->options.backlog;
+  if (params->options.batch_connections)
+    batch_connections_ = *params->options.batch_connections;
+
+  if (params->options.use_secure_transport) {
+    if (params->options.certificate && params->options.private_key) {
+      ssl_context_ = CreateSharedSSLServerContext(
+          *params->options.certificate, *params->options.private_key);
+    }
+    if (!ssl_context_) {
+      LOG(WARNING) << "A certificate and a private key are required to "
+                   << "accept TLS connections.";
+      setReadyState(READY_STATE_CLOSED);
+      DispatchEvent("error");
+      return;
+    }
+  }
+
   socket_.reset(new net::TCPServerSocket(NULL, net::NetLog::Source()));
   net::IPEndPoint address(ip_number, params->options.local_port);
 
-  if (socket_->Listen(address, 5) != net::OK) {
+  if (socket_->Listen(address, backlog) != net::OK) {
     LOG(WARNING) << "Failed to listen on " << params->options.local_address
         << " port " << params->options.local_port;
     setReadyState(READY_STATE_CLOSED);
@@ -83,6 +204,8 @@ void TCPServerSocketObject::OnInit(
     return;
   }
 
+  connection_id_prefix_ = base::GenerateGUID() + "-";
+
   setReadyState(READY_STATE_OPEN);
   DispatchEvent("open");
   DoAccept();
@@ -92,6 +215,9 @@ void TCPServerSocketObject::OnClose(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
   if (socket_)
     socket_.reset();
+  accepted_socket_.reset();
+  has_accept_pending_ = false;
+  accept_retry_timer_.Stop();
 
   setReadyState(READY_STATE_CLOSED);
   DispatchEvent("close");
@@ -108,38 +234,9 @@ void TCPServerSocketObject::OnResume(
 }
 
 void TCPServerSocketObject::OnAccept(int status) {
-  if (is_accepting_ && !is_suspended_) {
-    net::IPEndPoint local_address;
-    accepted_socket_->GetLocalAddress(&local_address);
-
-    jsapi::tcp_socket::TCPOptions options;
-    options.local_address = local_address.ToStringWithoutPort();
-    options.local_port = local_address.port();
-    options.address_reuse = false;
-    options.no_delay = true;
-    options.use_secure_transport = false;
-
-    std::string object_id = base::GenerateGUID();
-    std::unique_ptr<BindingObject> obj(new TCPSocketObject(
-                            std::move(accepted_socket_)));
-    instance_->AddBindingObject(object_id, std::move(obj));
-
-    std::unique_ptr<base::ListValue> dataList(new base::ListValue);
-    dataList->AppendString(object_id);
-    dataList->Append(options.ToValue().release());
-
-    std::unique_ptr<base::ListValue> eventData(new base::ListValue);
-    eventData->Append(dataList.release());
-
-    DispatchEvent("connect", std::move(eventData));
-  } else {
-    // The spec is not really clear about what to do when we get a incoming
-    // connection but nobody is listening. We are just closing the socket in
-    // this case.
-    accepted_socket_.reset();
-  }
-
-  DoAccept();
+  has_accept_pending_ = false;
+  if (DidAccept(status))
+    DoAccept();
 }
 
 }  // namespace sysapps
@@ -5,11 +5,16 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_TCP_SERVER_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_TCP_SERVER_SOCKET_OBJECT_H_
 
+#include <stdint.h>
+
 #include <string>
+#include "base/timer/timer.h"
+#include "base/values.h"
 #include "net/socket/tcp_server_socket.h"
 #include "xwalk/sysapps/common/event_target.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_extension.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_object.h"
+#include "xwalk/sysapps/raw_socket/secure_transport.h"
 
 namespace xwalk {
 namespace sysapps {
@@ -22,7 +27,12 @@ class TCPServerSocketObject : public RawSocketObject {
   ~TCPServerSocketObject() override;
 
  private:
+  // Accepts the pending connections until none is left.
   void DoAccept();
+  // Accounts for a completed accept. Returns false if accepting has to stop.
+  bool DidAccept(int status);
+  // Dispatches the connections accepted but not dispatched yet.
+  void FlushConnections();
 
   // EventTarget implementation.
   void StartEvent(const std::string& type) override;
@@ -39,9 +49,25 @@ class TCPServerSocketObject : public RawSocketObject {
 
   bool is_suspended_;
   bool is_accepting_;
+  bool has_accept_pending_;
+  // Whether the connections accepted in a row are delivered as a single
+  // "connect" event.
+  bool batch_connections_;
+
+  // The accepted sockets are named after the server, which saves generating
+  // a GUID for each of them.
+  std::string connection_id_prefix_;
+  int64_t next_connection_id_;
+
+  // Set when the connections use TLS.
+  scoped_refptr<SharedSSLServerContext> ssl_context_;
 
   std::unique_ptr<net::TCPServerSocket> socket_;
   std::unique_ptr<net::StreamSocket> accepted_socket_;
+  std::unique_ptr<base::ListValue> pending_connections_;
+  // Accepting is retried after a while when it fails, e.g. for lack of file
+  // descriptors, instead of spinning on the error.
+  base::OneShotTimer accept_retry_timer_;
 
   RawSocketInstance* instance_;
 };
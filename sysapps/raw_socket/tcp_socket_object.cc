@@ -4,45 +4,71 @@
 
 #include "xwalk/sysapps/raw_socket/tcp_socket_object.h"
 
-#include <string.h>
 #include "base/logging.h"
-#include "base/numerics/safe_conversions.h"
+#include "base/values.h"
 #include "net/base/net_errors.h"
+#include "net/socket/ssl_client_socket.h"
 #include "xwalk/sysapps/raw_socket/tcp_socket.h"
 
 using namespace xwalk::jsapi::tcp_socket; // NOLINT
 using namespace xwalk::jsapi::raw_socket; // NOLINT
 
-namespace {
-
-const size_t kBufferSize = 4096;
-
-}  // namespace
-
 namespace xwalk {
 namespace sysapps {
 
-TCPSocketObject::TCPSocketObject()
-    : has_write_pending_(false),
+TCPSocketObject::TCPSocketObject(SecureTransportContext* secure_transport)
+    : has_read_pending_(false),
+      has_write_pending_(false),
+      needs_drain_(false),
       is_suspended_(false),
       is_half_closed_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
+      is_closed_(false),
+      use_secure_transport_(false),
+      is_handshaking_(false),
+      batch_reads_(false),
+      written_bytes_(0),
+      read_buffer_(new net::IOBuffer(read_buffer_sizer_.size())),
+      read_buffer_size_(read_buffer_sizer_.size()),
+      read_offset_(0),
+      batch_start_(0),
+      secure_transport_(secure_transport),
+      server_handshake_socket_(NULL),
       resolver_(net::HostResolver::CreateDefaultResolver(NULL)),
       single_resolver_(new net::SingleRequestHostResolver(resolver_.get())) {
   RegisterHandlers();
 }
 
 TCPSocketObject::TCPSocketObject(std::unique_ptr<net::StreamSocket> socket)
-    : has_write_pending_(false),
+    : has_read_pending_(false),
+      has_write_pending_(false),
+      needs_drain_(false),
       is_suspended_(false),
       is_half_closed_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
+      is_closed_(false),
+      use_secure_transport_(false),
+      is_handshaking_(false),
+      batch_reads_(false),
+      written_bytes_(0),
+      read_buffer_(new net::IOBuffer(read_buffer_sizer_.size())),
+      read_buffer_size_(read_buffer_sizer_.size()),
+      read_offset_(0),
+      batch_start_(0),
+      secure_transport_(NULL),
+      server_handshake_socket_(NULL),
       socket_(socket.release()) {
   RegisterHandlers();
 }
 
+TCPSocketObject::TCPSocketObject(
+    std::unique_ptr<net::SSLServerSocket> socket,
+    scoped_refptr<SharedSSLServerContext> server_context)
+    : TCPSocketObject(std::unique_ptr<net::StreamSocket>()) {
+  use_secure_transport_ = true;
+  server_context_ = server_context;
+  server_handshake_socket_ = socket.get();
+  socket_ = std::move(socket);
+}
+
 TCPSocketObject::~TCPSocketObject() {}
 
 void TCPSocketObject::RegisterHandlers() {
@@ -61,34 +87,169 @@ void TCPSocketObject::RegisterHandlers() {
 }
 
 void TCPSocketObject::DoRead() {
-  if (!socket_->IsConnected())
+  if (is_handshaking_)
     return;
 
-  int ret = socket_->Read(read_buffer_.get(),
-                          kBufferSize,
-                          base::Bind(&TCPSocketObject::OnRead,
-                                     base::Unretained(this)));
+  while (!has_read_pending_ && socket_->IsConnected()) {
+    // The buffer can only be replaced when it holds no data and no read is
+    // writing into it.
+    if (batch_start_ == read_offset_) {
+      batch_start_ = read_offset_ = 0;
+      if (read_buffer_size_ != read_buffer_sizer_.size()) {
+        read_buffer_size_ = read_buffer_sizer_.size();
+        read_buffer_ = new net::IOBuffer(read_buffer_size_);
+      }
+    }
+
+    scoped_refptr<net::IOBuffer> buffer(
+        new net::WrappedIOBuffer(read_buffer_->data() + read_offset_));
+    int ret = socket_->Read(buffer.get(),
+                            read_buffer_size_ - read_offset_,
+                            base::Bind(&TCPSocketObject::OnRead,
+                                       base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_read_pending_ = true;
+      // Nothing else is ready to be read, dispatch the current batch.
+      FlushReadData();
+      return;
+    }
+
+    if (!DidRead(ret))
+      return;
+  }
+}
+
+bool TCPSocketObject::DidRead(int status) {
+  if (status <= 0) {
+    FlushReadData();
+    SetClosed();
+    // No data means the other side has disconnected the socket.
+    DispatchEvent(status == 0 ? "close" : "error");
+    return false;
+  }
+
+  read_buffer_sizer_.DidRead(status, read_buffer_size_ - read_offset_);
+  read_offset_ += status;
+
+  if (!batch_reads_ || read_offset_ == read_buffer_size_)
+    FlushReadData();
 
-  if (ret > 0)
-    OnRead(ret);
+  return true;
 }
 
-void TCPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
-  if (socket_.get()) {
-    DoRead();
+void TCPSocketObject::FlushReadData() {
+  if (batch_start_ == read_offset_)
     return;
+
+  // The only copy of the payload is the one into the event.
+  if (!is_suspended_ && IsEventActive("data")) {
+    std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+    eventData->Append(base::BinaryValue::CreateWithCopiedBuffer(
+        read_buffer_->data() + batch_start_, read_offset_ - batch_start_));
+    DispatchEvent("data", std::move(eventData));
+  }
+
+  batch_start_ = read_offset_;
+}
+
+void TCPSocketObject::DoWrite() {
+  while (!has_write_pending_ && !write_queue_.empty()) {
+    if (!socket_.get() || !socket_->IsConnected() || is_handshaking_)
+      return;
+
+    int size = 0;
+    scoped_refptr<net::IOBuffer> buffer = write_queue_.GetWriteBuffer(&size);
+    int ret = socket_->Write(buffer.get(), size,
+                             base::Bind(&TCPSocketObject::OnWrite,
+                                        base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_write_pending_ = true;
+      return;
+    }
+
+    if (ret < 0) {
+      OnWrite(ret);
+      return;
+    }
+
+    DidWrite(ret);
   }
+}
+
+void TCPSocketObject::DidWrite(int size) {
+  write_queue_.Consume(size);
+  written_bytes_ += size;
+
+  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->AppendDouble(written_bytes_);
+  DispatchEvent("bufferedamount", std::move(eventData));
+
+  if (needs_drain_ && write_queue_.empty()) {
+    needs_drain_ = false;
+    DispatchEvent("drain");
+  }
+}
+
+void TCPSocketObject::DidDiscard(size_t size) {
+  if (!size)
+    return;
+  written_bytes_ += size;
+
+  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->AppendDouble(written_bytes_);
+  DispatchEvent("bufferedamount", std::move(eventData));
+}
+
+void TCPSocketObject::ClearWriteQueue() {
+  size_t size = write_queue_.buffered_amount();
+  write_queue_.Clear();
+  DidDiscard(size);
+}
+
+void TCPSocketObject::SetClosed() {
+  // A pending write never completes once disconnected.
+  if (socket_.get())
+    socket_->Disconnect();
+  has_write_pending_ = false;
+  ClearWriteQueue();
+  is_closed_ = true;
+  setReadyState(READY_STATE_CLOSED);
+}
 
+void TCPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
   std::unique_ptr<Init::Params> params(Init::Params::Create(*info->arguments()));
   if (!params) {
     LOG(WARNING) << "Malformed parameters passed to " << info->name();
-    setReadyState(READY_STATE_CLOSED);
+    SetClosed();
     DispatchEvent("error");
     return;
   }
 
-  net::HostResolver::RequestInfo request_info(
-      net::HostPortPair(params->remote_address, params->remote_port));
+  if (params->options && params->options->batch_reads)
+    batch_reads_ = *params->options->batch_reads;
+
+  if (server_handshake_socket_) {
+    is_handshaking_ = true;
+    int ret = server_handshake_socket_->Handshake(
+        base::Bind(&TCPSocketObject::OnServerHandshake,
+                   base::Unretained(this)));
+    if (ret != net::ERR_IO_PENDING)
+      OnServerHandshake(ret);
+    return;
+  }
+
+  if (socket_.get()) {
+    DoRead();
+    return;
+  }
+
+  if (params->options)
+    use_secure_transport_ = params->options->use_secure_transport;
+
+  host_ = net::HostPortPair(params->remote_address, params->remote_port);
+  net::HostResolver::RequestInfo request_info(host_);
 
   int ret = single_resolver_->Resolve(
       request_info, net::DEFAULT_PRIORITY, &addresses_,
@@ -101,10 +262,7 @@ void TCPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
 }
 
 void TCPSocketObject::OnClose(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
-  if (socket_.get())
-    socket_->Disconnect();
-
-  setReadyState(READY_STATE_CLOSED);
+  SetClosed();
   DispatchEvent("close");
 }
 
@@ -126,12 +284,6 @@ void TCPSocketObject::OnResume(std::unique_ptr<XWalkExtensionFunctionInfo> info)
 
 void TCPSocketObject::OnSendString(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
-  if (is_half_closed_ || has_write_pending_)
-    return;
-
-  if (!socket_.get() || !socket_->IsConnected())
-    return;
-
   std::unique_ptr<SendDOMString::Params>
       params(SendDOMString::Params::Create(*info->arguments()));
 
@@ -140,27 +292,35 @@ void TCPSocketObject::OnSendString(
     return;
   }
 
-  if (params->data.size() > kBufferSize) {
-    LOG(WARNING) << "Write data bigger than the write buffer.";
+  if (is_half_closed_ || is_closed_) {
+    DidDiscard(params->data.size());
     return;
   }
 
-  memcpy(write_buffer_->data(), params->data.data(), params->data.size());
+  // Data sent while still connecting is flushed by OnConnect().
+  write_queue_.Push(params->data);
+  if (params->notify_drain && *params->notify_drain)
+    needs_drain_ = true;
 
-  int ret = socket_->Write(write_buffer_.get(),
-                           base::checked_cast<int>(params->data.size()),
-                           base::Bind(&TCPSocketObject::OnWrite,
-                                      base::Unretained(this)));
+  DoWrite();
+}
 
-  if (ret == net::ERR_IO_PENDING)
-    has_write_pending_ = true;
-  else if (ret == static_cast<int>(params->data.size()))
+void TCPSocketObject::OnTransportConnect(int status) {
+  if (status != net::OK || !use_secure_transport_) {
+    OnConnect(status);
     return;
-  else
-    socket_->Disconnect();
+  }
+
+  socket_ = secure_transport_->CreateClientSocket(std::move(socket_), host_);
+  is_handshaking_ = true;
+  int ret = socket_->Connect(base::Bind(&TCPSocketObject::OnConnect,
+                                        base::Unretained(this)));
+  if (ret != net::ERR_IO_PENDING)
+    OnConnect(ret);
 }
 
 void TCPSocketObject::OnConnect(int status) {
+  is_handshaking_ = false;
   if (status == net::OK) {
     if (is_half_closed_)
       setReadyState(READY_STATE_HALFCLOSED);
@@ -169,42 +329,51 @@ void TCPSocketObject::OnConnect(int status) {
 
     DispatchEvent("open");
     DoRead();
+    DoWrite();
   } else {
-    setReadyState(READY_STATE_CLOSED);
+    SetClosed();
     DispatchEvent("error");
   }
 }
 
 void TCPSocketObject::OnRead(int status) {
-  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  has_read_pending_ = false;
 
-  // No data means the other side has
-  // disconnected the socket.
-  if (status == 0) {
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("close", std::move(eventData));
+  if (DidRead(status))
+    DoRead();
+}
+
+void TCPSocketObject::OnWrite(int status) {
+  has_write_pending_ = false;
+
+  if (status < 0) {
+    SetClosed();
+    DispatchEvent("error");
     return;
   }
 
-  std::unique_ptr<base::Value> data(base::BinaryValue::CreateWithCopiedBuffer(
-      static_cast<char*>(read_buffer_->data()), status));
+  DidWrite(status);
+  DoWrite();
+}
 
-  eventData->Append(data.release());
+void TCPSocketObject::OnServerHandshake(int status) {
+  is_handshaking_ = false;
+  server_handshake_socket_ = NULL;
 
-  if (!is_suspended_)
-    DispatchEvent("data", std::move(eventData));
+  if (status != net::OK) {
+    LOG(WARNING) << "TLS handshake failed: " << net::ErrorToString(status);
+    SetClosed();
+    DispatchEvent("error");
+    return;
+  }
 
   DoRead();
-}
-
-void TCPSocketObject::OnWrite(int status) {
-  has_write_pending_ = false;
-  DispatchEvent("drain");
+  DoWrite();
 }
 
 void TCPSocketObject::OnResolved(int status) {
   if (status != net::OK) {
-    setReadyState(READY_STATE_CLOSED);
+    SetClosed();
     DispatchEvent("error");
     return;
   }
@@ -214,8 +383,10 @@ void TCPSocketObject::OnResolved(int status) {
                                          nullptr,
                                          net::NetLog::Source()));
 
-  socket_->Connect(base::Bind(&TCPSocketObject::OnConnect,
-                              base::Unretained(this)));
+  int ret = socket_->Connect(base::Bind(&TCPSocketObject::OnTransportConnect,
+                                        base::Unretained(this)));
+  if (ret != net::ERR_IO_PENDING)
+    OnTransportConnect(ret);
 }
 
 }  // namespace sysapps
@@ -8,21 +8,47 @@
 #include <string>
 #include "net/dns/single_request_host_resolver.h"
 #include "net/base/io_buffer.h"
+#include "net/base/host_port_pair.h"
 #include "net/socket/tcp_client_socket.h"
 #include "xwalk/sysapps/raw_socket/raw_socket_object.h"
+#include "xwalk/sysapps/raw_socket/read_buffer_sizer.h"
+#include "xwalk/sysapps/raw_socket/secure_transport.h"
+#include "xwalk/sysapps/raw_socket/socket_write_queue.h"
 
 namespace xwalk {
 namespace sysapps {
 
 class TCPSocketObject : public RawSocketObject {
  public:
-  TCPSocketObject();
+  // Connects to the address given by JavaScript, using |secure_transport|
+  // if it asks for TLS.
+  explicit TCPSocketObject(SecureTransportContext* secure_transport);
+  // Wraps a socket accepted by a server.
   explicit TCPSocketObject(std::unique_ptr<net::StreamSocket> socket);
+  // Wraps a socket accepted by a TLS server, the handshake is done before
+  // anything is read or written.
+  TCPSocketObject(std::unique_ptr<net::SSLServerSocket> socket,
+                  scoped_refptr<SharedSSLServerContext> server_context);
   ~TCPSocketObject() override;
 
  private:
   void RegisterHandlers();
   void DoRead();
+  // Accounts for a completed read. Returns false if reading has to stop.
+  bool DidRead(int status);
+  // Dispatches the data read but not dispatched yet as one "data" event.
+  void FlushReadData();
+  void DoWrite();
+  // Accounts for |size| bytes written, dispatches "bufferedamount" and, if
+  // JavaScript asked for it, "drain" once the queue is empty.
+  void DidWrite(int size);
+  // Accounts for |size| bytes which won't be written, so that they don't
+  // stay in the bufferedAmount attribute.
+  void DidDiscard(size_t size);
+  void ClearWriteQueue();
+  // Disconnects the socket and discards the data not written yet, which
+  // can't be sent anymore.
+  void SetClosed();
 
   // JavaScript function handlers.
   void OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info);
@@ -33,24 +59,55 @@ class TCPSocketObject : public RawSocketObject {
   void OnSendString(std::unique_ptr<XWalkExtensionFunctionInfo> info);
 
   // net::TCPClientSocket callbacks.
+  void OnTransportConnect(int status);
   void OnConnect(int status);
   void OnRead(int status);
   void OnWrite(int status);
 
+  // net::SSLServerSocket callbacks.
+  void OnServerHandshake(int status);
+
   // net::SingleRequestHostResolver callbacks.
   void OnResolved(int status);
 
+  bool has_read_pending_;
   bool has_write_pending_;
+  bool needs_drain_;
   bool is_suspended_;
   bool is_half_closed_;
+  bool is_closed_;
+  bool use_secure_transport_;
+  // Nothing is read or written until the TLS handshake is done.
+  bool is_handshaking_;
+  // Whether consecutive reads are coalesced into a single "data" event.
+  bool batch_reads_;
+
+  // Total amount of bytes written to the socket or discarded, JavaScript
+  // derives the bufferedAmount attribute from it.
+  double written_bytes_;
 
+  // Reads fill |read_buffer_| starting at |read_offset_|. The bytes from
+  // |batch_start_| to |read_offset_| have not been dispatched yet.
+  ReadBufferSizer read_buffer_sizer_;
   scoped_refptr<net::IOBuffer> read_buffer_;
-  scoped_refptr<net::IOBuffer> write_buffer_;
+  int read_buffer_size_;
+  int read_offset_;
+  int batch_start_;
+
+  SocketWriteQueue write_queue_;
+
+  SecureTransportContext* secure_transport_;
+  // Set for sockets accepted by a TLS server, declared before |socket_| so
+  // that it outlives it.
+  scoped_refptr<SharedSSLServerContext> server_context_;
+  net::SSLServerSocket* server_handshake_socket_;
+
   std::unique_ptr<net::StreamSocket> socket_;
 
   std::unique_ptr<net::HostResolver> resolver_;
   std::unique_ptr<net::SingleRequestHostResolver> single_resolver_;
   net::AddressList addresses_;
+  net::HostPortPair host_;
 };
 
 }  // namespace sysapps
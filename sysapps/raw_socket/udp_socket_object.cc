@@ -4,11 +4,15 @@
 
 #include "xwalk/sysapps/raw_socket/udp_socket_object.h"
 
+#include <string.h>
+
 #include <algorithm>
 #include <string>
 
 #include "base/logging.h"
 #include "base/numerics/safe_conversions.h"
+#include "base/values.h"
+#include "net/base/ip_address.h"
 #include "net/base/net_errors.h"
 #include "xwalk/sysapps/raw_socket/udp_socket.h"
 
@@ -17,20 +21,62 @@ using namespace xwalk::jsapi::raw_socket; // NOLINT
 
 namespace {
 
-const size_t kBufferSize = 4096;
+// Largest payload of an UDP datagram.
+const size_t kMaxDatagramSize = 65507;
+
+// Upper bound of the number of datagrams dispatched in a single event.
+const size_t kMaxBatchedMessages = 64;
+
+// Whether a RecvFrom() error only concerns a single datagram, e.g. an ICMP
+// error reported for an earlier send, so that the socket can keep reading.
+bool IsTransientReadError(int status) {
+  return status == net::ERR_CONNECTION_REFUSED ||
+         status == net::ERR_CONNECTION_RESET ||
+         status == net::ERR_ADDRESS_UNREACHABLE ||
+         status == net::ERR_MSG_TOO_BIG;
+}
+
+// Replies to a method returning a Promise on the JavaScript side, which is
+// rejected unless |result| is net::OK.
+void PostPromiseResult(
+    std::unique_ptr<xwalk::extensions::XWalkExtensionFunctionInfo> info,
+    int result) {
+  std::unique_ptr<base::ListValue> data(new base::ListValue);
+  data->AppendString("");
+  data->AppendString(result == net::OK ? "" : net::ErrorToString(result));
+
+  info->PostResult(std::move(data));
+}
 
 }  // namespace
 
 namespace xwalk {
 namespace sysapps {
 
+UDPSocketObject::PendingDatagram::PendingDatagram()
+    : size(0),
+      has_destination(false) {}
+
+UDPSocketObject::PendingDatagram::PendingDatagram(
+    const PendingDatagram& other) = default;
+
+UDPSocketObject::PendingDatagram::~PendingDatagram() {}
+
 UDPSocketObject::UDPSocketObject()
-    : has_write_pending_(false),
+    : has_read_pending_(false),
+      has_write_pending_(false),
+      needs_drain_(false),
       is_suspended_(false),
       is_reading_(false),
-      read_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_(new net::IOBuffer(kBufferSize)),
-      write_buffer_size_(0),
+      batch_messages_(false),
+      receive_buffer_size_(0),
+      send_buffer_size_(0),
+      multicast_ttl_(0),
+      multicast_loopback_(false),
+      broadcast_(false),
+      written_bytes_(0),
+      read_buffer_(new net::IOBuffer(kMaxDatagramSize)),
+      pending_messages_(new base::ListValue),
       resolver_(net::HostResolver::CreateDefaultResolver(NULL)),
       single_resolver_(new net::SingleRequestHostResolver(resolver_.get())) {
   handler_.Register("init",
@@ -52,19 +98,73 @@ UDPSocketObject::UDPSocketObject()
 UDPSocketObject::~UDPSocketObject() {}
 
 void UDPSocketObject::DoRead() {
-  if (!socket_->is_connected())
-    return;
-
   is_reading_ = true;
 
-  int ret = socket_->RecvFrom(read_buffer_.get(),
-                              kBufferSize,
-                              &from_,
-                              base::Bind(&UDPSocketObject::OnRead,
-                                         base::Unretained(this)));
+  while (!has_read_pending_ && socket_->is_connected()) {
+    int ret = socket_->RecvFrom(read_buffer_.get(),
+                                kMaxDatagramSize,
+                                &from_,
+                                base::Bind(&UDPSocketObject::OnRead,
+                                           base::Unretained(this)));
+
+    if (ret == net::ERR_IO_PENDING) {
+      has_read_pending_ = true;
+      // Nothing else is ready to be read, dispatch the current batch.
+      FlushMessages();
+      return;
+    }
 
-  if (ret > 0)
-    OnRead(ret);
+    if (!DidRead(ret))
+      return;
+  }
+}
+
+bool UDPSocketObject::DidRead(int status) {
+  if (status < 0) {
+    if (IsTransientReadError(status))
+      return true;
+
+    FlushMessages();
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("error");
+    return false;
+  }
+
+  // Unlike for streams, no data is an empty datagram and not the end of
+  // the connection.
+
+  // The UDPMessageEvent is built by hand so that the payload is copied once,
+  // straight into the event.
+  if (!is_suspended_ && IsEventActive("message")) {
+    std::unique_ptr<base::DictionaryValue> message(new base::DictionaryValue);
+    message->Set("data", base::BinaryValue::CreateWithCopiedBuffer(
+        read_buffer_->data(), status));
+    message->SetString("remoteAddress", from_.ToStringWithoutPort());
+    message->SetInteger("remotePort", from_.port());
+    pending_messages_->Append(message.release());
+  }
+
+  if (!batch_messages_ || pending_messages_->GetSize() >= kMaxBatchedMessages)
+    FlushMessages();
+
+  return true;
+}
+
+void UDPSocketObject::FlushMessages() {
+  if (pending_messages_->empty())
+    return;
+
+  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  if (batch_messages_) {
+    eventData->Append(pending_messages_.release());
+    pending_messages_.reset(new base::ListValue);
+  } else {
+    std::unique_ptr<base::Value> message;
+    pending_messages_->Remove(0, &message);
+    eventData->Append(message.release());
+  }
+
+  DispatchEvent("message", std::move(eventData));
 }
 
 void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
@@ -86,17 +186,35 @@ void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
     return;
   }
 
-  if (!params->options->local_address.empty()) {
+  const UDPOptions& options = *params->options;
+  if (options.batch_messages)
+    batch_messages_ = *options.batch_messages;
+  if (options.receive_buffer_size)
+    receive_buffer_size_ = *options.receive_buffer_size;
+  if (options.send_buffer_size)
+    send_buffer_size_ = *options.send_buffer_size;
+  if (options.multicast_ttl)
+    multicast_ttl_ = *options.multicast_ttl;
+  if (options.broadcast)
+    broadcast_ = *options.broadcast;
+  multicast_loopback_ = options.loopback;
+
+  // A local port alone is enough to receive, on any interface. This is what
+  // multicast listeners need.
+  std::string local_address = options.local_address;
+  if (local_address.empty() && options.local_port)
+    local_address = "0.0.0.0";
+
+  if (!local_address.empty()) {
     net::IPAddress ip_number;
-    if (!net::ParseURLHostnameToAddress(params->options->local_address,
-                                     &ip_number)) {
-      LOG(WARNING) << "Invalid IP address " << params->options->local_address;
+    if (!net::ParseURLHostnameToAddress(local_address, &ip_number)) {
+      LOG(WARNING) << "Invalid IP address " << local_address;
       setReadyState(READY_STATE_CLOSED);
       DispatchEvent("error");
       return;
     }
 
-    const net::IPEndPoint end_point(ip_number, params->options->local_port);
+    const net::IPEndPoint end_point(ip_number, options.local_port);
 
     if (socket_->Open(end_point.GetFamily()) != net::OK) {
       LOG(WARNING) << "Cannot open UDP socket";
@@ -105,7 +223,14 @@ void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
       return;
     }
 
-    if (params->options->address_reuse)
+    if (ApplySocketOptions() != net::OK) {
+      LOG(WARNING) << "Cannot set the UDP socket options";
+      setReadyState(READY_STATE_CLOSED);
+      DispatchEvent("error");
+      return;
+    }
+
+    if (options.address_reuse)
       socket_->AllowAddressReuse();
 
     if (socket_->Bind(end_point) != net::OK) {
@@ -120,14 +245,13 @@ void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
     return;
   }
 
-  if (params->options->remote_address.empty() ||
-      !params->options->remote_port) {
+  if (options.remote_address.empty() || !options.remote_port) {
     OnConnectionOpen(net::OK);
     return;
   }
 
   net::HostResolver::RequestInfo request_info(net::HostPortPair(
-      params->options->remote_address, params->options->remote_port));
+      options.remote_address, options.remote_port));
 
   int ret = single_resolver_->Resolve(
       request_info,
@@ -142,6 +266,7 @@ void UDPSocketObject::OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
 }
 
 void UDPSocketObject::OnClose(std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  ClearWriteQueue();
   socket_.reset();
 }
 
@@ -155,17 +280,66 @@ void UDPSocketObject::OnResume(std::unique_ptr<XWalkExtensionFunctionInfo> info)
 
 void UDPSocketObject::OnJoinMulticast(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  std::unique_ptr<JoinMulticast::Params>
+      params(JoinMulticast::Params::Create(*info->arguments()));
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    PostPromiseResult(std::move(info), net::ERR_INVALID_ARGUMENT);
+    return;
+  }
+
+  PostPromiseResult(std::move(info), SetMulticastMembership(
+      params->multicast_group_address, true));
 }
 
 void UDPSocketObject::OnLeaveMulticast(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
+  std::unique_ptr<LeaveMulticast::Params>
+      params(LeaveMulticast::Params::Create(*info->arguments()));
+  if (!params) {
+    LOG(WARNING) << "Malformed parameters passed to " << info->name();
+    PostPromiseResult(std::move(info), net::ERR_INVALID_ARGUMENT);
+    return;
+  }
+
+  PostPromiseResult(std::move(info), SetMulticastMembership(
+      params->multicast_group_address, false));
+}
+
+int UDPSocketObject::SetMulticastMembership(const std::string& group_address,
+                                            bool join) {
+  // Memberships are tied to a bound socket.
+  if (!socket_ || !socket_->is_connected())
+    return net::ERR_SOCKET_NOT_CONNECTED;
+
+  net::IPAddress group;
+  if (!group.AssignFromIPLiteral(group_address))
+    return net::ERR_ADDRESS_INVALID;
+
+  return join ? socket_->JoinGroup(group) : socket_->LeaveGroup(group);
+}
+
+int UDPSocketObject::ApplySocketOptions() {
+  int ret = net::OK;
+
+  if (receive_buffer_size_ > 0)
+    ret = socket_->SetReceiveBufferSize(receive_buffer_size_);
+  if (ret == net::OK && send_buffer_size_ > 0)
+    ret = socket_->SetSendBufferSize(send_buffer_size_);
+  if (ret == net::OK && broadcast_)
+    ret = socket_->SetBroadcast(true);
+  // The multicast options only take effect when the socket gets bound or
+  // connected.
+  if (ret == net::OK && multicast_ttl_ > 0)
+    ret = socket_->SetMulticastTimeToLive(multicast_ttl_);
+  if (ret == net::OK)
+    ret = socket_->SetMulticastLoopbackMode(multicast_loopback_);
+
+  return ret;
 }
 
 void UDPSocketObject::OnSendString(
     std::unique_ptr<XWalkExtensionFunctionInfo> info) {
-  if (!socket_ || has_write_pending_)
-    return;
-
   std::unique_ptr<SendDOMString::Params>
       params(SendDOMString::Params::Create(*info->arguments()));
   if (!params) {
@@ -173,66 +347,171 @@ void UDPSocketObject::OnSendString(
     return;
   }
 
-  if (params->data.size() > kBufferSize) {
-    LOG(WARNING) << "Write data bigger than the write buffer.";
+  if (!socket_) {
+    DidDiscard(params->data.size());
     return;
   }
 
-  write_buffer_size_ = params->data.size();
-  memcpy(write_buffer_->data(), params->data.data(), write_buffer_size_);
-
-  if (!params->remote_address || !*params->remote_port) {
-    OnSend(net::OK);
+  if (params->data.size() > kMaxDatagramSize) {
+    LOG(WARNING) << "Datagram bigger than " << kMaxDatagramSize << " bytes.";
+    DidDiscard(params->data.size());
     return;
   }
 
-  net::HostResolver::RequestInfo request_info(net::HostPortPair(
-      *params->remote_address, *params->remote_port));
+  PendingDatagram datagram;
+  datagram.size = base::checked_cast<int>(params->data.size());
+  datagram.buffer = new net::IOBuffer(std::max(datagram.size, 1));
+  memcpy(datagram.buffer->data(), params->data.data(), datagram.size);
+  if (params->remote_address && params->remote_port &&
+      *params->remote_port) {
+    datagram.has_destination = true;
+    datagram.destination = net::HostPortPair(*params->remote_address,
+                                             *params->remote_port);
+  }
+  write_queue_.push_back(datagram);
 
-  int ret = single_resolver_->Resolve(
-      request_info,
-      net::DEFAULT_PRIORITY,
-      &addresses_,
-      base::Bind(&UDPSocketObject::OnSend,
-                 base::Unretained(this)),
-      net::BoundNetLog());
+  if (params->notify_drain && *params->notify_drain)
+    needs_drain_ = true;
 
-  if (ret != net::ERR_IO_PENDING)
-    OnSend(ret);
-  else
-    has_write_pending_ = true;
+  DoWrite();
 }
 
-void UDPSocketObject::OnRead(int status) {
-  // No data means the other side has
-  // disconnected the socket.
-  if (status == 0) {
+void UDPSocketObject::DoWrite() {
+  while (!has_write_pending_ && !write_queue_.empty() && socket_) {
+    const PendingDatagram& datagram = write_queue_.front();
+    if (datagram.has_destination &&
+        !datagram.destination.Equals(resolved_destination_)) {
+      net::HostResolver::RequestInfo request_info(datagram.destination);
+
+      has_write_pending_ = true;
+      int ret = single_resolver_->Resolve(
+          request_info,
+          net::DEFAULT_PRIORITY,
+          &addresses_,
+          base::Bind(&UDPSocketObject::OnResolved,
+                     base::Unretained(this)),
+          net::BoundNetLog());
+
+      if (ret != net::ERR_IO_PENDING)
+        OnResolved(ret);
+      return;
+    }
+
+    if (!SendFrontDatagram())
+      return;
+  }
+}
+
+bool UDPSocketObject::SendFrontDatagram() {
+  if (addresses_.empty()) {
+    CloseWithError();
+    return false;
+  }
+
+  if (!socket_->is_connected()) {
+    // If we are waiting for reads and the socket is not connected,
+    // it means the connection was closed.
+    if (is_reading_ ||
+        socket_->Open(addresses_[0].GetFamily()) != net::OK ||
+        ApplySocketOptions() != net::OK ||
+        socket_->Connect(addresses_[0]) != net::OK) {
+      CloseWithError();
+      return false;
+    }
+  }
+
+  const PendingDatagram& datagram = write_queue_.front();
+  int ret = socket_->SendTo(
+      datagram.buffer.get(),
+      datagram.size,
+      addresses_[0],
+      base::Bind(&UDPSocketObject::OnWrite, base::Unretained(this)));
+
+  if (ret == net::ERR_IO_PENDING) {
+    has_write_pending_ = true;
+    return false;
+  }
+
+  if (ret < net::OK) {
+    ClearWriteQueue();
+    socket_->Close();
     setReadyState(READY_STATE_CLOSED);
     DispatchEvent("close");
-    return;
+    return false;
   }
 
-  std::unique_ptr<base::Value> data(base::BinaryValue::CreateWithCopiedBuffer(
-      static_cast<char*>(read_buffer_->data()), status));
+  if (!is_reading_ && socket_->is_connected())
+    DoRead();
+
+  DidWrite(datagram.size);
+  return true;
+}
+
+void UDPSocketObject::DidWrite(int size) {
+  write_queue_.pop_front();
+  written_bytes_ += size;
+
+  std::unique_ptr<base::ListValue> eventData(new base::ListValue);
+  eventData->AppendDouble(written_bytes_);
+  DispatchEvent("bufferedamount", std::move(eventData));
 
-  UDPMessageEvent event;
-  std::string buffer_data(read_buffer_->data(), status);
-  std::copy(buffer_data.begin(), buffer_data.end(), back_inserter(event.data));
-  event.remote_port = from_.port();
-  event.remote_address = from_.ToStringWithoutPort();
+  if (needs_drain_ && write_queue_.empty()) {
+    needs_drain_ = false;
+    DispatchEvent("drain");
+  }
+}
+
+void UDPSocketObject::DidDiscard(size_t size) {
+  if (!size)
+    return;
+  written_bytes_ += size;
 
   std::unique_ptr<base::ListValue> eventData(new base::ListValue);
-  eventData->Append(event.ToValue().release());
+  eventData->AppendDouble(written_bytes_);
+  DispatchEvent("bufferedamount", std::move(eventData));
+}
+
+void UDPSocketObject::ClearWriteQueue() {
+  // A pending resolution would send the head of the queue.
+  single_resolver_->Cancel();
+  has_write_pending_ = false;
+
+  size_t size = 0;
+  for (const PendingDatagram& datagram : write_queue_)
+    size += datagram.size;
+  write_queue_.clear();
+  DidDiscard(size);
+}
 
-  if (!is_suspended_)
-    DispatchEvent("message", std::move(eventData));
+void UDPSocketObject::CloseWithError() {
+  ClearWriteQueue();
+  setReadyState(READY_STATE_CLOSED);
+  DispatchEvent("error");
+}
+
+void UDPSocketObject::OnRead(int status) {
+  has_read_pending_ = false;
 
-  DoRead();
+  if (DidRead(status))
+    DoRead();
 }
 
 void UDPSocketObject::OnWrite(int status) {
   has_write_pending_ = false;
-  DispatchEvent("drain");
+
+  if (status < net::OK) {
+    ClearWriteQueue();
+    socket_->Close();
+    setReadyState(READY_STATE_CLOSED);
+    DispatchEvent("close");
+    return;
+  }
+
+  if (!is_reading_ && socket_->is_connected())
+    DoRead();
+
+  DidWrite(write_queue_.front().size);
+  DoWrite();
 }
 
 void UDPSocketObject::OnConnectionOpen(int status) {
@@ -246,46 +525,21 @@ void UDPSocketObject::OnConnectionOpen(int status) {
   DispatchEvent("open");
 }
 
-void UDPSocketObject::OnSend(int status) {
-  if (status != net::OK || addresses_.empty()) {
-    setReadyState(READY_STATE_CLOSED);
-    DispatchEvent("error");
-    return;
-  }
-
-  if (!socket_->is_connected()) {
-    // If we are waiting for reads and the socket is not connected,
-    // it means the connection was closed.
-    if (is_reading_ ||
-        socket_->Open(addresses_[0].GetFamily()) != net::OK ||
-        socket_->Connect(addresses_[0]) != net::OK) {
-      setReadyState(READY_STATE_CLOSED);
-      DispatchEvent("error");
-      return;
-    }
-  }
+void UDPSocketObject::OnResolved(int status) {
+  has_write_pending_ = false;
 
-  int ret = socket_->SendTo(
-      write_buffer_.get(),
-      base::checked_cast<int>(write_buffer_size_),
-      addresses_[0],
-      base::Bind(&UDPSocketObject::OnWrite, base::Unretained(this)));
+  // The socket was closed meanwhile.
+  if (write_queue_.empty() || !socket_)
+    return;
 
-  if (ret < net::OK) {
-    if (ret == net::ERR_IO_PENDING) {
-      has_write_pending_ = true;
-    } else {
-      socket_->Close();
-      setReadyState(READY_STATE_CLOSED);
-      DispatchEvent("close");
-      return;
-    }
-  } else {
-    has_write_pending_ = false;
+  if (status != net::OK) {
+    CloseWithError();
+    return;
   }
 
-  if (!is_reading_ && socket_->is_connected())
-    DoRead();
+  resolved_destination_ = write_queue_.front().destination;
+  if (SendFrontDatagram())
+    DoWrite();
 }
 
 }  // namespace sysapps
@@ -5,9 +5,12 @@
 #ifndef XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_
 #define XWALK_SYSAPPS_RAW_SOCKET_UDP_SOCKET_OBJECT_H_
 
+#include <deque>
 #include <string>
 
+#include "base/values.h"
 #include "net/base/address_list.h"
+#include "net/base/host_port_pair.h"
 #include "net/base/io_buffer.h"
 #include "net/dns/single_request_host_resolver.h"
 #include "net/udp/udp_socket.h"
@@ -22,7 +25,40 @@ class UDPSocketObject : public RawSocketObject {
   ~UDPSocketObject() override;
 
  private:
+  // A datagram waiting to be sent. Datagrams without |destination| go to
+  // the remote address given at initialization.
+  struct PendingDatagram {
+    PendingDatagram();
+    PendingDatagram(const PendingDatagram& other);
+    ~PendingDatagram();
+
+    scoped_refptr<net::IOBuffer> buffer;
+    int size;
+    bool has_destination;
+    net::HostPortPair destination;
+  };
+
   void DoRead();
+  // Accounts for a received datagram, which may be empty. Returns false if
+  // reading has to stop, after a fatal error.
+  bool DidRead(int status);
+  // Dispatches the datagrams received but not dispatched yet.
+  void FlushMessages();
+  // Applies the UDPOptions socket options, must be called right after the
+  // socket is opened and before it is bound or connected.
+  int ApplySocketOptions();
+  int SetMulticastMembership(const std::string& group_address, bool join);
+  void DoWrite();
+  // Sends the datagram at the head of the queue. Returns false if the send
+  // did not complete synchronously.
+  bool SendFrontDatagram();
+  void DidWrite(int size);
+  // Accounts for |size| bytes which won't be sent, so that they don't stay
+  // in the bufferedAmount attribute.
+  void DidDiscard(size_t size);
+  // Discards the queued datagrams and the resolution of their destination.
+  void ClearWriteQueue();
+  void CloseWithError();
 
   // JavaScript function handlers.
   void OnInit(std::unique_ptr<XWalkExtensionFunctionInfo> info);
@@ -39,17 +75,35 @@ class UDPSocketObject : public RawSocketObject {
 
   // net::SingleRequestHostResolver callbacks.
   void OnConnectionOpen(int status);
-  void OnSend(int status);
+  void OnResolved(int status);
 
+  bool has_read_pending_;
   bool has_write_pending_;
+  bool needs_drain_;
   bool is_suspended_;
   bool is_reading_;
+  // Whether the datagrams received in a row are dispatched as one event.
+  bool batch_messages_;
+
+  // Socket options from UDPOptions. Zero means the system default.
+  int receive_buffer_size_;
+  int send_buffer_size_;
+  int multicast_ttl_;
+  bool multicast_loopback_;
+  bool broadcast_;
+
+  // Total amount of bytes sent or discarded, JavaScript derives the
+  // bufferedAmount attribute from it.
+  double written_bytes_;
 
   scoped_refptr<net::IOBuffer> read_buffer_;
-  scoped_refptr<net::IOBuffer> write_buffer_;
+  std::unique_ptr<base::ListValue> pending_messages_;
   std::unique_ptr<net::UDPSocket> socket_;
 
-  size_t write_buffer_size_;
+  std::deque<PendingDatagram> write_queue_;
+  // Destination |addresses_| was last resolved for, so that consecutive
+  // datagrams to the same peer are not resolved again.
+  net::HostPortPair resolved_destination_;
 
   std::unique_ptr<net::HostResolver> resolver_;
   std::unique_ptr<net::SingleRequestHostResolver> single_resolver_;
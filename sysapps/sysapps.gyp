@@ -5,7 +5,9 @@
       'type': 'static_library',
       'dependencies': [
         '../../base/base.gyp:base',
+        '../../crypto/crypto.gyp:crypto',
         '../../net/net.gyp:net',
+        '../../third_party/boringssl/boringssl.gyp:boringssl',
         '../../ui/base/ui_base.gyp:ui_base',
         '../../ui/gfx/gfx.gyp:gfx',
         '../../ui/gfx/gfx.gyp:gfx_geometry',
@@ -33,6 +35,12 @@
         'raw_socket/raw_socket_extension.h',
         'raw_socket/raw_socket_object.cc',
         'raw_socket/raw_socket_object.h',
+        'raw_socket/read_buffer_sizer.cc',
+        'raw_socket/read_buffer_sizer.h',
+        'raw_socket/secure_transport.cc',
+        'raw_socket/secure_transport.h',
+        'raw_socket/socket_write_queue.cc',
+        'raw_socket/socket_write_queue.h',
         'raw_socket/tcp_server_socket.idl',
         'raw_socket/tcp_server_socket_object.cc',
         'raw_socket/tcp_server_socket_object.h',
@@ -7,6 +7,7 @@
         '../../base/base.gyp:base',
         '../../base/base.gyp:run_all_unittests',
         '../../content/content_shell_and_tests.gyp:test_support_content',
+        '../../net/net.gyp:net',
         '../../testing/gtest.gyp:gtest',
         '../extensions/extensions.gyp:xwalk_extensions',
         'sysapps.gyp:sysapps',
@@ -15,6 +16,8 @@
         'common/binding_object_store_unittest.cc',
         'common/event_target_unittest.cc',
         'common/sysapps_manager_unittest.cc',
+        'raw_socket/read_buffer_sizer_unittest.cc',
+        'raw_socket/socket_write_queue_unittest.cc',
       ],
       'conditions': [
         ['use_aura==1', {
@@ -31,6 +34,7 @@
         '../../base/base.gyp:base',
         '../../content/content_shell_and_tests.gyp:test_support_content',
         '../../net/net.gyp:net',
+        '../../net/net.gyp:net_test_support',
         '../../skia/skia.gyp:skia',
         '../../testing/gtest.gyp:gtest',
         '../extensions/extensions.gyp:xwalk_extensions',
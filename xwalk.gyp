@@ -117,6 +117,8 @@
         'runtime/browser/android/state_serializer.h',
         'runtime/browser/android/xwalk_autofill_client_android.cc',
         'runtime/browser/android/xwalk_autofill_client_android.h',
+        'runtime/browser/android/xwalk_browsing_data.cc',
+        'runtime/browser/android/xwalk_browsing_data.h',
         'runtime/browser/android/xwalk_content.cc',
         'runtime/browser/android/xwalk_content.h',
         'runtime/browser/android/xwalk_content_lifecycle_notifier.cc',
@@ -159,18 +161,27 @@
         'runtime/browser/android/xwalk_web_resource_response_impl.h',
         'runtime/browser/application_component.cc',
         'runtime/browser/application_component.h',
+        'runtime/browser/content_setting_lookup_cache.cc',
+        'runtime/browser/content_setting_lookup_cache.h',
+        'runtime/browser/copy_on_write_map.h',
         'runtime/browser/devtools/remote_debugging_server.cc',
         'runtime/browser/devtools/remote_debugging_server.h',
         'runtime/browser/devtools/xwalk_devtools_frontend.cc',
         'runtime/browser/devtools/xwalk_devtools_frontend.h',
         'runtime/browser/devtools/xwalk_devtools_manager_delegate.cc',
         'runtime/browser/devtools/xwalk_devtools_manager_delegate.h',
+        'runtime/browser/directory_enumerator.cc',
+        'runtime/browser/directory_enumerator.h',
+        'runtime/browser/favicon_store.cc',
+        'runtime/browser/favicon_store.h',
         'runtime/browser/geolocation/xwalk_access_token_store.cc',
         'runtime/browser/geolocation/xwalk_access_token_store.h',
         'runtime/browser/image_util.cc',
         'runtime/browser/image_util.h',
         'runtime/browser/media/media_capture_devices_dispatcher.cc',
         'runtime/browser/media/media_capture_devices_dispatcher.h',
+        'runtime/browser/permission_decision_cache.cc',
+        'runtime/browser/permission_decision_cache.h',
         'runtime/browser/renderer_host/pepper/xwalk_browser_pepper_host_factory.cc',
         'runtime/browser/renderer_host/pepper/xwalk_browser_pepper_host_factory.h',
         'runtime/browser/runtime.cc',
@@ -253,6 +264,8 @@
         'runtime/browser/ui/xwalk_javascript_native_dialog_factory_views.cc',
         'runtime/browser/ui/xwalk_views_delegate.cc',
         'runtime/browser/ui/xwalk_views_delegate.h',
+        'runtime/browser/visited_link_history.cc',
+        'runtime/browser/visited_link_history.h',
         'runtime/browser/wifidirect_component_win.cc',
         'runtime/browser/wifidirect_component_win.h',
         'runtime/browser/xwalk_app_extension_bridge.cc',
@@ -320,6 +333,8 @@
         'runtime/common/android/xwalk_message_generator.h',
         'runtime/common/android/xwalk_render_view_messages.cc',
         'runtime/common/android/xwalk_render_view_messages.h',
+        'runtime/common/async_log_sink.cc',
+        'runtime/common/async_log_sink.h',
         'runtime/common/logging_xwalk.cc',
         'runtime/common/logging_xwalk.h',
         'runtime/common/paths_mac.h',